@@ -29,6 +29,10 @@ use avs_binding_macros::FromCEnum;
 pub enum AvsPixelFormat {
     #[default]
     Rgb0_8 = AVS_PIXEL_RGB0_8,
+    Bgra8 = AVS_PIXEL_BGRA_8,
+    Rgba8 = AVS_PIXEL_RGBA_8,
+    I420 = AVS_PIXEL_I420,
+    Nv12 = AVS_PIXEL_NV12,
 }
 
 #[derive(Debug, Default, FromCEnum, PartialEq)]
@@ -37,6 +41,7 @@ pub enum AvsAudioSource {
     #[default]
     Internal = AVS_AUDIO_INTERNAL,
     External = AVS_AUDIO_EXTERNAL,
+    File = AVS_AUDIO_FILE,
 }
 
 #[derive(Debug, Default, FromCEnum, PartialEq)]
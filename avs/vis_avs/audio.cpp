@@ -1,97 +1,445 @@
 #include "audio.h"
 
-#include "../3rdparty/md_fft.h"
-
 #include <cmath>
 #include <cstdio>
 #include <cstring>
+#ifdef SIMD_MODE_X86_SSE
+#include <immintrin.h>
+#endif
 
-// The `ring` member is supposed to be used as the pointer into the ring buffer, while
-// the `linear` member is supposed to be used as the pointer into the linear source or
-// destination buffer.
-struct Audio::RingIter {
-    RingIter(size_t length, size_t from, bool reverse = false)
-        : length((int64_t)length),
-          ring((int64_t)(from % length)),
-          linear(reverse ? length - 1 : 0),
-          reverse(reverse) {
-        // printf("RingIter: %ld %ld %d\n", length, from, reverse);
-    }
-    int64_t length;
-    int64_t ring;
-    size_t linear;
-    size_t reverse;
-    RingIter& operator++() {
-        if (this->length == 0) {
-            return *this;
-        }
-        if (this->reverse) {
-            --this->ring;
-            while (this->ring < 0) {
-                this->ring += this->length;
-            }
-            --this->linear;
+// The ring holds more than a single frame's worth of audio, even at high sample rates
+// and low frame rates, so that reading the latest samples is practically never
+// disturbed by the producer.
+#define AUDIO_RING_MIN_LENGTH 16384
+
+// The default spectrum size, which matches the old fixed-size FFT.
+#define AUDIO_DEFAULT_FFT_SIZE 1024
+
+// The default rate audio is analyzed at, the one most music is distributed in.
+#define AUDIO_DEFAULT_ANALYSIS_RATE 44100
+
+// The default number of samples per chunk to ask audio input devices for, about 5ms.
+#define AUDIO_DEFAULT_INPUT_LATENCY_SAMPLES 256
+// The weight of each new chunk in the average input jitter.
+#define AUDIO_INPUT_JITTER_SMOOTHING 0.0625
+// A gap between chunks' capture times of more than this fraction of a chunk is an xrun.
+#define AUDIO_INPUT_XRUN_THRESHOLD 0.5
+
+// Beats are only predicted from tempos with at least this confidence.
+#define AUDIO_BEAT_PREDICTION_MIN_CONFIDENCE 0.4
+// A detected onset within this fraction of a beat period counts as the predicted beat.
+#define AUDIO_BEAT_PREDICTION_TOLERANCE 0.1
+
+// The default bands for `levels`: Bass, mids and treble.
+static const double audio_default_band_edges_hz[] = {20.0, 250.0, 4000.0, 20000.0};
+#define AUDIO_DEFAULT_ATTACK_MS 10.0
+#define AUDIO_DEFAULT_DECAY_MS  250.0
+// Longer gaps between frames don't make the envelopes any more settled.
+#define AUDIO_MAX_LEVELS_TIME_STEP_MS 1000
+
+Audio::Audio(size_t ring_buffer_length)
+    : input_latency_samples(AUDIO_DEFAULT_INPUT_LATENCY_SAMPLES),
+      ring(ring_buffer_length > AUDIO_RING_MIN_LENGTH ? ring_buffer_length
+                                                      : AUDIO_RING_MIN_LENGTH),
+      latest_sample_time(0),
+      samples_per_second(0),
+      requested_analysis_rate(AUDIO_DEFAULT_ANALYSIS_RATE),
+      analysis_rate(AUDIO_DEFAULT_ANALYSIS_RATE),
+      capture_time_origin_us(Audio::capture_time_unknown),
+      requested_fft_size(AUDIO_DEFAULT_FFT_SIZE),
+      requested_window(AVS_SPECTRUM_WINDOW_HANN),
+      fft(AUDIO_DEFAULT_FFT_SIZE, AVS_SPECTRUM_WINDOW_HANN),
+      dependencies(AUDIO_DEPENDS_ALL),
+      bands_lock(lock_init()) {
+    this->resize_spectrum(AUDIO_DEFAULT_FFT_SIZE, AVS_SPECTRUM_WINDOW_HANN);
+    this->set_bands(audio_default_band_edges_hz,
+                    sizeof(audio_default_band_edges_hz) / sizeof(double) - 1,
+                    AUDIO_DEFAULT_ATTACK_MS,
+                    AUDIO_DEFAULT_DECAY_MS);
+}
+
+Audio::~Audio() { lock_destroy(this->bands_lock); }
+
+bool Audio::set_spectrum(size_t fft_size, AVS_Spectrum_Window window) {
+    if (fft_size < Stereo_FFT::min_size || fft_size > Stereo_FFT::max_size
+        || (fft_size & (fft_size - 1)) != 0) {
+        return false;
+    }
+    if (window < AVS_SPECTRUM_WINDOW_HANN || window > AVS_SPECTRUM_WINDOW_RECTANGULAR) {
+        return false;
+    }
+    this->requested_fft_size = fft_size;
+    this->requested_window = window;
+    return true;
+}
+
+bool Audio::set_analysis_rate(size_t samples_per_second) {
+    if (samples_per_second < Audio::min_analysis_rate
+        || samples_per_second > Audio::max_analysis_rate) {
+        return false;
+    }
+    this->requested_analysis_rate = samples_per_second;
+    return true;
+}
+
+bool Audio::set_presentation_offset(double offset_ms) {
+    if (!(offset_ms >= -Audio::max_presentation_offset_ms)
+        || !(offset_ms <= Audio::max_presentation_offset_ms)) {
+        return false;
+    }
+    this->presentation_offset_us = (int64_t)llround(offset_ms * 1000.0);
+    return true;
+}
+
+bool Audio::set_input_latency(uint32_t latency_samples) {
+    if (latency_samples > Audio::max_input_latency_samples) {
+        return false;
+    }
+    bool changed = this->input_latency_samples.exchange(latency_samples)
+                   != latency_samples;
+    if (changed && this->audio_in != nullptr) {
+        this->audio_in_stop();
+        this->audio_in_start();
+    }
+    return true;
+}
+
+void Audio::current_tempo(AVS_Audio_Tempo* tempo_out) const {
+    Tempo_Estimate estimate;
+    if (!this->beat_detector.tempo(&estimate)) {
+        *tempo_out = {};
+        return;
+    }
+    auto now = (double)this->beat_detector.stream_position();
+    double beats = (now - estimate.beat_time) / estimate.beat_period;
+    double phase = beats - floor(beats);
+    tempo_out->bpm = estimate.bpm;
+    tempo_out->confidence = estimate.confidence;
+    tempo_out->beat_phase = phase;
+    tempo_out->next_beat_in_ms = (1.0 - phase) * estimate.beat_period * 1000.0
+                                 / (double)estimate.samples_per_second;
+}
+
+void Audio::input_stats(AVS_Audio_Input_Stats* stats_out) const {
+    stats_out->latency_samples = this->input_latency_samples.load();
+    stats_out->chunk_samples = this->input_chunk_length.load();
+    stats_out->num_xruns = this->input_num_xruns.load();
+    stats_out->num_overruns = this->ring.num_overruns();
+    stats_out->callback_jitter_ms = (double)this->input_jitter_us.load() / 1000.0;
+    stats_out->max_callback_jitter_ms =
+        (double)this->input_max_jitter_us.load() / 1000.0;
+}
+
+bool Audio::set_bands(const double* band_edges_hz,
+                      size_t num_bands,
+                      double attack_ms,
+                      double decay_ms) {
+    if (band_edges_hz == nullptr || num_bands < 1 || num_bands > Audio_Levels::max_bands
+        || !(attack_ms >= 0.0) || !(decay_ms >= 0.0)) {
+        return false;
+    }
+    for (size_t i = 0; i < num_bands; i++) {
+        if (!(band_edges_hz[i] >= 0.0) || !(band_edges_hz[i + 1] > band_edges_hz[i])) {
+            return false;
+        }
+    }
+    lock_lock(this->bands_lock);
+    this->requested_bands_config.num_bands = num_bands;
+    for (size_t i = 0; i <= num_bands; i++) {
+        this->requested_bands_config.edges_hz[i] = band_edges_hz[i];
+    }
+    this->requested_bands_config.attack_ms = attack_ms;
+    this->requested_bands_config.decay_ms = decay_ms;
+    lock_unlock(this->bands_lock);
+    this->bands_config_changed = true;
+    return true;
+}
+
+void Audio::set_dependencies(uint32_t dependencies) {
+    this->dependencies = dependencies;
+}
+
+void Audio::resize_spectrum(size_t fft_size, AVS_Spectrum_Window window) {
+    bool size_changed = fft_size != this->fft.size() || this->legacy_bins.empty();
+    this->fft.resize(fft_size, window);
+    if (!size_changed) {
+        return;
+    }
+    size_t analysis_length =
+        fft_size > AUDIO_BUFFER_LEN ? fft_size : (size_t)AUDIO_BUFFER_LEN;
+    this->analysis_left.assign(analysis_length, 0.0f);
+    this->analysis_right.assign(analysis_length, 0.0f);
+    this->spectrum_left.resize(this->fft.num_bins());
+    this->spectrum_right.resize(this->fft.num_bins());
+    this->legacy_bins.resize(AUDIO_BUFFER_LEN);
+    size_t last_fft_bin = this->fft.num_bins() - 1;
+    double fft_bins_per_bin = (double)last_fft_bin / (double)AUDIO_BUFFER_LEN;
+    for (size_t i = 0; i < AUDIO_BUFFER_LEN; i++) {
+        auto& bin = this->legacy_bins[i];
+        if (fft_bins_per_bin < 1.0) {
+            double position = ((double)i + 0.5) * fft_bins_per_bin;
+            bin.first = (uint32_t)position;
+            bin.last = bin.first;
+            bin.fraction = (float)(position - bin.first);
         } else {
-            ++this->ring;
-            while (this->ring >= this->length) {
-                this->ring -= this->length;
+            bin.first = (uint32_t)((double)i * fft_bins_per_bin);
+            bin.last = (uint32_t)ceil((double)(i + 1) * fft_bins_per_bin) - 1;
+            bin.fraction = 0.0f;
+        }
+        if (bin.last > last_fft_bin) {
+            bin.last = last_fft_bin;
+        }
+    }
+}
+
+void Audio::spectrum_to_legacy_bins(const float* spectrum,
+                                    float* legacy_bins_out) const {
+    size_t last_fft_bin = this->fft.num_bins() - 1;
+    for (size_t i = 0; i < AUDIO_BUFFER_LEN; i++) {
+        const auto& bin = this->legacy_bins[i];
+        if (bin.first == bin.last) {
+            size_t next = bin.first < last_fft_bin ? bin.first + 1 : bin.first;
+            float first = spectrum[bin.first];
+            legacy_bins_out[i] = first + (spectrum[next] - first) * bin.fraction;
+        } else {
+            float max = spectrum[bin.first];
+            for (size_t k = bin.first + 1; k <= bin.last; k++) {
+                max = spectrum[k] > max ? spectrum[k] : max;
             }
-            ++this->linear;
+            legacy_bins_out[i] = max;
         }
-        return *this;
     }
-};
+}
 
-Audio::Audio(size_t ring_buffer_length)
-    : lock(lock_init()),
-      write_head(0),
-      latest_sample_time(0),
-      samples_per_second(0),
-      fft(new FFT()) {
-    this->buffer.resize(ring_buffer_length, {0, 0});
-    if (this->fft) {
-        this->fft->Init(ring_buffer_length,
-                        ring_buffer_length,
-                        1.0f,  // equalize
-                        1.0f   // window-function exponent
-        );
-    }
-}
-
-Audio::~Audio() {
-    lock_destroy(this->lock);
-    if (this->fft) {
-        this->fft->CleanUp();
-    }
-    delete this->fft;
-}
-
-void Audio::get(int64_t until_time_samples) {
-    size_t dest_back_offset = 0;
-    if (until_time_samples == 0) {
-        until_time_samples = this->latest_sample_time;
-    } else if (until_time_samples > this->latest_sample_time) {
-        auto silence_samples = until_time_samples - this->latest_sample_time;
-        dest_back_offset += silence_samples;
-        auto dest_silence_start = AUDIO_BUFFER_LEN - silence_samples;
-        memset(&this->osc.left[dest_silence_start], 0, silence_samples * sizeof(float));
-        memset(
-            &this->osc.right[dest_silence_start], 0, silence_samples * sizeof(float));
-        memset(
-            &this->spec.left[dest_silence_start], 0, silence_samples * sizeof(float));
-        memset(
-            &this->spec.right[dest_silence_start], 0, silence_samples * sizeof(float));
-    }
-    for (RingIter it(this->buffer.size() - dest_back_offset, this->write_head, true);
-         it.linear > dest_back_offset;
-         ++it) {
-        this->osc.left[it.linear - dest_back_offset] = this->buffer[it.ring].left;
-        this->osc.right[it.linear - dest_back_offset] = this->buffer[it.ring].right;
-    }
-    this->fft->time_to_frequency_domain(this->osc.left, this->spec.left);
-    this->fft->time_to_frequency_domain(this->osc.right, this->spec.right);
-    this->osc.average_center();
-    this->spec.average_center();
+void Audio::get(int64_t time_in_ms, int64_t until_time_samples) {
+    uint32_t dependencies = this->dependencies.load();
+    this->resize_spectrum(this->requested_fft_size.load(),
+                          (AVS_Spectrum_Window)this->requested_window.load());
+    size_t analysis_length = this->analysis_left.size();
+    // The spectrum needs the full analysis length, the waveform only its end.
+    if (dependencies & (AUDIO_DEPENDS_SPEC | AUDIO_DEPENDS_LEVELS)) {
+        this->read_latest(analysis_length, until_time_samples);
+        size_t fft_start = analysis_length - this->fft.size();
+        this->fft.magnitudes(&this->analysis_left[fft_start],
+                             &this->analysis_right[fft_start],
+                             this->spectrum_left.data(),
+                             this->spectrum_right.data());
+    } else if (dependencies & AUDIO_DEPENDS_OSC) {
+        this->read_latest(AUDIO_BUFFER_LEN, until_time_samples);
+    }
+    if (dependencies & AUDIO_DEPENDS_SPEC) {
+        this->spectrum_to_legacy_bins(this->spectrum_left.data(), this->spec.left);
+        this->spectrum_to_legacy_bins(this->spectrum_right.data(), this->spec.right);
+        if (dependencies & AUDIO_DEPENDS_CENTER) {
+            this->spec.average_center();
+        }
+    }
+    if (dependencies & AUDIO_DEPENDS_OSC) {
+        size_t osc_start = analysis_length - AUDIO_BUFFER_LEN;
+        memcpy(this->osc.left,
+               &this->analysis_left[osc_start],
+               AUDIO_BUFFER_LEN * sizeof(float));
+        memcpy(this->osc.right,
+               &this->analysis_right[osc_start],
+               AUDIO_BUFFER_LEN * sizeof(float));
+        if (dependencies & AUDIO_DEPENDS_CENTER) {
+            this->osc.average_center();
+        }
+    }
+    this->update_visdata(dependencies);
+    if (dependencies & AUDIO_DEPENDS_LEVELS) {
+        this->update_levels(time_in_ms);
+    }
+    if (dependencies & AUDIO_DEPENDS_TEMPO) {
+        this->current_tempo(&this->tempo);
+    }
+    if (this->beat_detection_enabled) {
+        if (dependencies & AUDIO_DEPENDS_BEAT) {
+            uint64_t num_onsets = this->beat_detector.num_onsets();
+            this->is_beat = num_onsets != this->last_num_onsets;
+            this->last_num_onsets = num_onsets;
+            if (this->beat_prediction_enabled && this->predicted_beat_missed()) {
+                this->is_beat = true;
+            }
+        } else {
+            this->is_beat = false;
+        }
+    }
+}
+
+/**
+ * Return the sum of the squares of `length` values each from `left` and `right`, and
+ * their largest absolute value in `peak_out`.
+ */
+static float sum_squares_c(const float* left,
+                           const float* right,
+                           size_t length,
+                           float* peak_out) {
+    float sum = 0.0f;
+    float peak = 0.0f;
+    for (size_t i = 0; i < length; i++) {
+        sum += left[i] * left[i] + right[i] * right[i];
+        float abs_left = fabsf(left[i]);
+        float abs_right = fabsf(right[i]);
+        peak = abs_left > peak ? abs_left : peak;
+        peak = abs_right > peak ? abs_right : peak;
+    }
+    *peak_out = peak;
+    return sum;
+}
+
+#ifdef SIMD_MODE_X86_SSE
+static float sum_squares_x86v128(const float* left,
+                                 const float* right,
+                                 size_t length,
+                                 float* peak_out) {
+    __m128 sum = _mm_setzero_ps();
+    __m128 peak = _mm_setzero_ps();
+    __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        __m128 l = _mm_loadu_ps(&left[i]);
+        __m128 r = _mm_loadu_ps(&right[i]);
+        sum = _mm_add_ps(sum, _mm_add_ps(_mm_mul_ps(l, l), _mm_mul_ps(r, r)));
+        peak = _mm_max_ps(peak, _mm_and_ps(l, abs_mask));
+        peak = _mm_max_ps(peak, _mm_and_ps(r, abs_mask));
+    }
+    float sums[4];
+    float peaks[4];
+    _mm_storeu_ps(sums, sum);
+    _mm_storeu_ps(peaks, peak);
+    float tail_peak;
+    float total = sums[0] + sums[1] + sums[2] + sums[3]
+                  + sum_squares_c(&left[i], &right[i], length - i, &tail_peak);
+    for (float p : peaks) {
+        tail_peak = p > tail_peak ? p : tail_peak;
+    }
+    *peak_out = tail_peak;
+    return total;
+}
+#endif
+
+static float sum_squares(const float* left,
+                         const float* right,
+                         size_t length,
+                         float* peak_out) {
+#ifdef SIMD_MODE_X86_SSE
+    return sum_squares_x86v128(left, right, length, peak_out);
+#else
+    return sum_squares_c(left, right, length, peak_out);
+#endif
+}
+
+// Move `level` towards `target` by the fraction `attack` if it's rising, or `decay`.
+static float follow_envelope(float level, float target, float attack, float decay) {
+    return level + (target - level) * (target > level ? attack : decay);
+}
+
+void Audio::update_levels(int64_t time_in_ms) {
+    if (this->bands_config_changed.exchange(false)) {
+        lock_lock(this->bands_lock);
+        this->bands_config = this->requested_bands_config;
+        lock_unlock(this->bands_lock);
+        this->levels.num_bands = this->bands_config.num_bands;
+        this->last_levels_time_ms = -1;
+    }
+    size_t fft_size = this->fft.size();
+    size_t fft_start = this->analysis_left.size() - fft_size;
+    float peak;
+    float sum = sum_squares(&this->analysis_left[fft_start],
+                            &this->analysis_right[fft_start],
+                            fft_size,
+                            &peak);
+    this->levels.rms = sqrtf(sum / (float)(2 * fft_size));
+    this->levels.peak = peak;
+
+    // With both channels summed up, the sum of squared magnitudes is four times the
+    // mean power, times the noise bandwidth.
+    float power_scale = 1.0f / (4.0f * this->fft.noise_bandwidth());
+    double bins_per_hz = (double)fft_size / (double)this->analysis_rate.load();
+    size_t num_bins = this->fft.num_bins();
+    for (size_t b = 0; b < this->bands_config.num_bands; b++) {
+        auto first = (size_t)(this->bands_config.edges_hz[b] * bins_per_hz + 0.5);
+        auto end = (size_t)(this->bands_config.edges_hz[b + 1] * bins_per_hz + 0.5);
+        first = first < num_bins - 1 ? first : num_bins - 1;
+        end = end < num_bins ? end : num_bins;
+        // Bands narrower than a bin still get the nearest one.
+        end = end > first ? end : first + 1;
+        float band_peak;
+        float band_sum = sum_squares(&this->spectrum_left[first],
+                                     &this->spectrum_right[first],
+                                     end - first,
+                                     &band_peak);
+        this->levels.bands[b].energy = sqrtf(band_sum * power_scale);
+    }
+
+    if (this->last_levels_time_ms < 0) {
+        // Start out settled.
+        for (size_t b = 0; b < this->bands_config.num_bands; b++) {
+            this->levels.bands[b].envelope = this->levels.bands[b].energy;
+        }
+        this->levels.rms_envelope = this->levels.rms;
+    } else {
+        int64_t time_step_ms = time_in_ms - this->last_levels_time_ms;
+        if (time_step_ms > AUDIO_MAX_LEVELS_TIME_STEP_MS) {
+            time_step_ms = AUDIO_MAX_LEVELS_TIME_STEP_MS;
+        }
+        time_step_ms = time_step_ms > 0 ? time_step_ms : 0;
+        double attack_ms = this->bands_config.attack_ms;
+        double decay_ms = this->bands_config.decay_ms;
+        auto time_step = (double)time_step_ms;
+        // A time constant of 0 follows the level immediately.
+        float attack = 1.0f;
+        float decay = 1.0f;
+        if (attack_ms > 0.0) {
+            attack = (float)(1.0 - exp(-time_step / attack_ms));
+        }
+        if (decay_ms > 0.0) {
+            decay = (float)(1.0 - exp(-time_step / decay_ms));
+        }
+        for (size_t b = 0; b < this->bands_config.num_bands; b++) {
+            auto& band = this->levels.bands[b];
+            band.envelope = follow_envelope(band.envelope, band.energy, attack, decay);
+        }
+        this->levels.rms_envelope =
+            follow_envelope(this->levels.rms_envelope, this->levels.rms, attack, decay);
+    }
+    this->last_levels_time_ms = time_in_ms;
+}
+
+// Copy the latest `num_samples` samples from the ring to the end of the analysis
+// buffers. Any time between the latest sample and `until_time_samples` is silence.
+void Audio::read_latest(size_t num_samples, int64_t until_time_samples) {
+    size_t silence_samples = 0;
+    int64_t latest_sample_time = this->latest_sample_time.load();
+    size_t samples_per_second = this->samples_per_second.load();
+    if (until_time_samples > latest_sample_time && samples_per_second > 0) {
+        // Both times are at the input rate, the ring is at the analysis rate.
+        silence_samples = (size_t)((double)(until_time_samples - latest_sample_time)
+                                   * (double)this->analysis_rate.load()
+                                   / (double)samples_per_second);
+        if (silence_samples > num_samples) {
+            silence_samples = num_samples;
+        }
+    }
+    size_t audio_samples = num_samples - silence_samples;
+    size_t start = this->analysis_left.size() - num_samples;
+    float* left = &this->analysis_left[start];
+    float* right = &this->analysis_right[start];
+    // With capture times, end the window at the audio that plays when the frame is
+    // seen. The ring clamps that to the latest sample, so no latency is ever added.
+    uint64_t end_position = UINT64_MAX;
+    int64_t origin_us = this->capture_time_origin_us.load();
+    if (origin_us != Audio::capture_time_unknown) {
+        int64_t presentation_time_us =
+            (int64_t)timer_us() + this->presentation_offset_us.load();
+        double position = (double)(presentation_time_us - origin_us)
+                          * (double)this->analysis_rate.load() / 1000000.0;
+        end_position = position > 0.0 ? (uint64_t)position : 0;
+    }
+    this->ring.read(end_position, left, right, audio_samples);
+    memset(&left[audio_samples], 0, silence_samples * sizeof(float));
+    memset(&right[audio_samples], 0, silence_samples * sizeof(float));
 }
 
 int32_t Audio::set(const float* audio_left,
@@ -99,50 +447,37 @@ int32_t Audio::set(const float* audio_left,
                    size_t audio_length,
                    size_t samples_per_second,
                    int64_t end_time_samples) {
-    printf("set: %ld\n", end_time_samples);
     auto remaining = this->samples_remaining(end_time_samples);
-    if (audio_length != 0 && this->latest_sample_time < end_time_samples) {
+    if (audio_length != 0 && this->latest_sample_time.load() < end_time_samples) {
         if (audio_left == nullptr || audio_right == nullptr
             || samples_per_second == 0) {
             return -1;
         }
-        size_t source_audio_offset = 0;
-        if (audio_length > this->buffer.capacity()) {
-            source_audio_offset = audio_length - this->buffer.capacity();
-        }
-        lock_lock(this->lock);
-        if (this->samples_per_second != samples_per_second) {
-            this->write_head = 0;
-            this->buffer.clear();
-            this->buffer.resize(this->buffer.capacity(), {0, 0});
-        }
-        this->samples_per_second = samples_per_second;
-        for (RingIter it(this->buffer.capacity(), this->write_head);
-             it.linear < audio_length;
-             ++it, ++this->write_head) {
-            this->buffer[it.ring].left =
-                fminf(1.0, fmaxf(-1.0, audio_left[source_audio_offset + it.linear]));
-            this->buffer[it.ring].right =
-                fminf(1.0, fmaxf(-1.0, audio_right[source_audio_offset + it.linear]));
-        }
-        this->latest_sample_time = end_time_samples;
-        lock_unlock(this->lock);
+        this->update_rates(samples_per_second);
+        size_t num_written = this->resampler.write(
+            audio_left, audio_right, audio_length, this->ring);
+        this->detect_beats(num_written, this->resampler.output_rate());
+        this->latest_sample_time.store(end_time_samples);
     }
     return remaining;
 }
 
-void Audio::to_legacy_visdata(char visdata[2][2][AUDIO_BUFFER_LEN]) {
-    for (int i = 0; i < AUDIO_BUFFER_LEN; ++i) {
-        auto ileft = (int8_t)(this->osc.left[i] * 127.0f);
-        auto iright = (int8_t)(this->osc.right[i] * 127.0f);
-        visdata[1 /*osc*/][0][i] = ileft;
-        visdata[1 /*osc*/][1][i] = iright;
+void Audio::update_visdata(uint32_t dependencies) {
+    if (dependencies & AUDIO_DEPENDS_OSC) {
+        for (int i = 0; i < AUDIO_BUFFER_LEN; ++i) {
+            auto ileft = (int8_t)(this->osc.left[i] * 127.0f);
+            auto iright = (int8_t)(this->osc.right[i] * 127.0f);
+            this->visdata[1 /*osc*/][0][i] = ileft;
+            this->visdata[1 /*osc*/][1][i] = iright;
+        }
     }
-    for (int i = 0; i < AUDIO_BUFFER_LEN; ++i) {
-        auto ileft = (uint8_t)(this->spec.left[i] * 255.0f);
-        auto iright = (uint8_t)(this->spec.right[i] * 255.0f);
-        visdata[0 /*spec*/][0][i] = (int8_t)ileft;
-        visdata[0 /*spec*/][1][i] = (int8_t)iright;
+    if (dependencies & AUDIO_DEPENDS_SPEC) {
+        for (int i = 0; i < AUDIO_BUFFER_LEN; ++i) {
+            auto ileft = (uint8_t)(fminf(this->spec.left[i], 1.0f) * 255.0f);
+            auto iright = (uint8_t)(fminf(this->spec.right[i], 1.0f) * 255.0f);
+            this->visdata[0 /*spec*/][0][i] = (int8_t)ileft;
+            this->visdata[0 /*spec*/][1][i] = (int8_t)iright;
+        }
     }
 }
 
@@ -150,29 +485,146 @@ int32_t Audio::samples_remaining(int64_t relative_to) const {
     if (this->samples_per_second == 0) {
         return -1;
     }
-    return (int32_t)(relative_to - this->latest_sample_time);
+    return (int32_t)(relative_to - this->latest_sample_time.load());
 }
 
 void Audio::capture_handler(void* data,
                             AudioFrame* audio_data,
                             size_t samples_per_second,
-                            uint32_t num_samples) {
+                            uint32_t num_samples,
+                            int64_t capture_time_us) {
     auto audio = (Audio*)data;
-    for (RingIter it(audio->buffer.capacity(), audio->write_head);
-         it.linear < num_samples;
-         ++it, ++audio->write_head) {
-        audio->buffer[it.ring] = audio_data[it.linear];
+    audio->update_rates(samples_per_second);
+    size_t num_written = audio->resampler.write(audio_data, num_samples, audio->ring);
+    audio->detect_beats(num_written, audio->resampler.output_rate());
+    audio->update_input_stats(num_samples, samples_per_second, capture_time_us);
+    if (capture_time_us < 0) {
+        audio->capture_time_origin_us = Audio::capture_time_unknown;
+        return;
+    }
+    auto ring_duration_us = (int64_t)((double)audio->ring.num_written() * 1000000.0
+                                      / (double)audio->resampler.output_rate());
+    audio->capture_time_origin_us = capture_time_us - ring_duration_us;
+}
+
+void Audio::update_input_stats(uint32_t num_samples,
+                               size_t samples_per_second,
+                               int64_t capture_time_us) {
+    auto now_us = (int64_t)timer_us();
+    int64_t duration_us = samples_per_second > 0
+                              ? (int64_t)num_samples * 1000000 / samples_per_second
+                              : 0;
+    if (this->last_chunk_time_us >= 0) {
+        int64_t jitter_us =
+            now_us - this->last_chunk_time_us - this->last_chunk_duration_us;
+        jitter_us = jitter_us < 0 ? -jitter_us : jitter_us;
+        int64_t average_us = this->input_jitter_us.load(std::memory_order_relaxed);
+        average_us += (int64_t)((double)(jitter_us - average_us)
+                                * AUDIO_INPUT_JITTER_SMOOTHING);
+        this->input_jitter_us.store(average_us, std::memory_order_relaxed);
+        if (jitter_us > this->input_max_jitter_us.load(std::memory_order_relaxed)) {
+            this->input_max_jitter_us.store(jitter_us, std::memory_order_relaxed);
+        }
+    }
+    if (capture_time_us >= 0 && this->last_capture_time_us >= 0) {
+        // Consecutive chunks are captured one chunk length apart, unless some audio
+        // got lost in between.
+        int64_t gap_us = capture_time_us - this->last_capture_time_us - duration_us;
+        if ((double)gap_us > (double)duration_us * AUDIO_INPUT_XRUN_THRESHOLD) {
+            this->input_num_xruns.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    this->last_chunk_time_us = now_us;
+    this->last_chunk_duration_us = duration_us;
+    this->last_capture_time_us = capture_time_us;
+    this->input_chunk_length.store(num_samples, std::memory_order_relaxed);
+}
+
+// Prepare the resampler for converting from the input rate to the requested analysis
+// rate. After a change of the input rate, the ring just continues at the same rate, but
+// audio at an old analysis rate doesn't belong in the ring anymore.
+void Audio::update_rates(size_t samples_per_second) {
+    this->samples_per_second = samples_per_second;
+    size_t analysis_rate = this->requested_analysis_rate.load();
+    bool analysis_rate_changed = analysis_rate != this->resampler.output_rate();
+    if (!this->resampler.set_rates(samples_per_second, analysis_rate)) {
+        return;
+    }
+    if (analysis_rate_changed) {
+        this->ring.write_silence(this->ring.length());
+        this->analysis_rate = analysis_rate;
+    }
+}
+
+// Analyze the `num_samples` samples just written to the ring. Beat detection runs here,
+// as audio arrives, instead of once per frame in `get()`, so that onsets are found at
+// the sample they occurred and between frames just the same.
+void Audio::detect_beats(size_t num_samples, size_t samples_per_second) {
+    uint32_t dependencies = this->dependencies.load();
+    bool beats_needed =
+        this->beat_detection_enabled && (dependencies & AUDIO_DEPENDS_BEAT);
+    bool tempo_needed =
+        this->tempo_tracking_enabled || (dependencies & AUDIO_DEPENDS_TEMPO);
+    if (!beats_needed && !tempo_needed) {
+        this->beat_detector_paused = true;
+        return;
+    }
+    if (this->beat_detector_paused) {
+        // Don't let audio from before the pause trigger an onset.
+        this->beat_detector.reset();
+        this->beat_detector_paused = false;
+    }
+    Audio_Ring::Segment segments[2];
+    int num_segments = this->ring.latest_written(num_samples, segments);
+    for (int i = 0; i < num_segments; i++) {
+        this->beat_detector.process(segments[i].left,
+                                    segments[i].right,
+                                    segments[i].length,
+                                    samples_per_second);
+    }
+}
+
+/**
+ * Whether the tempo tracker predicted a beat that's now far enough in the past that an
+ * onset should have been detected for it, but wasn't. Each predicted beat is only
+ * considered once.
+ */
+bool Audio::predicted_beat_missed() {
+    Tempo_Estimate estimate;
+    if (!this->beat_detector.tempo(&estimate)
+        || estimate.confidence < AUDIO_BEAT_PREDICTION_MIN_CONFIDENCE) {
+        return false;
+    }
+    auto now = (double)this->beat_detector.stream_position();
+    if (now < this->last_predicted_beat_time) {
+        // The detector was reset, and the stream position with it.
+        this->last_predicted_beat_time = -INFINITY;
+    }
+    double tolerance = estimate.beat_period * AUDIO_BEAT_PREDICTION_TOLERANCE;
+    double beats = floor((now - tolerance - estimate.beat_time) / estimate.beat_period);
+    double predicted_time = estimate.beat_time + beats * estimate.beat_period;
+    // Estimates shift slightly with each update, don't take that for a new beat.
+    if (predicted_time <= this->last_predicted_beat_time + tolerance) {
+        return false;
     }
+    this->last_predicted_beat_time = predicted_time;
+    int64_t onset_time = this->beat_detector.latest_onset_time();
+    return onset_time < 0 || fabs((double)onset_time - predicted_time) > tolerance;
 }
 
 void Audio::audio_in_start() {
     if (this->audio_in == nullptr) {
-        this->audio_in = ::audio_in_start(capture_handler, this);
+        // A new input's first chunk doesn't continue the previous input's last one.
+        this->last_chunk_time_us = -1;
+        this->last_capture_time_us = -1;
+        this->audio_in = ::audio_in_start(
+            capture_handler, this, this->input_latency_samples.load());
     }
 }
 
 void Audio::audio_in_stop() {
     if (this->audio_in != nullptr) {
         ::audio_in_stop(this->audio_in);
+        this->audio_in = nullptr;
     }
 }
@@ -1,9 +1,16 @@
 #pragma once
 
 #include "audio_in.h"
+#include "audio_ring.h"
+#include "avs.h"
+#include "beat_detector.h"
+#include "fft.h"
+#include "resampler.h"
 
 #include "../platform.h"
 
+#include <atomic>
+#include <cmath>
 #include <cstdint>
 #include <map>
 #include <tuple>
@@ -11,7 +18,28 @@
 
 #define AUDIO_BUFFER_LEN 576
 
-class FFT;  // in "../3rdparty/md_fft.h"
+/**
+ * The kinds of audio data a preset may read while rendering. Effects declare theirs in
+ * their Effect_Info, and `Audio::get()` only prepares the ones the current preset uses.
+ */
+enum Audio_Dependency : uint32_t {
+    AUDIO_DEPENDS_NONE = 0,
+    // The waveform in `osc` and the legacy `visdata`.
+    AUDIO_DEPENDS_OSC = 1 << 0,
+    // The spectrum in `spec` and the legacy `visdata`.
+    AUDIO_DEPENDS_SPEC = 1 << 1,
+    // The `center` channel of whichever of `osc` and `spec` is used.
+    AUDIO_DEPENDS_CENTER = 1 << 2,
+    // `is_beat`, i.e. internal beat detection if that's the beat source.
+    AUDIO_DEPENDS_BEAT = 1 << 3,
+    // The band energies and overall levels in `levels`.
+    AUDIO_DEPENDS_LEVELS = 1 << 4,
+    // The tempo in `tempo`, i.e. beat detection and tempo tracking for any beat source.
+    AUDIO_DEPENDS_TEMPO = 1 << 5,
+    AUDIO_DEPENDS_ALL = AUDIO_DEPENDS_OSC | AUDIO_DEPENDS_SPEC | AUDIO_DEPENDS_CENTER
+                        | AUDIO_DEPENDS_BEAT | AUDIO_DEPENDS_LEVELS
+                        | AUDIO_DEPENDS_TEMPO,
+};
 
 struct AudioChannels {
     float left[AUDIO_BUFFER_LEN];
@@ -24,41 +52,213 @@ struct AudioChannels {
     }
 };
 
-class Audio {
-   private:
-    struct RingIter;
+/**
+ * Loudness measures of the latest audio, computed once per frame, so that neither
+ * presets nor effects have to sum up spectrum values themselves. All values are
+ * amplitudes, a full-scale sine wave has an RMS of about 0.71 and a peak of 1, in the
+ * band it falls into as well as overall.
+ */
+struct Audio_Levels {
+    static constexpr size_t max_bands = 16;
+    struct Band {
+        // The RMS of all frequencies in the band.
+        float energy;
+        // `energy`, following rises with the attack time and falls with the decay time.
+        float envelope;
+    };
+    size_t num_bands;
+    Band bands[max_bands];
+    float rms;
+    float peak;
+    float rms_envelope;
+};
 
+class Audio {
    public:
     explicit Audio(size_t ring_buffer_length = 1024);
     ~Audio();
+    Audio(const Audio&) = delete;
+    Audio& operator=(const Audio&) = delete;
     int32_t set(const float* audio_left,
                 const float* audio_right,
                 size_t audio_length,
                 size_t samples_per_second,
                 int64_t end_time_in_samples);
-    void get(int64_t until_time_samples = 0);
+    // Prepare the audio data for the frame at `time_in_ms`.
+    void get(int64_t time_in_ms, int64_t until_time_samples = 0);
+    /**
+     * Set the number of samples and window function for the spectrum in `spec`. Takes
+     * effect on the next `get()`. Returns `false` if `fft_size` isn't a power of 2
+     * between `Stereo_FFT::min_size` and `max_size`, or `window` is invalid.
+     */
+    bool set_spectrum(size_t fft_size, AVS_Spectrum_Window window);
+    /**
+     * Set the sample rate that incoming audio is converted to before analysis. Takes
+     * effect with the next incoming audio. Returns `false` if the rate is outside of
+     * `min_analysis_rate` and `max_analysis_rate`.
+     */
+    bool set_analysis_rate(size_t samples_per_second);
+    static constexpr size_t min_analysis_rate = 8000;
+    static constexpr size_t max_analysis_rate = 192000;
+    /**
+     * Set how long after `get()` the frame is expected to be seen, relative to when its
+     * audio is heard. If the audio input reports capture times, `get()` then uses the
+     * audio captured at that point, or the latest there is if that's still in the
+     * future. Returns `false` if the offset is beyond `max_presentation_offset_ms`.
+     */
+    bool set_presentation_offset(double offset_ms);
+    static constexpr double max_presentation_offset_ms = 10000.0;
+    /**
+     * Set the frequency bands in `levels`, band `i` spans from `band_edges_hz[i]` to
+     * `band_edges_hz[i + 1]`. The envelopes rise towards a higher level with a time
+     * constant of `attack_ms` and fall with one of `decay_ms`. Takes effect on the next
+     * `get()`. Returns `false` if there are more than `Audio_Levels::max_bands` bands,
+     * the edges aren't increasing, or a time is negative.
+     */
+    bool set_bands(const double* band_edges_hz,
+                   size_t num_bands,
+                   double attack_ms,
+                   double decay_ms);
+    /**
+     * Set which `Audio_Dependency` data `get()` needs to provide from now on. Anything
+     * not included is left stale. Defaults to `AUDIO_DEPENDS_ALL`.
+     */
+    void set_dependencies(uint32_t dependencies);
+    /**
+     * Set the number of samples per chunk to ask the audio input for, at 48kHz, or 0
+     * for the device's default. Restarts the audio input if it's running. Returns
+     * `false` if the number is above `max_input_latency_samples`.
+     */
+    bool set_input_latency(uint32_t latency_samples);
+    static constexpr uint32_t max_input_latency_samples = 8192;
+    // Calculate the tempo and beat phase as of the latest audio.
+    void current_tempo(AVS_Audio_Tempo* tempo_out) const;
+    // Fill in the audio input's fields of `stats_out`.
+    void input_stats(AVS_Audio_Input_Stats* stats_out) const;
     static void capture_handler(void* data,
                                 AudioFrame* audio,
                                 size_t samples_per_second,
-                                uint32_t num_samples);
+                                uint32_t num_samples,
+                                int64_t capture_time_us);
     void audio_in_start();
     void audio_in_stop();
 
     AudioChannels osc{};
     AudioChannels spec{};
+    // `osc` and `spec` as 8-bit values, in the layout legacy effects expect.
+    char visdata[2][2][AUDIO_BUFFER_LEN] = {};
+    Audio_Levels levels{};
+    AVS_Audio_Tempo tempo{};
     bool is_beat = false;
-    void to_legacy_visdata(char visdata[2][2][AUDIO_BUFFER_LEN]);
+    /**
+     * Run onset detection on incoming audio, and set `is_beat` in `get()` if there
+     * was an onset since the previous call. For AVS_BEAT_INTERNAL. Detection is paused
+     * while the dependencies don't include `AUDIO_DEPENDS_BEAT`.
+     */
+    std::atomic<bool> beat_detection_enabled{false};
+    /**
+     * Also set `is_beat` when the tempo tracker expected a beat, but none was detected.
+     * Only with `beat_detection_enabled`.
+     */
+    std::atomic<bool> beat_prediction_enabled{false};
+    // Track the tempo even while the dependencies don't include `AUDIO_DEPENDS_TEMPO`.
+    std::atomic<bool> tempo_tracking_enabled{false};
 
    private:
     int32_t samples_remaining(int64_t relative_to) const;
+    void detect_beats(size_t num_samples, size_t samples_per_second);
+    bool predicted_beat_missed();
+    void update_rates(size_t samples_per_second);
+    void read_latest(size_t num_samples, int64_t until_time_samples);
+    void update_visdata(uint32_t dependencies);
+    void update_levels(int64_t time_in_ms);
+    void update_input_stats(uint32_t num_samples,
+                            size_t samples_per_second,
+                            int64_t capture_time_us);
 
-    lock_t* lock = nullptr;
     AVS_Audio_Input* audio_in = nullptr;
-    /** audio data ring buffer */
-    std::vector<AudioFrame> buffer;
-    /** index of the latest audio sample */
-    size_t write_head;
-    int64_t latest_sample_time;
-    size_t samples_per_second;
-    FFT* fft;
+    std::atomic<uint32_t> input_latency_samples;
+    /**
+     * Written by the audio input's thread, read by `input_stats()`. Jitter is the
+     * difference between the time between two chunks of audio and the length of the
+     * first one, i.e. how irregularly chunks arrive.
+     */
+    std::atomic<uint64_t> input_num_xruns{0};
+    std::atomic<uint32_t> input_chunk_length{0};
+    std::atomic<int64_t> input_jitter_us{0};
+    std::atomic<int64_t> input_max_jitter_us{0};
+    // Only touched by the audio input's thread.
+    int64_t last_chunk_time_us = -1;
+    int64_t last_chunk_duration_us = 0;
+    int64_t last_capture_time_us = -1;
+    /**
+     * Audio data, written by either `set()` or the audio input's capture thread, and
+     * read by `get()` on the render thread.
+     */
+    Audio_Ring ring;
+    // In samples at the input rate, `samples_per_second`.
+    std::atomic<int64_t> latest_sample_time;
+    std::atomic<size_t> samples_per_second;
+    /**
+     * Input is converted to a fixed rate before it's written to the ring, so that the
+     * analysis, and the layout of the spectrum in particular, doesn't depend on what
+     * the audio source happens to run at. Only touched by the producer.
+     */
+    Resampler resampler;
+    std::atomic<size_t> requested_analysis_rate;
+    // The rate of the samples in the ring.
+    std::atomic<size_t> analysis_rate;
+    /**
+     * The `timer_us()` time at which ring position 0 would have been captured, going
+     * back from the latest capture time at the analysis rate. A single value, so that
+     * `get()` can't see a time and a ring position that don't belong together.
+     * `capture_time_unknown` for audio without capture times.
+     */
+    std::atomic<int64_t> capture_time_origin_us;
+    static constexpr int64_t capture_time_unknown = INT64_MIN;
+    std::atomic<int64_t> presentation_offset_us{0};
+
+    void resize_spectrum(size_t fft_size, AVS_Spectrum_Window window);
+    void spectrum_to_legacy_bins(const float* spectrum, float* legacy_bins_out) const;
+    std::atomic<size_t> requested_fft_size;
+    std::atomic<int> requested_window;
+    Stereo_FFT fft;
+    // The latest `max(fft.size(), AUDIO_BUFFER_LEN)` samples, `osc` is the end of it.
+    std::vector<float> analysis_left;
+    std::vector<float> analysis_right;
+    std::vector<float> spectrum_left;
+    std::vector<float> spectrum_right;
+    /**
+     * Each of the AUDIO_BUFFER_LEN bins in `spec` covers an equal part of the range
+     * from 0Hz to half the sample rate. If that's less than one FFT bin wide, it's
+     * interpolated between `first` and `first + 1` at `fraction`, otherwise it's the
+     * maximum of FFT bins `first` through `last`.
+     */
+    struct Legacy_Bin {
+        uint32_t first;
+        uint32_t last;
+        float fraction;
+    };
+    std::vector<Legacy_Bin> legacy_bins;
+    std::atomic<uint32_t> dependencies;
+
+    struct Bands_Config {
+        size_t num_bands;
+        double edges_hz[Audio_Levels::max_bands + 1];
+        double attack_ms;
+        double decay_ms;
+    };
+    Bands_Config bands_config;
+    // Written by `set_bands()`, taken over in `get()` if `bands_config_changed`.
+    Bands_Config requested_bands_config;
+    std::atomic<bool> bands_config_changed{false};
+    lock_t* bands_lock;
+    int64_t last_levels_time_ms = -1;
+
+    Beat_Detector beat_detector;
+    // Only touched by the producer, to restart detection after it was paused.
+    bool beat_detector_paused = false;
+    uint64_t last_num_onsets = 0;
+    // The stream position of the latest predicted beat `predicted_beat_missed()` saw.
+    double last_predicted_beat_time = -INFINITY;
 };
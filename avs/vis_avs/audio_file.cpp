@@ -0,0 +1,572 @@
+#include "audio_file.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifndef NO_FFMPEG
+#include "video_libav.h"
+#endif
+
+// The number of samples the decoding thread decodes at once.
+#define AUDIO_FILE_CHUNK_LENGTH 4096
+/**
+ * Decoding audio is much faster than realtime, so the reader should practically never
+ * have to wait long. But with a slow disk or network share it might, so be as generous
+ * as `AVS_Video` is with frames.
+ */
+#define WAIT_SAMPLES_AVAILABLE        20000
+#define WAIT_SPACE_OR_STOP            500
+#define WAIT_DECODING_THREAD_FINISH   WAIT_SPACE_OR_STOP * 2
+
+#ifndef NO_FFMPEG
+// Hide libav types in here so that audio_file.h doesn't have to include libav headers.
+// The library functions themselves are shared with `AVS_Video`.
+struct Audio_File::LibAV_Audio {
+    AVFormatContext* demuxer = NULL;
+    AVCodecContext* decoder = NULL;
+    AVFrame* frame = NULL;
+    AVPacket* packet = NULL;
+    int32_t stream = -1;
+    bool flushing = false;
+};
+#endif
+
+static uint16_t read_le16(const uint8_t* data) {
+    return (uint16_t)(data[0] | (data[1] << 8));
+}
+
+static uint32_t read_le32(const uint8_t* data) {
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16)
+           | ((uint32_t)data[3] << 24);
+}
+
+Audio_File::Audio_File(const char* filename) : error(NULL), filename(filename) {
+    if (!this->open_wav()) {
+#ifndef NO_FFMPEG
+        if (this->error != NULL || !this->open_libav()) {
+            if (this->error == NULL) {
+                this->error = "unsupported audio file";
+            }
+            return;
+        }
+#else
+        if (this->error == NULL) {
+            this->error = "unsupported audio file (only WAV without libav)";
+        }
+        return;
+#endif
+    }
+    if (this->sample_rate == 0 || this->num_channels == 0) {
+        this->error = "invalid sample rate or channel count";
+        return;
+    }
+    this->buffer_length = this->sample_rate * Audio_File::read_ahead_seconds;
+    this->buffer_left.resize(this->buffer_length);
+    this->buffer_right.resize(this->buffer_length);
+    this->chunk_left.resize(AUDIO_FILE_CHUNK_LENGTH);
+    this->chunk_right.resize(AUDIO_FILE_CHUNK_LENGTH);
+    this->buffer_lock = lock_init();
+    this->space_available = signal_create_single();
+    this->samples_available = signal_create_single();
+    this->stop_decoding = signal_create_single();
+    this->decoding_thread = thread_create(decode_thread_func, this);
+}
+
+Audio_File::~Audio_File() {
+    if (this->decoding_thread != NULL) {
+        signal_set(this->stop_decoding);
+        thread_join(this->decoding_thread, WAIT_DECODING_THREAD_FINISH);
+        thread_destroy(this->decoding_thread);
+        signal_destroy(this->space_available);
+        signal_destroy(this->samples_available);
+        signal_destroy(this->stop_decoding);
+        lock_destroy(this->buffer_lock);
+    }
+    if (this->wav_file != NULL) {
+        fclose(this->wav_file);
+    }
+#ifndef NO_FFMPEG
+    this->close_libav();
+#endif
+}
+
+bool Audio_File::open_wav() {
+    this->wav_file = fopen(this->filename.c_str(), "rb");
+    if (this->wav_file == NULL) {
+        this->error = "cannot open file";
+        return false;
+    }
+    uint8_t header[12];
+    if (fread(header, 1, sizeof(header), this->wav_file) != sizeof(header)
+        || memcmp(header, "RIFF", 4) != 0 || memcmp(&header[8], "WAVE", 4) != 0) {
+        fclose(this->wav_file);
+        this->wav_file = NULL;
+        return false;
+    }
+    bool have_format = false;
+    uint8_t chunk_header[8];
+    while (fread(chunk_header, 1, sizeof(chunk_header), this->wav_file)
+           == sizeof(chunk_header)) {
+        uint32_t chunk_size = read_le32(&chunk_header[4]);
+        if (memcmp(chunk_header, "fmt ", 4) == 0 && !have_format) {
+            // WAVEFORMATEXTENSIBLE is 40 bytes, the plain WAVEFORMAT(EX) is shorter.
+            uint8_t format[40] = {};
+            size_t format_length = chunk_size < sizeof(format) ? chunk_size : 40;
+            if (chunk_size < 16
+                || fread(format, 1, format_length, this->wav_file) != format_length) {
+                break;
+            }
+            fseek(this->wav_file,
+                  (long)(chunk_size - format_length + (chunk_size & 1)),
+                  SEEK_CUR);
+            uint16_t format_tag = read_le16(&format[0]);
+            uint16_t bits_per_sample = read_le16(&format[14]);
+            if (format_tag == 0xfffe /* WAVE_FORMAT_EXTENSIBLE */ && chunk_size >= 40) {
+                // The first two bytes of the sub-format GUID are the actual format.
+                format_tag = read_le16(&format[24]);
+            }
+            if (format_tag == 1 /* WAVE_FORMAT_PCM */) {
+                switch (bits_per_sample) {
+                    case 8: this->wav_sample_type = SAMPLE_U8; break;
+                    case 16: this->wav_sample_type = SAMPLE_S16; break;
+                    case 24: this->wav_sample_type = SAMPLE_S24; break;
+                    case 32: this->wav_sample_type = SAMPLE_S32; break;
+                    default: return this->close_wav_unsupported();
+                }
+            } else if (format_tag == 3 /* WAVE_FORMAT_IEEE_FLOAT */) {
+                switch (bits_per_sample) {
+                    case 32: this->wav_sample_type = SAMPLE_F32; break;
+                    case 64: this->wav_sample_type = SAMPLE_F64; break;
+                    default: return this->close_wav_unsupported();
+                }
+            } else {
+                // Compressed WAV files, e.g. ADPCM, are left to libav.
+                return this->close_wav_unsupported();
+            }
+            this->num_channels = read_le16(&format[2]);
+            this->sample_rate = read_le32(&format[4]);
+            have_format = true;
+        } else if (memcmp(chunk_header, "data", 4) == 0) {
+            if (!have_format) {
+                break;
+            }
+            // Files written while streaming may not have the final size in the header.
+            this->wav_data_remaining =
+                chunk_size == 0 || chunk_size == 0xffffffff ? SIZE_MAX : chunk_size;
+            this->wav_chunk.resize(AUDIO_FILE_CHUNK_LENGTH * this->num_channels
+                                   * Audio_File::sample_size(this->wav_sample_type));
+            return true;
+        } else {
+            fseek(this->wav_file, (long)(chunk_size + (chunk_size & 1)), SEEK_CUR);
+        }
+    }
+    this->error = "invalid WAV file";
+    fclose(this->wav_file);
+    this->wav_file = NULL;
+    return false;
+}
+
+bool Audio_File::close_wav_unsupported() {
+    fclose(this->wav_file);
+    this->wav_file = NULL;
+    this->num_channels = 0;
+    this->sample_rate = 0;
+    return false;
+}
+
+size_t Audio_File::sample_size(Sample_Type type) {
+    switch (type) {
+        case SAMPLE_U8: return 1;
+        case SAMPLE_S16: return 2;
+        case SAMPLE_S24: return 3;
+        case SAMPLE_S32: return 4;
+        case SAMPLE_F32: return 4;
+        case SAMPLE_F64: return 8;
+    }
+    return 0;
+}
+
+float Audio_File::sample_to_float(const uint8_t* data, size_t index, Sample_Type type) {
+    switch (type) {
+        case SAMPLE_U8: return ((float)data[index] - 128.0f) / 128.0f;
+        case SAMPLE_S16: {
+            int16_t value;
+            memcpy(&value, &data[index * 2], sizeof(value));
+            return (float)value / 32768.0f;
+        }
+        case SAMPLE_S24: {
+            const uint8_t* bytes = &data[index * 3];
+            auto value = (int32_t)(((uint32_t)bytes[0] << 8)
+                                   | ((uint32_t)bytes[1] << 16)
+                                   | ((uint32_t)bytes[2] << 24));
+            return (float)value / 2147483648.0f;
+        }
+        case SAMPLE_S32: {
+            int32_t value;
+            memcpy(&value, &data[index * 4], sizeof(value));
+            return (float)value / 2147483648.0f;
+        }
+        case SAMPLE_F32: {
+            float value;
+            memcpy(&value, &data[index * 4], sizeof(value));
+            return value;
+        }
+        case SAMPLE_F64: {
+            double value;
+            memcpy(&value, &data[index * 8], sizeof(value));
+            return (float)value;
+        }
+    }
+    return 0.0f;
+}
+
+/**
+ * Convert `length` samples of interleaved `num_channels`-channel audio into float. The
+ * first channel goes into `left`, the second one into `right`. Mono is copied to both.
+ */
+void Audio_File::deinterleave(const uint8_t* data,
+                              Sample_Type type,
+                              size_t num_channels,
+                              size_t length,
+                              float* left,
+                              float* right) {
+    size_t right_channel = num_channels > 1 ? 1 : 0;
+    for (size_t i = 0; i < length; i++) {
+        left[i] = Audio_File::sample_to_float(data, i * num_channels, type);
+        right[i] =
+            Audio_File::sample_to_float(data, i * num_channels + right_channel, type);
+    }
+}
+
+bool Audio_File::decode_wav(float* left,
+                            float* right,
+                            size_t max_samples,
+                            size_t& length_out) {
+    size_t frame_size =
+        this->num_channels * Audio_File::sample_size(this->wav_sample_type);
+    size_t max_bytes = max_samples * frame_size;
+    if (max_bytes > this->wav_data_remaining) {
+        max_bytes = this->wav_data_remaining - this->wav_data_remaining % frame_size;
+    }
+    size_t bytes_read = fread(this->wav_chunk.data(), 1, max_bytes, this->wav_file);
+    length_out = bytes_read / frame_size;
+    this->wav_data_remaining -= bytes_read;
+    Audio_File::deinterleave(this->wav_chunk.data(),
+                             this->wav_sample_type,
+                             this->num_channels,
+                             length_out,
+                             left,
+                             right);
+    return bytes_read == max_bytes && this->wav_data_remaining >= frame_size;
+}
+
+#ifndef NO_FFMPEG
+bool Audio_File::open_libav() {
+    AVS_Video::LibAV libav;
+    if (!libav.loaded) {
+        this->error = !AVS_Video::LibAV::load_error.empty()
+                          ? AVS_Video::LibAV::load_error.c_str()
+                          : "libav not loaded";
+        return false;
+    }
+    using LibAV = AVS_Video::LibAV;
+    this->av = new LibAV_Audio();
+    this->av->demuxer = LibAV::alloc_context();
+    if (!this->av->demuxer) {
+        this->error = "demuxer context alloc failed";
+        return false;
+    }
+    if (LibAV::open_input(&this->av->demuxer, this->filename.c_str(), NULL, NULL)
+        != 0) {
+        // `avformat_open_input()` frees the context on failure.
+        this->av->demuxer = NULL;
+        this->error = "open input failed";
+        return false;
+    }
+    if (LibAV::find_stream_info(this->av->demuxer, NULL) < 0) {
+        this->error = "reading stream info failed";
+        return false;
+    }
+    this->av->stream =
+        LibAV::find_best_stream(this->av->demuxer, AVMEDIA_TYPE_AUDIO, -1, -1, NULL, 0);
+    if (this->av->stream < 0) {
+        this->error = "no audio stream found";
+        return false;
+    }
+    AVCodecParameters* codec_params =
+        this->av->demuxer->streams[this->av->stream]->codecpar;
+    const AVCodec* codec = LibAV::find_decoder(codec_params->codec_id);
+    if (codec == NULL) {
+        this->error = "no decoder for audio codec";
+        return false;
+    }
+    this->av->decoder = LibAV::alloc_context3(codec);
+    if (!this->av->decoder) {
+        this->error = "decoder context alloc failed";
+        return false;
+    }
+    if (LibAV::parameters_to_context(this->av->decoder, codec_params) < 0) {
+        this->error = "decoder context init failed";
+        return false;
+    }
+    if (LibAV::open2(this->av->decoder, codec, NULL) < 0) {
+        this->error = "decoder open failed";
+        return false;
+    }
+    this->av->packet = LibAV::packet_alloc();
+    this->av->frame = LibAV::frame_alloc();
+    if (!this->av->packet || !this->av->frame) {
+        this->error = "cannot allocate decoder packet or frame";
+        return false;
+    }
+    this->sample_rate = this->av->decoder->sample_rate;
+    this->num_channels = this->av->decoder->ch_layout.nb_channels;
+    return true;
+}
+
+void Audio_File::close_libav() {
+    if (this->av == NULL) {
+        return;
+    }
+    using LibAV = AVS_Video::LibAV;
+    LibAV::free_context(&this->av->decoder);
+    LibAV::frame_free(&this->av->frame);
+    LibAV::packet_free(&this->av->packet);
+    if (this->av->demuxer != NULL) {
+        LibAV::close_input(&this->av->demuxer);  // also frees the context
+    }
+    delete this->av;
+    this->av = NULL;
+}
+
+bool Audio_File::decode_libav(float* left,
+                              float* right,
+                              size_t max_samples,
+                              size_t& length_out) {
+    using LibAV = AVS_Video::LibAV;
+    length_out = 0;
+    while (length_out < max_samples) {
+        if (this->av_frame_offset < (size_t)this->av->frame->nb_samples) {
+            length_out += this->convert_libav_frame(
+                &left[length_out], &right[length_out], max_samples - length_out);
+            continue;
+        }
+        LibAV::frame_unref(this->av->frame);
+        this->av_frame_offset = 0;
+        int result = LibAV::receive_frame(this->av->decoder, this->av->frame);
+        if (result == 0) {
+            continue;
+        }
+        if (result != AVERROR(EAGAIN)) {
+            // Either the end of the file or a decoding error, stop either way.
+            return false;
+        }
+        if (this->av->flushing) {
+            return false;
+        }
+        if (LibAV::read_frame(this->av->demuxer, this->av->packet) < 0) {
+            // Get the last frames out of the decoder.
+            LibAV::send_packet(this->av->decoder, NULL);
+            this->av->flushing = true;
+            continue;
+        }
+        if (this->av->packet->stream_index == this->av->stream) {
+            LibAV::send_packet(this->av->decoder, this->av->packet);
+        }
+        LibAV::packet_unref(this->av->packet);
+    }
+    return true;
+}
+
+size_t Audio_File::convert_libav_frame(float* left, float* right, size_t max_samples) {
+    AVFrame* frame = this->av->frame;
+    size_t length = (size_t)frame->nb_samples - this->av_frame_offset;
+    length = length < max_samples ? length : max_samples;
+    size_t num_channels = frame->ch_layout.nb_channels;
+    Sample_Type type;
+    switch (frame->format) {
+        case AV_SAMPLE_FMT_U8:
+        case AV_SAMPLE_FMT_U8P: type = SAMPLE_U8; break;
+        case AV_SAMPLE_FMT_S16:
+        case AV_SAMPLE_FMT_S16P: type = SAMPLE_S16; break;
+        case AV_SAMPLE_FMT_S32:
+        case AV_SAMPLE_FMT_S32P: type = SAMPLE_S32; break;
+        case AV_SAMPLE_FMT_FLT:
+        case AV_SAMPLE_FMT_FLTP: type = SAMPLE_F32; break;
+        case AV_SAMPLE_FMT_DBL:
+        case AV_SAMPLE_FMT_DBLP: type = SAMPLE_F64; break;
+        default:
+            // 64-bit integer samples, which no common codec decodes to.
+            memset(left, 0, length * sizeof(float));
+            memset(right, 0, length * sizeof(float));
+            this->av_frame_offset += length;
+            return length;
+    }
+    size_t offset_bytes = this->av_frame_offset * Audio_File::sample_size(type);
+    bool is_planar = frame->format >= AV_SAMPLE_FMT_U8P;
+    if (is_planar) {
+        const uint8_t* left_data = frame->extended_data[0] + offset_bytes;
+        const uint8_t* right_data =
+            frame->extended_data[num_channels > 1 ? 1 : 0] + offset_bytes;
+        for (size_t i = 0; i < length; i++) {
+            left[i] = Audio_File::sample_to_float(left_data, i, type);
+            right[i] = Audio_File::sample_to_float(right_data, i, type);
+        }
+    } else {
+        Audio_File::deinterleave(frame->extended_data[0] + offset_bytes * num_channels,
+                                 type,
+                                 num_channels,
+                                 length,
+                                 left,
+                                 right);
+    }
+    this->av_frame_offset += length;
+    return length;
+}
+#endif
+
+uint32_t Audio_File::decode_thread_func(void* this_file) {
+    auto file = (Audio_File*)this_file;
+    while (file->decode_chunk()) {
+        ;
+    }
+    return 0;
+}
+
+/**
+ * Decode the next chunk of samples into the read-ahead buffer, if there's space for it.
+ * Otherwise wait until `read()` frees up some space, or the file is closed. Returns
+ * false once decoding is finished.
+ */
+bool Audio_File::decode_chunk() {
+    if (signal_wait(this->stop_decoding, 0) != NULL) {
+        return false;
+    }
+    signal_unset(this->space_available);
+    lock_lock(this->buffer_lock);
+    auto free_space =
+        this->buffer_length - (size_t)(this->buffer_end - this->buffer_start);
+    lock_unlock(this->buffer_lock);
+    if (free_space < AUDIO_FILE_CHUNK_LENGTH) {
+        signal_t* space_available_or_stop[2] = {this->space_available,
+                                                this->stop_decoding};
+        auto signalled =
+            signal_wait_any(space_available_or_stop, 2, WAIT_SPACE_OR_STOP);
+        return signalled != this->stop_decoding;
+    }
+
+    size_t length = 0;
+    bool has_more;
+    if (this->wav_file != NULL) {
+        has_more = this->decode_wav(this->chunk_left.data(),
+                                    this->chunk_right.data(),
+                                    AUDIO_FILE_CHUNK_LENGTH,
+                                    length);
+    } else {
+#ifndef NO_FFMPEG
+        has_more = this->decode_libav(this->chunk_left.data(),
+                                      this->chunk_right.data(),
+                                      AUDIO_FILE_CHUNK_LENGTH,
+                                      length);
+#else
+        has_more = false;
+#endif
+    }
+
+    lock_lock(this->buffer_lock);
+    for (size_t i = 0; i < length; i++) {
+        size_t index = (size_t)((this->buffer_end + (int64_t)i) % this->buffer_length);
+        this->buffer_left[index] = this->chunk_left[i];
+        this->buffer_right[index] = this->chunk_right[i];
+    }
+    this->buffer_end += (int64_t)length;
+    this->end_of_file = !has_more;
+    lock_unlock(this->buffer_lock);
+    signal_set(this->samples_available);
+    if (!has_more) {
+        signal_wait(this->stop_decoding, WAIT_INFINITE);
+        return false;
+    }
+    return true;
+}
+
+size_t Audio_File::read(int64_t position,
+                        float* left,
+                        float* right,
+                        size_t num_samples) {
+    if (this->error != NULL) {
+        memset(left, 0, num_samples * sizeof(float));
+        memset(right, 0, num_samples * sizeof(float));
+        return 0;
+    }
+    if (num_samples > this->buffer_length) {
+        // More than the read-ahead buffer can hold, only the end can be read.
+        size_t skip = num_samples - this->buffer_length;
+        memset(left, 0, skip * sizeof(float));
+        memset(right, 0, skip * sizeof(float));
+        position += (int64_t)skip;
+        left += skip;
+        right += skip;
+        num_samples = this->buffer_length;
+    }
+    int64_t end = position + (int64_t)num_samples;
+    while (true) {
+        signal_unset(this->samples_available);
+        lock_lock(this->buffer_lock);
+        // Samples before `position` are never read again, make room for new ones.
+        if (position > this->buffer_start) {
+            this->buffer_start =
+                position < this->buffer_end ? position : this->buffer_end;
+        }
+        bool is_available = this->buffer_end >= end || this->end_of_file;
+        if (is_available) {
+            break;
+        }
+        lock_unlock(this->buffer_lock);
+        signal_set(this->space_available);
+        if (signal_wait(this->samples_available, WAIT_SAMPLES_AVAILABLE) == NULL) {
+            log_warn("%s: timeout waiting for audio samples", this->filename.c_str());
+            lock_lock(this->buffer_lock);
+            break;
+        }
+    }
+    // Still holding `buffer_lock` here.
+    size_t num_copied = this->copy_from_buffer(position, left, right, num_samples);
+    if (end > this->buffer_start) {
+        this->buffer_start = end < this->buffer_end ? end : this->buffer_end;
+    }
+    lock_unlock(this->buffer_lock);
+    signal_set(this->space_available);
+    return num_copied;
+}
+
+/**
+ * Copy whatever part of `position` to `position + length` is in the buffer, and fill
+ * the rest with silence. `buffer_lock` must be held.
+ */
+size_t Audio_File::copy_from_buffer(int64_t position,
+                                    float* left,
+                                    float* right,
+                                    size_t length) {
+    int64_t end = position + (int64_t)length;
+    int64_t copy_start = position > this->buffer_start ? position : this->buffer_start;
+    int64_t copy_end = end < this->buffer_end ? end : this->buffer_end;
+    if (copy_end <= copy_start) {
+        memset(left, 0, length * sizeof(float));
+        memset(right, 0, length * sizeof(float));
+        return 0;
+    }
+    auto silence_before = (size_t)(copy_start - position);
+    auto num_copied = (size_t)(copy_end - copy_start);
+    memset(left, 0, silence_before * sizeof(float));
+    memset(right, 0, silence_before * sizeof(float));
+    for (size_t i = 0; i < num_copied; i++) {
+        size_t index = (size_t)((copy_start + (int64_t)i) % this->buffer_length);
+        left[silence_before + i] = this->buffer_left[index];
+        right[silence_before + i] = this->buffer_right[index];
+    }
+    size_t silence_after = length - silence_before - num_copied;
+    memset(&left[silence_before + num_copied], 0, silence_after * sizeof(float));
+    memset(&right[silence_before + num_copied], 0, silence_after * sizeof(float));
+    return num_copied;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "../platform.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+/**
+ * Audio from a file, for AVS_AUDIO_FILE.
+ *
+ * WAV files (integer PCM of 8 to 32 bits, or 32/64-bit float) are read directly. Any
+ * other format is decoded with libav, unless AVS was compiled with NO_FFMPEG. Only the
+ * first two channels are used, mono files are played on both.
+ *
+ * A background thread decodes the file into a read-ahead buffer of
+ * `read_ahead_seconds`, and `read()` takes samples out of it at any position at or
+ * after the previous read. Rendering faster than realtime therefore only waits for the
+ * decoder if it has fallen behind, and decoding never runs far ahead.
+ */
+class Audio_File {
+   public:
+    static constexpr size_t read_ahead_seconds = 10;
+
+    explicit Audio_File(const char* filename);
+    ~Audio_File();
+    Audio_File(const Audio_File&) = delete;
+    Audio_File& operator=(const Audio_File&) = delete;
+
+    // NULL if the file was opened successfully, otherwise a short error message.
+    const char* error;
+    size_t samples_per_second() const { return this->sample_rate; }
+    /**
+     * Copy `num_samples` samples, starting `position` samples into the file, into
+     * `left` and `right`. Waits for the decoder if needed. Anything beyond the end of
+     * the file, or before the previous read, is silence. Returns the number of samples
+     * actually from the file.
+     */
+    size_t read(int64_t position, float* left, float* right, size_t num_samples);
+
+   private:
+    bool open_wav();
+    bool close_wav_unsupported();
+    bool decode_wav(float* left, float* right, size_t max_samples, size_t& length_out);
+    static uint32_t decode_thread_func(void* this_file);
+    bool decode_chunk();
+    size_t copy_from_buffer(int64_t position, float* left, float* right, size_t length);
+
+    std::string filename;
+    size_t sample_rate = 0;
+    size_t num_channels = 0;
+
+    enum Sample_Type {
+        SAMPLE_U8,
+        SAMPLE_S16,
+        SAMPLE_S24,
+        SAMPLE_S32,
+        SAMPLE_F32,
+        SAMPLE_F64,
+    };
+    static size_t sample_size(Sample_Type type);
+    static float sample_to_float(const uint8_t* data, size_t index, Sample_Type type);
+    static void deinterleave(const uint8_t* data,
+                             Sample_Type type,
+                             size_t num_channels,
+                             size_t length,
+                             float* left,
+                             float* right);
+
+    FILE* wav_file = NULL;
+    Sample_Type wav_sample_type = SAMPLE_S16;
+    size_t wav_data_remaining = 0;
+    std::vector<uint8_t> wav_chunk;
+
+#ifndef NO_FFMPEG
+    bool open_libav();
+    void close_libav();
+    bool decode_libav(float* left,
+                      float* right,
+                      size_t max_samples,
+                      size_t& length_out);
+    size_t convert_libav_frame(float* left, float* right, size_t max_samples);
+    struct LibAV_Audio;
+    LibAV_Audio* av = NULL;
+    // The number of samples of the current libav frame already converted.
+    size_t av_frame_offset = 0;
+#endif
+
+    /**
+     * The read-ahead buffer is a ring of `buffer_length` samples, holding the file's
+     * samples from `buffer_start` up to, but not including, `buffer_end`.
+     */
+    std::vector<float> buffer_left;
+    std::vector<float> buffer_right;
+    size_t buffer_length = 0;
+    int64_t buffer_start = 0;
+    int64_t buffer_end = 0;
+    bool end_of_file = false;
+    // Only used by the decoding thread, to decode into before moving into the buffer.
+    std::vector<float> chunk_left;
+    std::vector<float> chunk_right;
+
+    thread_t* decoding_thread = NULL;
+    lock_t* buffer_lock = NULL;
+    signal_t* space_available = NULL;
+    signal_t* samples_available = NULL;
+    signal_t* stop_decoding = NULL;
+};
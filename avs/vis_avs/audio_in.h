@@ -11,12 +11,25 @@ struct AudioFrame {
 };
 
 typedef void AVS_Audio_Input;
+/**
+ * Called from the audio input's thread with each chunk of captured audio.
+ * `capture_time_us` is the `timer_us()` time at which the last of the samples was
+ * captured by the device, or < 0 if the input can't tell.
+ */
 typedef void (*avs_audio_input_handler)(void* data,
                                         AudioFrame* audio,
                                         size_t samples_per_second,
-                                        uint32_t num_samples);
+                                        uint32_t num_samples,
+                                        int64_t capture_time_us);
 
-AVS_Audio_Input* audio_in_start(avs_audio_input_handler callback, void* data);
+/**
+ * Start capturing audio. The handler is called with stereo audio, inputs with other
+ * channel counts are mixed down. `latency_samples` is the number of samples per chunk
+ * to ask the device for, at 48kHz, or 0 for the device's default.
+ */
+AVS_Audio_Input* audio_in_start(avs_audio_input_handler callback,
+                                void* data,
+                                uint32_t latency_samples);
 void audio_in_stop(AVS_Audio_Input* audio_in);
 std::vector<std::string> audio_in_devices();
 bool audio_in_select_device(uint32_t device_index);
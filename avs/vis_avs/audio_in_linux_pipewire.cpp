@@ -8,42 +8,200 @@
 #include <math.h>
 #include <signal.h>
 #include <stdio.h>
+#include <time.h>
 
 #include <pipewire/pipewire.h>
 #include <spa/param/audio/format-utils.h>
 
+/**
+ * Estimate when the latest samples of the stream were captured, in `timer_us()` time.
+ * PipeWire timestamps graph cycles with the monotonic clock and reports how long
+ * samples took to get from the device to the stream. Returns -1 if that's unknown.
+ */
+static int64_t capture_time_us(LibPipewire* pw) {
+    struct pw_time time = {};
+    if (pw->stream_get_time_n(pw->stream, &time, sizeof(time)) < 0 || time.now == 0
+        || time.rate.denom == 0) {
+        return -1;
+    }
+    struct timespec now;
+    if (clock_gettime(CLOCK_MONOTONIC, &now) != 0) {
+        return -1;
+    }
+    int64_t now_ns = (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+    int64_t delay_ns =
+        time.delay * 1000000000 * (int64_t)time.rate.num / (int64_t)time.rate.denom;
+    // Samples held back by the stream's own resampler are older still.
+    uint32_t stream_rate = pw->active_format.samples_per_second;
+    if (stream_rate > 0) {
+        delay_ns += (int64_t)time.buffered * 1000000000 / stream_rate;
+    }
+    int64_t age_us = (now_ns - time.now + delay_ns) / 1000;
+    return (int64_t)timer_us() - age_us;
+}
+
+// Mixing down is done in blocks of this many samples, a typical maximum quantum.
+#define PIPEWIRE_DOWNMIX_BLOCK_LENGTH 8192
+
+// Mix `num_samples` samples of `num_channels` interleaved channels down to stereo.
+static void downmix(const LibPipewire::Stream_Format& format,
+                    const float* samples,
+                    uint32_t num_channels,
+                    uint32_t num_samples,
+                    AudioFrame* frames_out) {
+    for (uint32_t i = 0; i < num_samples; i++) {
+        float left = 0.0f;
+        float right = 0.0f;
+        for (uint32_t c = 0; c < num_channels; c++) {
+            left += samples[c] * format.downmix_left[c];
+            right += samples[c] * format.downmix_right[c];
+        }
+        frames_out[i] = {left, right};
+        samples += num_channels;
+    }
+}
+
+// Channels on either side go to that side, LFE channels are dropped, and anything in
+// the middle, or unknown, goes to both sides at -3dB.
+static void set_downmix_gains(const spa_audio_info_raw& info,
+                              LibPipewire::Stream_Format* format) {
+    for (uint32_t c = 0; c < info.channels && c < SPA_AUDIO_MAX_CHANNELS; c++) {
+        float left = (float)M_SQRT1_2;
+        float right = (float)M_SQRT1_2;
+        uint32_t position =
+            info.channels == 1 ? (uint32_t)SPA_AUDIO_CHANNEL_MONO : info.position[c];
+        switch (position) {
+            case SPA_AUDIO_CHANNEL_MONO:
+                left = 1.0f;
+                right = 1.0f;
+                break;
+            case SPA_AUDIO_CHANNEL_FL:
+                left = 1.0f;
+                right = 0.0f;
+                break;
+            case SPA_AUDIO_CHANNEL_FR:
+                left = 0.0f;
+                right = 1.0f;
+                break;
+            case SPA_AUDIO_CHANNEL_SL:
+            case SPA_AUDIO_CHANNEL_RL:
+            case SPA_AUDIO_CHANNEL_FLC:
+            case SPA_AUDIO_CHANNEL_RLC:
+            case SPA_AUDIO_CHANNEL_FLW:
+            case SPA_AUDIO_CHANNEL_TFL:
+            case SPA_AUDIO_CHANNEL_TSL:
+            case SPA_AUDIO_CHANNEL_TRL:
+                right = 0.0f;
+                break;
+            case SPA_AUDIO_CHANNEL_SR:
+            case SPA_AUDIO_CHANNEL_RR:
+            case SPA_AUDIO_CHANNEL_FRC:
+            case SPA_AUDIO_CHANNEL_RRC:
+            case SPA_AUDIO_CHANNEL_FRW:
+            case SPA_AUDIO_CHANNEL_TFR:
+            case SPA_AUDIO_CHANNEL_TSR:
+            case SPA_AUDIO_CHANNEL_TRR:
+                left = 0.0f;
+                break;
+            case SPA_AUDIO_CHANNEL_LFE:
+            case SPA_AUDIO_CHANNEL_LFE2:
+                left = 0.0f;
+                right = 0.0f;
+                break;
+            default: break;
+        }
+        format->downmix_left[c] = left;
+        format->downmix_right[c] = right;
+    }
+}
+
+// Hand a new format over to the data thread. Call from the main loop thread only.
+static void publish_format(LibPipewire* pw, const LibPipewire::Stream_Format& format) {
+    while (true) {
+        // An unused pending format may be overwritten, but not while it's being read.
+        int state = pw->pending_format_state.load(std::memory_order_acquire);
+        if (state != LibPipewire::FORMAT_READING
+            && pw->pending_format_state.compare_exchange_weak(
+                state, LibPipewire::FORMAT_WRITING, std::memory_order_acquire)) {
+            break;
+        }
+    }
+    pw->pending_format = format;
+    pw->pending_format_state.store(LibPipewire::FORMAT_READY,
+                                   std::memory_order_release);
+}
+
+// Pick up a new format, if any. Call from the data thread only, never blocks.
+static void update_active_format(LibPipewire* pw) {
+    int state = LibPipewire::FORMAT_READY;
+    if (pw->pending_format_state.compare_exchange_strong(
+            state, LibPipewire::FORMAT_READING, std::memory_order_acquire)) {
+        pw->active_format = pw->pending_format;
+        pw->pending_format_state.store(LibPipewire::FORMAT_NONE,
+                                       std::memory_order_release);
+    }
+}
+
 static void on_process(void* data) {
     auto pw = (LibPipewire*)data;
     struct pw_buffer* b;
     struct spa_buffer* buf;
-    float *samples, max;
-    uint32_t c, n, n_channels, n_samples, peak;
 
     if (pw->stream == nullptr) {
         return;
     }
+    update_active_format(pw);
 
     if ((b = pw->stream_dequeue_buffer(pw->stream)) == NULL) {
         return;
     }
 
     buf = b->buffer;
-    if ((samples = (float*)buf->datas[0].data) == NULL) {
+    const struct spa_data& buffer_data = buf->datas[0];
+    const auto& format = pw->active_format;
+    uint32_t num_channels = format.channels;
+    uint32_t samples_per_second = format.samples_per_second;
+    if (buffer_data.data == NULL || num_channels == 0
+        || num_channels > SPA_AUDIO_MAX_CHANNELS) {
+        pw->stream_queue_buffer(pw->stream, b);
         return;
     }
+    uint32_t offset = SPA_MIN(buffer_data.chunk->offset, buffer_data.maxsize);
+    uint32_t size = SPA_MIN(buffer_data.chunk->size, buffer_data.maxsize - offset);
+    auto samples = (const float*)SPA_PTROFF(buffer_data.data, offset, void);
+    uint32_t num_samples = size / (sizeof(float) * num_channels);
+    int64_t end_capture_time_us = capture_time_us(pw);
 
-    n_channels = pw->format.info.raw.channels;
-    n_samples = buf->datas[0].chunk->size / sizeof(float);
-
-    pw->user_callback(
-        pw->user_data, (AudioFrame*)samples, pw->format.info.raw.rate, n_samples);
-
-    // for (c = 0; c < pw->format.info.raw.channels; c++) {
-    //     max = 0.0f;
-    //     for (n = c; n < n_samples; n += n_channels) {
-    //         max = fmaxf(max, fabsf(samples[n]));
-    //     }
-    // }
+    if (num_channels == 2) {
+        // Straight from PipeWire's buffer, into the ring.
+        pw->user_callback(pw->user_data,
+                          (AudioFrame*)samples,
+                          samples_per_second,
+                          num_samples,
+                          end_capture_time_us);
+    } else {
+        uint32_t done = 0;
+        while (done < num_samples && !pw->downmix_buffer.empty()) {
+            uint32_t length = SPA_MIN(num_samples - done,
+                                      (uint32_t)pw->downmix_buffer.size());
+            downmix(format,
+                    &samples[done * num_channels],
+                    num_channels,
+                    length,
+                    pw->downmix_buffer.data());
+            done += length;
+            int64_t capture_time = end_capture_time_us;
+            if (capture_time >= 0) {
+                capture_time -= (int64_t)(num_samples - done) * 1000000
+                                / (int64_t)samples_per_second;
+            }
+            pw->user_callback(pw->user_data,
+                              pw->downmix_buffer.data(),
+                              samples_per_second,
+                              length,
+                              capture_time);
+        }
+    }
 
     pw->stream_queue_buffer(pw->stream, b);
 }
@@ -68,6 +226,13 @@ static void on_stream_param_changed(void* data,
     }
 
     spa_format_audio_raw_parse(param, &pw->format.info.raw);
+    LibPipewire::Stream_Format format;
+    format.channels = pw->format.info.raw.channels;
+    format.samples_per_second = pw->format.info.raw.rate;
+    // Normally PipeWire mixes down to the requested stereo itself and `on_process()`
+    // passes the samples through, but be ready for anything else it may negotiate.
+    set_downmix_gains(pw->format.info.raw, &format);
+    publish_format(pw, format);
 }
 
 static const struct pw_stream_events stream_events = {
@@ -76,11 +241,13 @@ static const struct pw_stream_events stream_events = {
     .process = on_process,
 };
 
-AVS_Audio_Input* audio_in_start(avs_audio_input_handler callback, void* data) {
+AVS_Audio_Input* audio_in_start(avs_audio_input_handler callback,
+                                void* data,
+                                uint32_t latency_samples) {
     auto pw = new LibPipewire(callback, data);
     if (!pw->loaded) {
         log_err("failed to load pipewire: %s", pw->load_error.c_str());
-        free(pw);
+        delete pw;
         return nullptr;
     }
     const struct spa_pod* params[1];
@@ -88,6 +255,8 @@ AVS_Audio_Input* audio_in_start(avs_audio_input_handler callback, void* data) {
     struct pw_properties* props;
     struct spa_pod_builder builder = SPA_POD_BUILDER_INIT(buffer, sizeof(buffer));
 
+    // `on_process()` runs in realtime, so don't allocate there.
+    pw->downmix_buffer.resize(PIPEWIRE_DOWNMIX_BLOCK_LENGTH);
     pw->init(0, nullptr);
     pw->loop = pw->thread_loop_new("my thread", NULL);
 
@@ -107,6 +276,12 @@ AVS_Audio_Input* audio_in_start(avs_audio_input_handler callback, void* data) {
                                PW_KEY_MEDIA_ROLE,
                                "Music",
                                nullptr);
+    if (latency_samples > 0) {
+        // PipeWire scales this to the graph's actual rate.
+        char latency[32];
+        snprintf(latency, sizeof(latency), "%u/48000", latency_samples);
+        pw->properties_set(props, PW_KEY_NODE_LATENCY, latency);
+    }
     // uncomment if you want to capture from the sink monitor ports
     // TODO: make input device selectable both from the outside and from the inside
     // pw->properties_set(props, PW_KEY_STREAM_CAPTURE_SINK, "true");
@@ -120,9 +295,12 @@ AVS_Audio_Input* audio_in_start(avs_audio_input_handler callback, void* data) {
 
     /* Make one parameter with the supported formats. The SPA_PARAM_EnumFormat
      * id means that this is a format enumeration (of 1 value).
-     * We leave the channels and rate empty to accept the native graph
-     * rate and channels. */
-    auto info = SPA_AUDIO_INFO_RAW_INIT(.format = SPA_AUDIO_FORMAT_F32);
+     * We leave the rate empty to accept the native graph rate, and ask for
+     * stereo, so that PipeWire does any channel mixing, and buffers can go
+     * straight into the ring. */
+    auto info = SPA_AUDIO_INFO_RAW_INIT(.format = SPA_AUDIO_FORMAT_F32, .channels = 2);
+    info.position[0] = SPA_AUDIO_CHANNEL_FL;
+    info.position[1] = SPA_AUDIO_CHANNEL_FR;
     params[0] = spa_format_audio_raw_build(&builder, SPA_PARAM_EnumFormat, &info);
 
     pw->stream_connect(
@@ -145,12 +323,14 @@ void audio_in_stop(AVS_Audio_Input* audio_in) {
     pw->stream_destroy(pw->stream);
     pw->thread_loop_destroy(pw->loop);
     pw->deinit();
-    free(audio_in);
+    delete pw;
 }
 
 #else  // NO_PIPEWIRE
 
-AVS_Audio_Input* audio_in_start(avs_audio_input_handler, void*) { return nullptr; }
+AVS_Audio_Input* audio_in_start(avs_audio_input_handler, void*, uint32_t) {
+    return nullptr;
+}
 void audio_in_stop(AVS_Audio_Input*) {}
 
 #endif
@@ -1,8 +1,11 @@
 #include "audio_in.h"
 
-AVS_Audio_Input* audio_in_start(avs_audio_input_handler callback, void* data) {
+AVS_Audio_Input* audio_in_start(avs_audio_input_handler callback,
+                                void* data,
+                                uint32_t latency_samples) {
     (void)callback;
     (void)data;
+    (void)latency_samples;
     return nullptr;
 }
 
@@ -16,6 +16,7 @@ bool LibPipewire::load_pipewire_dlib() {
     LOAD_FUNC(LibPipewire, libpipewire, pw, stream_connect);
     LOAD_FUNC(LibPipewire, libpipewire, pw, stream_dequeue_buffer);
     LOAD_FUNC(LibPipewire, libpipewire, pw, stream_destroy);
+    LOAD_FUNC(LibPipewire, libpipewire, pw, stream_get_time_n);
     LOAD_FUNC(LibPipewire, libpipewire, pw, stream_new_simple);
     LOAD_FUNC(LibPipewire, libpipewire, pw, stream_queue_buffer);
     LOAD_FUNC(LibPipewire, libpipewire, pw, thread_loop_destroy);
@@ -36,6 +37,7 @@ DEFINE_FUNC(LibPipewire, pw, properties_set);
 DEFINE_FUNC(LibPipewire, pw, stream_connect);
 DEFINE_FUNC(LibPipewire, pw, stream_dequeue_buffer);
 DEFINE_FUNC(LibPipewire, pw, stream_destroy);
+DEFINE_FUNC(LibPipewire, pw, stream_get_time_n);
 DEFINE_FUNC(LibPipewire, pw, stream_new_simple);
 DEFINE_FUNC(LibPipewire, pw, stream_queue_buffer);
 DEFINE_FUNC(LibPipewire, pw, thread_loop_destroy);
@@ -4,7 +4,9 @@
 
 #include "../platform.h"
 
+#include <atomic>
 #include <string>
+#include <vector>
 
 #include <pipewire/pipewire.h>
 #include <spa/param/audio/format-utils.h>
@@ -21,6 +23,35 @@ struct LibPipewire {
     avs_audio_input_handler user_callback;
     void* user_data;
 
+    // The parts of the negotiated format that `on_process()` needs.
+    struct Stream_Format {
+        uint32_t channels = 0;
+        uint32_t samples_per_second = 0;
+        /**
+         * For streams with other than two channels, the gains with which each channel
+         * is mixed into the left and right channels.
+         */
+        float downmix_left[SPA_AUDIO_MAX_CHANNELS] = {};
+        float downmix_right[SPA_AUDIO_MAX_CHANNELS] = {};
+    };
+    /**
+     * Formats are negotiated on the main loop thread, but samples are processed on the
+     * data thread. A new format is put into `pending_format`, and `on_process()` copies
+     * it over into `active_format`, which only the data thread uses. The state tells
+     * who may access `pending_format`.
+     */
+    enum Format_State {
+        FORMAT_NONE,
+        FORMAT_WRITING,
+        FORMAT_READY,
+        FORMAT_READING,
+    };
+    Stream_Format active_format;
+    Stream_Format pending_format;
+    std::atomic<int> pending_format_state{FORMAT_NONE};
+    // The stereo audio mixed down into. Sized once before the stream starts.
+    std::vector<AudioFrame> downmix_buffer;
+
     static decltype(&pw_deinit) deinit;
     static decltype(&pw_init) init;
     static decltype(&pw_properties_new) properties_new;
@@ -28,6 +59,7 @@ struct LibPipewire {
     static decltype(&pw_stream_connect) stream_connect;
     static decltype(&pw_stream_dequeue_buffer) stream_dequeue_buffer;
     static decltype(&pw_stream_destroy) stream_destroy;
+    static decltype(&pw_stream_get_time_n) stream_get_time_n;
     static decltype(&pw_stream_new_simple) stream_new_simple;
     static decltype(&pw_stream_queue_buffer) stream_queue_buffer;
     static decltype(&pw_thread_loop_destroy) thread_loop_destroy;
@@ -0,0 +1,204 @@
+#include "audio_ring.h"
+
+#include <cstring>
+#ifdef SIMD_MODE_X86_SSE
+#include <immintrin.h>
+#endif
+
+// Give up making a consistent copy after this many attempts, and use the last one.
+#define AUDIO_RING_MAX_READ_ATTEMPTS 4
+
+static size_t next_power_of_2(size_t n) {
+    size_t power = 1;
+    while (power < n) {
+        power <<= 1;
+    }
+    return power;
+}
+
+Audio_Ring::Audio_Ring(size_t min_length)
+    : mask(next_power_of_2(min_length) - 1),
+      left(this->mask + 1, 0.0f),
+      right(this->mask + 1, 0.0f) {}
+
+static void clamp_copy_c(float* dest, const float* src, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        float sample = src[i] > -1.0f ? src[i] : -1.0f;  // Also turns NaN into -1.
+        dest[i] = sample < 1.0f ? sample : 1.0f;
+    }
+}
+
+#ifdef SIMD_MODE_X86_SSE
+static void clamp_copy_x86v128(float* dest, const float* src, size_t length) {
+    const __m128 minus_one = _mm_set1_ps(-1.0f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        // maxps returns the second operand if either one is NaN, like the C version.
+        __m128 sample = _mm_max_ps(_mm_loadu_ps(&src[i]), minus_one);
+        _mm_storeu_ps(&dest[i], _mm_min_ps(sample, one));
+    }
+    clamp_copy_c(&dest[i], &src[i], length - i);
+}
+#endif
+
+static void clamp_copy(float* dest, const float* src, size_t length) {
+#ifdef SIMD_MODE_X86_SSE
+    clamp_copy_x86v128(dest, src, length);
+#else
+    clamp_copy_c(dest, src, length);
+#endif
+}
+
+static void deinterleave_c(float* left,
+                           float* right,
+                           const AudioFrame* frames,
+                           size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        left[i] = frames[i].left;
+        right[i] = frames[i].right;
+    }
+}
+
+#ifdef SIMD_MODE_X86_SSE
+static void deinterleave_x86v128(float* left,
+                                 float* right,
+                                 const AudioFrame* frames,
+                                 size_t length) {
+    auto src = (const float*)frames;
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        __m128 frames01 = _mm_loadu_ps(&src[i * 2]);
+        __m128 frames23 = _mm_loadu_ps(&src[i * 2 + 4]);
+        _mm_storeu_ps(&left[i],
+                      _mm_shuffle_ps(frames01, frames23, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(&right[i],
+                      _mm_shuffle_ps(frames01, frames23, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+    deinterleave_c(&left[i], &right[i], &frames[i], length - i);
+}
+#endif
+
+template <typename Copy_Fn>
+void Audio_Ring::write_segments(size_t num_samples, Copy_Fn copy) {
+    uint64_t head = this->head.load(std::memory_order_relaxed);
+    // Announce the write before touching any samples, so a concurrent reader can tell
+    // if its copy might contain any of them.
+    this->write_end.store(head + num_samples, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    size_t start = head & this->mask;
+    size_t first_length = this->length() - start;
+    if (first_length > num_samples) {
+        first_length = num_samples;
+    }
+    copy(start, 0, first_length);
+    copy(0, first_length, num_samples - first_length);
+    this->head.store(head + num_samples, std::memory_order_release);
+}
+
+void Audio_Ring::write(const float* left, const float* right, size_t num_samples) {
+    if (num_samples > this->length()) {
+        // Only the last `length()` samples would survive anyway.
+        left += num_samples - this->length();
+        right += num_samples - this->length();
+        num_samples = this->length();
+    }
+    this->write_segments(num_samples, [&](size_t dest, size_t src, size_t length) {
+        clamp_copy(&this->left[dest], &left[src], length);
+        clamp_copy(&this->right[dest], &right[src], length);
+    });
+}
+
+void Audio_Ring::write(const AudioFrame* frames, size_t num_samples) {
+    if (num_samples > this->length()) {
+        frames += num_samples - this->length();
+        num_samples = this->length();
+    }
+    this->write_segments(num_samples, [&](size_t dest, size_t src, size_t length) {
+#ifdef SIMD_MODE_X86_SSE
+        deinterleave_x86v128(
+            &this->left[dest], &this->right[dest], &frames[src], length);
+#else
+        deinterleave_c(&this->left[dest], &this->right[dest], &frames[src], length);
+#endif
+    });
+}
+
+void Audio_Ring::write_silence(size_t num_samples) {
+    if (num_samples > this->length()) {
+        num_samples = this->length();
+    }
+    this->write_segments(num_samples, [&](size_t dest, size_t, size_t length) {
+        memset(&this->left[dest], 0, length * sizeof(float));
+        memset(&this->right[dest], 0, length * sizeof(float));
+    });
+}
+
+int Audio_Ring::latest_written(size_t num_samples, Segment segments_out[2]) const {
+    if (num_samples > this->length()) {
+        num_samples = this->length();
+    }
+    uint64_t head = this->head.load(std::memory_order_relaxed);
+    size_t start = (head - num_samples) & this->mask;
+    size_t first_length = this->length() - start;
+    if (first_length >= num_samples) {
+        segments_out[0] = {&this->left[start], &this->right[start], num_samples};
+        return 1;
+    }
+    segments_out[0] = {&this->left[start], &this->right[start], first_length};
+    segments_out[1] = {
+        this->left.data(), this->right.data(), num_samples - first_length};
+    return 2;
+}
+
+void Audio_Ring::read_latest(float* left_out, float* right_out, size_t num_samples) {
+    this->read(UINT64_MAX, left_out, right_out, num_samples);
+}
+
+void Audio_Ring::read(uint64_t end_position,
+                      float* left_out,
+                      float* right_out,
+                      size_t num_samples) {
+    uint64_t end = 0;
+    for (int attempt = 0; attempt < AUDIO_RING_MAX_READ_ATTEMPTS; attempt++) {
+        uint64_t head = this->head.load(std::memory_order_acquire);
+        end = end_position < head ? end_position : head;
+        // Keep clear of the samples the next write will overwrite first.
+        uint64_t oldest_end = head + num_samples - this->length();
+        if (head + num_samples > this->length() && end < oldest_end) {
+            end = oldest_end;
+        }
+        uint64_t first_sample = end - num_samples;
+        size_t start = first_sample & this->mask;
+        size_t first_length = this->length() - start;
+        if (first_length > num_samples) {
+            first_length = num_samples;
+        }
+        size_t second_length = num_samples - first_length;
+        memcpy(left_out, &this->left[start], first_length * sizeof(float));
+        memcpy(right_out, &this->right[start], first_length * sizeof(float));
+        memcpy(&left_out[first_length],
+               this->left.data(),
+               second_length * sizeof(float));
+        memcpy(&right_out[first_length],
+               this->right.data(),
+               second_length * sizeof(float));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t write_end = this->write_end.load(std::memory_order_relaxed);
+        if (write_end - first_sample <= this->length()) {
+            break;
+        }
+    }
+    uint64_t tail = this->tail.load(std::memory_order_relaxed);
+    if (end > tail && end - tail > this->length()) {
+        this->overruns.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (end > tail) {
+        this->tail.store(end, std::memory_order_relaxed);
+    }
+}
+
+uint64_t Audio_Ring::num_unread() const {
+    return this->head.load(std::memory_order_acquire)
+           - this->tail.load(std::memory_order_relaxed);
+}
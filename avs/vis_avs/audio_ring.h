@@ -0,0 +1,97 @@
+#pragma once
+
+#include "audio_in.h"
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * A single-producer, single-consumer ring buffer of stereo audio, stored as separate
+ * left and right channels.
+ *
+ * The producer (an audio input thread, or whoever calls `avs_audio_set()`) appends
+ * samples, overwriting the oldest ones if the consumer doesn't keep up. The consumer
+ * (the render thread) copies out the most recent samples. Neither side ever blocks.
+ * Copies are done in at most two contiguous segments, split at the end of the ring.
+ *
+ * If the producer overwrites samples while they are being read, the read is retried,
+ * so the consumer never gets a torn window. As long as the ring is much larger than
+ * what's read at once, that's practically never the case.
+ */
+class Audio_Ring {
+   public:
+    // The length is rounded up to the next power of 2.
+    explicit Audio_Ring(size_t min_length);
+    Audio_Ring(const Audio_Ring&) = delete;
+    Audio_Ring& operator=(const Audio_Ring&) = delete;
+
+    size_t length() const { return this->mask + 1; }
+
+    // Producer: Append samples, clamped to [-1, 1].
+    void write(const float* left, const float* right, size_t num_samples);
+    // Producer: Append interleaved samples, as they come from audio input devices.
+    void write(const AudioFrame* frames, size_t num_samples);
+    void write_silence(size_t num_samples);
+
+    struct Segment {
+        const float* left;
+        const float* right;
+        size_t length;
+    };
+    /**
+     * Producer: Get the `num_samples` most recently written samples, as up to two
+     * segments in chronological order. Returns the number of segments. Meant for
+     * analyzing incoming audio right after writing it.
+     */
+    int latest_written(size_t num_samples, Segment segments_out[2]) const;
+
+    /**
+     * Consumer: Copy the `num_samples` most recently written samples to `left_out` and
+     * `right_out`, and mark everything up to them as read. `num_samples` must not be
+     * larger than `length()`.
+     */
+    void read_latest(float* left_out, float* right_out, size_t num_samples);
+    /**
+     * Consumer: Like `read_latest()`, but copy the `num_samples` samples before
+     * `end_position`, counted in samples written since the start. If `end_position` is
+     * beyond the latest sample, or so far back that its samples were overwritten, the
+     * copy is taken from as close to it as possible.
+     */
+    void read(uint64_t end_position,
+              float* left_out,
+              float* right_out,
+              size_t num_samples);
+    // Both: Total number of samples written.
+    uint64_t num_written() const { return this->head.load(std::memory_order_acquire); }
+    // Consumer: Samples written since the last read.
+    uint64_t num_unread() const;
+    // Any thread: How often samples were overwritten before they were read.
+    uint64_t num_overruns() const {
+        return this->overruns.load(std::memory_order_relaxed);
+    }
+
+   private:
+    // The producer's and consumer's positions are on separate cache lines, so that
+    // they don't slow each other down by invalidating the other's cache.
+    static constexpr size_t cache_line_size = 64;
+
+    template <typename Copy_Fn>
+    void write_segments(size_t num_samples, Copy_Fn copy);
+
+    size_t mask;
+    std::vector<float> left;
+    std::vector<float> right;
+
+    char padding0[cache_line_size];
+    // Total number of samples written, published after the samples themselves.
+    std::atomic<uint64_t> head{0};
+    // Set before samples are written, to the position the write will end at.
+    std::atomic<uint64_t> write_end{0};
+    char padding1[cache_line_size - 2 * sizeof(std::atomic<uint64_t>)];
+    // Total number of samples read, i.e. the head at the time of the last read.
+    std::atomic<uint64_t> tail{0};
+    std::atomic<uint64_t> overruns{0};
+    char padding2[cache_line_size - 2 * sizeof(uint64_t)];
+};
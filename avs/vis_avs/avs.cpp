@@ -82,10 +82,39 @@ bool avs_render_frame(AVS_Handle avs,
         instance->error = "Framebuffer must not be NULL";
         return false;
     }
+    if (pixel_format < AVS_PIXEL_RGB0_8 || pixel_format > AVS_PIXEL_NV12) {
+        instance->error = "Unknown pixel format";
+        return false;
+    }
     return instance->render_frame(
         framebuffer, time_in_ms, is_beat, width, height, pixel_format);
 }
 
+AVS_API
+bool avs_render_scaling_set(AVS_Handle avs,
+                            double target_frame_time_ms,
+                            double min_scale) {
+    AVS_Instance* instance = get_instance_from_handle(avs);
+    if (instance == nullptr) {
+        return false;
+    }
+    return instance->set_render_scaling(target_frame_time_ms, min_scale);
+}
+
+AVS_API
+bool avs_memory_stats(AVS_Handle avs, AVS_Memory_Stats* stats_out) {
+    AVS_Instance* instance = get_instance_from_handle(avs);
+    if (instance == nullptr) {
+        return false;
+    }
+    if (stats_out == nullptr) {
+        instance->error = "Memory stats output is null";
+        return false;
+    }
+    instance->memory_stats(stats_out);
+    return true;
+}
+
 AVS_API
 int32_t avs_audio_set(AVS_Handle avs,
                       const float* left,
@@ -101,14 +130,90 @@ int32_t avs_audio_set(AVS_Handle avs,
         left, right, audio_length, samples_per_second, end_time_samples);
 }
 
+AVS_API
+bool avs_audio_spectrum_set(AVS_Handle avs,
+                            size_t fft_size,
+                            AVS_Spectrum_Window window) {
+    AVS_Instance* instance = get_instance_from_handle(avs);
+    if (instance == nullptr) {
+        return false;
+    }
+    return instance->audio_spectrum_set(fft_size, window);
+}
+
+AVS_API
+bool avs_audio_analysis_rate_set(AVS_Handle avs, size_t samples_per_second) {
+    AVS_Instance* instance = get_instance_from_handle(avs);
+    if (instance == nullptr) {
+        return false;
+    }
+    return instance->audio_analysis_rate_set(samples_per_second);
+}
+
+AVS_API
+bool avs_audio_bands_set(AVS_Handle avs,
+                         const double* band_edges_hz,
+                         size_t num_bands,
+                         double attack_ms,
+                         double decay_ms) {
+    AVS_Instance* instance = get_instance_from_handle(avs);
+    if (instance == nullptr) {
+        return false;
+    }
+    return instance->audio_bands_set(band_edges_hz, num_bands, attack_ms, decay_ms);
+}
+
+AVS_API
+bool avs_audio_presentation_offset_set(AVS_Handle avs, double offset_ms) {
+    AVS_Instance* instance = get_instance_from_handle(avs);
+    if (instance == nullptr) {
+        return false;
+    }
+    return instance->audio_presentation_offset_set(offset_ms);
+}
+
+AVS_API
+bool avs_audio_tempo(AVS_Handle avs, AVS_Audio_Tempo* tempo_out) {
+    AVS_Instance* instance = get_instance_from_handle(avs);
+    if (instance == nullptr) {
+        return false;
+    }
+    if (tempo_out == nullptr) {
+        instance->error = "Audio tempo output is null";
+        return false;
+    }
+    instance->audio.tempo_tracking_enabled = true;
+    instance->audio.current_tempo(tempo_out);
+    return true;
+}
+
+AVS_API
+bool avs_audio_beat_prediction_set(AVS_Handle avs, bool enabled) {
+    AVS_Instance* instance = get_instance_from_handle(avs);
+    if (instance == nullptr) {
+        return false;
+    }
+    instance->audio.beat_prediction_enabled = enabled;
+    return true;
+}
+
+AVS_API
+bool avs_audio_file_set(AVS_Handle avs, const char* file_path) {
+    AVS_Instance* instance = get_instance_from_handle(avs);
+    if (instance == nullptr) {
+        return false;
+    }
+    return instance->audio_file_set(file_path);
+}
+
 AVS_API
 int32_t avs_audio_device_count(AVS_Handle avs) {
     AVS_Instance* instance = get_instance_from_handle(avs);
     if (instance == NULL) {
         return NULL;
     }
-    if (instance->audio_source == AVS_AUDIO_EXTERNAL) {
-        instance->error = "Audio source set to external on init";
+    if (instance->audio_source != AVS_AUDIO_INTERNAL) {
+        instance->error = "Audio source not set to internal on init";
         return -1;
     }
     // return instance->audio_device_count();
@@ -121,8 +226,8 @@ const char* const* avs_audio_device_names(AVS_Handle avs) {
     if (instance == NULL) {
         return NULL;
     }
-    if (instance->audio_source == AVS_AUDIO_EXTERNAL) {
-        instance->error = "Audio source set to external on init";
+    if (instance->audio_source != AVS_AUDIO_INTERNAL) {
+        instance->error = "Audio source not set to internal on init";
         return NULL;
     }
     // return instance->audio_device_names();
@@ -135,7 +240,7 @@ bool avs_audio_device_set(AVS_Handle avs, int32_t device) {
     if (instance == NULL) {
         return false;
     }
-    if (instance->audio_source == AVS_AUDIO_EXTERNAL) {
+    if (instance->audio_source != AVS_AUDIO_INTERNAL) {
         return true;
     }
     // return instance->audio_device_set(device);
@@ -143,6 +248,29 @@ bool avs_audio_device_set(AVS_Handle avs, int32_t device) {
     return false;
 }
 
+AVS_API
+bool avs_audio_device_latency_set(AVS_Handle avs, uint32_t latency_samples) {
+    AVS_Instance* instance = get_instance_from_handle(avs);
+    if (instance == nullptr) {
+        return false;
+    }
+    return instance->audio_device_latency_set(latency_samples);
+}
+
+AVS_API
+bool avs_audio_input_stats(AVS_Handle avs, AVS_Audio_Input_Stats* stats_out) {
+    AVS_Instance* instance = get_instance_from_handle(avs);
+    if (instance == nullptr) {
+        return false;
+    }
+    if (stats_out == nullptr) {
+        instance->error = "Audio input stats output is null";
+        return false;
+    }
+    instance->audio.input_stats(stats_out);
+    return true;
+}
+
 AVS_API
 bool avs_input_key_set(AVS_Handle avs, uint32_t key, bool state) {
     AVS_Instance* instance = get_instance_from_handle(avs);
@@ -5,8 +5,14 @@
  *
  *   Init/Free:    avs_init() & avs_free()
  *   Rendering:    avs_render_frame()
- *   Audio:        avs_audio_set(), avs_audio_device_count(),
- *                 avs_audio_device_names() & avs_audio_device_set()
+ *   Audio:        avs_audio_set(), avs_audio_spectrum_set(),
+ *                 avs_audio_analysis_rate_set(), avs_audio_bands_set(),
+ *                 avs_audio_presentation_offset_set(), avs_audio_tempo(),
+ *                 avs_audio_beat_prediction_set(),
+ *                 avs_audio_file_set(),
+ *                 avs_audio_device_count(),
+ *                 avs_audio_device_names(), avs_audio_device_set(),
+ *                 avs_audio_device_latency_set() & avs_audio_input_stats()
  *   Input:        avs_input_key_set(), avs_input_mouse_pos_set() &
  *                 avs_input_mouse_button_set()
  *   Preset files: avs_preset_load(), avs_preset_set(),
@@ -50,7 +56,7 @@
  *                    height,
  *                    -1,               // <0 for realtime rendering
  *                    false,            // ignored, since AVS_BEAT_INTERNAL
- *                    AVS_PIXEL_RGB0_8  // the only valid pixel format
+ *                    AVS_PIXEL_RGB0_8  // AVS' native pixel format
  *             )) {
  *                 // -------------------------------------
  *                 // Do something with `framebuffer` here,
@@ -79,10 +85,25 @@ extern "C" {
 
 typedef uint32_t AVS_Handle;
 
-typedef enum { AVS_PIXEL_RGB0_8 = 0 } AVS_Pixel_Format;  // To be expanded.
+typedef enum {
+    AVS_PIXEL_RGB0_8 = 0,  // 32-bit pixels, bytes in memory: B, G, R, unused
+    AVS_PIXEL_BGRA_8 = 1,  // 32-bit pixels, bytes in memory: B, G, R, A (always 255)
+    AVS_PIXEL_RGBA_8 = 2,  // 32-bit pixels, bytes in memory: R, G, B, A (always 255)
+    AVS_PIXEL_I420 = 3,    // 8-bit planar Y, U, V, with 2x2-subsampled U & V planes
+    AVS_PIXEL_NV12 = 4,    // 8-bit planar Y & 2x2-subsampled, interleaved U/V plane
+} AVS_Pixel_Format;
 
-typedef enum { AVS_AUDIO_INTERNAL = 0, AVS_AUDIO_EXTERNAL = 1 } AVS_Audio_Source;
+typedef enum {
+    AVS_AUDIO_INTERNAL = 0,
+    AVS_AUDIO_EXTERNAL = 1,
+    AVS_AUDIO_FILE = 2,
+} AVS_Audio_Source;
 typedef enum { AVS_BEAT_INTERNAL = 0, AVS_BEAT_EXTERNAL = 1 } AVS_Beat_Source;
+typedef enum {
+    AVS_SPECTRUM_WINDOW_HANN = 0,             // Good general-purpose choice
+    AVS_SPECTRUM_WINDOW_BLACKMAN_HARRIS = 1,  // Less leakage, wider peaks
+    AVS_SPECTRUM_WINDOW_RECTANGULAR = 2,      // No window, sharpest peaks, most leakage
+} AVS_Spectrum_Window;
 
 /**
  * Initialize an AVS instance. If initialization fails for some reason, the returned
@@ -101,6 +122,8 @@ typedef enum { AVS_BEAT_INTERNAL = 0, AVS_BEAT_EXTERNAL = 1 } AVS_Beat_Source;
  *       its audio buffer. If `avs_audio_set()` is not called, AVS will assume silence.
  *       If `AVS_AUDIO_INTERNAL`, AVS will open a recording device itself and get audio
  *       input from there.
+ *       If `AVS_AUDIO_FILE`, AVS will play the audio file set with
+ *       `avs_audio_file_set()`, in sync with `avs_render_frame()`'s `time_in_ms`.
  *
  *   `beat_source`
  *       If `AVS_BEAT_EXTERNAL`, AVS will depend on `avs_render_frame()`'s `is_beat`
@@ -149,7 +172,10 @@ AVS_Handle avs_init(const char* base_path,
  *       generating visuals for audio playing at the same time. The passage of time
  *       doesn't matter so much here (except for ensuring smoothness of animations).
  *       Neither does exact time-matching the frame and the audio signal: Latency must
- *       be minimal at all costs, and the latest audio is always the best.
+ *       be minimal at all costs, and the latest audio is always the best. The one
+ *       exception is internal audio from a device that reports capture times, where
+ *       the audio can be matched to when the frame is displayed, see
+ *       `avs_audio_presentation_offset_set()`.
  *
  *       For realtime mode, set `time_in_ms` to any negative value. Its absolute value
  *       is ignored (for now) and the internal time is set by the actual system time.
@@ -181,9 +207,16 @@ AVS_Handle avs_init(const char* base_path,
  *       ignored.
  *
  *   `pixel_format`
- *       Must be `AVS_PIXEL_RGB0_8`. Any other value is invalid at the moment.
- *       Note: Has no impact on what pixel format the preset can use internally. Only
- *       defines the pixel format of the final rendered frame.
+ *       The pixel format of `framebuffer`. Presets always render in
+ *       `AVS_PIXEL_RGB0_8`, any other format is converted to while writing the final
+ *       frame, which is cheaper than converting the frame afterwards.
+ *       Rows are tightly packed, without padding. For the 32-bit formats the buffer
+ *       must hold `width * height * 4` bytes. The alpha channel is always opaque, so
+ *       the pixels are valid both as straight and as premultiplied alpha.
+ *       The YUV formats use BT.709 colors in limited ("TV") range. Their chroma planes
+ *       are `(width + 1) / 2` by `(height + 1) / 2` samples, and follow the
+ *       `width * height` luma plane immediately: For `AVS_PIXEL_I420` a U plane and
+ *       then a V plane, for `AVS_PIXEL_NV12` a single plane of alternating U and V.
  */
 bool avs_render_frame(AVS_Handle avs,
                       void* framebuffer,
@@ -193,6 +226,56 @@ bool avs_render_frame(AVS_Handle avs,
                       bool is_beat,
                       AVS_Pixel_Format pixel_format);
 
+/**
+ * Enable dynamic resolution scaling, to keep frame times below a target on slow
+ * hardware. Presets are then rendered at a reduced internal resolution if needed,
+ * which is chosen adaptively from measured frame times, and scaled up bilinearly to
+ * the size passed to `avs_render_frame()`. The internal resolution is lowered or
+ * raised in steps of 1/16th of the output resolution, at most once every 30 frames.
+ * Disabled by default.
+ *
+ *   `target_frame_time_ms`
+ *       The time `avs_render_frame()` should take at most, e.g. 16 for 60fps.
+ *       0 or less disables scaling, and frames are rendered at full resolution again.
+ *
+ *   `min_scale`
+ *       The smallest fraction of the output width and height to render at, between 0
+ *       and 1. 0.5 would render 1920x1080 at 960x540 at worst.
+ *
+ * Returns `true` on success or `false` if `min_scale` is out of range or some other
+ * error occurred.
+ */
+bool avs_render_scaling_set(AVS_Handle avs,
+                            double target_frame_time_ms,
+                            double min_scale);
+
+/**
+ * Memory used by an AVS instance for frame-sized buffers.
+ *
+ * Populate this struct by calling `avs_memory_stats()`.
+ */
+typedef struct {
+    /** Bytes allocated for framebuffers, both in use and kept around for reuse. */
+    size_t framebuffer_bytes_allocated;
+    /** Bytes of framebuffers currently in use by the renderer, effects or presets. */
+    size_t framebuffer_bytes_in_use;
+    /** Number of heap allocations for framebuffers since the instance was created. */
+    uint64_t framebuffer_num_allocations;
+    /**
+     * Bytes used by the 8 global buffers shared between effects, included in
+     * `framebuffer_bytes_in_use`. Global buffers take up memory only once a preset
+     * writes to them, e.g. with "Buffer Save".
+     */
+    size_t global_buffer_bytes;
+} AVS_Memory_Stats;
+
+/**
+ * Fill `stats_out` with the current memory statistics of the AVS instance.
+ *
+ * Returns `true` on success or `false` if `avs` or `stats_out` is invalid.
+ */
+bool avs_memory_stats(AVS_Handle avs, AVS_Memory_Stats* stats_out);
+
 /**
  * Fill AVS' audio wave data ring buffer with new data. Audio data should be in 32-bit
  * float format, in stereo. AVS will calculate the FFT of the audio for frequencies
@@ -215,7 +298,7 @@ bool avs_render_frame(AVS_Handle avs,
  * in that case.
  *
  * Returns INT32_MAX on overflow, and negative values ≤ -2 on underflow or -1 if `avs`
- * was initialized with `audio_source=AVS_AUDIO_INTERNAL`.
+ * was initialized with `audio_source=AVS_AUDIO_INTERNAL` or `AVS_AUDIO_FILE`.
  */
 int32_t avs_audio_set(AVS_Handle avs,
                       const float* audio_left,
@@ -224,11 +307,142 @@ int32_t avs_audio_set(AVS_Handle avs,
                       size_t samples_per_second,
                       int64_t start_time_in_samples);
 
+/**
+ * Configure the frequency analysis of the audio, for both internal and external audio.
+ * Takes effect on the next frame.
+ *
+ *   `fft_size`
+ *       The number of audio samples the spectrum is calculated from, a power of 2
+ *       between 64 and 8192. Larger sizes resolve frequencies more finely, but react to
+ *       changes more slowly. Presets always see 576 spectrum values from 0Hz to half
+ *       the sample rate, sizes above 1024 give these a higher resolution in the lower
+ *       frequencies. The default is 1024.
+ *
+ *   `window`
+ *       The window function applied to the samples before the FFT. The default is
+ *       `AVS_SPECTRUM_WINDOW_HANN`.
+ *
+ * Returns `true` on success or `false` if `fft_size` or `window` is invalid.
+ */
+bool avs_audio_spectrum_set(AVS_Handle avs,
+                            size_t fft_size,
+                            AVS_Spectrum_Window window);
+
+/**
+ * Set the sample rate that audio is analyzed at, for both internal and external audio.
+ * Audio at any other rate is converted to this rate first, so that the spectrum covers
+ * the same frequencies regardless of the audio source. Takes effect with the next
+ * audio received, which also discards all previous audio.
+ *
+ *   `samples_per_second`
+ *       The analysis sample rate, from 8000 to 192000. The spectrum seen by presets
+ *       reaches up to half of this. The default is 44100.
+ *
+ * Returns `true` on success or `false` if `samples_per_second` is out of range.
+ */
+bool avs_audio_analysis_rate_set(AVS_Handle avs, size_t samples_per_second);
+
+/**
+ * Configure the frequency bands whose levels presets can read with the `getband()`
+ * EEL function. Takes effect on the next frame. By default there are 3 bands, bass
+ * (20-250Hz), mids (250-4000Hz) and treble (4000-20000Hz), with an attack time of 10ms
+ * and a decay time of 250ms.
+ *
+ *   `band_edges_hz`
+ *       `num_bands + 1` increasing frequencies in Hz. Band `i` reaches from
+ *       `band_edges_hz[i]` to `band_edges_hz[i + 1]`.
+ *
+ *   `num_bands`
+ *       The number of bands, from 1 to 16.
+ *
+ *   `attack_ms` & `decay_ms`
+ *       The time constants of the smoothed band levels, for rising and falling levels
+ *       respectively. 0 disables smoothing in that direction.
+ *
+ * Returns `true` on success or `false` if any of the parameters is invalid.
+ */
+bool avs_audio_bands_set(AVS_Handle avs,
+                         const double* band_edges_hz,
+                         size_t num_bands,
+                         double attack_ms,
+                         double decay_ms);
+
+/**
+ * Set when frames rendered in realtime mode will be seen, relative to when the audio
+ * captured at the same moment is heard, so that each frame shows the audio playing
+ * while it is on screen. Only applies to `audio_source=AVS_AUDIO_INTERNAL` with an
+ * audio device that reports capture times, which currently means PipeWire. Audio that
+ * hasn't been captured yet can't be used, so if the offset points into the future the
+ * latest audio is used as before. No audio is ever held back.
+ *
+ *   `offset_ms`
+ *       The display latency, i.e. the time between calling `avs_render_frame()` and
+ *       the frame appearing on screen, minus the time between audio being captured and
+ *       being heard. E.g. when capturing the monitor of an output with 150ms latency,
+ *       and frames are displayed 30ms after rendering, set `offset_ms` to -120.
+ *       Between -10000 and 10000, the default is 0.
+ *
+ * Returns `true` on success or `false` if `offset_ms` is out of range.
+ */
+bool avs_audio_presentation_offset_set(AVS_Handle avs, double offset_ms);
+
+/**
+ * The tempo of the audio, as estimated from the onsets found by internal beat
+ * detection.
+ *
+ * Populate this struct by calling `avs_audio_tempo()`.
+ */
+typedef struct {
+    /** The tempo in beats per minute, from 60 to 180, or 0 if none was found yet. */
+    double bpm;
+    /** How steady the beat is, from 0 (no recognizable beat) to 1. */
+    double confidence;
+    /** Rises from 0 at a beat to 1 just before the next one. */
+    double beat_phase;
+    /** The time until the next beat is expected. */
+    double next_beat_in_ms;
+} AVS_Audio_Tempo;
+
+/**
+ * Fill `tempo_out` with the current tempo. Works with any audio and beat source. The
+ * tempo is tracked while the preset uses it, and always once this was called, so the
+ * first few seconds after the first call may return a `bpm` of 0.
+ *
+ * Returns `true` on success or `false` if `avs` or `tempo_out` is invalid.
+ */
+bool avs_audio_tempo(AVS_Handle avs, AVS_Audio_Tempo* tempo_out);
+
+/**
+ * Enable or disable beat prediction. If enabled, and the tempo is steady, beats that
+ * the tempo predicts but beat detection missed are filled in, like Winamp AVS' "smart
+ * beat" option. Filled-in beats arrive a little late, about a tenth of a beat. Only
+ * applies to `beat_source=AVS_BEAT_INTERNAL`. Disabled by default.
+ *
+ * Returns `true` on success or `false` if `avs` is invalid.
+ */
+bool avs_audio_beat_prediction_set(AVS_Handle avs, bool enabled);
+
+/**
+ * Open an audio file to play, if `avs` was initialized with
+ * `audio_source=AVS_AUDIO_FILE`. WAV files are always supported, other formats if
+ * libav is available. The file is decoded ahead of time in the background.
+ *
+ * In video mode, `avs_render_frame()`'s `time_in_ms` is the position in the file, so
+ * frames get the audio right up to their timestamp, and rendering as fast as possible
+ * just works. In realtime mode, the file starts playing with the next frame.
+ *
+ * Pass `NULL` or an empty path to close the file, AVS will assume silence then.
+ *
+ * Returns `true` on success or `false` if the file cannot be opened or decoded, or
+ * `avs` wasn't initialized with `audio_source=AVS_AUDIO_FILE`.
+ */
+bool avs_audio_file_set(AVS_Handle avs, const char* file_path);
+
 /**
  * Returns the number of audio input devices AVS has detected.
  *
- * Returns -1 if `avs` was initialized with `audio_source=AVS_AUDIO_EXTERNAL`, or some
- * other error occurred.
+ * Returns -1 if `avs` wasn't initialized with `audio_source=AVS_AUDIO_INTERNAL`, or
+ * some other error occurred.
  */
 int32_t avs_audio_device_count(AVS_Handle avs);
 
@@ -240,7 +454,7 @@ int32_t avs_audio_device_count(AVS_Handle avs);
  * `avs_audio_device_names()` again or `avs_free()` is called for this instance.
  *
  * Returns a list with just `NULL` if no devices found. Returns `NULL` directly(!) if
- * `avs` was initialized with `audio_source=AVS_AUDIO_EXTERNAL` or some other error
+ * `avs` wasn't initialized with `audio_source=AVS_AUDIO_INTERNAL` or some other error
  * occurred.
  */
 const char* const* avs_audio_device_names(AVS_Handle avs);
@@ -249,13 +463,64 @@ const char* const* avs_audio_device_names(AVS_Handle avs);
  * Set the device to use for audio input. The device number is the index of the list of
  * device names.
  *
- * Has no effect if `avs` was initialized with `audio_source=AVS_AUDIO_EXTERNAL`.
+ * Has no effect if `avs` wasn't initialized with `audio_source=AVS_AUDIO_INTERNAL`.
  *
  * Returns `true` if device was successfully set (also when unchanged!) or `false` if
  * the device handle is invalid or some other error occurred.
  */
 bool avs_audio_device_set(AVS_Handle avs, int32_t device);
 
+/**
+ * Set how many samples at a time to ask the audio input device for. Smaller chunks
+ * mean lower latency, at the cost of more frequent wake-ups and a higher risk of
+ * xruns. The audio input is restarted if the value changes.
+ *
+ * Has no effect if `avs` wasn't initialized with `audio_source=AVS_AUDIO_INTERNAL`.
+ *
+ *   `latency_samples`
+ *       The chunk size in samples at 48kHz, scaled to the device's actual rate, up to
+ *       8192. 0 leaves it to the device or audio server. The default is 256, about
+ *       5ms.
+ *
+ * Returns `true` on success or `false` if `latency_samples` is out of range.
+ */
+bool avs_audio_device_latency_set(AVS_Handle avs, uint32_t latency_samples);
+
+/**
+ * Timing statistics of the audio input, to diagnose dropouts and irregular audio.
+ *
+ * Populate this struct by calling `avs_audio_input_stats()`.
+ */
+typedef struct {
+    /** The chunk size asked for with `avs_audio_device_latency_set()`. */
+    uint32_t latency_samples;
+    /** The number of samples in the latest chunk the device actually delivered. */
+    uint32_t chunk_samples;
+    /**
+     * Gaps in the captured audio where the device or audio server lost samples, since
+     * AVS was initialized. Only counted for devices that report capture times.
+     */
+    uint64_t num_xruns;
+    /**
+     * How often audio was overwritten before any frame used it, because frames were
+     * rendered too rarely. Counted for all audio sources.
+     */
+    uint64_t num_overruns;
+    /**
+     * How much the time between two chunks differs from the length of the first one,
+     * on average and at most. Large values mean audio arrives in irregular bursts.
+     */
+    double callback_jitter_ms;
+    double max_callback_jitter_ms;
+} AVS_Audio_Input_Stats;
+
+/**
+ * Fill `stats_out` with the current audio input statistics of the AVS instance.
+ *
+ * Returns `true` on success or `false` if `avs` or `stats_out` is invalid.
+ */
+bool avs_audio_input_stats(AVS_Handle avs, AVS_Audio_Input_Stats* stats_out);
+
 /**
  * Set a keyboard key state to either pressed, `true`, or released, `false`.
  *
@@ -221,6 +221,12 @@ class AVS {
                                 is_beat,
                                 pixel_format);
     }
+    bool set_render_scaling(double target_frame_time_ms, double min_scale = 0.5) const {
+        return avs_render_scaling_set(this->handle, target_frame_time_ms, min_scale);
+    }
+    bool memory_stats(AVS_Memory_Stats* stats_out) const {
+        return avs_memory_stats(this->handle, stats_out);
+    }
     int32_t audio_set(const float* left,
                       const float* right,
                       size_t audio_length,
@@ -233,6 +239,39 @@ class AVS {
                              samples_per_second,
                              start_time_in_samples);
     }
+    bool audio_spectrum_set(
+        size_t fft_size,
+        AVS_Spectrum_Window window = AVS_SPECTRUM_WINDOW_HANN) const {
+        return avs_audio_spectrum_set(this->handle, fft_size, window);
+    }
+    bool audio_analysis_rate_set(size_t samples_per_second) const {
+        return avs_audio_analysis_rate_set(this->handle, samples_per_second);
+    }
+    bool audio_bands_set(const double* band_edges_hz,
+                         size_t num_bands,
+                         double attack_ms,
+                         double decay_ms) const {
+        return avs_audio_bands_set(
+            this->handle, band_edges_hz, num_bands, attack_ms, decay_ms);
+    }
+    bool audio_presentation_offset_set(double offset_ms) const {
+        return avs_audio_presentation_offset_set(this->handle, offset_ms);
+    }
+    bool audio_tempo(AVS_Audio_Tempo* tempo_out) const {
+        return avs_audio_tempo(this->handle, tempo_out);
+    }
+    bool audio_beat_prediction_set(bool enabled) const {
+        return avs_audio_beat_prediction_set(this->handle, enabled);
+    }
+    bool audio_file_set(const char* file_path) const {
+        return avs_audio_file_set(this->handle, file_path);
+    }
+    bool audio_device_latency_set(uint32_t latency_samples) const {
+        return avs_audio_device_latency_set(this->handle, latency_samples);
+    }
+    bool audio_input_stats(AVS_Audio_Input_Stats* stats_out) const {
+        return avs_audio_input_stats(this->handle, stats_out);
+    }
     bool load(const char* file_path) const {
         return avs_preset_load(this->handle, file_path);
     }
@@ -52,6 +52,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../3rdparty/WDL-EEL2/eel2/ns-eel-addfuncs.h"
 #include "../platform.h"
 
+#include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -102,7 +103,7 @@ static double getvis(unsigned char* visdata, int bc, int bw, int ch, int xorv) {
 }
 
 static double getspec(AVS_Instance* avs, double* band, double* bandw, double* chan) {
-    return getvis((unsigned char*)avs->eel_state.visdata,
+    return getvis((unsigned char*)avs->audio.visdata,
                   (int)(*band * AUDIO_BUFFER_LEN),
                   (int)(*bandw * AUDIO_BUFFER_LEN),
                   (int)(*chan + 0.5),
@@ -111,13 +112,45 @@ static double getspec(AVS_Instance* avs, double* band, double* bandw, double* ch
 }
 
 static double getosc(AVS_Instance* avs, double* band, double* bandw, double* chan) {
-    return getvis((unsigned char*)&avs->eel_state.visdata[AUDIO_BUFFER_LEN * 2],
+    return getvis((unsigned char*)avs->audio.visdata[1],
                   (int)(*band * AUDIO_BUFFER_LEN),
                   (int)(*bandw * AUDIO_BUFFER_LEN),
                   (int)(*chan + 0.5),
                   128);
 }
 
+// The energy of band `band` (counting from 0), or its envelope if `smoothed` is set.
+static double getband(AVS_Instance* avs, double* band, double* smoothed) {
+    const auto& levels = avs->audio.levels;
+    auto index = (int)(*band + 0.5);
+    if (index < 0 || index >= (int)levels.num_bands) {
+        return 0.0;
+    }
+    return *smoothed != 0.0 ? levels.bands[index].envelope : levels.bands[index].energy;
+}
+
+// The overall level: 0 is the RMS, 1 the peak and 2 the RMS envelope.
+static double getlevel(AVS_Instance* avs, double* which) {
+    const auto& levels = avs->audio.levels;
+    switch ((int)(*which + 0.5)) {
+        case 0: return levels.rms;
+        case 1: return levels.peak;
+        case 2: return levels.rms_envelope;
+        default: return 0.0;
+    }
+}
+
+// The tempo: 0 is the BPM, 1 the confidence and 2 the beat phase.
+static double gettempo(AVS_Instance* avs, double* which) {
+    const auto& tempo = avs->audio.tempo;
+    switch ((int)(*which + 0.5)) {
+        case 0: return tempo.bpm;
+        case 1: return tempo.confidence;
+        case 2: return tempo.beat_phase;
+        default: return 0.0;
+    }
+}
+
 static double gettime(AVS_Instance* avs, double* sc) {
 #ifdef CAN_TALK_TO_WINAMP
     int ispos;
@@ -187,6 +220,9 @@ void AVS_EEL_IF_init(AVS_Instance* avs) {
     NSEEL_init();
     NSEEL_addfunc_retval("getosc", 3, NSEEL_PProc_THIS, (void*)getosc);
     NSEEL_addfunc_retval("getspec", 3, NSEEL_PProc_THIS, (void*)getspec);
+    NSEEL_addfunc_retval("getband", 2, NSEEL_PProc_THIS, (void*)getband);
+    NSEEL_addfunc_retval("getlevel", 1, NSEEL_PProc_THIS, (void*)getlevel);
+    NSEEL_addfunc_retval("gettempo", 1, NSEEL_PProc_THIS, (void*)gettempo);
     NSEEL_addfunc_retval("gettime", 1, NSEEL_PProc_THIS, (void*)gettime);
     NSEEL_addfunc_retval("getkbmouse", 1, NSEEL_PProc_THIS, (void*)getmouse);
 }
@@ -213,15 +249,79 @@ NSEEL_CODEHANDLE AVS_EEL_IF_Compile(AVS_Instance* avs,
     return handle;
 }
 
-void AVS_EEL_IF_Execute(AVS_Instance* avs,
-                        NSEEL_CODEHANDLE handle,
-                        char visdata[2][2][AUDIO_BUFFER_LEN]) {
+void AVS_EEL_IF_Execute(NSEEL_CODEHANDLE handle) {
     if (handle) {
-        avs->audio.to_legacy_visdata(avs->eel_state.visdata);
         NSEEL_code_execute(handle);
     }
 }
 
+static const struct {
+    const char* name;
+    uint32_t dependencies;
+} eel_audio_functions[] = {
+    {"getosc", AUDIO_DEPENDS_OSC},
+    {"getspec", AUDIO_DEPENDS_SPEC},
+    {"getband", AUDIO_DEPENDS_LEVELS},
+    {"getlevel", AUDIO_DEPENDS_LEVELS},
+    {"gettempo", AUDIO_DEPENDS_TEMPO},
+};
+
+// EEL variable names may contain dots, e.g. for `this.x` in user-defined functions.
+static bool is_eel_identifier_char(char c) {
+    return isalnum((unsigned char)c) || c == '_' || c == '.';
+}
+
+// EEL function names are case-insensitive.
+static uint32_t identifier_audio_dependencies(const char* identifier, size_t length) {
+    for (auto& function : eel_audio_functions) {
+        size_t i = 0;
+        while (i < length && function.name[i] != '\0'
+               && tolower((unsigned char)identifier[i]) == function.name[i]) {
+            i++;
+        }
+        if (i == length && function.name[i] == '\0') {
+            return function.dependencies;
+        }
+    }
+    return AUDIO_DEPENDS_NONE;
+}
+
+uint32_t AVS_EEL_IF_audio_dependencies(const char* code) {
+    if (code == nullptr) {
+        return AUDIO_DEPENDS_NONE;
+    }
+    uint32_t dependencies = AUDIO_DEPENDS_NONE;
+    const char* c = code;
+    while (*c != '\0') {
+        if (c[0] == '/' && c[1] == '/') {
+            c += strcspn(c, "\n");
+        } else if (c[0] == '/' && c[1] == '*') {
+            const char* comment_end = strstr(c + 2, "*/");
+            c = comment_end != nullptr ? comment_end + 2 : c + strlen(c);
+        } else if (*c == '"' || *c == '\'') {
+            char quote = *c++;
+            while (*c != '\0' && *c != quote) {
+                if (*c == '\\' && c[1] != '\0') {
+                    c++;
+                }
+                c++;
+            }
+            if (*c != '\0') {
+                c++;
+            }
+        } else if (is_eel_identifier_char(*c)) {
+            const char* identifier = c;
+            while (is_eel_identifier_char(*c)) {
+                c++;
+            }
+            dependencies |= identifier_audio_dependencies(identifier, c - identifier);
+        } else {
+            c++;
+        }
+    }
+    return dependencies;
+}
+
 void AVS_EEL_IF_resetvars(NSEEL_VMCTX ctx) { NSEEL_VM_remove_all_nonreg_vars(ctx); }
 
 void NSEEL_HOSTSTUB_EnterMutex() {}
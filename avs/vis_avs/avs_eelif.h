@@ -33,11 +33,19 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "../3rdparty/WDL-EEL2/eel2/ns-eel.h"
 
+#include <stdint.h>
+
 class AVS_Instance;  // instance.h
 
 void AVS_EEL_IF_init(AVS_Instance* avs);
 void AVS_EEL_IF_quit(AVS_Instance* avs);
 
 NSEEL_CODEHANDLE AVS_EEL_IF_Compile(AVS_Instance* avs, NSEEL_VMCTX context, char* code);
-void AVS_EEL_IF_Execute(AVS_Instance* avs, void* handle, char visdata[2][2][576]);
+void AVS_EEL_IF_Execute(NSEEL_CODEHANDLE handle);
+/**
+ * The `Audio_Dependency` flags for the audio functions (`getosc()`, `getspec()`,
+ * `getband()`, `getlevel()`, `gettempo()`) that `code` calls. Names in comments and
+ * strings don't count.
+ */
+uint32_t AVS_EEL_IF_audio_dependencies(const char* code);
 void AVS_EEL_IF_resetvars(NSEEL_VMCTX ctx);
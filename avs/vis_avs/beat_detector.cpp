@@ -0,0 +1,122 @@
+#include "beat_detector.h"
+
+#include <cmath>
+#include <cstring>
+
+// The threshold is the mean flux of the recent history times this factor, plus
+// `BEAT_FLUX_MIN_THRESHOLD`, which keeps noise in otherwise silent audio from
+// triggering onsets.
+#define BEAT_FLUX_THRESHOLD_FACTOR 1.5f
+#define BEAT_FLUX_MIN_THRESHOLD    4.0f
+// Magnitudes are compressed with log(1 + c * magnitude), to emphasize relative changes
+// in loudness over absolute ones.
+#define BEAT_LOG_COMPRESSION 128.0f
+
+Beat_Detector::Beat_Detector()
+    : fft(Beat_Detector::window_size, AVS_SPECTRUM_WINDOW_HANN) {
+    this->reset();
+}
+
+void Beat_Detector::reset() {
+    memset(this->window, 0, sizeof(this->window));
+    memset(this->previous_magnitudes, 0, sizeof(this->previous_magnitudes));
+    this->window_head = 0;
+    this->samples_until_hop = Beat_Detector::window_size;
+    this->stream_time = 0;
+    this->history_head = 0;
+    this->history_length = 0;
+    this->previous_flux = 0.0f;
+    this->previous_flux_2 = 0.0f;
+    this->last_onset_time = INT64_MIN / 2;
+    this->latest_onset = -1;
+    this->position = 0;
+    this->tempo_tracker.reset();
+}
+
+void Beat_Detector::process(const float* left,
+                            const float* right,
+                            size_t num_samples,
+                            size_t samples_per_second) {
+    if (samples_per_second != this->samples_per_second) {
+        this->reset();
+        this->samples_per_second = samples_per_second;
+    }
+    for (size_t i = 0; i < num_samples; i++) {
+        this->window[0][this->window_head] = left[i];
+        this->window[1][this->window_head] = right[i];
+        this->window_head = (this->window_head + 1) % Beat_Detector::window_size;
+        this->stream_time++;
+        if (--this->samples_until_hop == 0) {
+            this->samples_until_hop = Beat_Detector::hop_size;
+            this->analyze_window();
+        }
+    }
+    this->position = this->stream_time;
+}
+
+void Beat_Detector::analyze_window() {
+    float linear_window[2][Beat_Detector::window_size];
+    size_t tail_length = Beat_Detector::window_size - this->window_head;
+    size_t head_length = this->window_head;
+    for (int c = 0; c < 2; c++) {
+        memcpy(linear_window[c],
+               &this->window[c][head_length],
+               tail_length * sizeof(float));
+        memcpy(&linear_window[c][tail_length],
+               this->window[c],
+               head_length * sizeof(float));
+    }
+    this->fft.magnitudes(
+        linear_window[0], linear_window[1], this->spectrum[0], this->spectrum[1]);
+
+    float flux = 0.0f;
+    for (int c = 0; c < 2; c++) {
+        for (size_t i = 0; i < Beat_Detector::num_bins; i++) {
+            float magnitude = logf(1.0f + BEAT_LOG_COMPRESSION * this->spectrum[c][i]);
+            float increase = magnitude - this->previous_magnitudes[c][i];
+            if (increase > 0.0f) {
+                flux += increase;
+            }
+            this->previous_magnitudes[c][i] = magnitude;
+        }
+    }
+
+    // The previous window is an onset if its flux is a local maximum and sufficiently
+    // above the average of the windows before it.
+    float mean = 0.0f;
+    for (size_t i = 0; i < this->history_length; i++) {
+        mean += this->history[i];
+    }
+    if (this->history_length > 0) {
+        mean /= (float)this->history_length;
+    }
+    float threshold = mean * BEAT_FLUX_THRESHOLD_FACTOR + BEAT_FLUX_MIN_THRESHOLD;
+    // The onset happened somewhere in the newest hop of the previous window.
+    int64_t candidate_time = this->stream_time - (int64_t)Beat_Detector::hop_size * 2;
+    auto min_interval = (int64_t)((double)this->samples_per_second
+                                  * Beat_Detector::min_onset_interval_seconds);
+    // Right after a reset the flux compares against silence, so skip the first two.
+    if (this->history_length >= 2 && this->previous_flux > this->previous_flux_2
+        && this->previous_flux >= flux
+        && this->previous_flux > threshold
+        && candidate_time - this->last_onset_time >= min_interval) {
+        this->last_onset_time = candidate_time;
+        this->latest_onset = candidate_time;
+        this->onsets++;
+    }
+
+    if (this->history_length >= 2) {
+        this->tempo_tracker.add(flux,
+                                this->stream_time,
+                                Beat_Detector::hop_size,
+                                this->samples_per_second);
+    }
+
+    this->history[this->history_head] = this->previous_flux;
+    this->history_head = (this->history_head + 1) % Beat_Detector::history_size;
+    if (this->history_length < Beat_Detector::history_size) {
+        this->history_length++;
+    }
+    this->previous_flux_2 = this->previous_flux;
+    this->previous_flux = flux;
+}
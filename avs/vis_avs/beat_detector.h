@@ -0,0 +1,86 @@
+#pragma once
+
+#include "fft.h"
+#include "tempo_tracker.h"
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Onset detection on a stream of audio, for AVS_BEAT_INTERNAL.
+ *
+ * Samples are analyzed as they arrive, in overlapping windows every `hop_size`
+ * samples. For each window the spectral flux, i.e. the sum of increases in
+ * (log-compressed) magnitude over all frequency bins of both channels, is compared to
+ * an adaptive threshold derived from the recent flux history. Local maxima above the
+ * threshold are onsets, as long as they're not too close to the previous one. The flux
+ * also feeds a `Tempo_Tracker`.
+ *
+ * `process()` is meant to be called from a single (audio) thread. The onset counter
+ * and time may be read from any thread.
+ */
+class Beat_Detector {
+   public:
+    static constexpr size_t window_size = 512;
+    static constexpr size_t hop_size = 256;
+    // Number of past flux values the threshold is calculated from, ~0.35s at 44.1kHz.
+    static constexpr size_t history_size = 64;
+    // Onsets closer together than this are merged into the first one.
+    static constexpr double min_onset_interval_seconds = 0.1;
+
+    Beat_Detector();
+    Beat_Detector(const Beat_Detector&) = delete;
+    Beat_Detector& operator=(const Beat_Detector&) = delete;
+
+    // Forget all previous audio, e.g. after the sample rate changed.
+    void reset();
+    // Analyze the next `num_samples` stereo samples of the stream.
+    void process(const float* left,
+                 const float* right,
+                 size_t num_samples,
+                 size_t samples_per_second);
+
+    // The number of onsets detected since creation. Compare to a previous value to see
+    // if there was a beat in-between.
+    uint64_t num_onsets() const { return this->onsets.load(); }
+    // The stream position in samples, counted since the last `reset()`, of the most
+    // recent onset, or -1 if there was none yet.
+    int64_t latest_onset_time() const { return this->latest_onset.load(); }
+    // The stream position in samples, counted since the last `reset()`, up to which
+    // audio was analyzed.
+    int64_t stream_position() const { return this->position.load(); }
+    // The tempo estimate, with times in the same stream positions.
+    bool tempo(Tempo_Estimate* estimate_out) const {
+        return this->tempo_tracker.estimate(estimate_out);
+    }
+
+   private:
+    void analyze_window();
+
+    static constexpr size_t num_bins = window_size / 2 + 1;
+
+    Stereo_FFT fft;
+    size_t samples_per_second = 0;
+    // The last `window_size` samples of each channel, as ring buffers.
+    float window[2][window_size];
+    size_t window_head = 0;
+    size_t samples_until_hop = window_size;
+    int64_t stream_time = 0;
+
+    float spectrum[2][num_bins];
+    float previous_magnitudes[2][num_bins];
+    float history[history_size];
+    size_t history_head = 0;
+    size_t history_length = 0;
+    // The flux of the previous two windows, to find local maxima.
+    float previous_flux = 0.0f;
+    float previous_flux_2 = 0.0f;
+    int64_t last_onset_time = INT64_MIN / 2;
+
+    Tempo_Tracker tempo_tracker;
+
+    std::atomic<uint64_t> onsets{0};
+    std::atomic<int64_t> latest_onset{-1};
+    std::atomic<int64_t> position{0};
+};
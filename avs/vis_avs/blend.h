@@ -1,3 +1,5 @@
+#pragma once
+
 #include <stdint.h>
 #include <stdio.h>
 
@@ -111,7 +113,95 @@ inline void blend_default_fill(ARGS_SRCVAL_DEST_W) {
     }
 }
 
+/**
+ * A line blend mode (the lower byte of `g_line_blend_mode`) resolved at compile time.
+ * Drawing code templated on this blends each pixel with a direct call instead of
+ * switching on the global per pixel. Use `line_blend_dispatch()` to pick the
+ * specialization once per effect invocation.
+ */
+template <int mode>
+struct Line_Blend {
+    // The adjustable blend mode's ratio, unused otherwise.
+    uint32_t param;
+
+    explicit Line_Blend(uint32_t param) : param(param) {}
+    void px(uint32_t color, uint32_t* dest) const {
+        switch (mode) {
+            default: blend_replace_1px(&color, dest); break;
+            case 1: blend_add_1px(&color, dest, dest); break;
+            case 2: blend_maximum_1px(&color, dest, dest); break;
+            case 3: blend_5050_1px(&color, dest, dest); break;
+            case 4: blend_sub_src1_from_src2_1px(&color, dest, dest); break;
+            case 5: blend_sub_src2_from_src1_1px(&color, dest, dest); break;
+            case 6: blend_multiply_1px(&color, dest, dest); break;
+            case 7: blend_adjustable_1px(&color, dest, dest, this->param); break;
+            case 8: blend_xor_1px(&color, dest, dest); break;
+            case 9: blend_minimum_1px(&color, dest, dest); break;
+        }
+    }
+    void fill(uint32_t color, uint32_t* dest, uint32_t w) const {
+        switch (mode) {
+            default: blend_replace_fill(color, dest, w); break;
+            case 1: blend_add_fill(color, dest, w); break;
+            case 2: blend_maximum_fill(color, dest, w); break;
+            case 3: blend_5050_fill(color, dest, w); break;
+            case 4: blend_sub_src1_from_src2_fill(color, dest, w); break;
+            case 5: blend_sub_src2_from_src1_fill(color, dest, w); break;
+            case 6: blend_multiply_fill(color, dest, w); break;
+            case 7: blend_adjustable_fill(color, dest, dest, this->param, w); break;
+            case 8: blend_xor_fill(color, dest, w); break;
+            case 9: blend_minimum_fill(color, dest, w); break;
+        }
+    }
+};
+
+// Call `draw(blend)` with the `Line_Blend` specialization matching `line_blend_mode`
+// (usually `g_line_blend_mode`). `draw` is typically a generic lambda around the
+// effect's drawing loop.
+template <typename Draw>
+inline void line_blend_dispatch(int32_t line_blend_mode, Draw draw) {
+    uint32_t param = line_blend_mode >> 8 & 0xff;
+    switch (line_blend_mode & 0xff) {
+        default: draw(Line_Blend<0>(param)); break;
+        case 1: draw(Line_Blend<1>(param)); break;
+        case 2: draw(Line_Blend<2>(param)); break;
+        case 3: draw(Line_Blend<3>(param)); break;
+        case 4: draw(Line_Blend<4>(param)); break;
+        case 5: draw(Line_Blend<5>(param)); break;
+        case 6: draw(Line_Blend<6>(param)); break;
+        case 7: draw(Line_Blend<7>(param)); break;
+        case 8: draw(Line_Blend<8>(param)); break;
+        case 9: draw(Line_Blend<9>(param)); break;
+    }
+}
+
 uint32_t blend_bilinear_2x2(const uint32_t* src,
                             uint32_t w,
                             uint8_t lerp_x,
                             uint8_t lerp_y);
+// Bilinear-filter `n` pixels, each from the 2x2 block at `src[offsets[i]]` with its
+// own lerp values. Same result as calling `blend_bilinear_2x2()` for each pixel.
+void blend_bilinear_2x2_gather(const uint32_t* src,
+                               uint32_t w,
+                               const int32_t* offsets,
+                               const uint8_t* lerp_x,
+                               const uint8_t* lerp_y,
+                               uint32_t* dest,
+                               size_t n);
+// Sample `n` consecutive pixels along a line through `src` (of width `w`). The
+// coordinates are 16.16 fixed-point and advance by `ds` and `dt` per pixel. If `wrap_s`
+// or `wrap_t` is not 0, the coordinate is kept within [0, wrap), which requires that it
+// starts out within that range, that the step is smaller than the wrap value, and that
+// 2 * wrap doesn't overflow. With `bilinear` the 2x2 block at each position is filtered
+// like `blend_bilinear_2x2()` does, otherwise the pixel is copied.
+void blend_affine_row(const uint32_t* src,
+                      uint32_t w,
+                      int32_t s,
+                      int32_t t,
+                      int32_t ds,
+                      int32_t dt,
+                      int32_t wrap_s,
+                      int32_t wrap_t,
+                      bool bilinear,
+                      uint32_t* dest,
+                      size_t n);
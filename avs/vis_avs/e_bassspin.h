@@ -22,6 +22,7 @@ struct BassSpin_Info : public Effect_Info {
     static constexpr char const* help = "";
     static constexpr int32_t legacy_id = 7;
     static constexpr char const* legacy_ape_id = nullptr;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_SPEC;
 
     static const char* const* modes(int64_t* length_out) {
         *length_out = 2;
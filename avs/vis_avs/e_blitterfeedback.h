@@ -22,6 +22,7 @@ struct BlitterFeedback_Info : public Effect_Info {
     static constexpr char const* help = "";
     static constexpr int32_t legacy_id = 4;
     static constexpr char const* legacy_ape_id = nullptr;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static const char* const* blend_modes(int64_t* length_out) {
         *length_out = 2;
@@ -72,18 +73,48 @@ class E_BlitterFeedback
     virtual void load_legacy(unsigned char* data, int len);
     virtual int save_legacy(unsigned char* data);
     virtual E_BlitterFeedback* clone() { return new E_BlitterFeedback(*this); }
+
+    virtual bool can_multithread() { return true; }
+    virtual int smp_begin(int max_threads,
+                          char visdata[2][2][576],
+                          int is_beat,
+                          int* framebuffer,
+                          int* fbout,
+                          int w,
+                          int h);
+    virtual void smp_render(int this_thread,
+                            int max_threads,
+                            char visdata[2][2][576],
+                            int is_beat,
+                            int* framebuffer,
+                            int* fbout,
+                            int w,
+                            int h);
+    virtual int smp_finish(char visdata[2][2][576],
+                           int is_beat,
+                           int* framebuffer,
+                           int* fbout,
+                           int w,
+                           int h);
+
     void set_current_zoom(int32_t zoom);
 
    private:
-    int32_t blitter_normal(uint32_t* framebuffer,
-                           uint32_t* fbout,
-                           int w,
-                           int h,
-                           int32_t zoom);
-    int32_t blitter_out(uint32_t* framebuffer,
+    void blitter_normal(uint32_t* framebuffer,
                         uint32_t* fbout,
                         int w,
                         int h,
-                        int32_t zoom);
+                        int32_t zoom,
+                        int start_l,
+                        int end_l);
+    void blitter_out(uint32_t* framebuffer,
+                     uint32_t* fbout,
+                     int w,
+                     int h,
+                     int32_t zoom,
+                     int start_l,
+                     int end_l);
     int32_t current_zoom;
+    // The zoom level of the current frame, set up in smp_begin().
+    int32_t frame_zoom;
 };
@@ -35,6 +35,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "blend.h"
 #include "instance.h"
 
+#include <immintrin.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -67,7 +68,11 @@ E_Bump::E_Bump(AVS_Instance* avs)
     : Programmable_Effect(avs),
       cur_depth(this->config.depth),
       on_beat_fadeout(0),
-      use_old_xy_range(0) {}
+      use_old_xy_range(0),
+      depth_src(nullptr),
+      center_x(0),
+      center_y(0),
+      depth_scaled(0) {}
 E_Bump::~E_Bump() {}
 
 static inline uint32_t max_channel(uint32_t color, bool invert) {
@@ -94,38 +99,300 @@ static inline uint32_t set_far_depth(uint32_t c) {
 
 #define abs(x) ((x) >= 0 ? (x) : -(x))
 
+template <int blend_mode>
+static inline void bump_px_c(const uint32_t* depth,
+                             const uint32_t* fb_in,
+                             uint32_t* fb_out,
+                             int w,
+                             int light_x,
+                             int light_y,
+                             int depth_scaled,
+                             bool invert,
+                             bool skip_empty) {
+    uint32_t left = depth[-1];
+    uint32_t right = depth[1];
+    uint32_t above = depth[-w];
+    uint32_t below = depth[w];
+    if (skip_empty && !(left || right || above || below)) {
+        return;
+    }
+    int x_distance = max_channel(right, invert) - max_channel(left, invert) - light_x;
+    int y_distance = max_channel(below, invert) - max_channel(above, invert) - light_y;
+    x_distance = 127 - abs(x_distance);
+    y_distance = 127 - abs(y_distance);
+    uint32_t distance;
+    if (x_distance <= 0 || y_distance <= 0) {
+        distance = set_far_depth(*fb_in);
+    } else {
+        int xy_combined = (x_distance * y_distance * depth_scaled) >> (8 + 6);
+        distance = set_depth(xy_combined, *fb_in);
+    }
+    switch (blend_mode) {
+        case BLEND_SIMPLE_ADDITIVE: blend_add_1px(&distance, fb_in, fb_out); break;
+        case BLEND_SIMPLE_5050: blend_5050_1px(&distance, fb_in, fb_out); break;
+        default: blend_replace_1px(&distance, fb_out); break;
+    }
+}
+
+#ifdef SIMD_MODE_X86_SSE
+/*
+The SIMD versions clamp both distances to 0 instead of branching, which makes the
+light distance 0 as well and thus results in the same "far depth" color. This needs
+the depth scale to fit into 15 bits, in order to use 16-bit multiplies: Each distance
+is at most 127 and so is their product (in 16-bit) times the depth scale (in 32-bit).
+Also the light distance is clamped to 254 first, which gives the same result as the
+per-channel clamping in set_depth().
+*/
+static inline __m128i max_channel_x86v128(__m128i color_4px, bool invert) {
+    __m128i max_4px = _mm_max_epu8(color_4px, _mm_srli_epi32(color_4px, 8));
+    max_4px = _mm_max_epu8(max_4px, _mm_srli_epi32(color_4px, 16));
+    max_4px = _mm_and_si128(max_4px, _mm_set1_epi32(0xff));
+    return invert ? _mm_sub_epi32(_mm_set1_epi32(255), max_4px) : max_4px;
+}
+
+static inline __m128i distance_x86v128(__m128i high_4px,
+                                       __m128i low_4px,
+                                       __m128i light_4x,
+                                       bool invert) {
+    __m128i distance = _mm_sub_epi32(max_channel_x86v128(high_4px, invert),
+                                     max_channel_x86v128(low_4px, invert));
+    distance = _mm_sub_epi32(_mm_set1_epi32(127),
+                             _mm_abs_epi32(_mm_sub_epi32(distance, light_4x)));
+    return _mm_and_si128(distance, _mm_cmpgt_epi32(distance, _mm_setzero_si128()));
+}
+
+template <int blend_mode>
+static inline void bump_4px_x86v128(const uint32_t* depth,
+                                    const uint32_t* fb_in,
+                                    uint32_t* fb_out,
+                                    int w,
+                                    __m128i light_x_4x,
+                                    __m128i light_y_4x,
+                                    __m128i depth_scaled_4x,
+                                    bool invert,
+                                    bool skip_empty) {
+    __m128i left = _mm_loadu_si128((__m128i*)&depth[-1]);
+    __m128i right = _mm_loadu_si128((__m128i*)&depth[1]);
+    __m128i above = _mm_loadu_si128((__m128i*)&depth[-w]);
+    __m128i below = _mm_loadu_si128((__m128i*)&depth[w]);
+    __m128i x_distance = distance_x86v128(right, left, light_x_4x, invert);
+    __m128i y_distance = distance_x86v128(below, above, light_y_4x, invert);
+    __m128i xy_combined = _mm_madd_epi16(_mm_mullo_epi16(x_distance, y_distance),
+                                         depth_scaled_4x);
+    xy_combined =
+        _mm_min_epi16(_mm_srli_epi32(xy_combined, 8 + 6), _mm_set1_epi32(254));
+    // Spread the light distance to the three color channels.
+    xy_combined = _mm_or_si128(xy_combined, _mm_slli_epi32(xy_combined, 8));
+    xy_combined = _mm_or_si128(xy_combined, _mm_slli_epi32(xy_combined, 8));
+    __m128i rgb_mask = _mm_set1_epi32(0x00ffffff);
+    __m128i in = _mm_loadu_si128((__m128i*)fb_in);
+    __m128i distance =
+        _mm_min_epu8(_mm_adds_epu8(_mm_and_si128(in, rgb_mask), xy_combined),
+                     _mm_set1_epi32(0x00fefefe));
+    __m128i out;
+    switch (blend_mode) {
+        case BLEND_SIMPLE_ADDITIVE:
+            out = _mm_and_si128(_mm_adds_epu8(distance, in), rgb_mask);
+            break;
+        case BLEND_SIMPLE_5050: {
+            __m128i strip_high_bit_mask = _mm_set1_epi32(0x007f7f7f);
+            out = _mm_add_epi8(
+                _mm_and_si128(_mm_srli_epi16(distance, 1), strip_high_bit_mask),
+                _mm_and_si128(_mm_srli_epi16(in, 1), strip_high_bit_mask));
+            break;
+        }
+        default: out = distance; break;
+    }
+    if (skip_empty) {
+        __m128i empty = _mm_cmpeq_epi32(
+            _mm_or_si128(_mm_or_si128(left, right), _mm_or_si128(above, below)),
+            _mm_setzero_si128());
+        out = _mm_or_si128(_mm_and_si128(empty, _mm_loadu_si128((__m128i*)fb_out)),
+                           _mm_andnot_si128(empty, out));
+    }
+    _mm_storeu_si128((__m128i*)fb_out, out);
+}
+
+#ifdef __AVX2__
+static inline __m256i max_channel_x86v256(__m256i color_8px, bool invert) {
+    __m256i max_8px = _mm256_max_epu8(color_8px, _mm256_srli_epi32(color_8px, 8));
+    max_8px = _mm256_max_epu8(max_8px, _mm256_srli_epi32(color_8px, 16));
+    max_8px = _mm256_and_si256(max_8px, _mm256_set1_epi32(0xff));
+    return invert ? _mm256_sub_epi32(_mm256_set1_epi32(255), max_8px) : max_8px;
+}
+
+static inline __m256i distance_x86v256(__m256i high_8px,
+                                       __m256i low_8px,
+                                       __m256i light_8x,
+                                       bool invert) {
+    __m256i distance = _mm256_sub_epi32(max_channel_x86v256(high_8px, invert),
+                                        max_channel_x86v256(low_8px, invert));
+    distance = _mm256_sub_epi32(_mm256_set1_epi32(127),
+                                _mm256_abs_epi32(_mm256_sub_epi32(distance, light_8x)));
+    return _mm256_and_si256(distance,
+                            _mm256_cmpgt_epi32(distance, _mm256_setzero_si256()));
+}
+
+template <int blend_mode>
+static inline void bump_8px_x86v256(const uint32_t* depth,
+                                    const uint32_t* fb_in,
+                                    uint32_t* fb_out,
+                                    int w,
+                                    __m256i light_x_8x,
+                                    __m256i light_y_8x,
+                                    __m256i depth_scaled_8x,
+                                    bool invert,
+                                    bool skip_empty) {
+    __m256i left = _mm256_loadu_si256((__m256i*)&depth[-1]);
+    __m256i right = _mm256_loadu_si256((__m256i*)&depth[1]);
+    __m256i above = _mm256_loadu_si256((__m256i*)&depth[-w]);
+    __m256i below = _mm256_loadu_si256((__m256i*)&depth[w]);
+    __m256i x_distance = distance_x86v256(right, left, light_x_8x, invert);
+    __m256i y_distance = distance_x86v256(below, above, light_y_8x, invert);
+    __m256i xy_combined = _mm256_madd_epi16(
+        _mm256_mullo_epi16(x_distance, y_distance), depth_scaled_8x);
+    xy_combined = _mm256_min_epi16(_mm256_srli_epi32(xy_combined, 8 + 6),
+                                   _mm256_set1_epi32(254));
+    xy_combined = _mm256_or_si256(xy_combined, _mm256_slli_epi32(xy_combined, 8));
+    xy_combined = _mm256_or_si256(xy_combined, _mm256_slli_epi32(xy_combined, 8));
+    __m256i rgb_mask = _mm256_set1_epi32(0x00ffffff);
+    __m256i in = _mm256_loadu_si256((__m256i*)fb_in);
+    __m256i distance =
+        _mm256_min_epu8(_mm256_adds_epu8(_mm256_and_si256(in, rgb_mask), xy_combined),
+                        _mm256_set1_epi32(0x00fefefe));
+    __m256i out;
+    switch (blend_mode) {
+        case BLEND_SIMPLE_ADDITIVE:
+            out = _mm256_and_si256(_mm256_adds_epu8(distance, in), rgb_mask);
+            break;
+        case BLEND_SIMPLE_5050: {
+            __m256i strip_high_bit_mask = _mm256_set1_epi32(0x007f7f7f);
+            out = _mm256_add_epi8(
+                _mm256_and_si256(_mm256_srli_epi16(distance, 1), strip_high_bit_mask),
+                _mm256_and_si256(_mm256_srli_epi16(in, 1), strip_high_bit_mask));
+            break;
+        }
+        default: out = distance; break;
+    }
+    if (skip_empty) {
+        __m256i neighbors = _mm256_or_si256(_mm256_or_si256(left, right),
+                                            _mm256_or_si256(above, below));
+        __m256i empty = _mm256_cmpeq_epi32(neighbors, _mm256_setzero_si256());
+        out = _mm256_blendv_epi8(out, _mm256_loadu_si256((__m256i*)fb_out), empty);
+    }
+    _mm256_storeu_si256((__m256i*)fb_out, out);
+}
+#endif  // __AVX2__
+#endif  // SIMD_MODE_X86_SSE
+
+/* Renders the inner pixels of one row, the pointers point to the pixel in column 1. */
+template <int blend_mode>
+static void bump_row(const uint32_t* depth,
+                     const uint32_t* fb_in,
+                     uint32_t* fb_out,
+                     int w,
+                     int light_x,
+                     int light_y,
+                     int depth_scaled,
+                     bool invert,
+                     bool skip_empty) {
+    int length = w - 2;
+    int i = 0;
+#ifdef SIMD_MODE_X86_SSE
+    if (depth_scaled >= 0 && depth_scaled <= INT16_MAX) {
+#ifdef __AVX2__
+        __m256i light_y_8x = _mm256_set1_epi32(light_y);
+        __m256i depth_scaled_8x = _mm256_set1_epi32(depth_scaled);
+        __m256i light_x_8x = _mm256_add_epi32(
+            _mm256_set1_epi32(light_x), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        for (; i + 8 <= length; i += 8) {
+            bump_8px_x86v256<blend_mode>(&depth[i],
+                                         &fb_in[i],
+                                         &fb_out[i],
+                                         w,
+                                         light_x_8x,
+                                         light_y_8x,
+                                         depth_scaled_8x,
+                                         invert,
+                                         skip_empty);
+            light_x_8x = _mm256_add_epi32(light_x_8x, _mm256_set1_epi32(8));
+        }
+#endif
+        __m128i light_y_4x = _mm_set1_epi32(light_y);
+        __m128i depth_scaled_4x = _mm_set1_epi32(depth_scaled);
+        __m128i light_x_4x =
+            _mm_add_epi32(_mm_set1_epi32(light_x + i), _mm_setr_epi32(0, 1, 2, 3));
+        for (; i + 4 <= length; i += 4) {
+            bump_4px_x86v128<blend_mode>(&depth[i],
+                                         &fb_in[i],
+                                         &fb_out[i],
+                                         w,
+                                         light_x_4x,
+                                         light_y_4x,
+                                         depth_scaled_4x,
+                                         invert,
+                                         skip_empty);
+            light_x_4x = _mm_add_epi32(light_x_4x, _mm_set1_epi32(4));
+        }
+    }
+#endif
+    for (; i < length; i++) {
+        bump_px_c<blend_mode>(&depth[i],
+                              &fb_in[i],
+                              &fb_out[i],
+                              w,
+                              light_x + i,
+                              light_y,
+                              depth_scaled,
+                              invert,
+                              skip_empty);
+    }
+}
+
 int E_Bump::render(char visdata[2][2][576],
                    int is_beat,
                    int* framebuffer,
                    int* fbout,
                    int w,
                    int h) {
-    int32_t center_x;
-    int32_t center_y;
-    bool use_cur_buf;
+    int max_threads = this->smp_begin(1, visdata, is_beat, framebuffer, fbout, w, h);
+    if ((is_beat & 0x80000000) || max_threads < 1) {
+        return 0;
+    }
+    this->smp_render(0, 1, visdata, is_beat, framebuffer, fbout, w, h);
+    return this->smp_finish(visdata, is_beat, framebuffer, fbout, w, h);
+}
 
+int E_Bump::smp_begin(int max_threads,
+                      char[2][2][576],
+                      int is_beat,
+                      int* framebuffer,
+                      int*,
+                      int w,
+                      int h) {
     this->recompile_if_needed();
     if (is_beat & 0x80000000) {
         return 0;
     }
 
-    uint32_t* src_buffer = this->config.depth_buffer == 0
-                               ? (uint32_t*)framebuffer
-                               : (uint32_t*)this->avs->get_buffer(
-                                     w, h, this->config.depth_buffer - 1, false);
-    if (!src_buffer) {
+    // The global buffer is read directly, there's no need to copy it.
+    this->depth_src = this->config.depth_buffer == 0
+                          ? (uint32_t*)framebuffer
+                          : (uint32_t*)this->avs->get_buffer(
+                                w, h, this->config.depth_buffer - 1, false);
+    if (!this->depth_src) {
         return 0;
     }
 
     if (this->need_init) {
-        this->code_init.exec(visdata);
+        this->code_init.exec();
         this->need_init = false;
         *this->vars.bi = 1.0;
     }
 
-    this->code_frame.exec(visdata);
+    this->code_frame.exec();
     if (is_beat) {
-        this->code_beat.exec(visdata);
+        this->code_beat.exec();
     }
     this->init_variables(w, h, is_beat, this->on_beat_fadeout);
 
@@ -136,20 +403,15 @@ int E_Bump::render(char visdata[2][2][576],
         this->cur_depth = this->config.depth;
     }
 
-    memset(fbout, 0, w * h * 4);  // previous effects may have left fbout in a mess
-
     if (this->use_old_xy_range) {
-        center_x = *this->vars.x / 100.0 * w;
-        center_y = *this->vars.y / 100.0 * h;
+        this->center_x = *this->vars.x / 100.0 * w;
+        this->center_y = *this->vars.y / 100.0 * h;
     } else {
-        center_x = *this->vars.x * w;
-        center_y = *this->vars.y * h;
-    }
-    center_x = max(0, min(w, center_x));
-    center_y = max(0, min(h, center_y));
-    if (this->config.show_light_pos) {
-        fbout[center_x + center_y * w] = 0xFFFFFF;
+        this->center_x = *this->vars.x * w;
+        this->center_y = *this->vars.y * h;
     }
+    this->center_x = max(0, min(w, this->center_x));
+    this->center_y = max(0, min(h, this->center_y));
 
     if (*this->vars.bi < 0.0) {
         *this->vars.bi = 0.0;
@@ -157,133 +419,91 @@ int E_Bump::render(char visdata[2][2][576],
         *this->vars.bi = 1.0;
     }
     this->cur_depth = (int)(this->cur_depth * *this->vars.bi);
+    this->depth_scaled = (this->cur_depth << 8) / 100;
+
+    return max_threads;
+}
+
+void E_Bump::smp_render(int this_thread,
+                        int max_threads,
+                        char[2][2][576],
+                        int,
+                        int* framebuffer,
+                        int* fbout,
+                        int w,
+                        int h) {
+    if (max_threads < 1) {
+        max_threads = 1;
+    }
+    int start_l = (this_thread * h) / max_threads;
+    int end_l;
+    if (this_thread >= max_threads - 1) {
+        end_l = h;
+    } else {
+        end_l = ((this_thread + 1) * h) / max_threads;
+    }
+    if (end_l <= start_l) {
+        return;
+    }
+
+    // previous effects may have left fbout in a mess
+    memset(&fbout[start_l * w], 0, (end_l - start_l) * w * sizeof(uint32_t));
+
+    int light_pos = this->center_x + this->center_y * w;
+    if (this->config.show_light_pos && light_pos >= start_l * w
+        && light_pos < end_l * w) {
+        fbout[light_pos] = 0xFFFFFF;
+    }
 
-    int depth_scaled = (this->cur_depth << 8) / 100;
-    src_buffer += w + 1;
-    framebuffer += w + 1;
-    fbout += w + 1;
-
-    int light_y = 1 - center_y;
-    int i = h - 2;
-    int left;
-    int right;
-    int above;
-    int below;
-    int x_distance;
-    int y_distance;
-    int xy_combined;
-    uint32_t distance;
     auto fb_in = (uint32_t*)framebuffer;
     auto fb_out = (uint32_t*)fbout;
-    use_cur_buf = (src_buffer == fb_in);
-    while (i--) {
-        int j = w - 2;
-        int light_x = 1 - center_x;
+    // Pixels surrounded by black are skipped if the depth is taken from the image.
+    bool skip_empty = this->depth_src == fb_in;
+    bool invert = this->config.invert_depth;
+    int light_x = 1 - this->center_x;
+    for (int y = max(start_l, 1); y < min(end_l, h - 1); y++) {
+        int offset = y * w + 1;
+        int light_y = y - this->center_y;
         switch (this->config.blend_mode) {
-            case BLEND_SIMPLE_ADDITIVE: {
-                while (j--) {
-                    left = src_buffer[-1];
-                    right = src_buffer[1];
-                    above = src_buffer[-w];
-                    below = src_buffer[w];
-                    if (!use_cur_buf
-                        || (use_cur_buf && (left || right || above || below))) {
-                        x_distance = max_channel(right, this->config.invert_depth)
-                                     - max_channel(left, this->config.invert_depth)
-                                     - light_x;
-                        y_distance = max_channel(below, this->config.invert_depth)
-                                     - max_channel(above, this->config.invert_depth)
-                                     - light_y;
-                        x_distance = 127 - abs(x_distance);
-                        y_distance = 127 - abs(y_distance);
-                        if (x_distance <= 0 || y_distance <= 0) {
-                            distance = set_far_depth(*fb_in);
-                        } else {
-                            xy_combined =
-                                (x_distance * y_distance * depth_scaled) >> (8 + 6);
-                            distance = set_depth(xy_combined, *fb_in);
-                        }
-                        blend_add_1px(&distance, fb_in, fb_out);
-                    }
-                    src_buffer++;
-                    fb_in++;
-                    fb_out++;
-                    light_x++;
-                }
+            case BLEND_SIMPLE_ADDITIVE:
+                bump_row<BLEND_SIMPLE_ADDITIVE>(&this->depth_src[offset],
+                                                &fb_in[offset],
+                                                &fb_out[offset],
+                                                w,
+                                                light_x,
+                                                light_y,
+                                                this->depth_scaled,
+                                                invert,
+                                                skip_empty);
                 break;
-            }
-            case BLEND_SIMPLE_5050: {
-                while (j--) {
-                    left = src_buffer[-1];
-                    right = src_buffer[1];
-                    above = src_buffer[-w];
-                    below = src_buffer[w];
-                    if (!use_cur_buf
-                        || (use_cur_buf && (left || right || above || below))) {
-                        x_distance = max_channel(right, this->config.invert_depth)
-                                     - max_channel(left, this->config.invert_depth)
-                                     - light_x;
-                        y_distance = max_channel(below, this->config.invert_depth)
-                                     - max_channel(above, this->config.invert_depth)
-                                     - light_y;
-                        x_distance = 127 - abs(x_distance);
-                        y_distance = 127 - abs(y_distance);
-                        if (x_distance <= 0 || y_distance <= 0) {
-                            distance = set_far_depth(*fb_in);
-                        } else {
-                            xy_combined =
-                                (x_distance * y_distance * depth_scaled) >> (8 + 6);
-                            distance = set_depth(xy_combined, *fb_in);
-                        }
-                        blend_5050_1px(&distance, fb_in, fb_out);
-                    }
-                    src_buffer++;
-                    fb_in++;
-                    fb_out++;
-                    light_x++;
-                }
+            case BLEND_SIMPLE_5050:
+                bump_row<BLEND_SIMPLE_5050>(&this->depth_src[offset],
+                                            &fb_in[offset],
+                                            &fb_out[offset],
+                                            w,
+                                            light_x,
+                                            light_y,
+                                            this->depth_scaled,
+                                            invert,
+                                            skip_empty);
                 break;
-            }
             default:
-            case BLEND_SIMPLE_REPLACE: {
-                while (j--) {
-                    left = src_buffer[-1];
-                    right = src_buffer[1];
-                    above = src_buffer[-w];
-                    below = src_buffer[w];
-                    if (!use_cur_buf
-                        || (use_cur_buf && (left || right || above || below))) {
-                        x_distance = max_channel(right, this->config.invert_depth)
-                                     - max_channel(left, this->config.invert_depth)
-                                     - light_x;
-                        y_distance = max_channel(below, this->config.invert_depth)
-                                     - max_channel(above, this->config.invert_depth)
-                                     - light_y;
-                        x_distance = 127 - abs(x_distance);
-                        y_distance = 127 - abs(y_distance);
-                        if (x_distance <= 0 || y_distance <= 0) {
-                            distance = set_far_depth(*fb_in);
-                        } else {
-                            xy_combined =
-                                (x_distance * y_distance * depth_scaled) >> (8 + 6);
-                            distance = set_depth(xy_combined, *fb_in);
-                        }
-                        blend_replace_1px(&distance, fb_out);
-                    }
-                    src_buffer++;
-                    fb_in++;
-                    fb_out++;
-                    light_x++;
-                }
+            case BLEND_SIMPLE_REPLACE:
+                bump_row<BLEND_SIMPLE_REPLACE>(&this->depth_src[offset],
+                                               &fb_in[offset],
+                                               &fb_out[offset],
+                                               w,
+                                               light_x,
+                                               light_y,
+                                               this->depth_scaled,
+                                               invert,
+                                               skip_empty);
                 break;
-            }
         }
-        src_buffer += 2;
-        fb_in += 2;
-        fb_out += 2;
-        light_y++;
     }
+}
 
+int E_Bump::smp_finish(char[2][2][576], int, int*, int*, int, int) {
     if (this->on_beat_fadeout > 0) {
         this->on_beat_fadeout--;
         if (this->on_beat_fadeout) {
@@ -49,6 +49,7 @@ struct Bump_Info : public Effect_Info {
         "      Frame: x=0.5+cos(t)*0.3; y=0.5+cos(u)*0.3; t=t+0.1; u=u+0.012;\r\n";
     static constexpr int32_t legacy_id = 29;
     static constexpr char* legacy_ape_id = NULL;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static void recompile(Effect*, const Parameter*, const std::vector<int64_t>&);
     static constexpr uint32_t num_parameters = 11;
@@ -94,7 +95,35 @@ class E_Bump : public Programmable_Effect<Bump_Info, Bump_Config, Bump_Vars> {
     virtual int save_legacy(unsigned char* data);
     virtual E_Bump* clone() { return new E_Bump(*this); }
 
+    virtual bool can_multithread() { return true; }
+    virtual int smp_begin(int max_threads,
+                          char visdata[2][2][576],
+                          int is_beat,
+                          int* framebuffer,
+                          int* fbout,
+                          int w,
+                          int h);
+    virtual void smp_render(int this_thread,
+                            int max_threads,
+                            char visdata[2][2][576],
+                            int is_beat,
+                            int* framebuffer,
+                            int* fbout,
+                            int w,
+                            int h);
+    virtual int smp_finish(char visdata[2][2][576],
+                           int is_beat,
+                           int* framebuffer,
+                           int* fbout,
+                           int w,
+                           int h);
+
     int cur_depth;
     int on_beat_fadeout;
     bool use_old_xy_range;
+    // Per-frame state, set up in smp_begin() for all threads.
+    uint32_t* depth_src;
+    int32_t center_x;
+    int32_t center_y;
+    int depth_scaled;
 };
@@ -29,6 +29,7 @@ struct Colorfade_Info : public Effect_Info {
     static constexpr char const* help = "";
     static constexpr int32_t legacy_id = 11;
     static constexpr char* legacy_ape_id = nullptr;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static constexpr uint32_t num_parameters = 9;
     static constexpr Parameter parameters[num_parameters] = {
@@ -9,9 +9,8 @@ were thankfully plainly visible in the decompiled binary), and the actual mappin
 code is fairly straightforward.
 
 The original implementation used MMX asm, which has been updated to using SSE2/SSSE3
-intrinsics. The code could further be sped up by leveraging the "gather" instructions
-available with Intel's AVX2 extension (ca. 2014 and later CPU models) to load colors by
-index from the baked map.
+intrinsics. If available, the "gather" instructions of Intel's AVX2 extension (ca. 2014
+and later CPU models) are used to load colors by index from the color table.
 */
 #include "e_colormap.h"
 
@@ -19,7 +18,11 @@ index from the baked map.
 
 #include <algorithm>  // std::sort & std::reverse for map colors
 #include <cstdio>
+#include <cstring>
 #include <time.h>
+#ifdef SIMD_MODE_X86_SSE
+#include <immintrin.h>
+#endif
 
 // Integer range-mapping macros. Avoid truncation by multiplying first.
 // Map point A from one value range to another.
@@ -165,6 +168,7 @@ void E_ColorMap::bake_full_map(size_t map_index) {
     for (; cache_index < NUM_COLOR_VALUES; cache_index++) {
         this->config.maps[map_index].baked_map[cache_index] = last.color;
     }
+    this->color_lut_stale = true;
 }
 
 bool E_ColorMap::any_maps_enabled() {
@@ -178,70 +182,64 @@ bool E_ColorMap::any_maps_enabled() {
     return any_maps_enabled;
 }
 
-std::vector<uint64_t>& E_ColorMap::animate_map_frame(int is_beat) {
+void E_ColorMap::animate_map_frame(int is_beat) {
     this->config.next_map %= COLORMAP_NUM_MAPS;
     if (this->config.map_cycle_mode == COLORMAP_MAP_CYCLE_NONE
         || this->config.disable_map_change) {
         this->change_animation_step = 0;
-        return this->config.maps[this->config.current_map].baked_map;
-    } else {
-        this->change_animation_step += this->config.map_cycle_speed;
-        this->change_animation_step =
-            min(this->change_animation_step, COLORMAP_MAP_CYCLE_ANIMATION_STEPS);
-        if (is_beat
-            && (!this->config.dont_skip_fast_beats
-                || this->change_animation_step == COLORMAP_MAP_CYCLE_ANIMATION_STEPS)) {
-            if (this->any_maps_enabled()) {
-                do {
-                    if (this->config.map_cycle_mode == COLORMAP_MAP_CYCLE_BEAT_RANDOM) {
-                        this->config.next_map = rand() % COLORMAP_NUM_MAPS;
-                    } else {
-                        this->config.next_map =
-                            (this->config.next_map + 1) % COLORMAP_NUM_MAPS;
-                    }
-                } while (!this->config.maps[this->config.next_map].enabled);
-            }
-            this->change_animation_step = 0;
-        }
-        if (this->change_animation_step == 0) {
-            this->reset_tween_map();
-        } else if (this->change_animation_step == COLORMAP_MAP_CYCLE_ANIMATION_STEPS) {
-            this->config.current_map = this->config.next_map;
-            this->reset_tween_map();
-        } else {
-            if (this->config.current_map != this->config.next_map) {
-                this->animation_step();
-            } else {
-                this->reset_tween_map();
-            }
+        this->update_color_lut(false);
+        return;
+    }
+    this->change_animation_step += this->config.map_cycle_speed;
+    this->change_animation_step =
+        min(this->change_animation_step, COLORMAP_MAP_CYCLE_ANIMATION_STEPS);
+    if (is_beat
+        && (!this->config.dont_skip_fast_beats
+            || this->change_animation_step == COLORMAP_MAP_CYCLE_ANIMATION_STEPS)) {
+        if (this->any_maps_enabled()) {
+            do {
+                if (this->config.map_cycle_mode == COLORMAP_MAP_CYCLE_BEAT_RANDOM) {
+                    this->config.next_map = rand() % COLORMAP_NUM_MAPS;
+                } else {
+                    this->config.next_map =
+                        (this->config.next_map + 1) % COLORMAP_NUM_MAPS;
+                }
+            } while (!this->config.maps[this->config.next_map].enabled);
         }
-        return this->tween_map;
+        this->change_animation_step = 0;
     }
-}
-
-inline void E_ColorMap::animation_step() {
-    for (unsigned int i = 0; i < NUM_COLOR_VALUES; i++) {
-        blend_adjustable_1px(
-            (uint32_t*)&this->config.maps[this->config.current_map].baked_map[i],
-            (uint32_t*)&this->config.maps[this->config.next_map].baked_map[i],
-            (uint32_t*)&this->tween_map[i],
-            this->change_animation_step);
+    if (this->change_animation_step == COLORMAP_MAP_CYCLE_ANIMATION_STEPS) {
+        this->config.current_map = this->config.next_map;
     }
+    this->update_color_lut(this->change_animation_step > 0
+                           && this->change_animation_step
+                                  < COLORMAP_MAP_CYCLE_ANIMATION_STEPS
+                           && this->config.current_map != this->config.next_map);
 }
 
-inline void E_ColorMap::animation_step_sse2() {
-    for (unsigned int i = 0; i < NUM_COLOR_VALUES; i += 4) {
-        // __m128i four_current_values =
-        // _mm_loadu_si128((__m128i*)&(this->config.maps[this->config.current_map].baked_map[i]));
-        // __m128i four_next_values =
-        // _mm_loadu_si128((__m128i*)&(this->config.maps[this->config.next_map].baked_map[i]));
-        // __m128i blend_lerp = _mm_set1_epi8((uint8_t)this->change_animation_step);
-        /* TODO */
+void E_ColorMap::update_color_lut(bool tween) {
+    int64_t from = this->config.current_map;
+    int64_t to = tween ? this->config.next_map : from;
+    int32_t step = tween ? this->change_animation_step : 0;
+    if (!this->color_lut_stale && from == this->color_lut_from
+        && to == this->color_lut_to && step == this->color_lut_step) {
+        return;
     }
-}
-
-inline void E_ColorMap::reset_tween_map() {
-    this->tween_map = this->config.maps[this->config.current_map].baked_map;
+    const std::vector<uint64_t>& from_map = this->config.maps[from].baked_map;
+    const std::vector<uint64_t>& to_map = this->config.maps[to].baked_map;
+    for (unsigned int i = 0; i < NUM_COLOR_VALUES; i++) {
+        auto from_color = (uint32_t)from_map[i];
+        auto to_color = (uint32_t)to_map[i];
+        if (step == 0) {
+            this->color_lut[i] = from_color;
+        } else {
+            blend_adjustable_1px(&from_color, &to_color, &this->color_lut[i], step);
+        }
+    }
+    this->color_lut_from = from;
+    this->color_lut_to = to;
+    this->color_lut_step = step;
+    this->color_lut_stale = false;
 }
 
 inline int E_ColorMap::get_key(int color) {
@@ -266,117 +264,63 @@ inline int E_ColorMap::get_key(int color) {
     }
 }
 
-void E_ColorMap::blend(std::vector<uint64_t>& blend_map,
+#define COLORMAP_BLEND_LOOP(BLEND_1PX_EXPRESSION)                  \
+    for (size_t i = 0; i < length; i++) {                          \
+        uint32_t color = color_lut[this->get_key(framebuffer[i])]; \
+        BLEND_1PX_EXPRESSION;                                      \
+    }
+
+void E_ColorMap::blend(const uint32_t* color_lut,
                        uint32_t* framebuffer,
-                       int w,
-                       int h) {
-    uint32_t four_px_colors[4];
-    int four_keys[4];
+                       size_t length) {
     switch (this->config.blendmode) {
         case COLORMAP_BLENDMODE_REPLACE:
-            for (int i = 0; i < w * h; i += 4) {
-                for (int k = 0; k < 4; k++) {
-                    four_keys[k] = this->get_key(framebuffer[i + k]);
-                    blend_replace_1px(&blend_map[four_keys[k]], &framebuffer[i + k]);
-                }
-            }
+            COLORMAP_BLEND_LOOP(framebuffer[i] = color);
             break;
         case COLORMAP_BLENDMODE_ADDITIVE:
-            for (int i = 0; i < w * h; i += 4) {
-                for (int k = 0; k < 4; k++) {
-                    four_keys[k] = this->get_key(framebuffer[i + k]);
-                    four_px_colors[k] = blend_map[four_keys[k]];
-                    blend_add_1px(
-                        &four_px_colors[k], &framebuffer[i + k], &framebuffer[i + k]);
-                }
-            }
+            COLORMAP_BLEND_LOOP(
+                blend_add_1px(&color, &framebuffer[i], &framebuffer[i]));
             break;
         case COLORMAP_BLENDMODE_MAXIMUM:
-            for (int i = 0; i < w * h; i += 4) {
-                for (int k = 0; k < 4; k++) {
-                    four_keys[k] = this->get_key(framebuffer[i + k]);
-                    four_px_colors[k] = blend_map[four_keys[k]];
-                    blend_maximum_1px(
-                        &four_px_colors[k], &framebuffer[i + k], &framebuffer[i + k]);
-                }
-            }
+            COLORMAP_BLEND_LOOP(
+                blend_maximum_1px(&color, &framebuffer[i], &framebuffer[i]));
             break;
         case COLORMAP_BLENDMODE_MINIMUM:
-            for (int i = 0; i < w * h; i += 4) {
-                for (int k = 0; k < 4; k++) {
-                    four_keys[k] = this->get_key(framebuffer[i + k]);
-                    four_px_colors[k] = blend_map[four_keys[k]];
-                    blend_minimum_1px(
-                        &four_px_colors[k], &framebuffer[i + k], &framebuffer[i + k]);
-                }
-            }
+            COLORMAP_BLEND_LOOP(
+                blend_minimum_1px(&color, &framebuffer[i], &framebuffer[i]));
             break;
         case COLORMAP_BLENDMODE_5050:
-            for (int i = 0; i < w * h; i += 4) {
-                for (int k = 0; k < 4; k++) {
-                    four_keys[k] = this->get_key(framebuffer[i + k]);
-                    four_px_colors[k] = blend_map[four_keys[k]];
-                    blend_5050_1px(
-                        &four_px_colors[k], &framebuffer[i + k], &framebuffer[i + k]);
-                }
-            }
+            COLORMAP_BLEND_LOOP(
+                blend_5050_1px(&color, &framebuffer[i], &framebuffer[i]));
             break;
         case COLORMAP_BLENDMODE_SUB1:
-            for (int i = 0; i < w * h; i += 4) {
-                for (int k = 0; k < 4; k++) {
-                    four_keys[k] = this->get_key(framebuffer[i + k]);
-                    four_px_colors[k] = blend_map[four_keys[k]];
-                    blend_sub_src1_from_src2_1px(
-                        &four_px_colors[k], &framebuffer[i + k], &framebuffer[i + k]);
-                }
-            }
+            COLORMAP_BLEND_LOOP(
+                blend_sub_src1_from_src2_1px(&color, &framebuffer[i], &framebuffer[i]));
             break;
         case COLORMAP_BLENDMODE_SUB2:
-            for (int i = 0; i < w * h; i += 4) {
-                for (int k = 0; k < 4; k++) {
-                    four_keys[k] = this->get_key(framebuffer[i + k]);
-                    four_px_colors[k] = blend_map[four_keys[k]];
-                    blend_sub_src2_from_src1_1px(
-                        &framebuffer[i + k], &four_px_colors[k], &four_px_colors[k]);
-                }
-            }
+            COLORMAP_BLEND_LOOP(
+                blend_sub_src2_from_src1_1px(&color, &framebuffer[i], &framebuffer[i]));
             break;
         case COLORMAP_BLENDMODE_MULTIPLY:
-            for (int i = 0; i < w * h; i += 4) {
-                for (int k = 0; k < 4; k++) {
-                    four_keys[k] = this->get_key(framebuffer[i + k]);
-                    four_px_colors[k] = blend_map[four_keys[k]];
-                    blend_multiply_1px(
-                        &four_px_colors[k], &framebuffer[i + k], &framebuffer[i + k]);
-                }
-            }
+            COLORMAP_BLEND_LOOP(
+                blend_multiply_1px(&color, &framebuffer[i], &framebuffer[i]));
             break;
         case COLORMAP_BLENDMODE_XOR:
-            for (int i = 0; i < w * h; i += 4) {
-                for (int k = 0; k < 4; k++) {
-                    four_keys[k] = this->get_key(framebuffer[i + k]);
-                    four_px_colors[k] = blend_map[four_keys[k]];
-                    blend_xor_1px(
-                        &four_px_colors[k], &framebuffer[i + k], &framebuffer[i + k]);
-                }
-            }
+            COLORMAP_BLEND_LOOP(
+                blend_xor_1px(&color, &framebuffer[i], &framebuffer[i]));
             break;
         case COLORMAP_BLENDMODE_ADJUSTABLE:
-            for (int i = 0; i < w * h; i += 4) {
-                for (int k = 0; k < 4; k++) {
-                    four_keys[k] = this->get_key(framebuffer[i + k]);
-                    four_px_colors[k] = blend_map[four_keys[k]];
-                    blend_adjustable_1px(&four_px_colors[k],
-                                         &framebuffer[i + k],
-                                         &framebuffer[i + k],
-                                         this->config.adjustable_alpha);
-                }
-            }
+            COLORMAP_BLEND_LOOP(blend_adjustable_1px(&color,
+                                                     &framebuffer[i],
+                                                     &framebuffer[i],
+                                                     this->config.adjustable_alpha));
             break;
     }
 }
 
-inline __m128i E_ColorMap::get_key_ssse3(__m128i color4) {
+#ifdef SIMD_MODE_X86_SSE
+template <int color_key>
+static inline __m128i get_key_ssse3(__m128i color4) {
     // Gather uint8s from certain source locations. (0xff => dest will be zero.) Collect
     // the respective channels into the pixel's lower 8bits.
     __m128i gather_red = _mm_set_epi32(0xffffff0e, 0xffffff0a, 0xffffff06, 0xffffff02);
@@ -385,8 +329,7 @@ inline __m128i E_ColorMap::get_key_ssse3(__m128i color4) {
     __m128i gather_blue = _mm_set_epi32(0xffffff0c, 0xffffff08, 0xffffff04, 0xffffff00);
     __m128i max_channel_value = _mm_set1_epi32(NUM_COLOR_VALUES - 1);
     __m128i r, g;
-    __m128 color4f;
-    switch (this->config.color_key) {
+    switch (color_key) {
         case COLORMAP_COLOR_KEY_RED: return _mm_shuffle_epi8(color4, gather_red);
         case COLORMAP_COLOR_KEY_GREEN: return _mm_shuffle_epi8(color4, gather_green);
         case COLORMAP_COLOR_KEY_BLUE: return _mm_shuffle_epi8(color4, gather_blue);
@@ -414,215 +357,233 @@ inline __m128i E_ColorMap::get_key_ssse3(__m128i color4) {
             color4 = _mm_shuffle_epi8(color4, gather_blue);
             color4 = _mm_add_epi16(color4, r);
             color4 = _mm_add_epi16(color4, g);
-            // For inputs up to 255 * 3, float32 division returns the same results as
-            // integer division
-            color4f = _mm_cvtepi32_ps(color4);
-            color4f = _mm_div_ps(color4f, _mm_set1_ps(3.0f));
-            return _mm_cvtps_epi32(color4f);
-    }
-}
-
-void E_ColorMap::blend_ssse3(std::vector<uint64_t>& blend_map,
-                             uint32_t* framebuffer,
-                             int w,
-                             int h) {
-    __m128i framebuffer_4px;
-    int four_keys[4];
-    __m128i colors_4px;
-    __m128i extend_lo_p8_to_p16 =
-        _mm_set_epi32(0xff07ff06, 0xff05ff04, 0xff03ff02, 0xff01ff00);
-    __m128i extend_hi_p8_to_p16 =
-        _mm_set_epi32(0xff0fff0e, 0xff0dff0c, 0xff0bff0a, 0xff09ff08);
+            // This used to be a float division by 3 with round-to-nearest conversion,
+            // i.e. round(sum / 3), which is the same as (sum + 1) / 3. Dividing by
+            // multiplying with 2^17 / 3 (rounded up) is exact for sums < 2^15.
+            color4 = _mm_add_epi16(color4, _mm_set1_epi32(1));
+            return _mm_srli_epi32(_mm_mulhi_epu16(color4, _mm_set1_epi32(0xaaab)), 1);
+    }
+}
+
+static inline __m128i lookup_ssse3(const uint32_t* color_lut, __m128i keys) {
+#ifdef __AVX2__
+    return _mm_i32gather_epi32((const int*)color_lut, keys, 4);
+#else
+    return _mm_set_epi32(color_lut[_mm_extract_epi32(keys, 3)],
+                         color_lut[_mm_extract_epi32(keys, 2)],
+                         color_lut[_mm_extract_epi32(keys, 1)],
+                         color_lut[_mm_cvtsi128_si32(keys)]);
+#endif
+}
+
+static inline __m128i blend_4px_ssse3(int64_t blendmode,
+                                      __m128i framebuffer_4px,
+                                      __m128i colors_4px,
+                                      __m128i v,
+                                      __m128i i_v) {
+    __m128i zero = _mm_setzero_si128();
     __m128i framebuffer_2_px[2];
     __m128i colors_2_px[2];
-    switch (this->config.blendmode) {
+    switch (blendmode) {
+        default:
+        case COLORMAP_BLENDMODE_REPLACE: return colors_4px;
+        case COLORMAP_BLENDMODE_ADDITIVE:
+            return _mm_adds_epu8(framebuffer_4px, colors_4px);
+        case COLORMAP_BLENDMODE_MAXIMUM:
+            return _mm_max_epu8(framebuffer_4px, colors_4px);
+        case COLORMAP_BLENDMODE_MINIMUM:
+            return _mm_min_epu8(framebuffer_4px, colors_4px);
+        case COLORMAP_BLENDMODE_5050: return _mm_avg_epu8(framebuffer_4px, colors_4px);
+        case COLORMAP_BLENDMODE_SUB1: return _mm_subs_epu8(framebuffer_4px, colors_4px);
+        case COLORMAP_BLENDMODE_SUB2: return _mm_subs_epu8(colors_4px, framebuffer_4px);
+        case COLORMAP_BLENDMODE_XOR: return _mm_xor_si128(framebuffer_4px, colors_4px);
+        case COLORMAP_BLENDMODE_MULTIPLY:
+            // Unfortunately intel CPUs do not have a packed unsigned 8bit multiply.
+            // So the calculation becomes a matter of extending both sides of the
+            // multiplication to 16 bits, which doubles the size, resulting in 2
+            // packed 128bit values.
+            framebuffer_2_px[0] = _mm_unpacklo_epi8(framebuffer_4px, zero);
+            framebuffer_2_px[1] = _mm_unpackhi_epi8(framebuffer_4px, zero);
+            colors_2_px[0] = _mm_unpacklo_epi8(colors_4px, zero);
+            colors_2_px[1] = _mm_unpackhi_epi8(colors_4px, zero);
+            // We can then packed-multiply the half-filled 16bit (only the lower 8
+            // bits are non-zero) values. Thus we are interested only in the lower
+            // 16 bits of the 32bit result.
+            framebuffer_2_px[0] = _mm_mullo_epi16(framebuffer_2_px[0], colors_2_px[0]);
+            framebuffer_2_px[1] = _mm_mullo_epi16(framebuffer_2_px[1], colors_2_px[1]);
+            // Divide by 256 again, to normalize. This loses accuracy, because
+            // 0xff * 0xff => 0xfe, but it's the way Multiply works throughout AVS.
+            framebuffer_2_px[0] = _mm_srli_epi16(framebuffer_2_px[0], 8);
+            framebuffer_2_px[1] = _mm_srli_epi16(framebuffer_2_px[1], 8);
+            // Pack the expanded 16bit values back into 8bit values.
+            return _mm_packus_epi16(framebuffer_2_px[0], framebuffer_2_px[1]);
+        case COLORMAP_BLENDMODE_ADJUSTABLE:
+            // See Multiply blend case for details. This is basically the same
+            // thing, except that each side gets multiplied with v and 1-v
+            // respectively and then added together.
+            framebuffer_2_px[0] = _mm_unpacklo_epi8(framebuffer_4px, zero);
+            framebuffer_2_px[1] = _mm_unpackhi_epi8(framebuffer_4px, zero);
+            colors_2_px[0] = _mm_unpacklo_epi8(colors_4px, zero);
+            colors_2_px[1] = _mm_unpackhi_epi8(colors_4px, zero);
+            framebuffer_2_px[0] = _mm_mullo_epi16(framebuffer_2_px[0], i_v);
+            framebuffer_2_px[1] = _mm_mullo_epi16(framebuffer_2_px[1], i_v);
+            colors_2_px[0] = _mm_mullo_epi16(colors_2_px[0], v);
+            colors_2_px[1] = _mm_mullo_epi16(colors_2_px[1], v);
+            framebuffer_2_px[0] = _mm_adds_epu16(framebuffer_2_px[0], colors_2_px[0]);
+            framebuffer_2_px[1] = _mm_adds_epu16(framebuffer_2_px[1], colors_2_px[1]);
+            framebuffer_2_px[0] = _mm_srli_epi16(framebuffer_2_px[0], 8);
+            framebuffer_2_px[1] = _mm_srli_epi16(framebuffer_2_px[1], 8);
+            return _mm_packus_epi16(framebuffer_2_px[0], framebuffer_2_px[1]);
+    }
+}
+
+/**
+ * Key, look up and blend 4 pixels at a time. With the key mode and blend mode as
+ * template parameters, the whole per-pixel chain is inlined into a single loop.
+ * `blendmode` is only evaluated at runtime if `fused_blendmode` is -1.
+ */
+template <int color_key, int fused_blendmode>
+static void blend_ssse3(const uint32_t* color_lut,
+                        uint32_t* framebuffer,
+                        size_t length,
+                        int64_t blendmode,
+                        int64_t adjustable_alpha) {
+    if (fused_blendmode >= 0) {
+        blendmode = fused_blendmode;
+    }
+    __m128i v = _mm_set1_epi16((unsigned char)adjustable_alpha);
+    __m128i i_v = _mm_set1_epi16(COLORMAP_ADJUSTABLE_BLEND_MAX - adjustable_alpha);
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        __m128i framebuffer_4px = _mm_loadu_si128((__m128i*)&framebuffer[i]);
+        __m128i colors_4px =
+            lookup_ssse3(color_lut, get_key_ssse3<color_key>(framebuffer_4px));
+        _mm_storeu_si128(
+            (__m128i*)&framebuffer[i],
+            blend_4px_ssse3(blendmode, framebuffer_4px, colors_4px, v, i_v));
+    }
+    if (i < length) {
+        // Run the remaining pixels through the same code to get the same results.
+        uint32_t rest[4] = {0, 0, 0, 0};
+        memcpy(rest, &framebuffer[i], (length - i) * sizeof(uint32_t));
+        blend_ssse3<color_key, fused_blendmode>(
+            color_lut, rest, 4, blendmode, adjustable_alpha);
+        memcpy(&framebuffer[i], rest, (length - i) * sizeof(uint32_t));
+    }
+}
+
+template <int color_key>
+static void blend_ssse3_for_key(const uint32_t* color_lut,
+                                uint32_t* framebuffer,
+                                size_t length,
+                                int64_t blendmode,
+                                int64_t adjustable_alpha) {
+    switch (blendmode) {
         case COLORMAP_BLENDMODE_REPLACE:
-            for (int i = 0; i < w * h; i += 4) {
-                framebuffer_4px = _mm_loadu_si128((__m128i*)&framebuffer[i]);
-                _mm_store_si128((__m128i*)four_keys,
-                                this->get_key_ssse3(framebuffer_4px));
-                for (int k = 0; k < 4; k++) {
-                    framebuffer[i + k] = blend_map[four_keys[k]];
-                }
-            }
+            blend_ssse3<color_key, COLORMAP_BLENDMODE_REPLACE>(
+                color_lut, framebuffer, length, blendmode, adjustable_alpha);
             break;
         case COLORMAP_BLENDMODE_ADDITIVE:
-            for (int i = 0; i < w * h; i += 4) {
-                framebuffer_4px = _mm_loadu_si128((__m128i*)&framebuffer[i]);
-                _mm_store_si128((__m128i*)four_keys,
-                                this->get_key_ssse3(framebuffer_4px));
-                colors_4px = _mm_set_epi32(blend_map[four_keys[3]],
-                                           blend_map[four_keys[2]],
-                                           blend_map[four_keys[1]],
-                                           blend_map[four_keys[0]]);
-                framebuffer_4px = _mm_adds_epu8(framebuffer_4px, colors_4px);
-                _mm_store_si128((__m128i*)&framebuffer[i], framebuffer_4px);
-            }
+            blend_ssse3<color_key, COLORMAP_BLENDMODE_ADDITIVE>(
+                color_lut, framebuffer, length, blendmode, adjustable_alpha);
             break;
         case COLORMAP_BLENDMODE_MAXIMUM:
-            for (int i = 0; i < w * h; i += 4) {
-                framebuffer_4px = _mm_loadu_si128((__m128i*)&framebuffer[i]);
-                _mm_store_si128((__m128i*)four_keys,
-                                this->get_key_ssse3(framebuffer_4px));
-                colors_4px = _mm_set_epi32(blend_map[four_keys[3]],
-                                           blend_map[four_keys[2]],
-                                           blend_map[four_keys[1]],
-                                           blend_map[four_keys[0]]);
-                framebuffer_4px = _mm_max_epu8(framebuffer_4px, colors_4px);
-                _mm_store_si128((__m128i*)&framebuffer[i], framebuffer_4px);
-            }
+            blend_ssse3<color_key, COLORMAP_BLENDMODE_MAXIMUM>(
+                color_lut, framebuffer, length, blendmode, adjustable_alpha);
             break;
-        case COLORMAP_BLENDMODE_MINIMUM:
-            for (int i = 0; i < w * h; i += 4) {
-                framebuffer_4px = _mm_loadu_si128((__m128i*)&framebuffer[i]);
-                _mm_store_si128((__m128i*)four_keys,
-                                this->get_key_ssse3(framebuffer_4px));
-                colors_4px = _mm_set_epi32(blend_map[four_keys[3]],
-                                           blend_map[four_keys[2]],
-                                           blend_map[four_keys[1]],
-                                           blend_map[four_keys[0]]);
-                framebuffer_4px = _mm_min_epu8(framebuffer_4px, colors_4px);
-                _mm_store_si128((__m128i*)&framebuffer[i], framebuffer_4px);
-            }
+        default:
+            blend_ssse3<color_key, -1>(
+                color_lut, framebuffer, length, blendmode, adjustable_alpha);
             break;
-        case COLORMAP_BLENDMODE_5050:
-            for (int i = 0; i < w * h; i += 4) {
-                framebuffer_4px = _mm_loadu_si128((__m128i*)&framebuffer[i]);
-                _mm_store_si128((__m128i*)four_keys,
-                                this->get_key_ssse3(framebuffer_4px));
-                colors_4px = _mm_set_epi32(blend_map[four_keys[3]],
-                                           blend_map[four_keys[2]],
-                                           blend_map[four_keys[1]],
-                                           blend_map[four_keys[0]]);
-                framebuffer_4px = _mm_avg_epu8(framebuffer_4px, colors_4px);
-                _mm_store_si128((__m128i*)&framebuffer[i], framebuffer_4px);
-            }
+    }
+}
+#endif  // SIMD_MODE_X86_SSE
+
+int E_ColorMap::render(char visdata[2][2][576],
+                       int is_beat,
+                       int* framebuffer,
+                       int* fbout,
+                       int w,
+                       int h) {
+    this->smp_begin(1, visdata, is_beat, framebuffer, fbout, w, h);
+    if (is_beat & 0x80000000) {
+        return 0;
+    }
+    this->smp_render(0, 1, visdata, is_beat, framebuffer, fbout, w, h);
+    return this->smp_finish(visdata, is_beat, framebuffer, fbout, w, h);
+}
+
+int E_ColorMap::smp_begin(int max_threads,
+                          char[2][2][576],
+                          int is_beat,
+                          int*,
+                          int*,
+                          int,
+                          int) {
+    if (!(is_beat & 0x80000000)) {
+        this->animate_map_frame(is_beat);
+    }
+    return max_threads;
+}
+
+void E_ColorMap::smp_render(int this_thread,
+                            int max_threads,
+                            char[2][2][576],
+                            int,
+                            int* framebuffer,
+                            int*,
+                            int w,
+                            int h) {
+    if (max_threads < 1) {
+        max_threads = 1;
+    }
+    int start_l = (this_thread * h) / max_threads;
+    int end_l;
+    if (this_thread >= max_threads - 1) {
+        end_l = h;
+    } else {
+        end_l = ((this_thread + 1) * h) / max_threads;
+    }
+    if (end_l <= start_l) {
+        return;
+    }
+    auto band = (uint32_t*)&framebuffer[start_l * w];
+    size_t length = (size_t)(end_l - start_l) * w;
+#ifdef SIMD_MODE_X86_SSE
+    int64_t blendmode = this->config.blendmode;
+    int64_t alpha = this->config.adjustable_alpha;
+    switch (this->config.color_key) {
+        case COLORMAP_COLOR_KEY_RED:
+            blend_ssse3_for_key<COLORMAP_COLOR_KEY_RED>(
+                this->color_lut, band, length, blendmode, alpha);
             break;
-        case COLORMAP_BLENDMODE_SUB1:
-            for (int i = 0; i < w * h; i += 4) {
-                framebuffer_4px = _mm_loadu_si128((__m128i*)&framebuffer[i]);
-                _mm_store_si128((__m128i*)four_keys,
-                                this->get_key_ssse3(framebuffer_4px));
-                colors_4px = _mm_set_epi32(blend_map[four_keys[3]],
-                                           blend_map[four_keys[2]],
-                                           blend_map[four_keys[1]],
-                                           blend_map[four_keys[0]]);
-                framebuffer_4px = _mm_subs_epu8(framebuffer_4px, colors_4px);
-                _mm_store_si128((__m128i*)&framebuffer[i], framebuffer_4px);
-            }
+        case COLORMAP_COLOR_KEY_GREEN:
+            blend_ssse3_for_key<COLORMAP_COLOR_KEY_GREEN>(
+                this->color_lut, band, length, blendmode, alpha);
             break;
-        case COLORMAP_BLENDMODE_SUB2:
-            for (int i = 0; i < w * h; i += 4) {
-                framebuffer_4px = _mm_loadu_si128((__m128i*)&framebuffer[i]);
-                _mm_store_si128((__m128i*)four_keys,
-                                this->get_key_ssse3(framebuffer_4px));
-                colors_4px = _mm_set_epi32(blend_map[four_keys[3]],
-                                           blend_map[four_keys[2]],
-                                           blend_map[four_keys[1]],
-                                           blend_map[four_keys[0]]);
-                framebuffer_4px = _mm_subs_epu8(colors_4px, framebuffer_4px);
-                _mm_store_si128((__m128i*)&framebuffer[i], framebuffer_4px);
-            }
+        case COLORMAP_COLOR_KEY_BLUE:
+            blend_ssse3_for_key<COLORMAP_COLOR_KEY_BLUE>(
+                this->color_lut, band, length, blendmode, alpha);
             break;
-        case COLORMAP_BLENDMODE_MULTIPLY:
-            for (int i = 0; i < w * h; i += 4) {
-                framebuffer_4px = _mm_loadu_si128((__m128i*)&framebuffer[i]);
-                _mm_store_si128((__m128i*)four_keys,
-                                this->get_key_ssse3(framebuffer_4px));
-                colors_4px = _mm_set_epi32(blend_map[four_keys[3]],
-                                           blend_map[four_keys[2]],
-                                           blend_map[four_keys[1]],
-                                           blend_map[four_keys[0]]);
-                // Unfortunately intel CPUs do not have a packed unsigned 8bit multiply.
-                // So the calculation becomes a matter of extending both sides of the
-                // multiplication to 16 bits, which doubles the size, resulting in 2
-                // packed 128bit values.
-                framebuffer_2_px[0] =
-                    _mm_shuffle_epi8(framebuffer_4px, extend_lo_p8_to_p16);
-                framebuffer_2_px[1] =
-                    _mm_shuffle_epi8(framebuffer_4px, extend_hi_p8_to_p16);
-                colors_2_px[0] = _mm_shuffle_epi8(colors_4px, extend_lo_p8_to_p16);
-                colors_2_px[1] = _mm_shuffle_epi8(colors_4px, extend_hi_p8_to_p16);
-                // We can then packed-multiply the half-filled 16bit (only the lower 8
-                // bits are non-zero) values. Thus we are interested only in the lower
-                // 16 bits of the 32bit result.
-                framebuffer_2_px[0] =
-                    _mm_mullo_epi16(framebuffer_2_px[0], colors_2_px[0]);
-                framebuffer_2_px[1] =
-                    _mm_mullo_epi16(framebuffer_2_px[1], colors_2_px[1]);
-                // Divide by 256 again, to normalize. This loses accuracy, because
-                // 0xff * 0xff => 0xfe, but it's the way Multiply works throughout AVS.
-                framebuffer_2_px[0] = _mm_srli_epi16(framebuffer_2_px[0], 8);
-                framebuffer_2_px[1] = _mm_srli_epi16(framebuffer_2_px[1], 8);
-                // Pack the expanded 16bit values back into 8bit values.
-                framebuffer_4px =
-                    _mm_packus_epi16(framebuffer_2_px[0], framebuffer_2_px[1]);
-                _mm_store_si128((__m128i*)&framebuffer[i], framebuffer_4px);
-            }
+        case COLORMAP_COLOR_KEY_RGB_SUM_HALF:
+            blend_ssse3_for_key<COLORMAP_COLOR_KEY_RGB_SUM_HALF>(
+                this->color_lut, band, length, blendmode, alpha);
             break;
-        case COLORMAP_BLENDMODE_XOR:
-            for (int i = 0; i < w * h; i += 4) {
-                framebuffer_4px = _mm_loadu_si128((__m128i*)&framebuffer[i]);
-                _mm_store_si128((__m128i*)four_keys,
-                                this->get_key_ssse3(framebuffer_4px));
-                colors_4px = _mm_set_epi32(blend_map[four_keys[3]],
-                                           blend_map[four_keys[2]],
-                                           blend_map[four_keys[1]],
-                                           blend_map[four_keys[0]]);
-                framebuffer_4px = _mm_xor_si128(framebuffer_4px, colors_4px);
-                _mm_store_si128((__m128i*)&framebuffer[i], framebuffer_4px);
-            }
+        case COLORMAP_COLOR_KEY_MAX:
+            blend_ssse3_for_key<COLORMAP_COLOR_KEY_MAX>(
+                this->color_lut, band, length, blendmode, alpha);
             break;
-        case COLORMAP_BLENDMODE_ADJUSTABLE:
-            __m128i v = _mm_set1_epi16((unsigned char)this->config.adjustable_alpha);
-            __m128i i_v = _mm_set1_epi16(COLORMAP_ADJUSTABLE_BLEND_MAX
-                                         - this->config.adjustable_alpha);
-            for (int i = 0; i < w * h; i += 4) {
-                framebuffer_4px = _mm_loadu_si128((__m128i*)&framebuffer[i]);
-                _mm_store_si128((__m128i*)four_keys,
-                                this->get_key_ssse3(framebuffer_4px));
-                colors_4px = _mm_set_epi32(blend_map[four_keys[3]],
-                                           blend_map[four_keys[2]],
-                                           blend_map[four_keys[1]],
-                                           blend_map[four_keys[0]]);
-                // See Multiply blend case for details. This is basically the same
-                // thing, except that each side gets multiplied with v and 1-v
-                // respectively and then added together.
-                framebuffer_2_px[0] =
-                    _mm_shuffle_epi8(framebuffer_4px, extend_lo_p8_to_p16);
-                framebuffer_2_px[1] =
-                    _mm_shuffle_epi8(framebuffer_4px, extend_hi_p8_to_p16);
-                colors_2_px[0] = _mm_shuffle_epi8(colors_4px, extend_lo_p8_to_p16);
-                colors_2_px[1] = _mm_shuffle_epi8(colors_4px, extend_hi_p8_to_p16);
-                framebuffer_2_px[0] = _mm_mullo_epi16(framebuffer_2_px[0], i_v);
-                framebuffer_2_px[1] = _mm_mullo_epi16(framebuffer_2_px[1], i_v);
-                colors_2_px[0] = _mm_mullo_epi16(colors_2_px[0], v);
-                colors_2_px[1] = _mm_mullo_epi16(colors_2_px[1], v);
-                framebuffer_2_px[0] =
-                    _mm_adds_epu16(framebuffer_2_px[0], colors_2_px[0]);
-                framebuffer_2_px[1] =
-                    _mm_adds_epu16(framebuffer_2_px[1], colors_2_px[1]);
-                framebuffer_2_px[0] = _mm_srli_epi16(framebuffer_2_px[0], 8);
-                framebuffer_2_px[1] = _mm_srli_epi16(framebuffer_2_px[1], 8);
-                framebuffer_4px =
-                    _mm_packus_epi16(framebuffer_2_px[0], framebuffer_2_px[1]);
-                _mm_store_si128((__m128i*)&framebuffer[i], framebuffer_4px);
-            }
+        default:
+            blend_ssse3_for_key<COLORMAP_COLOR_KEY_RGB_AVERAGE>(
+                this->color_lut, band, length, blendmode, alpha);
             break;
     }
+#else
+    this->blend(this->color_lut, band, length);
+#endif
 }
 
-int E_ColorMap::render(char[2][2][576],
-                       int is_beat,
-                       int* framebuffer,
-                       int*,
-                       int w,
-                       int h) {
-    auto blend_map = this->animate_map_frame(is_beat);
-    this->blend_ssse3(blend_map, (uint32_t*)framebuffer, w, h);
-    // this->blend(blend_map, (uint32_t*)framebuffer, w, h);
-    return 0;
-}
+int E_ColorMap::smp_finish(char[2][2][576], int, int*, int*, int, int) { return 0; }
 
 void E_ColorMap::on_load() {
     for (size_t map_index = 0; map_index < this->config.maps.size(); map_index++) {
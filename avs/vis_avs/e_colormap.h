@@ -5,7 +5,6 @@
 #include "effect_info.h"
 #include "handles.h"
 
-#include <immintrin.h>
 #include <string>
 #include <vector>
 
@@ -132,6 +131,7 @@ struct ColorMap_Info : public Effect_Info {
         " component or close the AVS editor to enable it again.";
     static constexpr int32_t legacy_id = -1;
     static constexpr char* legacy_ape_id = "Color Map";
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static const char* const* map_cycle_modes(int64_t* length_out) {
         *length_out = 3;
@@ -237,12 +237,35 @@ class E_ColorMap : public Configurable_Effect<ColorMap_Info, ColorMap_Config> {
                        int* framebuffer,
                        int* fbout,
                        int w,
-                       int);
+                       int h);
     virtual void on_load();
     virtual void load_legacy(unsigned char* data, int len);
     virtual int save_legacy(unsigned char* data);
     virtual E_ColorMap* clone() { return new E_ColorMap(*this); }
 
+    virtual bool can_multithread() { return true; }
+    virtual int smp_begin(int max_threads,
+                          char visdata[2][2][576],
+                          int is_beat,
+                          int* framebuffer,
+                          int* fbout,
+                          int w,
+                          int h);
+    virtual void smp_render(int this_thread,
+                            int max_threads,
+                            char visdata[2][2][576],
+                            int is_beat,
+                            int* framebuffer,
+                            int* fbout,
+                            int w,
+                            int h);
+    virtual int smp_finish(char visdata[2][2][576],
+                           int is_beat,
+                           int* framebuffer,
+                           int* fbout,
+                           int w,
+                           int h);
+
     /* Other utilities */
     void flip_map(size_t map_index);
     void clear_map(size_t map_index);
@@ -250,24 +273,16 @@ class E_ColorMap : public Configurable_Effect<ColorMap_Info, ColorMap_Config> {
     void load_map(size_t map_index);
     void bake_full_map(size_t map_index);
 
-    std::vector<uint64_t> tween_map;
     int32_t change_animation_step;
 
    protected:
     int next_id = 1337;
     int get_new_id();
     bool any_maps_enabled();
-    void animation_step();
-    void animation_step_sse2();
-    void reset_tween_map();
-    std::vector<uint64_t>& animate_map_frame(int is_beat);
+    void animate_map_frame(int is_beat);
+    void update_color_lut(bool tween);
     int get_key(int color);
-    void blend(std::vector<uint64_t>& blend_map, uint32_t* framebuffer, int w, int h);
-    __m128i get_key_ssse3(__m128i color4);
-    void blend_ssse3(std::vector<uint64_t>& blend_map,
-                     uint32_t* framebuffer,
-                     int w,
-                     int h);
+    void blend(const uint32_t* color_lut, uint32_t* framebuffer, size_t length);
     size_t load_map_header(unsigned char* data, int len, size_t map_index, int pos);
     bool load_map_colors(unsigned char* data,
                          int len,
@@ -275,5 +290,12 @@ class E_ColorMap : public Configurable_Effect<ColorMap_Info, ColorMap_Config> {
                          size_t map_index,
                          uint32_t map_length);
 
-   public:
+    // The key-to-color table for the current frame, i.e. the current map's baked
+    // colors, or the in-between colors while cycling to the next map. Only rebuilt if
+    // the maps or the cycling state have changed.
+    uint32_t color_lut[NUM_COLOR_VALUES];
+    bool color_lut_stale = true;
+    int64_t color_lut_from = -1;
+    int64_t color_lut_to = -1;
+    int32_t color_lut_step = -1;
 };
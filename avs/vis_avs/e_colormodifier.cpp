@@ -79,7 +79,7 @@ E_ColorModifier::E_ColorModifier(AVS_Instance* avs)
 
 E_ColorModifier::~E_ColorModifier() {}
 
-int E_ColorModifier::render(char visdata[2][2][576],
+int E_ColorModifier::render(char[2][2][576],
                             int is_beat,
                             int* framebuffer,
                             int*,
@@ -91,13 +91,13 @@ int E_ColorModifier::render(char visdata[2][2][576],
     }
 
     if (this->need_init) {
-        this->code_init.exec(visdata);
+        this->code_init.exec();
         this->need_init = false;
     }
     this->init_variables(w, h, is_beat);
-    this->code_frame.exec(visdata);
+    this->code_frame.exec();
     if (is_beat) {
-        this->code_beat.exec(visdata);
+        this->code_beat.exec();
     }
 
     if (this->config.recompute_every_frame || !this->channel_table_valid) {
@@ -105,7 +105,7 @@ int E_ColorModifier::render(char visdata[2][2][576],
         uint8_t* t = this->channel_table;
         for (x = 0; x < 256; x++) {
             *this->vars.red = *this->vars.blue = *this->vars.green = x / 255.0;
-            this->code_point.exec(visdata);
+            this->code_point.exec();
             int r = (int)(*this->vars.red * 255.0 + 0.5);
             int g = (int)(*this->vars.green * 255.0 + 0.5);
             int b = (int)(*this->vars.blue * 255.0 + 0.5);
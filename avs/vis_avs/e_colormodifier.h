@@ -41,6 +41,7 @@ struct ColorModifier_Info : public Effect_Info {
         "Try loading an example via the 'Load Example' button for examples.";
     static constexpr int32_t legacy_id = 45;
     static constexpr char* legacy_ape_id = NULL;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static constexpr uint32_t num_examples = 10;
     static constexpr ColorModifier_Preset examples[num_examples] = {
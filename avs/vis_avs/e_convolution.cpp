@@ -8,8 +8,10 @@
 
 #include <cstdint>
 #include <cstdlib>
-
-#define MAX_DRAW_SIZE 16384
+#include <cstring>
+#ifdef SIMD_MODE_X86_SSE
+#include <immintrin.h>
+#endif
 
 #define GET_INT() \
     (data[pos] | (data[pos + 1] << 8) | (data[pos + 2] << 16) | (data[pos + 3] << 24))
@@ -69,27 +71,10 @@ void Convolution_Info::kernel_load(Effect* component,
 }
 
 E_Convolution::E_Convolution(AVS_Instance* avs)
-    : Configurable_Effect(avs),
-      draw(nullptr),
-      m64_farray(),
-      m64_bias(),
-      width(0),
-      height(0),
-      draw_created(false),
-      need_draw_update(true),
-      code_length(0) {
+    : Configurable_Effect(avs), draw(), need_draw_update(true), num_bands(1) {
     this->config.scale = 1;
 }
 
-E_Convolution::~E_Convolution() { delete_draw_func(); }
-
-inline void E_Convolution::delete_draw_func(void) {
-    if (this->draw_created) {
-        delete[] (unsigned char*)draw;
-        this->draw_created = false;
-    }
-}
-
 void E_Convolution::check_scale_not_zero() {
     if (this->config.scale == 0) {
         this->config.scale = 1;
@@ -133,889 +118,821 @@ void E_Convolution::kernel_clear() {
     this->need_draw_update = true;
 }
 
-// #define data(xx, yy) framebuffer[c[yy] + min(max(i + xx, 0), lastcol)]
-// #define scale(out) min(max((long)((out+farray[25])/this->config.scale),0),255)
-// #define bound(xx) min(max(xx, 0), 255)
-
-int E_Convolution::render(char[2][2][576],
-                          int,
+int E_Convolution::render(char visdata[2][2][576],
+                          int is_beat,
                           int* framebuffer,
                           int* fbout,
                           int w,
                           int h) {
-    if ((w != this->width) || (h != this->height)) {
-        this->width = w;
-        this->height = h;
-        this->need_draw_update = true;
+    this->smp_begin(1, visdata, is_beat, framebuffer, fbout, w, h);
+    if (is_beat & 0x80000000) {
+        return 0;
     }
-    if (this->need_draw_update) {
-        this->create_draw_func();
+    this->smp_render(0, 1, visdata, is_beat, framebuffer, fbout, w, h);
+    return this->smp_finish(visdata, is_beat, framebuffer, fbout, w, h);
+}
+
+/* Kernel preparation */
+
+static int64_t gcd(int64_t a, int64_t b) {
+    while (b != 0) {
+        int64_t t = a % b;
+        a = b;
+        b = t;
     }
-    return this->draw(framebuffer, fbout, this->m64_farray);
+    return a;
 }
 
-#define appenddraw(a) ((unsigned char*)draw)[this->code_length++] = a
+/**
+ * Write the exponent to `exponent_out` and return true if `value` is a power of two.
+ */
+static bool is_power_of_two(int64_t value, uint16_t* exponent_out) {
+    int64_t power = 1;
+    uint16_t exponent = 0;
+    for (; power < value; power <<= 1) {
+        exponent++;
+    }
+    *exponent_out = exponent;
+    return power == value;
+}
+
+/**
+ * Split `kernel` into `column` * `row` if it is a rank-1 matrix with an integer
+ * decomposition. The row vector is normalized by the GCD of its entries, so the column
+ * vector is integer for any integer rank-1 kernel.
+ */
+static bool decompose_rank_1(const int64_t* kernel, int64_t* column, int64_t* row) {
+    int first_row = -1;
+    for (int i = 0; i < CONVO_KERNEL_SIZE && first_row < 0; i++) {
+        if (kernel[i] != 0) {
+            first_row = i / CONVO_KERNEL_DIM;
+        }
+    }
+    if (first_row < 0) {
+        return false;
+    }
+    int64_t divisor = 0;
+    for (int x = 0; x < CONVO_KERNEL_DIM; x++) {
+        int64_t value = kernel[first_row * CONVO_KERNEL_DIM + x];
+        divisor = gcd(divisor, value < 0 ? -value : value);
+    }
+    int first_column = -1;
+    for (int x = 0; x < CONVO_KERNEL_DIM; x++) {
+        row[x] = kernel[first_row * CONVO_KERNEL_DIM + x] / divisor;
+        if (first_column < 0 && row[x] != 0) {
+            first_column = x;
+        }
+    }
+    for (int y = 0; y < CONVO_KERNEL_DIM; y++) {
+        int64_t value = kernel[y * CONVO_KERNEL_DIM + first_column];
+        if (value % row[first_column] != 0) {
+            return false;
+        }
+        column[y] = value / row[first_column];
+        for (int x = 0; x < CONVO_KERNEL_DIM; x++) {
+            if (column[y] * row[x] != kernel[y * CONVO_KERNEL_DIM + x]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
 
-void E_Convolution::create_draw_func() {
-    this->delete_draw_func();
+void E_Convolution::prepare_draw() {
+    this->need_draw_update = false;
+    Convolution_Draw& draw = this->draw;
     unsigned int possum = 0, negsum = 0;  // absolute sums of pos and neg values
     int zerostringl = 0;                  // length of the initial run of zeroes
-    int numpos = 0;                       // number of pos entries
-    int numneg = 0;                       // number of neg entries
     bool zerostring = true;               // are we still in an initial zero run
-    unsigned int fposdata[2][CONVO_KERNEL_SIZE][3];
-    // for each pass, will contain the x and y co-ords and the value of the
-    // pos data elements. e.g.
-    // this->config.kernel[ 7*fposdata[pass][i][1] + fposdata[pass][i][0] ] =
-    // fposdata[pass][i][2]>0
-    unsigned int fnegdata[2][CONVO_KERNEL_SIZE][3];
-    // for each pass, will contain the x and y co-ords and the absolute value
-    // of the neg data elements. e.g.
-    // abs(this->config.kernel[ 7*fnegdata[pass][i][1] + fnegdata[i][0] ]) =
-    // fnegdata[pass][i][2]>0
-    uint8_t use_fbout;  // 1 if need to use fbout
-    int divisionfactor = (int32_t)this->config.scale;
-    this->need_draw_update = false;
     for (int i = 0; i < CONVO_KERNEL_SIZE; i++) {
         if (this->config.kernel[i].value < 0) {
             negsum -= this->config.kernel[i].value;
             zerostring = false;
-            this->m64_farray[i] =
-                _mm_set1_pi16(((int16_t)(-this->config.kernel[i].value)));
         } else if (this->config.kernel[i].value > 0) {
             possum += this->config.kernel[i].value;
             zerostring = false;
-            this->m64_farray[i] =
-                _mm_set1_pi16(((int16_t)(this->config.kernel[i].value)));
-        } else {
-            if (zerostring) {
-                zerostringl++;
-            }
-            this->m64_farray[i] = _mm_setzero_si64();
+        } else if (zerostring) {
+            zerostringl++;
         }
     }
     if (this->config.bias < 0) {
         negsum -= this->config.bias;
-        this->m64_bias = _mm_set1_pi16(((int16_t)(-256 * this->config.bias)));
     } else {
         possum += this->config.bias;
-        this->m64_bias = _mm_set1_pi16(((int16_t)(256 * this->config.bias)));
-    }
-    _mm_empty();
-    if (divisionfactor > 0) {
-        // no sign swapping necessary
-        for (int i = 0; i < CONVO_KERNEL_SIZE; i++) {
-            if (this->config.kernel[i].value < 0) {
-                fnegdata[0][numneg][0] = i % CONVO_KERNEL_DIM;
-                fnegdata[0][numneg][1] = i / CONVO_KERNEL_DIM;
-                fnegdata[0][numneg][2] = -this->config.kernel[i].value;
-                fnegdata[1][numneg][0] = 6 - i / CONVO_KERNEL_DIM;
-                fnegdata[1][numneg][1] = i % CONVO_KERNEL_DIM;
-                fnegdata[1][numneg][2] = -this->config.kernel[i].value;
-                numneg++;
-            } else if (this->config.kernel[i].value > 0) {
-                fposdata[0][numpos][0] = i % CONVO_KERNEL_DIM;
-                fposdata[0][numpos][1] = i / CONVO_KERNEL_DIM;
-                fposdata[0][numpos][2] = this->config.kernel[i].value;
-                fposdata[1][numpos][0] = 6 - i / CONVO_KERNEL_DIM;
-                fposdata[1][numpos][1] = i % CONVO_KERNEL_DIM;
-                fposdata[1][numpos][2] = this->config.kernel[i].value;
-                numpos++;
-            }
-        }
-        if (this->config.bias < 0) {
-            fnegdata[0][numneg][0] = 0;
-            fnegdata[0][numneg][1] = CONVO_KERNEL_DIM;
-            fnegdata[0][numneg][2] = -this->config.bias;
-            fnegdata[1][numneg][0] = 0;
-            fnegdata[1][numneg][1] = CONVO_KERNEL_DIM;
-            fnegdata[1][numneg][2] = -this->config.bias;
-            numneg++;
-        } else if (this->config.bias > 0) {
-            fposdata[0][numpos][0] = 0;
-            fposdata[0][numpos][1] = CONVO_KERNEL_DIM;
-            fposdata[0][numpos][2] = this->config.bias;
-            fposdata[1][numpos][0] = 0;
-            fposdata[1][numpos][1] = CONVO_KERNEL_DIM;
-            fposdata[1][numpos][2] = this->config.bias;
-            numpos++;
+    }
+    // A negative scale swaps the roles of the positive and negative entries. Note that
+    // the choice of saturating or wrapping addition still depends on the unswapped
+    // sums.
+    int64_t divisionfactor = (int32_t)this->config.scale;
+    int64_t sign = 1;
+    if (divisionfactor <= 0) {
+        sign = -1;
+        divisionfactor = -divisionfactor;
+    }
+
+    int64_t kernel[CONVO_KERNEL_SIZE];
+    draw.num_taps[0][0] = draw.num_taps[0][1] = 0;
+    for (int i = 0; i < CONVO_KERNEL_SIZE; i++) {
+        kernel[i] = sign * this->config.kernel[i].value;
+        if (kernel[i] == 0) {
+            continue;
         }
+        int sum = kernel[i] > 0 ? 0 : 1;
+        auto weight = (uint16_t)(kernel[i] > 0 ? kernel[i] : -kernel[i]);
+        auto x = (uint8_t)(i % CONVO_KERNEL_DIM);
+        auto y = (uint8_t)(i / CONVO_KERNEL_DIM);
+        int n = draw.num_taps[0][sum]++;
+        draw.taps[0][sum][n] = {weight, x, y};
+        draw.taps[1][sum][n] = {weight, (uint8_t)(CONVO_KERNEL_DIM - 1 - y), x};
+    }
+    draw.num_taps[1][0] = draw.num_taps[0][0];
+    draw.num_taps[1][1] = draw.num_taps[0][1];
+    draw.num_passes = this->config.two_pass ? 2 : 1;
+    draw.saturate[0] = possum >= 256;
+    draw.saturate[1] = negsum >= 256;
+
+    int64_t bias = sign * this->config.bias;
+    draw.bias_sum = bias == 0 ? -1 : (bias > 0 ? 0 : 1);
+    draw.bias = (uint16_t)(256 * (bias > 0 ? bias : -bias));
+    draw.subtract = draw.num_taps[0][1] > 0 || draw.bias_sum == 1;
+    if (this->config.absolute) {
+        draw.combine = Convolution_Draw::COMBINE_ABSOLUTE;
+    } else if (this->config.wrap) {
+        draw.combine = Convolution_Draw::COMBINE_WRAP;
     } else {
-        // do sign swapping
-        for (int i = 0; i < CONVO_KERNEL_SIZE; i++) {
-            if (this->config.kernel[i].value < 0) {
-                fposdata[0][numpos][0] = i % CONVO_KERNEL_DIM;
-                fposdata[0][numpos][1] = i / CONVO_KERNEL_DIM;
-                fposdata[0][numpos][2] = -this->config.kernel[i].value;
-                fposdata[1][numpos][0] = 6 - i / CONVO_KERNEL_DIM;
-                fposdata[1][numpos][1] = i % CONVO_KERNEL_DIM;
-                fposdata[1][numpos][2] = -this->config.kernel[i].value;
-                numpos++;
-            } else if (this->config.kernel[i].value > 0) {
-                fnegdata[0][numneg][0] = i % CONVO_KERNEL_DIM;
-                fnegdata[0][numneg][1] = i / CONVO_KERNEL_DIM;
-                fnegdata[0][numneg][2] = this->config.kernel[i].value;
-                fnegdata[1][numneg][0] = 6 - i / CONVO_KERNEL_DIM;
-                fnegdata[1][numneg][1] = i % CONVO_KERNEL_DIM;
-                fnegdata[1][numneg][2] = this->config.kernel[i].value;
-                numneg++;
-            }
-        }
-        if (this->config.bias < 0) {
-            fposdata[0][numpos][0] = 0;
-            fposdata[0][numpos][1] = CONVO_KERNEL_DIM;
-            fposdata[0][numpos][2] = -this->config.bias;
-            fposdata[1][numpos][0] = 0;
-            fposdata[1][numpos][1] = CONVO_KERNEL_DIM;
-            fposdata[1][numpos][2] = -this->config.bias;
-            numpos++;
-        } else if (this->config.bias > 0) {
-            fnegdata[0][numneg][0] = 0;
-            fnegdata[0][numneg][1] = CONVO_KERNEL_DIM;
-            fnegdata[0][numneg][2] = this->config.bias;
-            fnegdata[1][numneg][0] = 0;
-            fnegdata[1][numneg][1] = CONVO_KERNEL_DIM;
-            fnegdata[1][numneg][2] = this->config.bias;
-            numneg++;
-        }
-        divisionfactor = -divisionfactor;
+        draw.combine = Convolution_Draw::COMBINE_CLAMP;
     }
-    if (zerostringl < (CONVO_KERNEL_SIZE / 2)) {
-        use_fbout = 1;
+    if (divisionfactor <= 1) {
+        draw.scale = Convolution_Draw::SCALE_NONE;
+    } else if (is_power_of_two(divisionfactor, &draw.scale_param)) {
+        draw.scale = Convolution_Draw::SCALE_SHIFT;
     } else {
-        use_fbout = 0;
+        draw.scale = Convolution_Draw::SCALE_MULTIPLY;
+        draw.scale_param = (uint16_t)(65536 / divisionfactor);
     }
-    draw = (draw_func) new uint8_t[MAX_DRAW_SIZE];
+    draw.in_place = zerostringl >= (CONVO_KERNEL_SIZE / 2);
 
-    // addresses to loop back to
-    int iloopstart;
-    int jloopstart;
-    this->code_length = 0;
-
-    // function header (nonstandard stack - see stack.txt)
-    appenddraw(0x53);  // push ebx
-    appenddraw(0x56);  // push esi
-    appenddraw(0x57);  // push edi
-    appenddraw(0x55);  // push ebp
-    appenddraw(0x8B);  // mov ebp, esp
-    // throughout this code the coments will reference i, j, k and c[.].
-    // see prog.txt to see the original non-optimised code to which they
-    // (approximiately) refer. also see registers.txt for correspondances
-    // between the registers here and the vars in prog.txt. double for loop
-    // header j external loop, i internal loop, k internal non reset int j = 0;
-    appenddraw(0xEC);
-    appenddraw(0x33);  // xor ebx, ebx
-    appenddraw(0xDB);
-    appenddraw(0x8B);  // mov esi, ebx (esi will be permanently used for j)
-    appenddraw(0xF3);
-    // int *k = (use_fbout)?fbout:framebuffer - this var will serve as a pointer
-    // to the address to output to
-    appenddraw(0x8B);  // mov ebx, [ebp+(use_fbout)?24:20]
-    appenddraw(0x5D);
-    appenddraw((use_fbout) ? 0x18 : 0x14);
-    appenddraw(0x8B);  // mov edx, ebx (edx
-                       // will be permanently
-                       // used for k)
-    appenddraw(0xD3);
-    // set up ecx as pointer to farray
-    appenddraw(0x8B);  // mov ecx, [ebp+28] (e.g. mov ecx, this->m64_farray)
-    appenddraw(0x4D);
-    appenddraw(0x1C);
-    // c[0] = framebuffer;
-    appenddraw(0x8B);  // mov ebx, [ebp+20]
-    appenddraw(0x5D);
-    appenddraw(0x14);
-    appenddraw(0x53);  // push ebx
-    // c[1] = framebuffer;
-    appenddraw(0x53);  // push ebx
-    // c[2] = framebuffer;
-    appenddraw(0x53);  // push ebx
-    // c[3] = framebuffer;
-    appenddraw(0x53);  // push ebx
-    // c[4] = framebuffer+4*width;
-    appenddraw(0x81);  // add ebx, 4*width
-    appenddraw(0xC3);
-    // 4*width needs to begin with the lowest byte
-    appenddraw((4 * this->width) & 0x000000FF);
-    appenddraw(((4 * this->width) & 0x0000FF00) >> 8);
-    appenddraw(((4 * this->width) & 0x00FF0000) >> 16);
-    appenddraw(((4 * this->width) & 0xFF000000) >> 24);
-    appenddraw(0x53);  // push ebx
-    // c[5] = framebuffer+8*width;
-    appenddraw(0x81);  // add ebx, 4*width
-    appenddraw(0xC3);
-    // 4*width needs to begin with the lowest byte
-    appenddraw((4 * this->width) & 0x000000FF);
-    appenddraw(((4 * this->width) & 0x0000FF00) >> 8);
-    appenddraw(((4 * this->width) & 0x00FF0000) >> 16);
-    appenddraw(((4 * this->width) & 0xFF000000) >> 24);
-    appenddraw(0x53);  // push ebx
-    // c[6] = framebuffer+12*width;
-    appenddraw(0x81);  // add ebx, 4*width
-    appenddraw(0xC3);
-    // 4*width needs to begin with the lowest byte
-    appenddraw((4 * this->width) & 0x000000FF);
-    appenddraw(((4 * this->width) & 0x0000FF00) >> 8);
-    appenddraw(((4 * this->width) & 0x00FF0000) >> 16);
-    appenddraw(((4 * this->width) & 0xFF000000) >> 24);
-    appenddraw(0x53);  // push ebx
-    // note: c[6] is at esp, c[5] is at esp+4, c[4] is at esp+8,c[3] is at
-    // esp+12,c[2] is at esp+16,c[1] is at esp+20,c[0] is at esp+24
-    appenddraw(0x0F);  // pxor	mm7, mm7 - mm7 will be permanently set to 0
-    appenddraw(0xEF);
-    appenddraw(0xFF);
-    // start of j loop
-    jloopstart = this->code_length;
-    // int i = 0;
-    // xor edi, edi - this register will be permanently assigned to i
-    appenddraw(0x33);
-    appenddraw(0xFF);
-    // start of i loop
-    for (int im = 0; im < CONVO_KERNEL_DIM; im++) {
-        // when im=0 this will deal with the i=0
-        // case, im=1, i=1, im=2, i=2, im=3,
-        // 2<i<width-3, im=4, i=width-3, im=5,
-        // i=width-2, im=6, i=width-1.
-        iloopstart = this->code_length;
-        for (int pass = 0; pass < (this->config.two_pass ? 2 : 1); pass++) {
-            // the last f***data[i][1] looked at (initialize with impossible value)
-            unsigned int lasty = 0xffffffff;
-            appenddraw(0x0F);  // movq mm0, mm7
-            appenddraw(0x7F);
-            appenddraw(0xF8);
-            if (numneg > 0) {
-                appenddraw(0x0F);  // movq mm1, mm7
-                appenddraw(0x7F);
-                appenddraw(0xF9);
+    draw.separable = false;
+    int64_t column[CONVO_KERNEL_DIM];
+    int64_t row[CONVO_KERNEL_DIM];
+    if (draw.in_place || !decompose_rank_1(kernel, column, row)) {
+        return;
+    }
+    // Splitting the kernel only yields the same result if wrapping and saturating
+    // additions are the same, i.e. if a saturating sum can't actually overflow.
+    for (int sum = 0; sum < 2; sum++) {
+        uint32_t max_sum = 0;
+        for (int t = 0; t < draw.num_taps[0][sum]; t++) {
+            max_sum += draw.taps[0][sum][t].weight * 255;
+        }
+        if (draw.saturate[sum] && max_sum > UINT16_MAX) {
+            return;
+        }
+    }
+    int num_columns = 0;
+    int num_rows = 0;
+    for (int i = 0; i < CONVO_KERNEL_DIM; i++) {
+        num_columns += row[i] != 0;
+        num_rows += column[i] != 0;
+    }
+    if (num_columns + num_rows >= num_columns * num_rows) {
+        return;
+    }
+    draw.separable = true;
+    for (int pass = 0; pass < 2; pass++) {
+        // The second pass' kernel is rotated, so its column vector is the first pass'
+        // row vector, and its row vector is the reversed column vector.
+        draw.num_h_taps[pass][0] = draw.num_h_taps[pass][1] = 0;
+        draw.num_v_taps[pass] = 0;
+        for (int i = 0; i < CONVO_KERNEL_DIM; i++) {
+            int64_t value = pass == 0 ? row[i] : column[CONVO_KERNEL_DIM - 1 - i];
+            if (value != 0) {
+                int half = value > 0 ? 0 : 1;
+                auto weight = (uint16_t)(value > 0 ? value : -value);
+                int n = draw.num_h_taps[pass][half]++;
+                draw.h_taps[pass][half][n] = {weight, (uint8_t)i, 0};
             }
-            // go through the pos values
-            for (int i = 0; i < numpos; i++) {
-                if (fposdata[pass][i][1] == CONVO_KERNEL_DIM) {
-                    // see if this the bias entry
-                    appenddraw(0x0F);
-                    // paddusw mm0, [ecx+49*8] (e.g. paddw mm0,
-                    // this->m64_farray[49])
-                    appenddraw(0xDD);
-                    appenddraw(0x81);
-                    appenddraw(0x88);
-                    appenddraw(0x01);
-                    appenddraw(0x00);
-                    appenddraw(0x00);
-                } else {
-                    if (lasty != fposdata[pass][i][1]) {
-                        // see if we actually need to adjust the value of eax
-                        // (the start of row address)
-                        appenddraw(0x8B);
-                        // mov eax, [esp+4*(6-fposdata[pass][i][1])]
-                        // (e.g. mov eax, c[fposdata[pass][i][1]])
-                        appenddraw(0x44);
-                        appenddraw(0x24);
-                        appenddraw((4 * (6 - fposdata[pass][i][1])) & 0xFF);
-                        lasty = fposdata[pass][i][1];
-                    }
-                    switch (im) {
-                        case 0:
-                            // movq mm2, [eax+max(4*(fposdata[pass][i][0]-3),0)]
-                            appenddraw(0x0F);
-                            appenddraw(0x6F);
-                            appenddraw(0x50);
-                            appenddraw(
-                                (max((signed)(4 * (fposdata[pass][i][0] - 3)), 0))
-                                & 0xFF);
-                            break;
-                        case 1:
-                            // movq mm2, [eax+max(4*(fposdata[pass][i][0]-2),0)]
-                            appenddraw(0x0F);
-                            appenddraw(0x6F);
-                            appenddraw(0x50);
-                            appenddraw(
-                                (max((signed)(4 * (fposdata[pass][i][0] - 2)), 0))
-                                & 0xFF);
-                            break;
-                        case 2:
-                            // movq mm2, [eax+max(4*(fposdata[pass][i][0]-1),0)]
-                            appenddraw(0x0F);
-                            appenddraw(0x6F);
-                            appenddraw(0x50);
-                            appenddraw(
-                                (max((signed)(4 * (fposdata[pass][i][0] - 1)), 0))
-                                & 0xFF);
-                            break;
-                        case 3:
-                            // movq mm2, [eax+edi+4*(fposdata[pass][i][0]-3)]
-                            appenddraw(0x0F);
-                            appenddraw(0x6F);
-                            appenddraw(0x54);
-                            appenddraw(0x38);
-                            appenddraw((4 * (fposdata[pass][i][0] - 3)) & 0xFF);
-                            break;
-                        case 4: {
-                            int xpos;
-                            // movq mm2,
-                            // [eax+4*min(fposdata[pass][i][0]-6+width,width-2)]
-                            appenddraw(0x0F);
-                            appenddraw(0x6F);
-                            appenddraw(0x90);
-                            xpos = (4
-                                    * min((unsigned)(fposdata[pass][i][0] - 6
-                                                     + this->width),
-                                          (unsigned)(this->width - 2)));
-                            // xpos needs to begin with the lowest byte
-                            appenddraw(xpos & 0x000000FF);
-                            appenddraw((xpos & 0x0000FF00) >> 8);
-                            appenddraw((xpos & 0x00FF0000) >> 16);
-                            appenddraw((xpos & 0xFF000000) >> 24);
-                            break;
-                        }
-                        case 5: {
-                            int xpos;
-                            appenddraw(
-                                0x0F);  // movq mm2,
-                                        // [eax+4*min(fposdata[pass][i][0]-5+width,width-2)]
-                            appenddraw(0x6F);
-                            appenddraw(0x90);
-                            xpos = (4
-                                    * min((unsigned)(fposdata[pass][i][0] - 5
-                                                     + this->width),
-                                          (unsigned)(this->width - 2)));
-                            // xpos needs to begin with the lowest byte
-                            appenddraw(xpos & 0x000000FF);
-                            appenddraw((xpos & 0x0000FF00) >> 8);
-                            appenddraw((xpos & 0x00FF0000) >> 16);
-                            appenddraw((xpos & 0xFF000000) >> 24);
-                            break;
-                        }
-                        case 6: {
-                            int xpos;
-                            // movq mm2,
-                            // [eax+4*min(fposdata[pass][i][0]-4+width,width-2)]
-                            appenddraw(0x0F);
-                            appenddraw(0x6F);
-                            appenddraw(0x90);
-                            xpos = (4
-                                    * min((unsigned)(fposdata[pass][i][0] - 4
-                                                     + this->width),
-                                          (unsigned)(this->width - 2)));
-                            // xpos needs to begin with the lowest byte
-                            appenddraw(xpos & 0x000000FF);
-                            appenddraw((xpos & 0x0000FF00) >> 8);
-                            appenddraw((xpos & 0x00FF0000) >> 16);
-                            appenddraw((xpos & 0xFF000000) >> 24);
-                            break;
-                        }
-                    }
-                    appenddraw(0x0F);  // punpcklbw mm2, mm7
-                    appenddraw(0x60);
-                    appenddraw(0xD7);
-                    // in which case we can just add
-                    if (fposdata[pass][i][2] != 1) {  // just add
-                        // see if fposdata[pass][i][2] is a power of 2
-                        unsigned int j;
-                        uint8_t k = 0;
-                        for (j = 1; j < fposdata[pass][i][2]; j <<= 1) {
-                            k++;
-                        }
-                        if (j == fposdata[pass][i][2]) {
-                            // fposdata[pass][i][2]=2^k
-                            appenddraw(0x0F);  // psllw mm2, k
-                            appenddraw(0x71);
-                            appenddraw(0xF2);
-                            appenddraw(k);
-                        } else {
-                            appenddraw(0x0F);
-                            // pmullw mm2,
-                            // [ecx+8*(7*fposdata[pass][i][1]+fposdata[pass][i][0])]
-                            // (e.g. pmullw mm2,
-                            // this->m64_farray[7*fposdata[pass][i][1]+fposdata[pass][i][0]])
-                            appenddraw(0xD5);
-                            appenddraw(0x91);
-                            // 8*(7*fposdata[pass][i][1]+fposdata[pass][i][0])
-                            // needs to begin with the lowest byte
-                            appenddraw((8
-                                        * (CONVO_KERNEL_DIM * fposdata[pass][i][1]
-                                           + fposdata[pass][i][0]))
-                                       & 0x000000FF);
-                            appenddraw(((8
-                                         * (CONVO_KERNEL_DIM * fposdata[pass][i][1]
-                                            + fposdata[pass][i][0]))
-                                        & 0x0000FF00)
-                                       >> 8);
-                            appenddraw(((8
-                                         * (CONVO_KERNEL_DIM * fposdata[pass][i][1]
-                                            + fposdata[pass][i][0]))
-                                        & 0x00FF0000)
-                                       >> 16);
-                            appenddraw(((8
-                                         * (CONVO_KERNEL_DIM * fposdata[pass][i][1]
-                                            + fposdata[pass][i][0]))
-                                        & 0xFF000000)
-                                       >> 24);
-                        }
-                    }
-                    if (possum < 256) {
-                        appenddraw(0x0F);  // paddw mm0, mm2
-                        appenddraw(0xFD);
-                        appenddraw(0xC2);
-                    } else {
-                        appenddraw(0x0F);  // paddw mm0, mm2
-                        appenddraw(0xDD);
-                        appenddraw(0xC2);
-                    }
-                }
+            value = pass == 0 ? column[i] : row[i];
+            if (value != 0) {
+                auto weight = (uint16_t)(value > 0 ? value : -value);
+                draw.v_taps[pass][draw.num_v_taps[pass]++] = {
+                    weight, (uint8_t)i, value < 0};
             }
-            // go through the neg values
-            lasty = 0xffffffff;
-            for (int i = 0; i < numneg; i++) {
-                // see if this the bias entry
-                if (fnegdata[pass][i][1] == CONVO_KERNEL_DIM) {
-                    // paddw mm1, [ecx+49*8] (e.g. paddw mm0, this->m64_farray[49])
-                    appenddraw(0x0F);
-                    appenddraw(0xDD);
-                    appenddraw(0x89);
-                    appenddraw(0x88);
-                    appenddraw(0x01);
-                    appenddraw(0x00);
-                    appenddraw(0x00);
-                } else {
-                    // see if we actually need to adjust the value of eax (the start
-                    // of row address)
-                    if (lasty != fnegdata[pass][i][1]) {
-                        // mov eax, [esp+4*(6-fnegdata[pass][i][1])]
-                        // (e.g. mov eax, c[fnegdata[pass][i][1]])
-                        appenddraw(0x8B);
-                        appenddraw(0x44);
-                        appenddraw(0x24);
-                        appenddraw((4 * (6 - fnegdata[pass][i][1])) & 0xFF);
-                        lasty = fnegdata[pass][i][1];
-                    }
-                    switch (im) {
-                        case 0:
-                            // movq mm2, [eax+max(4*(fnegdata[pass][i][0]-3),0)]
-                            appenddraw(0x0F);
-                            appenddraw(0x6F);
-                            appenddraw(0x50);
-                            appenddraw(
-                                (max((signed)(4 * (fnegdata[pass][i][0] - 3)), 0))
-                                & 0xFF);
-                            break;
-                        case 1:
-                            // movq mm2, [eax+max(4*(fnegdata[pass][i][0]-2),0)]
-                            appenddraw(0x0F);
-                            appenddraw(0x6F);
-                            appenddraw(0x50);
-                            appenddraw(
-                                (max((signed)(4 * (fnegdata[pass][i][0] - 2)), 0))
-                                & 0xFF);
-                            break;
-                        case 2:
-                            // movq mm2, [eax+max(4*(fnegdata[pass][i][0]-1),0)]
-                            appenddraw(0x0F);
-                            appenddraw(0x6F);
-                            appenddraw(0x50);
-                            appenddraw(
-                                (max((signed)(4 * (fnegdata[pass][i][0] - 1)), 0))
-                                & 0xFF);
-                            break;
-                        case 3:
-                            // movq mm2, [eax+edi+4*(fnegdata[pass][i][0]-3)]
-                            appenddraw(0x0F);
-                            appenddraw(0x6F);
-                            appenddraw(0x54);
-                            appenddraw(0x38);
-                            appenddraw((4 * (fnegdata[pass][i][0] - 3)) & 0xFF);
-                            break;
-                        case 4: {
-                            int xpos;
-                            // movq mm2,
-                            // [eax+4*min(fnegdata[pass][i][0]-6+width,width-2)]
-                            appenddraw(0x0F);
-                            appenddraw(0x6F);
-                            appenddraw(0x90);
-                            xpos = (4
-                                    * min((unsigned)(fnegdata[pass][i][0] - 6
-                                                     + this->width),
-                                          (unsigned)(this->width - 2)));
-                            // xpos needs to begin with the lowest byte
-                            appenddraw(xpos & 0x000000FF);
-                            appenddraw((xpos & 0x0000FF00) >> 8);
-                            appenddraw((xpos & 0x00FF0000) >> 16);
-                            appenddraw((xpos & 0xFF000000) >> 24);
-                            break;
-                        }
-                        case 5: {
-                            int xpos;
-                            // movq mm2,
-                            // [eax+4*min(fnegdata[pass][i][0]-5+width,width-2)]
-                            appenddraw(0x0F);
-                            appenddraw(0x6F);
-                            appenddraw(0x90);
-                            xpos = (4
-                                    * min((unsigned)(fnegdata[pass][i][0] - 5
-                                                     + this->width),
-                                          (unsigned)(this->width - 2)));
-                            // xpos needs to begin with the lowest byte
-                            appenddraw(xpos & 0x000000FF);
-                            appenddraw((xpos & 0x0000FF00) >> 8);
-                            appenddraw((xpos & 0x00FF0000) >> 16);
-                            appenddraw((xpos & 0xFF000000) >> 24);
-                            break;
-                        }
-                        case 6: {
-                            int xpos;
-                            // movq mm2,
-                            // [eax+4*min(fnegdata[pass][i][0]-4+width,width-2)]
-                            appenddraw(0x0F);
-                            appenddraw(0x6F);
-                            appenddraw(0x90);
-                            xpos = (4
-                                    * min((unsigned)(fnegdata[pass][i][0] - 4
-                                                     + this->width),
-                                          (unsigned)(this->width - 2)));
-                            // xpos needs to begin with the lowest byte
-                            appenddraw(xpos & 0x000000FF);
-                            appenddraw((xpos & 0x0000FF00) >> 8);
-                            appenddraw((xpos & 0x00FF0000) >> 16);
-                            appenddraw((xpos & 0xFF000000) >> 24);
-                            break;
-                        }
-                    }
-                    appenddraw(0x0F);  // punpcklbw mm2, mm7
-                    appenddraw(0x60);
-                    appenddraw(0xD7);
-                    // in which case we can just add
-                    if (fnegdata[pass][i][2] != 1) {  // just add
-                        // see if fnegdata[pass][i][2] is a power of 2
-                        unsigned int j;
-                        uint8_t k = 0;
-                        for (j = 1; j < fnegdata[pass][i][2]; j <<= 1) {
-                            k++;
-                        }
-                        if (j == fnegdata[pass][i][2]) {
-                            // fnegdata[pass][i][2]=2^k
-                            appenddraw(0x0F);  // psllw mm2, k
-                            appenddraw(0x71);
-                            appenddraw(0xF2);
-                            appenddraw(k);
-                        } else {
-                            appenddraw(0x0F);
-                            // pmullw mm2,
-                            // [ecx+8*(7*fnegdata[pass][i][1]+fnegdata[pass][i][0])]
-                            // (e.g. pmullw mm2,
-                            // this->m64_farray[7*fnegdata[pass][i][1]+fnegdata[pass][i][0]])
-                            appenddraw(0xD5);
-                            appenddraw(0x91);
-                            // 8*(7*fnegdata[pass][i][1]+fnegdata[pass][i][0])
-                            // needs to begin with the lowest byte
-                            appenddraw((8
-                                        * (CONVO_KERNEL_DIM * fnegdata[pass][i][1]
-                                           + fnegdata[pass][i][0]))
-                                       & 0x000000FF);
-                            appenddraw(((8
-                                         * (CONVO_KERNEL_DIM * fnegdata[pass][i][1]
-                                            + fnegdata[pass][i][0]))
-                                        & 0x0000FF00)
-                                       >> 8);
-                            appenddraw(((8
-                                         * (CONVO_KERNEL_DIM * fnegdata[pass][i][1]
-                                            + fnegdata[pass][i][0]))
-                                        & 0x00FF0000)
-                                       >> 16);
-                            appenddraw(((8
-                                         * (CONVO_KERNEL_DIM * fnegdata[pass][i][1]
-                                            + fnegdata[pass][i][0]))
-                                        & 0xFF000000)
-                                       >> 24);
-                        }
-                    }
-                    if (negsum < 256) {
-                        // paddw mm1, mm2
-                        appenddraw(0x0F);
-                        appenddraw(0xFD);
-                        appenddraw(0xCA);
-                    } else {
-                        // paddw mm1, mm2
-                        appenddraw(0x0F);
-                        appenddraw(0xDD);
-                        appenddraw(0xCA);
-                    }
+        }
+    }
+}
+
+/* Rendering */
+
+/**
+ * The original clamps source rows to the range [0, h-2], i.e. it never reads the last
+ * row.
+ */
+static inline int convolution_source_row(int j, int y, int h) {
+    int row = j + y - CONVO_KERNEL_DIM / 2;
+    if (row > h - 2) {
+        row = h - 2;
+    }
+    return row < 0 ? 0 : row;
+}
+
+/**
+ * For the three pixels at the right edge, the original clamps source columns to w-2.
+ * The pixels in the middle section (incl. the last one before the right edge) do read
+ * the last column.
+ */
+static inline int convolution_source_column(int i, int x, int w) {
+    int column = i + x - CONVO_KERNEL_DIM / 2;
+    if (i >= w - CONVO_KERNEL_DIM / 2 && column > w - 2) {
+        column = w - 2;
+    }
+    if (column >= w) {
+        column = w - 1;
+    }
+    return column < 0 ? 0 : column;
+}
+
+static inline uint16_t adds_u16(uint16_t a, uint16_t b) {
+    uint32_t sum = (uint32_t)a + b;
+    return sum > UINT16_MAX ? UINT16_MAX : (uint16_t)sum;
+}
+
+static inline uint16_t convolution_combine_c(const Convolution_Draw& draw,
+                                             uint16_t pos,
+                                             uint16_t neg) {
+    if (!draw.subtract) {
+        return pos;
+    }
+    switch (draw.combine) {
+        case Convolution_Draw::COMBINE_ABSOLUTE: {
+            // psubsw, then clear the sign bit
+            int32_t diff = (int16_t)pos - (int16_t)neg;
+            diff = diff > INT16_MAX ? INT16_MAX : (diff < INT16_MIN ? INT16_MIN : diff);
+            return (uint16_t)(diff & 0x7fff);
+        }
+        case Convolution_Draw::COMBINE_WRAP: return (uint16_t)(pos - neg);
+        default: return pos > neg ? pos - neg : 0;
+    }
+}
+
+static inline uint32_t convolution_finish_c(const Convolution_Draw& draw,
+                                            const uint16_t* result) {
+    uint32_t out = 0;
+    for (int c = 0; c < 4; c++) {
+        uint16_t value = result[c];
+        if (draw.scale == Convolution_Draw::SCALE_SHIFT) {
+            value = draw.scale_param >= 16 ? 0 : value >> draw.scale_param;
+        } else if (draw.scale == Convolution_Draw::SCALE_MULTIPLY && c < 3) {
+            // Like the original, leave the 4th channel unscaled.
+            value = (uint16_t)(((uint32_t)value * draw.scale_param) >> 16);
+        }
+        // packuswb treats its input as signed.
+        auto signed_value = (int16_t)value;
+        uint32_t channel =
+            signed_value < 0 ? 0 : (signed_value > 255 ? 255 : signed_value);
+        out |= channel << (c * 8);
+    }
+    return out;
+}
+
+static uint32_t convolution_px_c(const Convolution_Draw& draw,
+                                 const uint32_t* const* rows,
+                                 const int* columns) {
+    uint16_t result[4] = {0, 0, 0, 0};
+    for (int pass = 0; pass < draw.num_passes; pass++) {
+        uint16_t sums[2][4] = {{0, 0, 0, 0}, {0, 0, 0, 0}};
+        for (int sum = 0; sum < 2; sum++) {
+            for (int t = 0; t < draw.num_taps[pass][sum]; t++) {
+                const Convolution_Tap& tap = draw.taps[pass][sum][t];
+                uint32_t px = rows[tap.y][columns[tap.x]];
+                for (int c = 0; c < 4; c++) {
+                    auto product = (uint16_t)(((px >> (c * 8)) & 0xff) * tap.weight);
+                    sums[sum][c] = draw.saturate[sum]
+                                       ? adds_u16(sums[sum][c], product)
+                                       : (uint16_t)(sums[sum][c] + product);
                 }
             }
-            // do pos take neg
-            if (numneg > 0) {
-                if (this->config.absolute) {
-                    // psubsw mm0, mm1
-                    appenddraw(0x0F);
-                    appenddraw(0xE9);
-                    appenddraw(0xC1);
-                    // calculate absolute values
-                    // psllw mm0, 1
-                    appenddraw(0x0F);
-                    appenddraw(0x71);
-                    appenddraw(0xF0);
-                    appenddraw(0x01);
-                    // psrlw mm0, 1
-                    appenddraw(0x0F);
-                    appenddraw(0x71);
-                    appenddraw(0xD0);
-                    appenddraw(0x01);
-                } else {
-                    if (this->config.wrap) {
-                        // psubw mm0, mm1
-                        appenddraw(0x0F);
-                        appenddraw(0xF9);
-                        appenddraw(0xC1);
-                    } else {
-                        // psubusw mm0, mm1
-                        appenddraw(0x0F);
-                        appenddraw(0xD9);
-                        appenddraw(0xC1);
-                    }
+            if (draw.bias_sum == sum) {
+                for (int c = 0; c < 4; c++) {
+                    sums[sum][c] = adds_u16(sums[sum][c], draw.bias);
                 }
             }
-            if (this->config.two_pass && pass == 0) {
-                // movq mm3, mm0
-                appenddraw(0x0F);
-                appenddraw(0x7F);
-                appenddraw(0xC3);
+        }
+        for (int c = 0; c < 4; c++) {
+            uint16_t value = convolution_combine_c(draw, sums[0][c], sums[1][c]);
+            result[c] = pass == 0 ? value : adds_u16(value, result[c]);
+        }
+    }
+    return convolution_finish_c(draw, result);
+}
+
+static inline void convolution_horizontal_px_c(const Convolution_Tap* taps,
+                                               int num_taps,
+                                               const uint32_t* src,
+                                               const int* columns,
+                                               uint16_t* out) {
+    uint16_t sum[4] = {0, 0, 0, 0};
+    for (int t = 0; t < num_taps; t++) {
+        uint32_t px = src[columns[taps[t].x]];
+        for (int c = 0; c < 4; c++) {
+            sum[c] += (uint16_t)(((px >> (c * 8)) & 0xff) * taps[t].weight);
+        }
+    }
+    memcpy(out, sum, sizeof(sum));
+}
+
+static uint32_t convolution_vertical_px_c(const Convolution_Draw& draw,
+                                          const uint16_t* const (*h_rows)[2][7],
+                                          int i) {
+    uint16_t result[4] = {0, 0, 0, 0};
+    for (int pass = 0; pass < draw.num_passes; pass++) {
+        uint16_t sums[2][4] = {{0, 0, 0, 0}, {0, 0, 0, 0}};
+        for (int t = 0; t < draw.num_v_taps[pass]; t++) {
+            const Convolution_Vertical_Tap& tap = draw.v_taps[pass][t];
+            const uint16_t* pos = &h_rows[pass][tap.swap ? 1 : 0][tap.y][i * 4];
+            const uint16_t* neg = &h_rows[pass][tap.swap ? 0 : 1][tap.y][i * 4];
+            for (int c = 0; c < 4; c++) {
+                sums[0][c] += (uint16_t)(pos[c] * tap.weight);
+                sums[1][c] += (uint16_t)(neg[c] * tap.weight);
             }
-        }  // end of pass for
-        if (this->config.two_pass) {
-            // psubusw mm0, mm3
-            appenddraw(0x0F);
-            appenddraw(0xDD);
-            appenddraw(0xC3);
         }
-        // scale
-        if (divisionfactor != 1) {
-            int j;
-            // see if divisionfactor is a power of 2
-            uint8_t k = 0;
-            for (j = 1; j < divisionfactor; j <<= 1) {
-                k++;
+        if (draw.bias_sum >= 0) {
+            for (int c = 0; c < 4; c++) {
+                sums[draw.bias_sum][c] = adds_u16(sums[draw.bias_sum][c], draw.bias);
             }
-            if (j == divisionfactor) {
-                // divisionfactor=2^k
-                // psrlw mm0, k
-                appenddraw(0x0F);
-                appenddraw(0x71);
-                appenddraw(0xD0);
-                appenddraw(k);
+        }
+        for (int c = 0; c < 4; c++) {
+            uint16_t value = convolution_combine_c(draw, sums[0][c], sums[1][c]);
+            result[c] = pass == 0 ? value : adds_u16(value, result[c]);
+        }
+    }
+    return convolution_finish_c(draw, result);
+}
+
+#ifdef SIMD_MODE_X86_SSE
+/**
+ * SIMD operations on 16-bit channel lanes. `widen()` loads `num_px` pixels into two
+ * registers of 16-bit lanes in memory order, `narrow()` packs them back with signed
+ * saturation.
+ */
+struct Convolution_x86v128 {
+    typedef __m128i v;
+    static constexpr int num_px = 4;
+    static inline void widen(const uint32_t* src, v& lo, v& hi) {
+        __m128i px = _mm_loadu_si128((const __m128i*)src);
+        lo = _mm_unpacklo_epi8(px, _mm_setzero_si128());
+        hi = _mm_unpackhi_epi8(px, _mm_setzero_si128());
+    }
+    static inline void narrow(uint32_t* dest, v lo, v hi) {
+        _mm_storeu_si128((__m128i*)dest, _mm_packus_epi16(lo, hi));
+    }
+    static inline v load(const uint16_t* src) {
+        return _mm_loadu_si128((const __m128i*)src);
+    }
+    static inline void store(uint16_t* dest, v a) {
+        _mm_storeu_si128((__m128i*)dest, a);
+    }
+    static inline v zero() { return _mm_setzero_si128(); }
+    static inline v set1(uint16_t a) { return _mm_set1_epi16((int16_t)a); }
+    static inline v alpha_mask() { return _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0); }
+    static inline v mullo(v a, v b) { return _mm_mullo_epi16(a, b); }
+    static inline v mulhi(v a, v b) { return _mm_mulhi_epu16(a, b); }
+    static inline v add(v a, v b) { return _mm_add_epi16(a, b); }
+    static inline v adds(v a, v b) { return _mm_adds_epu16(a, b); }
+    static inline v sub(v a, v b) { return _mm_sub_epi16(a, b); }
+    static inline v subs(v a, v b) { return _mm_subs_epu16(a, b); }
+    static inline v subs_signed(v a, v b) { return _mm_subs_epi16(a, b); }
+    static inline v srl(v a, int count) {
+        return _mm_srl_epi16(a, _mm_cvtsi32_si128(count));
+    }
+    static inline v and_(v a, v b) { return _mm_and_si128(a, b); }
+    static inline v andnot(v a, v b) { return _mm_andnot_si128(a, b); }
+    static inline v or_(v a, v b) { return _mm_or_si128(a, b); }
+};
+
+#ifdef __AVX2__
+struct Convolution_x86v256 {
+    typedef __m256i v;
+    static constexpr int num_px = 8;
+    static inline void widen(const uint32_t* src, v& lo, v& hi) {
+        lo = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)src));
+        hi = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(src + 4)));
+    }
+    static inline void narrow(uint32_t* dest, v lo, v hi) {
+        // packus works per 128-bit lane, so the 64-bit quarters need reordering.
+        _mm256_storeu_si256(
+            (__m256i*)dest,
+            _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0b11011000));
+    }
+    static inline v load(const uint16_t* src) {
+        return _mm256_loadu_si256((const __m256i*)src);
+    }
+    static inline void store(uint16_t* dest, v a) {
+        _mm256_storeu_si256((__m256i*)dest, a);
+    }
+    static inline v zero() { return _mm256_setzero_si256(); }
+    static inline v set1(uint16_t a) { return _mm256_set1_epi16((int16_t)a); }
+    static inline v alpha_mask() {
+        return _mm256_broadcastsi128_si256(Convolution_x86v128::alpha_mask());
+    }
+    static inline v mullo(v a, v b) { return _mm256_mullo_epi16(a, b); }
+    static inline v mulhi(v a, v b) { return _mm256_mulhi_epu16(a, b); }
+    static inline v add(v a, v b) { return _mm256_add_epi16(a, b); }
+    static inline v adds(v a, v b) { return _mm256_adds_epu16(a, b); }
+    static inline v sub(v a, v b) { return _mm256_sub_epi16(a, b); }
+    static inline v subs(v a, v b) { return _mm256_subs_epu16(a, b); }
+    static inline v subs_signed(v a, v b) { return _mm256_subs_epi16(a, b); }
+    static inline v srl(v a, int count) {
+        return _mm256_srl_epi16(a, _mm_cvtsi32_si128(count));
+    }
+    static inline v and_(v a, v b) { return _mm256_and_si256(a, b); }
+    static inline v andnot(v a, v b) { return _mm256_andnot_si256(a, b); }
+    static inline v or_(v a, v b) { return _mm256_or_si256(a, b); }
+};
+#endif  // __AVX2__
+
+template <class V>
+static inline typename V::v convolution_combine(const Convolution_Draw& draw,
+                                                typename V::v pos,
+                                                typename V::v neg) {
+    if (!draw.subtract) {
+        return pos;
+    }
+    switch (draw.combine) {
+        case Convolution_Draw::COMBINE_ABSOLUTE:
+            return V::and_(V::subs_signed(pos, neg), V::set1(0x7fff));
+        case Convolution_Draw::COMBINE_WRAP: return V::sub(pos, neg);
+        default: return V::subs(pos, neg);
+    }
+}
+
+template <class V>
+static inline void convolution_finish(const Convolution_Draw& draw,
+                                      typename V::v lo,
+                                      typename V::v hi,
+                                      uint32_t* dest) {
+    if (draw.scale == Convolution_Draw::SCALE_SHIFT) {
+        lo = V::srl(lo, draw.scale_param);
+        hi = V::srl(hi, draw.scale_param);
+    } else if (draw.scale == Convolution_Draw::SCALE_MULTIPLY) {
+        typename V::v factor = V::set1(draw.scale_param);
+        typename V::v alpha = V::alpha_mask();
+        lo = V::or_(V::andnot(alpha, V::mulhi(lo, factor)), V::and_(alpha, lo));
+        hi = V::or_(V::andnot(alpha, V::mulhi(hi, factor)), V::and_(alpha, hi));
+    }
+    V::narrow(dest, lo, hi);
+}
+
+template <class V, bool saturate>
+static inline void convolution_sum(const Convolution_Tap* taps,
+                                   int num_taps,
+                                   const uint32_t* const* rows,
+                                   int i,
+                                   typename V::v& lo,
+                                   typename V::v& hi) {
+    for (int t = 0; t < num_taps; t++) {
+        typename V::v px_lo, px_hi;
+        V::widen(rows[taps[t].y] + i + taps[t].x - CONVO_KERNEL_DIM / 2, px_lo, px_hi);
+        typename V::v weight = V::set1(taps[t].weight);
+        if (saturate) {
+            lo = V::adds(lo, V::mullo(px_lo, weight));
+            hi = V::adds(hi, V::mullo(px_hi, weight));
+        } else {
+            lo = V::add(lo, V::mullo(px_lo, weight));
+            hi = V::add(hi, V::mullo(px_hi, weight));
+        }
+    }
+}
+
+/**
+ * Render `V::num_px` pixels starting at column `i`, which must not be within 3 pixels
+ * of either edge.
+ */
+template <class V>
+static inline void convolution_chunk(const Convolution_Draw& draw,
+                                     const uint32_t* const* rows,
+                                     int i,
+                                     uint32_t* dest) {
+    typename V::v result_lo = V::zero(), result_hi = V::zero();
+    for (int pass = 0; pass < draw.num_passes; pass++) {
+        typename V::v sum_lo[2] = {V::zero(), V::zero()};
+        typename V::v sum_hi[2] = {V::zero(), V::zero()};
+        for (int sum = 0; sum < 2; sum++) {
+            const Convolution_Tap* taps = draw.taps[pass][sum];
+            int num_taps = draw.num_taps[pass][sum];
+            if (draw.saturate[sum]) {
+                convolution_sum<V, true>(
+                    taps, num_taps, rows, i, sum_lo[sum], sum_hi[sum]);
             } else {
-                // movq [esp-8], mm0
-                appenddraw(0x0F);
-                appenddraw(0x7F);
-                appenddraw(0x44);
-                appenddraw(0x24);
-                appenddraw(0xF8);
-                // mov [esp-10], ax
-                appenddraw(0x66);
-                appenddraw(0x89);
-                appenddraw(0x44);
-                appenddraw(0x24);
-                appenddraw(0xF6);
-                // mov [esp-12], dx
-                appenddraw(0x66);
-                appenddraw(0x89);
-                appenddraw(0x54);
-                appenddraw(0x24);
-                appenddraw(0xF4);
-                appenddraw(0xBB);
-                // mov mov ebx,
-                // 65536/divisionfactor
-                // 65536/divisionfactor needs to begin with the lowest byte
-                appenddraw((65536 / divisionfactor) & 0x000000FF);
-                appenddraw(((65536 / divisionfactor) & 0x0000FF00) >> 8);
-                appenddraw(((65536 / divisionfactor) & 0x00FF0000) >> 16);
-                appenddraw(((65536 / divisionfactor) & 0xFF000000) >> 24);
-                appenddraw(0x66);  // mov dx, bx
-                appenddraw(0x8B);
-                appenddraw(0xD3);
-                appenddraw(0x66);  // mov ax, [esp-8]
-                appenddraw(0x8B);
-                appenddraw(0x44);
-                appenddraw(0x24);
-                appenddraw(0xF8);
-                appenddraw(0x66);  // mul dx
-                appenddraw(0xF7);
-                appenddraw(0xE2);
-                appenddraw(0x66);  // mov [esp-8], dx
-                appenddraw(0x89);
-                appenddraw(0x54);
-                appenddraw(0x24);
-                appenddraw(0xF8);
-                appenddraw(0x66);  // mov dx, bx
-                appenddraw(0x8B);
-                appenddraw(0xD3);
-                appenddraw(0x66);  // mov ax, [esp-6]
-                appenddraw(0x8B);
-                appenddraw(0x44);
-                appenddraw(0x24);
-                appenddraw(0xFA);
-                appenddraw(0x66);  // mul dx
-                appenddraw(0xF7);
-                appenddraw(0xE2);
-                appenddraw(0x66);  // mov [esp-6], dx
-                appenddraw(0x89);
-                appenddraw(0x54);
-                appenddraw(0x24);
-                appenddraw(0xFA);
-                appenddraw(0x66);  // mov dx, bx
-                appenddraw(0x8B);
-                appenddraw(0xD3);
-                appenddraw(0x66);  // mov ax, [esp-4]
-                appenddraw(0x8B);
-                appenddraw(0x44);
-                appenddraw(0x24);
-                appenddraw(0xFC);
-                appenddraw(0x66);  // mul dx
-                appenddraw(0xF7);
-                appenddraw(0xE2);
-                appenddraw(0x66);  // mov [esp-4], dx
-                appenddraw(0x89);
-                appenddraw(0x54);
-                appenddraw(0x24);
-                appenddraw(0xFC);
-                appenddraw(0x66);  // mov dx, [esp-12]
-                appenddraw(0x8B);
-                appenddraw(0x54);
-                appenddraw(0x24);
-                appenddraw(0xF4);
-                appenddraw(0x66);  // mov ax, [esp-10]
-                appenddraw(0x8B);
-                appenddraw(0x44);
-                appenddraw(0x24);
-                appenddraw(0xF6);
-                appenddraw(0x0F);  // movq mm0, [esp-8]
-                appenddraw(0x6F);
-                appenddraw(0x44);
-                appenddraw(0x24);
-                appenddraw(0xF8);
+                convolution_sum<V, false>(
+                    taps, num_taps, rows, i, sum_lo[sum], sum_hi[sum]);
+            }
+            if (draw.bias_sum == sum) {
+                sum_lo[sum] = V::adds(sum_lo[sum], V::set1(draw.bias));
+                sum_hi[sum] = V::adds(sum_hi[sum], V::set1(draw.bias));
             }
         }
-        // output
-        appenddraw(0x0F);  // packuswb mm0, mm7
-        appenddraw(0x67);
-        appenddraw(0xC7);
-        appenddraw(0x0F);  // movd [edx], mm0
-        appenddraw(0x7E);
-        appenddraw(0x02);
-        // increase k
-        appenddraw(0x83);  // add edx, 4
-        appenddraw(0xC2);
-        appenddraw(0x04);
-        // i "next" block
-        if (im < 4) {
-            appenddraw(0x83);  // add edi, 4
-            appenddraw(0xC7);
-            appenddraw(0x04);
+        typename V::v lo = convolution_combine<V>(draw, sum_lo[0], sum_lo[1]);
+        typename V::v hi = convolution_combine<V>(draw, sum_hi[0], sum_hi[1]);
+        result_lo = pass == 0 ? lo : V::adds(lo, result_lo);
+        result_hi = pass == 0 ? hi : V::adds(hi, result_hi);
+    }
+    convolution_finish<V>(draw, result_lo, result_hi, dest);
+}
+
+template <class V>
+static inline void convolution_horizontal_chunk(const Convolution_Tap* taps,
+                                                int num_taps,
+                                                const uint32_t* src,
+                                                int i,
+                                                uint16_t* out) {
+    typename V::v lo = V::zero(), hi = V::zero();
+    convolution_sum<V, false>(taps, num_taps, &src, i, lo, hi);
+    V::store(&out[i * 4], lo);
+    V::store(&out[(i + V::num_px / 2) * 4], hi);
+}
+
+template <class V>
+static inline void convolution_vertical_chunk(const Convolution_Draw& draw,
+                                              const uint16_t* const (*h_rows)[2][7],
+                                              int i,
+                                              uint32_t* dest) {
+    constexpr int hi_offset = V::num_px / 2 * 4;
+    typename V::v result_lo = V::zero(), result_hi = V::zero();
+    for (int pass = 0; pass < draw.num_passes; pass++) {
+        typename V::v sum_lo[2] = {V::zero(), V::zero()};
+        typename V::v sum_hi[2] = {V::zero(), V::zero()};
+        for (int t = 0; t < draw.num_v_taps[pass]; t++) {
+            const Convolution_Vertical_Tap& tap = draw.v_taps[pass][t];
+            const uint16_t* pos = &h_rows[pass][tap.swap ? 1 : 0][tap.y][i * 4];
+            const uint16_t* neg = &h_rows[pass][tap.swap ? 0 : 1][tap.y][i * 4];
+            typename V::v weight = V::set1(tap.weight);
+            sum_lo[0] = V::add(sum_lo[0], V::mullo(V::load(pos), weight));
+            sum_hi[0] = V::add(sum_hi[0], V::mullo(V::load(pos + hi_offset), weight));
+            sum_lo[1] = V::add(sum_lo[1], V::mullo(V::load(neg), weight));
+            sum_hi[1] = V::add(sum_hi[1], V::mullo(V::load(neg + hi_offset), weight));
+        }
+        if (draw.bias_sum >= 0) {
+            sum_lo[draw.bias_sum] = V::adds(sum_lo[draw.bias_sum], V::set1(draw.bias));
+            sum_hi[draw.bias_sum] = V::adds(sum_hi[draw.bias_sum], V::set1(draw.bias));
+        }
+        typename V::v lo = convolution_combine<V>(draw, sum_lo[0], sum_lo[1]);
+        typename V::v hi = convolution_combine<V>(draw, sum_hi[0], sum_hi[1]);
+        result_lo = pass == 0 ? lo : V::adds(lo, result_lo);
+        result_hi = pass == 0 ? hi : V::adds(hi, result_hi);
+    }
+    convolution_finish<V>(draw, result_lo, result_hi, dest + i);
+}
+#endif  // SIMD_MODE_X86_SSE
+
+static inline void convolution_source_columns(int i, int w, int* columns) {
+    for (int x = 0; x < CONVO_KERNEL_DIM; x++) {
+        columns[x] = convolution_source_column(i, x, w);
+    }
+}
+
+/**
+ * Render a single row. The pixels are processed strictly left to right, so rendering
+ * in-place reads the same (partially filtered) values as the original. `scalar_only`
+ * is needed if pixels within a SIMD chunk would depend on each other.
+ */
+static void convolution_render_row(const Convolution_Draw& draw,
+                                   const uint32_t* const* rows,
+                                   uint32_t* dest,
+                                   int w,
+                                   bool scalar_only) {
+    const int middle_end = w - CONVO_KERNEL_DIM / 2;
+    int columns[CONVO_KERNEL_DIM];
+    int i = 0;
+    for (; i < CONVO_KERNEL_DIM / 2 && i < w; i++) {
+        convolution_source_columns(i, w, columns);
+        dest[i] = convolution_px_c(draw, rows, columns);
+    }
+#ifdef SIMD_MODE_X86_SSE
+    if (!scalar_only) {
+#ifdef __AVX2__
+        for (; i + Convolution_x86v256::num_px <= middle_end;
+             i += Convolution_x86v256::num_px) {
+            convolution_chunk<Convolution_x86v256>(draw, rows, i, &dest[i]);
+        }
+#endif
+        for (; i + Convolution_x86v128::num_px <= middle_end;
+             i += Convolution_x86v128::num_px) {
+            convolution_chunk<Convolution_x86v128>(draw, rows, i, &dest[i]);
         }
-        if (im == 3) {
-            appenddraw(0x81);  // cmp edi, 4*(width-3)
-            appenddraw(0xFF);
-            // 4*(width-3) needs to begin with the lowest byte
-            appenddraw((4 * (this->width - 3)) & 0x000000FF);
-            appenddraw(((4 * (this->width - 3)) & 0x0000FF00) >> 8);
-            appenddraw(((4 * (this->width - 3)) & 0x00FF0000) >> 16);
-            appenddraw(((4 * (width - 3)) & 0xFF000000) >> 24);
-            // return to i "for". which jump to use depends on this->code_length
-            // can't use short jumps
-            if (iloopstart - this->code_length - 2 < -128) {
-                int jumpoffset;
-                appenddraw(0x0F);  // jb near back to i loop start
-                appenddraw(0x82);
-                jumpoffset = iloopstart - (this->code_length + 4);
-                // this->code_length + 4 is the index of the next command
-                // offset needs to begin with the lowest byte
-                appenddraw(jumpoffset & 0x000000FF);
-                appenddraw((jumpoffset & 0x0000FF00) >> 8);
-                appenddraw((jumpoffset & 0x00FF0000) >> 16);
-                appenddraw((jumpoffset & 0xFF000000) >> 24);
-            } else {  // can use short jumps.
-                // jb short back to i loop start
-                appenddraw(0x72);
-                // this->code_length+1 is the indes of the next command
-                auto value = ((char)(iloopstart - (this->code_length + 1)));
-                appenddraw(value);
+    }
+#else
+    (void)scalar_only, (void)middle_end;
+#endif
+    for (; i < w; i++) {
+        convolution_source_columns(i, w, columns);
+        dest[i] = convolution_px_c(draw, rows, columns);
+    }
+}
+
+static void convolution_horizontal(const Convolution_Tap* taps,
+                                   int num_taps,
+                                   const uint32_t* src,
+                                   uint16_t* out,
+                                   int w) {
+    const int middle_end = w - CONVO_KERNEL_DIM / 2;
+    int columns[CONVO_KERNEL_DIM];
+    int i = 0;
+    for (; i < CONVO_KERNEL_DIM / 2 && i < w; i++) {
+        convolution_source_columns(i, w, columns);
+        convolution_horizontal_px_c(taps, num_taps, src, columns, &out[i * 4]);
+    }
+#ifdef SIMD_MODE_X86_SSE
+#ifdef __AVX2__
+    for (; i + Convolution_x86v256::num_px <= middle_end;
+         i += Convolution_x86v256::num_px) {
+        convolution_horizontal_chunk<Convolution_x86v256>(taps, num_taps, src, i, out);
+    }
+#endif
+    for (; i + Convolution_x86v128::num_px <= middle_end;
+         i += Convolution_x86v128::num_px) {
+        convolution_horizontal_chunk<Convolution_x86v128>(taps, num_taps, src, i, out);
+    }
+#else
+    (void)middle_end;
+#endif
+    for (; i < w; i++) {
+        convolution_source_columns(i, w, columns);
+        convolution_horizontal_px_c(taps, num_taps, src, columns, &out[i * 4]);
+    }
+}
+
+// Row cache slots for the horizontal pass, must be a power of 2 >= CONVO_KERNEL_DIM.
+#define CONVO_SEPARABLE_SLOTS 8
+
+static size_t convolution_separable_scratch_size(int w) {
+    // [pass][slot][positive/negative half] rows of four 16-bit channels
+    return 2 * CONVO_SEPARABLE_SLOTS * 2 * 4 * (size_t)w;
+}
+
+/**
+ * Render a band of rows with a separable kernel: Filter each source row horizontally
+ * into an intermediate row cache (once per row, not once per output row) and then
+ * combine the cached rows vertically.
+ */
+static void convolution_render_separable(const Convolution_Draw& draw,
+                                         const uint32_t* src,
+                                         uint32_t* dest,
+                                         uint16_t* scratch,
+                                         int w,
+                                         int h,
+                                         int start_row,
+                                         int end_row) {
+    const size_t row_length = 4 * (size_t)w;
+    int cached_rows[2][CONVO_SEPARABLE_SLOTS];
+    for (int pass = 0; pass < 2; pass++) {
+        for (int slot = 0; slot < CONVO_SEPARABLE_SLOTS; slot++) {
+            cached_rows[pass][slot] = -1;
+        }
+    }
+    const uint16_t* h_rows[2][2][CONVO_KERNEL_DIM] = {};
+    for (int j = start_row; j < end_row; j++) {
+        for (int pass = 0; pass < draw.num_passes; pass++) {
+            for (int t = 0; t < draw.num_v_taps[pass]; t++) {
+                int y = draw.v_taps[pass][t].y;
+                int row = convolution_source_row(j, y, h);
+                int slot = row & (CONVO_SEPARABLE_SLOTS - 1);
+                uint16_t* pos =
+                    &scratch[((pass * CONVO_SEPARABLE_SLOTS + slot) * 2) * row_length];
+                uint16_t* neg = pos + row_length;
+                if (cached_rows[pass][slot] != row) {
+                    for (int half = 0; half < 2; half++) {
+                        convolution_horizontal(draw.h_taps[pass][half],
+                                               draw.num_h_taps[pass][half],
+                                               &src[row * w],
+                                               half == 0 ? pos : neg,
+                                               w);
+                    }
+                    cached_rows[pass][slot] = row;
+                }
+                h_rows[pass][0][y] = pos;
+                h_rows[pass][1][y] = neg;
             }
         }
+        uint32_t* dest_row = &dest[j * w];
+        int i = 0;
+#ifdef SIMD_MODE_X86_SSE
+#ifdef __AVX2__
+        for (; i + Convolution_x86v256::num_px <= w; i += Convolution_x86v256::num_px) {
+            convolution_vertical_chunk<Convolution_x86v256>(draw, h_rows, i, dest_row);
+        }
+#endif
+        for (; i + Convolution_x86v128::num_px <= w; i += Convolution_x86v128::num_px) {
+            convolution_vertical_chunk<Convolution_x86v128>(draw, h_rows, i, dest_row);
+        }
+#endif
+        for (; i < w; i++) {
+            dest_row[i] = convolution_vertical_px_c(draw, h_rows, i);
+        }
     }
-    // increment the line address array
-    appenddraw(0x8B);  // mov ebx, [esp]
-    appenddraw(0x1C);
-    appenddraw(0x24);
-    appenddraw(0x81);  // add ebx, 4*width
-    appenddraw(0xC3);
-    // 4*width needs to begin with the lowest byte
-    appenddraw((4 * this->width) & 0x000000FF);
-    appenddraw(((4 * this->width) & 0x0000FF00) >> 8);
-    appenddraw(((4 * this->width) & 0x00FF0000) >> 16);
-    appenddraw(((4 * this->width) & 0xFF000000) >> 24);
-    appenddraw(0x8B);  // mov eax, framebuffer
-    appenddraw(0x45);
-    appenddraw(0x14);
-    appenddraw(0x05);  // add eax, 4*width*(height-1)
-    // 4*width*(height-1) needs to begin with the lowest byte
-    appenddraw((4 * this->width * (this->height - 1)) & 0x000000FF);
-    appenddraw(((4 * this->width * (this->height - 1)) & 0x0000FF00) >> 8);
-    appenddraw(((4 * this->width * (this->height - 1)) & 0x00FF0000) >> 16);
-    appenddraw(((4 * this->width * (this->height - 1)) & 0xFF000000) >> 24);
-    appenddraw(0x3B);  // cmp ebx, eax
-    appenddraw(0xD8);
-    appenddraw(0x75);  // jne 3 (e.g. to the push epx line)
-    appenddraw(0x03);
-    appenddraw(0x8B);  // mov ebx, [esp]
-    appenddraw(0x1C);
-    appenddraw(0x24);
-    appenddraw(0x53);  // push ebx
-    // note: relative to esp the addresses of c[0]-c[6] are the same.
-    // this has effectively done
-    // c[0]=c[1]...c[5]=c[6],c[6]+=4*w,c[6]=min(c[6],address of the last row of
-    // franebuffer) j next block
-    appenddraw(0x46);  // inc esi
-    appenddraw(0x81);  // cmp esi, height
-    appenddraw(0xFE);
-    // height needs to begin with the lowest byte
-    appenddraw(this->height & 0x000000FF);
-    appenddraw((this->height & 0x0000FF00) >> 8);
-    appenddraw((this->height & 0x00FF0000) >> 16);
-    appenddraw((this->height & 0xFF000000) >> 24);
-    // return to j "for". which jump to use depends on this->code_length
-    if (jloopstart - this->code_length - 2 < -128) {
-        // can't use short jumps
-        int jumpoffset;
-        appenddraw(0x0F);  // jb near back to j loop start
+}
 
-        // this->code_length + 4 is the index of the next command
-        appenddraw(0x82);
-        jumpoffset = jloopstart - (this->code_length + 4);
-        // offset needs to begin with the lowest byte
-        appenddraw(jumpoffset & 0x000000FF);
-        appenddraw((jumpoffset & 0x0000FF00) >> 8);
-        appenddraw((jumpoffset & 0x00FF0000) >> 16);
-        appenddraw((jumpoffset & 0xFF000000) >> 24);
-    } else {
-        // can use short jumps.
-        appenddraw(0x72);  // jb short back to j loop start
-        auto value = ((char)(jloopstart - (this->code_length + 1)));
-        appenddraw(value);
-        // this->code_length + 1 is the index of the next command
-    }  // clear mmx state
-    appenddraw(0x0F);  // emms
-    appenddraw(0x77);
-    // function exit code
-    appenddraw(0x8B);  // mov esp, ebp
-    appenddraw(0xE5);
-    appenddraw(0x5D);  // pop ebp
-    appenddraw(0x5F);  // pop edi
-    appenddraw(0x5E);  // pop esi
-    appenddraw(0x5B);  // pop ebx
-    appenddraw(0xB8);  // mov eax, use_fbout
-    appenddraw(use_fbout);
-    appenddraw(0x00);
-    appenddraw(0x00);
-    appenddraw(0x00);
-    appenddraw(0xC3);  // ret
-    this->draw_created = true;
+static inline void convolution_band(int band,
+                                    int num_bands,
+                                    int h,
+                                    int* start_row,
+                                    int* end_row) {
+    *start_row = (band * h) / num_bands;
+    *end_row = band >= num_bands - 1 ? h : ((band + 1) * h) / num_bands;
+}
+
+// In-place rendering reads up to 3 rows below the current one.
+#define CONVO_HALO_ROWS (CONVO_KERNEL_DIM / 2)
+
+int E_Convolution::smp_begin(int max_threads,
+                             char[2][2][576],
+                             int,
+                             int* framebuffer,
+                             int*,
+                             int w,
+                             int h) {
+    if (this->need_draw_update) {
+        this->prepare_draw();
+    }
+    int num_bands = max_threads < 1 ? 1 : max_threads;
+    if (this->draw.in_place) {
+        if (this->draw.num_passes > 1) {
+            // The rotated second pass reads already-filtered pixels from the rows
+            // above, so the frame can only be rendered sequentially.
+            num_bands = 1;
+        } else {
+            // The last two rows read from each other and need to be in the same band.
+            num_bands = max(1, min(num_bands, h / (CONVO_HALO_ROWS * 2)));
+        }
+    }
+    this->num_bands = num_bands;
+    if (this->draw.in_place && num_bands > 1) {
+        // Each band but the last needs to read the next band's first rows before they
+        // are filtered, so keep a copy.
+        this->band_halos.resize((size_t)(num_bands - 1) * CONVO_HALO_ROWS * w);
+        for (int band = 0; band < num_bands - 1; band++) {
+            int start_row, end_row;
+            convolution_band(band, num_bands, h, &start_row, &end_row);
+            int num_rows = min(CONVO_HALO_ROWS, h - end_row);
+            memcpy(&this->band_halos[(size_t)band * CONVO_HALO_ROWS * w],
+                   &framebuffer[end_row * w],
+                   num_rows * w * sizeof(uint32_t));
+        }
+    }
+    if (this->draw.separable) {
+        this->separable_rows.resize(num_bands * convolution_separable_scratch_size(w));
+    }
+    return num_bands;
+}
+
+void E_Convolution::smp_render(int this_thread,
+                               int max_threads,
+                               char[2][2][576],
+                               int,
+                               int* framebuffer,
+                               int* fbout,
+                               int w,
+                               int h) {
+    if (this_thread >= this->num_bands) {
+        return;
+    }
+    int start_row, end_row;
+    convolution_band(
+        this_thread, min(max_threads, this->num_bands), h, &start_row, &end_row);
+    if (end_row <= start_row) {
+        return;
+    }
+    const Convolution_Draw& draw = this->draw;
+    auto src = (const uint32_t*)framebuffer;
+    auto dest = (uint32_t*)(draw.in_place ? framebuffer : fbout);
+    if (draw.separable) {
+        uint16_t* scratch =
+            &this->separable_rows[this_thread * convolution_separable_scratch_size(w)];
+        convolution_render_separable(
+            draw, src, dest, scratch, w, h, start_row, end_row);
+        return;
+    }
+    const uint32_t* halo = nullptr;
+    if (draw.in_place && end_row < h) {
+        halo = &this->band_halos[(size_t)this_thread * CONVO_HALO_ROWS * w];
+    }
+    // When filtering in-place, the second pass and the last two rows read pixels
+    // filtered earlier in the same row, so pixels can't be rendered in parallel.
+    bool in_place_sequential = draw.in_place && draw.num_passes > 1;
+    for (int j = start_row; j < end_row; j++) {
+        const uint32_t* rows[CONVO_KERNEL_DIM];
+        for (int y = 0; y < CONVO_KERNEL_DIM; y++) {
+            int row = convolution_source_row(j, y, h);
+            rows[y] =
+                halo && row >= end_row ? &halo[(row - end_row) * w] : &src[row * w];
+        }
+        bool scalar_only = in_place_sequential || (draw.in_place && j >= h - 2);
+        convolution_render_row(draw, rows, &dest[j * w], w, scalar_only);
+    }
+}
+
+int E_Convolution::smp_finish(char[2][2][576], int, int*, int*, int, int) {
+    return this->draw.in_place ? 0 : 1;
 }
 
 void E_Convolution::kernel_save() {
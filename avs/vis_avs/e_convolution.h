@@ -4,7 +4,7 @@
 #include "effect_info.h"
 
 #include <cstdint>
-#include <mmintrin.h>
+#include <vector>
 
 #define CONVO_KERNEL_DIM       7
 #define CONVO_KERNEL_SIZE      CONVO_KERNEL_DIM* CONVO_KERNEL_DIM
@@ -115,12 +115,66 @@ struct Convolution_Info : public Effect_Info {
     EFFECT_INFO_GETTERS;
 };
 
-typedef int (*draw_func)(void* framebuffer, void* fbout, void* m64f_array);
+struct Convolution_Tap {
+    uint16_t weight;  // absolute kernel value, modulo 2^16 (i.e. what pmullw sees)
+    uint8_t x;        // kernel column, 0-6
+    uint8_t y;        // kernel row, 0-6
+};
+
+struct Convolution_Vertical_Tap {
+    uint16_t weight;
+    uint8_t y;
+    // Negative row factor: the row feeds the subtracted sum from the positive half of
+    // the horizontal pass and vice versa.
+    bool swap;
+};
+
+/**
+ * Everything needed to render a frame with the current kernel. This replaces the
+ * JIT-compiled MMX draw function of the original APE, and reproduces its arithmetic
+ * bit-exactly: Each channel is a 16-bit lane. Positive and negative kernel entries
+ * (multiplied modulo 2^16) are summed up separately, either wrapping or with unsigned
+ * saturation, depending on the kernel's total sums. Both sums are then combined
+ * according to the "wrap" and "absolute" settings, scaled and packed back to 8 bits
+ * with signed saturation.
+ */
+struct Convolution_Draw {
+    enum Combine { COMBINE_CLAMP = 0, COMBINE_WRAP, COMBINE_ABSOLUTE };
+    enum Scale { SCALE_NONE = 0, SCALE_SHIFT, SCALE_MULTIPLY };
+    // Nonzero kernel entries for each pass, split into [0] added and [1] subtracted.
+    // The second pass uses the kernel rotated by 90deg.
+    Convolution_Tap taps[2][2][CONVO_KERNEL_SIZE];
+    int num_taps[2][2];
+    int num_passes;
+    // Whether the added/subtracted sums use paddusw instead of paddw.
+    bool saturate[2];
+    uint16_t bias;
+    // Which sum the bias is added to (it's always added with saturation). -1 for none.
+    int bias_sum;
+    bool subtract;
+    Combine combine;
+    Scale scale;
+    uint16_t scale_param;
+    // The original renders in-place if the first 24 kernel entries are zero. This
+    // makes some edge pixels (and the second pass) read already-filtered pixels, which
+    // is retained for compatibility.
+    bool in_place;
+
+    // If the kernel is a rank-1 matrix (an outer product of a column and a row vector),
+    // it's applied as a horizontal and a vertical pass instead. Only used if the
+    // result is the same, i.e. if the sums can never saturate.
+    bool separable;
+    // [pass][0: positive, 1: negative] horizontal factors.
+    Convolution_Tap h_taps[2][2][CONVO_KERNEL_DIM];
+    int num_h_taps[2][2];
+    Convolution_Vertical_Tap v_taps[2][CONVO_KERNEL_DIM];
+    int num_v_taps[2];
+};
 
 class E_Convolution : public Configurable_Effect<Convolution_Info, Convolution_Config> {
    public:
     E_Convolution(AVS_Instance* avs);
-    virtual ~E_Convolution();
+    virtual ~E_Convolution() = default;
     virtual int render(char visdata[2][2][576],
                        int is_beat,
                        int* framebuffer,
@@ -131,8 +185,30 @@ class E_Convolution : public Configurable_Effect<Convolution_Info, Convolution_C
     virtual int save_legacy(unsigned char* data);
     virtual E_Convolution* clone() { return new E_Convolution(*this); }
 
-    void create_draw_func();
-    inline void delete_draw_func();
+    virtual bool can_multithread() { return true; }
+    virtual int smp_begin(int max_threads,
+                          char visdata[2][2][576],
+                          int is_beat,
+                          int* framebuffer,
+                          int* fbout,
+                          int w,
+                          int h);
+    virtual void smp_render(int this_thread,
+                            int max_threads,
+                            char visdata[2][2][576],
+                            int is_beat,
+                            int* framebuffer,
+                            int* fbout,
+                            int w,
+                            int h);
+    virtual int smp_finish(char visdata[2][2][576],
+                           int is_beat,
+                           int* framebuffer,
+                           int* fbout,
+                           int w,
+                           int h);
+
+    void prepare_draw();
     void check_scale_not_zero();
     void check_mutually_exclusive_abs_wrap(bool wrap_changed_last = true);
     void autoscale();
@@ -140,14 +216,12 @@ class E_Convolution : public Configurable_Effect<Convolution_Info, Convolution_C
     void kernel_save();
     void kernel_load();
 
-    draw_func draw;
-
-    // abs(farray) packed into the four unsigned shorts that make up an m64
-    __m64 m64_farray[CONVO_KERNEL_SIZE];
-    __m64 m64_bias;
-    int width;
-    int height;
-    bool draw_created;
+    Convolution_Draw draw;
     bool need_draw_update;
-    int code_length;
+    int num_bands;
+    // Original copies of the first rows of each band (but the first) for in-place
+    // rendering, since the band above needs to read them unfiltered.
+    std::vector<uint32_t> band_halos;
+    // Per-band intermediate rows of the horizontal pass of a separable kernel.
+    std::vector<uint16_t> separable_rows;
 };
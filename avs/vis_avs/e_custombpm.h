@@ -27,6 +27,7 @@ struct CustomBPM_Info : public Effect_Info {
     static constexpr char const* help = "";
     static constexpr int32_t legacy_id = 33;
     static constexpr char const* legacy_ape_id = nullptr;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static const char* const* bpm_modes(int64_t* length_out) {
         *length_out = 3;
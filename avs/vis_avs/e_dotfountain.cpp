@@ -69,7 +69,7 @@ void DotFountain_Info::init_color_map_list(Effect* component,
 E_DotFountain::E_DotFountain(AVS_Instance* avs)
     : Configurable_Effect(avs), points(), color_map() {
     this->init_color_map();
-    memset(this->points, 0, sizeof(this->points));
+    memset(&this->points, 0, sizeof(this->points));
 }
 
 void E_DotFountain::init_color_map() {
@@ -110,31 +110,32 @@ int E_DotFountain::render(char visdata[2][2][576],
     matrixTranslate(transform2, 0.0f, -20.0f, 400.0f);
     matrixMultiply(transform, transform2);
 
-    DotFountain_Point tmp_ring[NUM_ROT_DIV];
-    DotFountain_Point* prev;
-    DotFountain_Point* next;
+    DotFountain_Points& p = this->points;
 
     // Move all points.
-    memcpy(tmp_ring, &this->points[0], sizeof(tmp_ring));
-    int generation = NUM_ROT_HEIGHT - 2;
-    do {
-        float accel_radius = 1.3f / ((float)generation + 100);
-        prev = &this->points[generation][0];
-        next = &this->points[generation + 1][0];
+    const size_t moved_size = sizeof(p.radius[0]) * (NUM_ROT_HEIGHT - 1);
+    memmove(p.radius[1], p.radius[0], moved_size);
+    memmove(p.delta_radius[1], p.delta_radius[0], moved_size);
+    memmove(p.height[1], p.height[0], moved_size);
+    memmove(p.delta_height[1], p.delta_height[0], moved_size);
+    memmove(p.ax[1], p.ax[0], moved_size);
+    memmove(p.ay[1], p.ay[0], moved_size);
+    memmove(p.color[1], p.color[0], sizeof(p.color[0]) * (NUM_ROT_HEIGHT - 1));
+    for (int generation = 1; generation < NUM_ROT_HEIGHT; generation++) {
+        float accel_radius = 1.3f / ((float)(generation - 1) + 100);
+        float* radius = p.radius[generation];
+        float* delta_radius = p.delta_radius[generation];
+        float* height = p.height[generation];
+        float* delta_height = p.delta_height[generation];
         for (int angular_pos = 0; angular_pos < NUM_ROT_DIV; angular_pos++) {
-            *next = *prev;
-            next->radius += next->delta_radius;
-            next->delta_height += 0.05f;
-            next->delta_radius += accel_radius;
-            next->height += next->delta_height;
-            next++;
-            prev++;
+            radius[angular_pos] += delta_radius[angular_pos];
+            delta_height[angular_pos] += 0.05f;
+            delta_radius[angular_pos] += accel_radius;
+            height[angular_pos] += delta_height[angular_pos];
         }
-    } while (generation--);
+    }
 
     // Add a new ring of points at the bottom
-    next = this->points[0];
-    prev = tmp_ring;
     float angle;
     for (int angular_pos = 0; angular_pos < NUM_ROT_DIV; angular_pos++) {
         auto audio_sample = (uint8_t)visdata[1][0][angular_pos] ^ 128;
@@ -142,23 +143,21 @@ int E_DotFountain::render(char visdata[2][2][576],
         if (audio > 255) {
             audio = 255;
         }
-        next->radius = 1.0f;
-        next->height = 250;
+        p.radius[0][angular_pos] = 1.0f;
+        p.height[0][angular_pos] = 250;
         float dr = (float)std::labs(audio) / 200.0f + 1.0f;
-        // Initial upward speed
-        next->delta_height =
-            -dr * (100.0f + (next->delta_height - prev->delta_height)) / 100.0f * 2.8f;
+        // Initial upward speed. (The original added the difference between the new
+        // and the old ring's delta_height here, which was always zero.)
+        p.delta_height[0][angular_pos] = -dr * 100.0f / 100.0f * 2.8f;
         audio = audio / 4;
         if (audio > 63) {
             audio = 63;
         }
-        next->color = this->color_map[audio];
+        p.color[0][angular_pos] = this->color_map[audio];
         angle = (float)(angular_pos * M_PI) * 2.0f / NUM_ROT_DIV;
-        next->ax = (float)sin(angle);
-        next->ay = (float)cos(angle);
-        next->delta_radius = 0.0;
-        next++;
-        prev++;
+        p.ax[0][angular_pos] = (float)sin(angle);
+        p.ay[0][angular_pos] = (float)cos(angle);
+        p.delta_radius[0][angular_pos] = 0.0;
     }
 
     // Display points:
@@ -170,29 +169,37 @@ int E_DotFountain::render(char visdata[2][2][576],
     if (zoom2 < zoom) {
         zoom = zoom2;
     }
-    DotFountain_Point* cur_point = this->points[0];
-    for (generation = 0; generation < NUM_ROT_HEIGHT; generation++) {
-        for (int angular_pos = 0; angular_pos < NUM_ROT_DIV; angular_pos++) {
-            float x, y, z;
-            matrixApply(transform,
-                        cur_point->ax * cur_point->radius,
-                        cur_point->height,
-                        cur_point->ay * cur_point->radius,
-                        &x,
-                        &y,
-                        &z);
-            z = zoom / z;
-            if (z > 0.0000001) {
-                int screen_x = (int)(x * z) + w / 2;
-                int screen_y = (int)(y * z) + h / 2;
-                if (screen_y >= 0 && screen_y < h && screen_x >= 0 && screen_x < w) {
-                    auto dest = (uint32_t*)framebuffer + screen_y * w + screen_x;
-                    blend_default_1px(&cur_point->color, dest, dest);
-                }
+    const int num_points = NUM_ROT_HEIGHT * NUM_ROT_DIV;
+    const float* radius = p.radius[0];
+    const float* ax = p.ax[0];
+    const float* ay = p.ay[0];
+    for (int i = 0; i < num_points; i++) {
+        this->point_x[i] = ax[i] * radius[i];
+        this->point_z[i] = ay[i] * radius[i];
+    }
+    memcpy(this->point_y, p.height[0], sizeof(this->point_y));
+    // The original dropped points with a scale of 1e-7 or less, compared as double.
+    // This is the largest float not greater than that.
+    const float min_scale = nextafterf(1e-7f, 0.0f);
+    matrixProject(transform,
+                  this->point_x,
+                  this->point_y,
+                  this->point_z,
+                  num_points,
+                  zoom,
+                  min_scale,
+                  w,
+                  h,
+                  this->point_offset);
+    line_blend_dispatch(g_line_blend_mode, [&](const auto& blend) {
+        auto fb = (uint32_t*)framebuffer;
+        const pixel_rgb0_8* color = p.color[0];
+        for (int i = 0; i < num_points; i++) {
+            if (this->point_offset[i] >= 0) {
+                blend.px(color[i], &fb[this->point_offset[i]]);
             }
-            cur_point++;
         }
-    }
+    });
     this->config.rotation += (float)this->config.rotation_speed / 5.0f;
     if (this->config.rotation >= 360.0f) {
         this->config.rotation -= 360.0f;
@@ -36,6 +36,8 @@ struct DotFountain_Info : public Effect_Info {
     static constexpr char const* help = "";
     static constexpr int32_t legacy_id = 19;
     static constexpr char const* legacy_ape_id = nullptr;
+    static constexpr uint32_t audio_dependencies =
+        AUDIO_DEPENDS_OSC | AUDIO_DEPENDS_BEAT;
 
     static void init_color_map(Effect*, const Parameter*, const std::vector<int64_t>&);
     static void init_color_map_list(Effect*,
@@ -75,14 +77,16 @@ struct DotFountain_Info : public Effect_Info {
     EFFECT_INFO_GETTERS;
 };
 
-struct DotFountain_Point {
-    float radius;
-    float delta_radius;
-    float height;
-    float delta_height;
-    float ax;
-    float ay;
-    pixel_rgb0_8 color;
+// The fountain's points, a ring of NUM_ROT_DIV points per generation, with each
+// property in its own array for batched processing.
+struct DotFountain_Points {
+    float radius[NUM_ROT_HEIGHT][NUM_ROT_DIV];
+    float delta_radius[NUM_ROT_HEIGHT][NUM_ROT_DIV];
+    float height[NUM_ROT_HEIGHT][NUM_ROT_DIV];
+    float delta_height[NUM_ROT_HEIGHT][NUM_ROT_DIV];
+    float ax[NUM_ROT_HEIGHT][NUM_ROT_DIV];
+    float ay[NUM_ROT_HEIGHT][NUM_ROT_DIV];
+    pixel_rgb0_8 color[NUM_ROT_HEIGHT][NUM_ROT_DIV];
 };
 
 class E_DotFountain : public Configurable_Effect<DotFountain_Info, DotFountain_Config> {
@@ -101,6 +105,11 @@ class E_DotFountain : public Configurable_Effect<DotFountain_Info, DotFountain_C
     void init_color_map();
 
    private:
-    DotFountain_Point points[NUM_ROT_HEIGHT][NUM_ROT_DIV];
+    DotFountain_Points points;
     pixel_rgb0_8 color_map[COLOR_MAP_SIZE];
+    // Cartesian coordinates of the points, and their framebuffer offsets.
+    float point_x[NUM_ROT_HEIGHT * NUM_ROT_DIV];
+    float point_y[NUM_ROT_HEIGHT * NUM_ROT_DIV];
+    float point_z[NUM_ROT_HEIGHT * NUM_ROT_DIV];
+    int32_t point_offset[NUM_ROT_HEIGHT * NUM_ROT_DIV];
 };
@@ -33,6 +33,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "e_dotgrid.h"
 
 #include "blend.h"
+#include "effect_common.h"
 #include "pixel_format.h"
 
 #include <cstdint>
@@ -118,27 +119,21 @@ int E_DotGrid::render(char[2][2][576],
 
     int32_t sy = (yp >> 8) % (int32_t)this->config.spacing;
     int32_t sx = (xp >> 8) % (int32_t)this->config.spacing;
-    auto dest = (uint32_t*)framebuffer;
-    dest += sy * w;
-    for (y = sy; y < h; y += (int32_t)this->config.spacing) {
-        if (this->config.blend_mode == DOTGRID_BLEND_ADDITIVE) {
+    auto draw = [&](const auto& blend) {
+        auto dest = (uint32_t*)framebuffer + sy * w;
+        for (y = sy; y < h; y += (int32_t)this->config.spacing) {
             for (x = sx; x < w; x += (int32_t)this->config.spacing) {
-                blend_add_1px(&current_color, &dest[x], &dest[x]);
-            }
-        } else if (this->config.blend_mode == DOTGRID_BLEND_5050) {
-            for (x = sx; x < w; x += (int32_t)this->config.spacing) {
-                blend_5050_1px(&current_color, &dest[x], &dest[x]);
-            }
-        } else if (this->config.blend_mode == DOTGRID_BLEND_DEFAULT) {
-            for (x = sx; x < w; x += (int32_t)this->config.spacing) {
-                blend_default_1px(&current_color, &dest[x], &dest[x]);
-            }
-        } else {  // DOTGRID_BLEND_REPLACE
-            for (x = sx; x < w; x += (int32_t)this->config.spacing) {
-                blend_replace_1px(&current_color, &dest[x]);
+                blend.px(current_color, &dest[x]);
             }
+            dest += w * this->config.spacing;
         }
-        dest += w * this->config.spacing;
+    };
+    switch (this->config.blend_mode) {
+        case DOTGRID_BLEND_ADDITIVE: draw(Line_Blend<BLEND_ADDITIVE>(0)); break;
+        case DOTGRID_BLEND_5050: draw(Line_Blend<BLEND_5050>(0)); break;
+        case DOTGRID_BLEND_DEFAULT: line_blend_dispatch(g_line_blend_mode, draw); break;
+        default:
+        case DOTGRID_BLEND_REPLACE: draw(Line_Blend<BLEND_REPLACE>(0)); break;
     }
     xp += (int32_t)this->config.speed_x;
     yp += (int32_t)this->config.speed_y;
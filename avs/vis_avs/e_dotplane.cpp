@@ -157,6 +157,7 @@ int E_DotPlane::render(char visdata[2][2][576],
     if (zoom2 < zoom) {
         zoom = zoom2;
     }
+    int num_points = 0;
     for (y_pos = 0; y_pos < GRID_WIDTH; y_pos++) {
         int grid_start_pos =
             (this->config.rotation < 90.0 || this->config.rotation > 270.0)
@@ -175,21 +176,34 @@ int E_DotPlane::render(char visdata[2][2][576],
             color += GRID_WIDTH - 1;
             height += GRID_WIDTH - 1;
         }
-        for (x_pos = 0; x_pos < GRID_WIDTH; x_pos++) {
-            float x, y, z;
-            matrixApply(transform, cur_y, 64.0f - *height, cur_x, &x, &y, &z);
-            z = zoom / z;
-            int screen_x = (int)(x * z) + (w / 2);
-            int screen_y = (int)(y * z) + (h / 2);
-            if (screen_y >= 0 && screen_y < h && screen_x >= 0 && screen_x < w) {
-                auto dest = (uint32_t*)framebuffer + screen_y * w + screen_x;
-                blend_default_1px(color, dest, dest);
-            }
+        for (x_pos = 0; x_pos < GRID_WIDTH; x_pos++, num_points++) {
+            this->point_x[num_points] = cur_y;
+            this->point_y[num_points] = 64.0f - *height;
+            this->point_z[num_points] = cur_x;
+            this->point_color[num_points] = *color;
             cur_y += grid_step;
             color += direction;
             height += direction;
         }
     }
+    matrixProject(transform,
+                  this->point_x,
+                  this->point_y,
+                  this->point_z,
+                  num_points,
+                  zoom,
+                  -INFINITY,
+                  w,
+                  h,
+                  this->point_offset);
+    line_blend_dispatch(g_line_blend_mode, [&](const auto& blend) {
+        auto fb = (uint32_t*)framebuffer;
+        for (int i = 0; i < num_points; i++) {
+            if (this->point_offset[i] >= 0) {
+                blend.px(this->point_color[i], &fb[this->point_offset[i]]);
+            }
+        }
+    });
     this->config.rotation += (double)this->config.rotation_speed / 5.0f;
     if (this->config.rotation >= 360.0f) {
         this->config.rotation -= 360.0f;
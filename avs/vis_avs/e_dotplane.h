@@ -33,6 +33,7 @@ struct DotPlane_Info : public Effect_Info {
     static constexpr char const* help = "";
     static constexpr int32_t legacy_id = 1;
     static constexpr char const* legacy_ape_id = nullptr;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_SPEC;
 
     static void init_color_map(Effect*, const Parameter*, const std::vector<int64_t>&);
     static void init_color_map_list(Effect*,
@@ -91,4 +92,10 @@ class E_DotPlane : public Configurable_Effect<DotPlane_Info, DotPlane_Config> {
     float grid_height_delta[GRID_WIDTH * GRID_WIDTH];
     pixel_rgb0_8 grid_color[GRID_WIDTH * GRID_WIDTH];
     pixel_rgb0_8 color_map[COLOR_MAP_SIZE];
+    // The grid points of the current frame in drawing order, for batched projection.
+    float point_x[GRID_WIDTH * GRID_WIDTH];
+    float point_y[GRID_WIDTH * GRID_WIDTH];
+    float point_z[GRID_WIDTH * GRID_WIDTH];
+    pixel_rgb0_8 point_color[GRID_WIDTH * GRID_WIDTH];
+    int32_t point_offset[GRID_WIDTH * GRID_WIDTH];
 };
@@ -153,7 +153,7 @@ E_DynamicDistanceModifier::~E_DynamicDistanceModifier() {
     this->m_wmul = 0;
 }
 
-int E_DynamicDistanceModifier::render(char visdata[2][2][576],
+int E_DynamicDistanceModifier::render(char[2][2][576],
                                       int is_beat,
                                       int* framebuffer,
                                       int* fbout,
@@ -186,19 +186,19 @@ int E_DynamicDistanceModifier::render(char visdata[2][2][576],
     }
 
     if (this->need_init) {
-        this->code_init.exec(visdata);
+        this->code_init.exec();
         this->need_init = false;
     }
     this->init_variables(w, h, is_beat);
-    this->code_frame.exec(visdata);
+    this->code_frame.exec();
     if (is_beat) {
-        this->code_beat.exec(visdata);
+        this->code_beat.exec();
     }
     int x;
     if (this->code_point.is_valid()) {
         for (x = 0; x < imax_d - 32; x++) {
             *this->vars.d = x / (this->max_d - 1);
-            this->code_point.exec(visdata);
+            this->code_point.exec();
             this->m_tab[x] = (int)(*this->vars.d * 256.0 * this->max_d / (x + 1));
         }
         for (; x < imax_d; x++) {
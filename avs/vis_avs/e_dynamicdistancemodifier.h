@@ -38,6 +38,7 @@ struct DynamicDistanceModifier_Info : public Effect_Info {
     ;
     static constexpr int32_t legacy_id = 35;
     static constexpr char* legacy_ape_id = NULL;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static const char* const* blend_modes(int64_t* length_out) {
         *length_out = 2;
@@ -121,7 +121,7 @@ int E_DynamicMovement::smp_finish(char[2][2][576], int, int*, int*, int, int) {
 }
 
 int E_DynamicMovement::smp_begin(int max_threads,
-                                 char visdata[2][2][576],
+                                 char[2][2][576],
                                  int is_beat,
                                  int*,
                                  int*,
@@ -167,13 +167,13 @@ int E_DynamicMovement::smp_begin(int max_threads,
         return 0;
     }
     if (this->need_init) {
-        this->code_init.exec(visdata);
+        this->code_init.exec();
         this->need_init = false;
     }
     this->init_variables(w, h, is_beat);
-    this->code_frame.exec(visdata);
+    this->code_frame.exec();
     if (is_beat) {
-        this->code_beat.exec(visdata);
+        this->code_beat.exec();
     }
     int x;
     int y;
@@ -207,7 +207,7 @@ int E_DynamicMovement::smp_begin(int max_threads,
             *this->vars.d = sqrt(xd * xd + yd * yd) * divmax_d;
             *this->vars.r = atan2(yd, xd) + M_PI * 0.5;
 
-            this->code_point.exec(visdata);
+            this->code_point.exec();
 
             int tmp1, tmp2;
             if (this->coordinates == COORDS_POLAR) {
@@ -250,6 +250,36 @@ int E_DynamicMovement::smp_begin(int max_threads,
     return max_threads;
 }
 
+#define DMOVE_BILINEAR_BATCH_SIZE 64
+
+struct DMove_Bilinear_Batch {
+    int32_t offsets[DMOVE_BILINEAR_BATCH_SIZE];
+    uint8_t lerp_x[DMOVE_BILINEAR_BATCH_SIZE];
+    uint8_t lerp_y[DMOVE_BILINEAR_BATCH_SIZE];
+    uint32_t alpha[DMOVE_BILINEAR_BATCH_SIZE];
+    uint32_t pixels[DMOVE_BILINEAR_BATCH_SIZE];
+};
+
+static void dmove_bilinear_batch(DMove_Bilinear_Batch& batch,
+                                 const uint32_t* in,
+                                 int w,
+                                 bool blend,
+                                 uint32_t*& blendin,
+                                 uint32_t*& out,
+                                 int batch_size) {
+    if (!blend) {
+        blend_bilinear_2x2_gather(
+            in, w, batch.offsets, batch.lerp_x, batch.lerp_y, out, batch_size);
+        out += batch_size;
+        return;
+    }
+    blend_bilinear_2x2_gather(
+        in, w, batch.offsets, batch.lerp_x, batch.lerp_y, batch.pixels, batch_size);
+    for (int i = 0; i < batch_size; i++) {
+        blend_adjustable_1px(&batch.pixels[i], blendin++, out++, batch.alpha[i]);
+    }
+}
+
 void E_DynamicMovement::smp_render(int this_thread,
                                    int max_threads,
                                    char[2][2][576],
@@ -292,6 +322,7 @@ void E_DynamicMovement::smp_render(int this_thread,
     auto in = (uint32_t*)fbin;
     auto blendin = (uint32_t*)framebuffer;
     auto out = (uint32_t*)fbout;
+    DMove_Bilinear_Batch batch;
     int yseek = 1;
     int xc_dpos, yc_pos = 0, yc_dpos;
     xc_dpos = (w << 16) / (this->XRES - 1);
@@ -440,19 +471,26 @@ void E_DynamicMovement::smp_render(int this_thread,
 
 #endif
 
+// Bilinear filtering first collects a batch of source positions, and then filters
+// them all at once.
 #define LOOPS(DO)                                                                      \
-    if (this->blend && this->bilinear)                                                 \
-        DO(CHECK uint32_t src_bilinear = blend_bilinear_2x2(                           \
-               in + (xp >> 16) + (this->w_mul[yp >> 16]), w, xp, yp);                  \
-           blend_adjustable_1px(&src_bilinear, blendin++, out++, ap >> 16);            \
-           ap += d_a)                                                                  \
-    else if (this->blend)                                                              \
+    if (this->bilinear) {                                                              \
+        for (int remaining = seek; remaining > 0;) {                                   \
+            seek = min(remaining, DMOVE_BILINEAR_BATCH_SIZE);                          \
+            remaining -= seek;                                                         \
+            int batch_size = seek;                                                     \
+            int i = 0;                                                                 \
+            DO(CHECK batch.offsets[i] = (xp >> 16) + this->w_mul[yp >> 16];            \
+               batch.lerp_x[i] = (uint8_t)xp;                                          \
+               batch.lerp_y[i] = (uint8_t)yp;                                          \
+               batch.alpha[i++] = ap >> 16;                                            \
+               ap += d_a)                                                              \
+            dmove_bilinear_batch(batch, in, w, this->blend, blendin, out, batch_size); \
+        }                                                                              \
+    } else if (this->blend)                                                            \
         DO(CHECK blend_adjustable_1px(                                                 \
                &in[(xp >> 16) + (this->w_mul[yp >> 16])], blendin++, out++, ap >> 16); \
            ap += d_a)                                                                  \
-    else if (this->bilinear)                                                           \
-        DO(CHECK* out++ = blend_bilinear_2x2(                                          \
-               in + (xp >> 16) + (this->w_mul[yp >> 16]), w, xp, yp))                  \
     else                                                                               \
         DO(CHECK* out++ = in[(xp >> 16) + (this->w_mul[yp >> 16])])
 
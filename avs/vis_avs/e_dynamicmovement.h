@@ -40,6 +40,7 @@ struct DynamicMovement_Info : public Effect_Info {
         "Dynamic movement help goes here (send me some :)";
     static constexpr int32_t legacy_id = 43;
     static constexpr char* legacy_ape_id = NULL;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static constexpr int32_t num_examples = 8;
     static constexpr DynamicMovement_Example examples[num_examples] = {
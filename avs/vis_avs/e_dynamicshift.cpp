@@ -63,7 +63,7 @@ E_DynamicShift::E_DynamicShift(AVS_Instance* avs)
     : Programmable_Effect(avs), m_lastw(0), m_lasth(0) {}
 E_DynamicShift::~E_DynamicShift() {}
 
-int E_DynamicShift::render(char visdata[2][2][576],
+int E_DynamicShift::render(char[2][2][576],
                            int is_beat,
                            int* framebuffer,
                            int* fbout,
@@ -80,13 +80,13 @@ int E_DynamicShift::render(char visdata[2][2][576],
         *this->vars.x = 0;
         *this->vars.y = 0;
         *this->vars.alpha = 0.5;
-        this->code_init.exec(visdata);
+        this->code_init.exec();
         this->need_init = false;
     }
     this->init_variables(w, h, is_beat);
-    this->code_frame.exec(visdata);
+    this->code_frame.exec();
     if (is_beat) {
-        this->code_beat.exec(visdata);
+        this->code_beat.exec();
     }
 
     int doblend = this->config.blend_mode;
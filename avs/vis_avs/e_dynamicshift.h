@@ -28,6 +28,7 @@ struct DynamicShift_Info : public Effect_Info {
         "alpha = alpha value (0.0-1.0) for blend\r\n";
     static constexpr int32_t legacy_id = 42;
     static constexpr char* legacy_ape_id = NULL;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static const char* const* blend_modes(int64_t* length_out) {
         *length_out = 2;
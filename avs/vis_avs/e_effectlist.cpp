@@ -82,6 +82,17 @@ E_EffectList::E_EffectList(AVS_Instance* avs)
     this->enabled = true;
 }
 
+E_EffectList::E_EffectList(const E_EffectList& other)
+    : Programmable_Effect(other),
+      list_framebuffer(nullptr),
+      last_w(0),
+      last_h(0),
+      on_beat_frames_cooldown(other.on_beat_frames_cooldown) {}
+
+E_EffectList::~E_EffectList() {
+    this->avs->framebuffer_pool.release(this->list_framebuffer);
+}
+
 void E_EffectList::smp_cleanup_threads() {
     if (E_EffectList::smp.num_threads > 0) {
         if (E_EffectList::smp.quit_signal) {
@@ -131,10 +142,10 @@ int E_EffectList::render(char visdata[2][2][576],
                              this->config.input_blend_adjustable,
                              this->config.output_blend_adjustable);
         if (this->need_init) {
-            this->code_init.exec(visdata);
+            this->code_init.exec();
             this->need_init = false;
         }
-        this->code_frame.exec(visdata);
+        this->code_frame.exec();
 
         if (!is_preinit) {
             is_beat = *this->vars.beat > 0.1 || *this->vars.beat < -0.1;
@@ -161,9 +172,7 @@ int E_EffectList::render(char visdata[2][2][576],
         && this->config.output_blend_mode == LIST_BLEND_REPLACE) {
         int buffer_parity = 0;
         int line_blend_mode_save = g_line_blend_mode;
-        if (this->list_framebuffer) {
-            free(this->list_framebuffer);
-        }
+        this->avs->framebuffer_pool.release(this->list_framebuffer);
         this->list_framebuffer = nullptr;
         if (clear_this_frame && (this->config.input_blend_mode != 1)) {
             memset(framebuffer, 0, w * h * sizeof(int));
@@ -255,10 +264,10 @@ int E_EffectList::render(char visdata[2][2][576],
     }
 
     if (!enabled_this_frame) {
-        if (this->list_framebuffer) {
-            free(this->list_framebuffer);
-        }
-        this->list_framebuffer = NULL;
+        // The pool keeps the buffer, so lists that are only enabled on some frames
+        // don't allocate each time.
+        this->avs->framebuffer_pool.release(this->list_framebuffer);
+        this->list_framebuffer = nullptr;
         return 0;
     }
 
@@ -271,9 +280,10 @@ int E_EffectList::render(char visdata[2][2][576],
 
         int* newfb;
         if (!do_resize) {
-            newfb = (int*)calloc(w * h, sizeof(int));
+            newfb = (int*)this->avs->framebuffer_pool.acquire(w * h * sizeof(int));
         } else {
-            newfb = (int*)malloc(w * h * sizeof(int));
+            newfb = (int*)this->avs->framebuffer_pool.acquire(w * h * sizeof(int),
+                                                              false);
             if (newfb) {
                 int dxpos = (this->last_w << 16) / w;
                 int ypos = 0;
@@ -293,9 +303,7 @@ int E_EffectList::render(char visdata[2][2][576],
         // TODO [bug]: What happens here if newfb alloc failed?
         this->last_w = w;
         this->last_h = h;
-        if (this->list_framebuffer) {
-            free(this->list_framebuffer);
-        }
+        this->avs->framebuffer_pool.release(this->list_framebuffer);
         this->list_framebuffer = newfb;
     }
     if (clear_this_frame) {
@@ -375,8 +383,8 @@ int E_EffectList::render(char visdata[2][2][576],
             nt = child->smp_begin(nt,
                                   visdata,
                                   is_beat,
-                                  buffer_parity ? fbout : framebuffer,
-                                  buffer_parity ? framebuffer : fbout,
+                                  buffer_parity ? fbout : this->list_framebuffer,
+                                  buffer_parity ? this->list_framebuffer : fbout,
                                   w,
                                   h);
             if (!is_preinit && nt > 0) {
@@ -396,8 +404,8 @@ int E_EffectList::render(char visdata[2][2][576],
 
                 t = child->smp_finish(visdata,
                                       is_beat,
-                                      buffer_parity ? fbout : framebuffer,
-                                      buffer_parity ? framebuffer : fbout,
+                                      buffer_parity ? fbout : this->list_framebuffer,
+                                      buffer_parity ? this->list_framebuffer : fbout,
                                       w,
                                       h);
             }
@@ -568,10 +576,8 @@ bool E_EffectList::remove_render(int index, int del) {
 
 void E_EffectList::clear_renders() {
     this->children.clear();
-    if (this->list_framebuffer) {
-        free(this->list_framebuffer);
-    }
-    this->list_framebuffer = 0;
+    this->avs->framebuffer_pool.release(this->list_framebuffer);
+    this->list_framebuffer = nullptr;
 }
 
 // index=-1 for add
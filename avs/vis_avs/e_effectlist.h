@@ -39,6 +39,9 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 // size of extended data + 4 -- "cause we fucked up"
 #define EFFECTLIST_AVS281D_EXT_SIZE 36
 
+extern int config_smp;
+extern int config_smp_mt;
+
 enum EffectList_Blend_Modes {
     LIST_BLEND_IGNORE = 0,
     LIST_BLEND_REPLACE = 1,
@@ -89,6 +92,7 @@ struct EffectList_Info : public Effect_Info {
         "'w' and 'h' are set with the current width and height of the frame\r\n";
     static constexpr int32_t legacy_id = -2;
     static constexpr char const* legacy_ape_id = nullptr;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
     static constexpr char const* legacy_v28_ape_id = "AVS 2.8+ Effect List Config";
 
     static const char* const* blend_modes(int64_t* length_out) {
@@ -175,7 +179,9 @@ class E_EffectList
     : public Programmable_Effect<EffectList_Info, EffectList_Config, EffectList_Vars> {
    public:
     E_EffectList(AVS_Instance* avs);
-    virtual ~E_EffectList() = default;
+    // Copies don't share the list's framebuffer.
+    E_EffectList(const E_EffectList& other);
+    virtual ~E_EffectList();
     virtual int render(char visdata[2][2][576],
                        int is_beat,
                        int* framebuffer,
@@ -188,14 +194,14 @@ class E_EffectList
     int64_t get_num_renders() { return this->children.size(); }
 
     virtual bool can_multithread() { return true; }
-    void smp_render_list(int min_threads,
-                         Effect* component,
-                         char visdata[2][2][576],
-                         int is_beat,
-                         int* framebuffer,
-                         int* fbout,
-                         int w,
-                         int h);
+    static void smp_render_list(int min_threads,
+                                Effect* component,
+                                char visdata[2][2][576],
+                                int is_beat,
+                                int* framebuffer,
+                                int* fbout,
+                                int w,
+                                int h);
     static void smp_cleanup_threads();
 
     Effect* get_child(int index);
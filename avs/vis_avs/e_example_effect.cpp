@@ -98,6 +98,12 @@ struct Example_Info : public Effect_Info {
         "A simple render effect to showcase how to write effect classes";
     static constexpr int32_t legacy_id = -1;
     static constexpr char* legacy_ape_id = nullptr;
+    /* If the effect reads `visdata` or `is_beat` in `render()`, declare that here with
+     * `Audio_Dependency` flags, e.g. `AUDIO_DEPENDS_OSC | AUDIO_DEPENDS_BEAT`. Audio
+     * data that no effect in the preset declares isn't updated. This example doesn't
+     * use audio, so it could leave out this line.
+     */
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_NONE;
 
     /* `num_parameters` in Info must match the number of parameters defined in Config.
      * (To be precise, it must not be larger. If it's smaller, then the remaining config
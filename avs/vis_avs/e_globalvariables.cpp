@@ -66,25 +66,25 @@ E_GlobalVariables::~E_GlobalVariables() {
     }
 }
 
-int E_GlobalVariables::render(char visdata[2][2][576],
+int E_GlobalVariables::render(char[2][2][576],
                               int is_beat,
                               int*,
                               int*,
                               int w,
                               int h) {
     if (this->load_code_next_frame) {
-        this->exec_code_from_file(visdata);
+        this->exec_code_from_file();
         this->load_code_next_frame = false;
     }
     this->recompile_if_needed();
     if (this->need_init) {
-        this->code_init.exec(visdata);
+        this->code_init.exec();
         this->init_variables(w, h, is_beat & IS_BEAT_MASK, 5);
         this->need_init = false;
     }
-    this->code_frame.exec(visdata);
+    this->code_frame.exec();
     if (is_beat & IS_BEAT_MASK) {
-        this->code_beat.exec(visdata);
+        this->code_beat.exec();
     }
     if (this->config.load_time == GLOBALVARS_LOAD_FRAME
         || (this->config.load_time == GLOBALVARS_LOAD_CODE && *this->vars.load != 0.0)
@@ -114,7 +114,7 @@ void GlobalVariables_Vars::init(int w, int h, int is_beat, va_list) {
     *this->save = 0.0f;
 }
 
-void E_GlobalVariables::exec_code_from_file(char visdata[2][2][576]) {
+void E_GlobalVariables::exec_code_from_file() {
     FILE* file;
     size_t file_size;
     char* file_code;
@@ -136,7 +136,7 @@ void E_GlobalVariables::exec_code_from_file(char visdata[2][2][576]) {
     lock_lock(this->code_lock);
     file_code_handle = AVS_EEL_IF_Compile(this->avs, this->vm_context, file_code);
     if (file_code_handle) {
-        AVS_EEL_IF_Execute(this->avs, file_code_handle, visdata);
+        AVS_EEL_IF_Execute(file_code_handle);
     }
     NSEEL_code_free(file_code_handle);
     lock_unlock(this->code_lock);
@@ -70,6 +70,7 @@ struct GlobalVariables_Info : public Effect_Info {
         " folder too.";
     static constexpr int32_t legacy_id = -1;
     static constexpr char const* legacy_ape_id = "Jheriko: Global";
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static const char* const* load_times(int64_t* length_out) {
         *length_out = 4;
@@ -146,7 +147,7 @@ class E_GlobalVariables : public Programmable_Effect<GlobalVariables_Info,
     std::vector<int*> buf_ranges;
     static const int max_gmb_index;
 
-    void exec_code_from_file(char visdata[2][2][576]);
+    void exec_code_from_file();
     void save_ranges_to_file();
     static bool check_set_range(const std::string& input,
                                 std::vector<int*>& ranges,
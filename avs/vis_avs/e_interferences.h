@@ -27,6 +27,7 @@ struct Interferences_Info : public Effect_Info {
     static constexpr char const* help = "";
     static constexpr int32_t legacy_id = 41;
     static constexpr char* legacy_ape_id = NULL;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static void on_init_rotation(Effect*,
                                  const Parameter*,
@@ -21,6 +21,7 @@ struct Interleave_Info : public Effect_Info {
     static constexpr char const* help = "";
     static constexpr int32_t legacy_id = 23;
     static constexpr char* legacy_ape_id = NULL;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static void on_x_change(Effect*, const Parameter*, const std::vector<int64_t>&);
     static void on_y_change(Effect*, const Parameter*, const std::vector<int64_t>&);
@@ -18,6 +18,7 @@ struct Mirror_Info : public Effect_Info {
     static constexpr char const* help = "";
     static constexpr int32_t legacy_id = 26;
     static constexpr char const* legacy_ape_id = nullptr;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static void on_mode_change(Effect*, const Parameter*, const std::vector<int64_t>&);
     static void on_random_change(Effect*,
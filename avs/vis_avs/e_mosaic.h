@@ -18,6 +18,7 @@ struct Mosaic_Info : public Effect_Info {
     static constexpr char const* help = "";
     static constexpr int32_t legacy_id = 30;
     static constexpr char const* legacy_ape_id = nullptr;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static constexpr uint32_t num_parameters = 5;
     static constexpr Parameter parameters[num_parameters] = {
@@ -133,7 +133,7 @@ E_Movement::Transform::~Transform() {
 }
 
 void E_Movement::regenerate_transform_table(int effect,
-                                            char visdata[2][2][576],
+                                            char[2][2][576],
                                             int w,
                                             int h) {
     lock_lock(this->transform.lock);
@@ -296,7 +296,7 @@ void E_Movement::regenerate_transform_table(int effect,
                     *this->vars.d = sqrt(xd * xd + yd * yd) * i_max_d;
                     *this->vars.r = atan2(yd, xd) + M_PI * 0.5;
 
-                    this->code_init.exec(visdata);
+                    this->code_init.exec();
 
                     double tmp1, tmp2;
                     if (coords == COORDS_POLAR) {
@@ -412,6 +412,30 @@ int E_Movement::smp_begin(int max_threads,
     return max_threads;
 }
 
+// TODO [cleanup]: Why is this mask/limit needed? It seems arbitrary.
+#define OFFSET_MASK                  ((1 << 22) - 1)
+#define MOVEMENT_BILINEAR_BATCH_SIZE 64
+
+/**
+ * Unpack `n` (<= `MOVEMENT_BILINEAR_BATCH_SIZE`) transform table entries and bilinear-
+ * filter their source pixels all at once.
+ */
+static void movement_bilinear_batch(const uint32_t* src,
+                                    const uint32_t* trans,
+                                    uint32_t* dest,
+                                    int w,
+                                    int n) {
+    int32_t offsets[MOVEMENT_BILINEAR_BATCH_SIZE];
+    uint8_t lerp_x[MOVEMENT_BILINEAR_BATCH_SIZE];
+    uint8_t lerp_y[MOVEMENT_BILINEAR_BATCH_SIZE];
+    for (int i = 0; i < n; i++) {
+        offsets[i] = (int32_t)(trans[i] & OFFSET_MASK);
+        lerp_x[i] = (trans[i] >> 24) & (31 << 3);
+        lerp_y[i] = (trans[i] >> 19) & (31 << 3);
+    }
+    blend_bilinear_2x2_gather(src, w, offsets, lerp_x, lerp_y, dest, n);
+}
+
 void E_Movement::smp_render(int this_thread,
                             int max_threads,
                             char[2][2][576],
@@ -420,9 +444,6 @@ void E_Movement::smp_render(int this_thread,
                             int* fbout,
                             int w,
                             int h) {
-// TODO [cleanup]: Why is this mask/limit needed? It seems arbitrary.
-#define OFFSET_MASK ((1 << 22) - 1)
-
     int x;
 
     if (max_threads < 1) {
@@ -519,84 +540,23 @@ void E_Movement::smp_render(int this_thread,
         dest += skip_pix;
         trans += skip_pix;
         if (this->transform.bilinear && this->config.blend_mode == BLEND_SIMPLE_5050) {
-            while (x--) {
-                int offs = trans[0] & OFFSET_MASK;
-                auto src2 = blend_bilinear_2x2((uint32_t*)framebuffer + offs,
-                                               w,
-                                               ((trans[0] >> 24) & (31 << 3)),
-                                               ((trans[0] >> 19) & (31 << 3)));
-                blend_5050_1px(&src[0], &src2, &dest[0]);
-                offs = trans[1] & OFFSET_MASK;
-                src2 = blend_bilinear_2x2((uint32_t*)framebuffer + offs,
-                                          w,
-                                          ((trans[1] >> 24) & (31 << 3)),
-                                          ((trans[1] >> 19) & (31 << 3)));
-                blend_5050_1px(&src[1], &src2, &dest[1]);
-                offs = trans[2] & OFFSET_MASK;
-                src2 = blend_bilinear_2x2((uint32_t*)framebuffer + offs,
-                                          w,
-                                          ((trans[2] >> 24) & (31 << 3)),
-                                          ((trans[2] >> 19) & (31 << 3)));
-                blend_5050_1px(&src[2], &src2, &dest[2]);
-                offs = trans[3] & OFFSET_MASK;
-                src2 = blend_bilinear_2x2((uint32_t*)framebuffer + offs,
-                                          w,
-                                          ((trans[3] >> 24) & (31 << 3)),
-                                          ((trans[3] >> 19) & (31 << 3)));
-                blend_5050_1px(&src[3], &src2, &dest[3]);
-                src += 4;
-                dest += 4;
-                trans += 4;
-            }
-            x = (w * out_h) & 3;
-            while (x--) {
-                int offs = trans[0] & OFFSET_MASK;
-                auto src2 = blend_bilinear_2x2((uint32_t*)framebuffer + offs,
-                                               w,
-                                               ((trans[0] >> 24) & (31 << 3)),
-                                               ((trans[0] >> 19) & (31 << 3)));
-                blend_5050_1px(src, &src2, dest);
-                src++;
-                dest++;
-                trans++;
+            uint32_t src2[MOVEMENT_BILINEAR_BATCH_SIZE];
+            for (int n = w * out_h; n > 0; n -= MOVEMENT_BILINEAR_BATCH_SIZE) {
+                int batch = min(n, MOVEMENT_BILINEAR_BATCH_SIZE);
+                movement_bilinear_batch((uint32_t*)framebuffer, trans, src2, w, batch);
+                for (int i = 0; i < batch; i++) {
+                    blend_5050_1px(&src[i], &src2[i], &dest[i]);
+                }
+                src += batch;
+                dest += batch;
+                trans += batch;
             }
-#ifndef NO_MMX
-            _mm_empty();
-#endif
         } else if (this->transform.bilinear) {
-            while (x--) {
-                int offs = trans[0] & OFFSET_MASK;
-                dest[0] = blend_bilinear_2x2(&src[offs],
-                                             w,
-                                             ((trans[0] >> 24) & (31 << 3)),
-                                             ((trans[0] >> 19) & (31 << 3)));
-                offs = trans[1] & OFFSET_MASK;
-                dest[1] = blend_bilinear_2x2(&src[offs],
-                                             w,
-                                             ((trans[1] >> 24) & (31 << 3)),
-                                             ((trans[1] >> 19) & (31 << 3)));
-                offs = trans[2] & OFFSET_MASK;
-                dest[2] = blend_bilinear_2x2(&src[offs],
-                                             w,
-                                             ((trans[2] >> 24) & (31 << 3)),
-                                             ((trans[2] >> 19) & (31 << 3)));
-                offs = trans[3] & OFFSET_MASK;
-                dest[3] = blend_bilinear_2x2(&src[offs],
-                                             w,
-                                             ((trans[3] >> 24) & (31 << 3)),
-                                             ((trans[3] >> 19) & (31 << 3)));
-                dest += 4;
-                trans += 4;
-            }
-            x = (w * out_h) & 3;
-            while (x--) {
-                int offs = trans[0] & OFFSET_MASK;
-                dest[0] = blend_bilinear_2x2(&src[offs],
-                                             w,
-                                             ((trans[0] >> 24) & (31 << 3)),
-                                             ((trans[0] >> 19) & (31 << 3)));
-                dest++;
-                trans++;
+            for (int n = w * out_h; n > 0; n -= MOVEMENT_BILINEAR_BATCH_SIZE) {
+                int batch = min(n, MOVEMENT_BILINEAR_BATCH_SIZE);
+                movement_bilinear_batch((uint32_t*)framebuffer, trans, dest, w, batch);
+                dest += batch;
+                trans += batch;
             }
         } else if (this->config.blend_mode == BLEND_SIMPLE_5050) {
             auto src2 = (uint32_t*)framebuffer;
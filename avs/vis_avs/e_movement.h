@@ -44,6 +44,7 @@ struct Movement_Info : public Effect_Info {
         " (might be useful)\r\n";
     static constexpr int32_t legacy_id = 15;
     static constexpr char* legacy_ape_id = NULL;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static constexpr int32_t num_effects = 23;
     static constexpr Movement_Effect effects[num_effects] = {
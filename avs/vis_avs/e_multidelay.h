@@ -49,6 +49,7 @@ struct MultiDelay_Info : public Effect_Info {
     static constexpr char const* help = "";
     static constexpr int32_t legacy_id = -1;
     static constexpr char* legacy_ape_id = "Holden05: Multi Delay";
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static const char* const* modes(int64_t* length_out) {
         *length_out = 2;
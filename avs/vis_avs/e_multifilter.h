@@ -21,6 +21,7 @@ struct MultiFilter_Info : public Effect_Info {
     static constexpr char const* help = "";
     static constexpr int32_t legacy_id = -1;
     static constexpr char const* legacy_ape_id = "Jheriko : MULTIFILTER";
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static const char* const* effects(int64_t* length_out) {
         *length_out = 4;
@@ -16,6 +16,7 @@ struct OnBeatClear_Info : public Effect_Info {
     static constexpr char const* help = "";
     static constexpr int32_t legacy_id = 5;
     static constexpr char const* legacy_ape_id = nullptr;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static const char* const* blend_modes(int64_t* length_out) {
         *length_out = 2;
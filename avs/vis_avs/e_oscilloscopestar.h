@@ -25,6 +25,7 @@ struct OscilloscopeStar_Info : public Effect_Info {
     static constexpr char const* help = "";
     static constexpr int32_t legacy_id = 2;
     static constexpr char const* legacy_ape_id = nullptr;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_OSC;
 
     static constexpr uint32_t num_color_params = 1;
     static constexpr Parameter color_params[num_color_params] = {
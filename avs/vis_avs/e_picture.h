@@ -26,6 +26,7 @@ struct Picture_Info : public Effect_Info {
     static constexpr char const* help = "";
     static constexpr int32_t legacy_id = 34;
     static constexpr char const* legacy_ape_id = nullptr;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static const char* const* image_files(int64_t* length_out);
     static const char* const* fits(int64_t* length_out) {
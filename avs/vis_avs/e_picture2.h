@@ -44,6 +44,7 @@ struct Picture2_Info : public Effect_Info {
     static constexpr char const* help = "";
     static constexpr int32_t legacy_id = -1;
     static constexpr char const* legacy_ape_id = "Picture II";
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static const char* const* image_files(int64_t* length_out);
     static const char* const* blend_modes(int64_t* length_out) {
@@ -52,6 +52,11 @@ constexpr Parameter Ring_Info::parameters[];
 
 E_Ring::E_Ring(AVS_Instance* avs) : Configurable_Effect(avs), current_color_pos(0) {}
 
+uint32_t E_Ring::audio_dependencies() {
+    return this->config.audio_source == AUDIO_WAVEFORM ? AUDIO_DEPENDS_OSC
+                                                       : AUDIO_DEPENDS_SPEC;
+}
+
 int E_Ring::render(char visdata[2][2][576],
                    int is_beat,
                    int* framebuffer,
@@ -61,6 +61,7 @@ class E_Ring : public Configurable_Effect<Ring_Info, Ring_Config> {
     virtual void load_legacy(unsigned char* data, int len);
     virtual int save_legacy(unsigned char* data);
     virtual E_Ring* clone() { return new E_Ring(*this); }
+    virtual uint32_t audio_dependencies();
 
     uint32_t current_color_pos;
 };
@@ -1,4 +1,5 @@
 #include "e_root.h"
+#include "e_effectlist.h"
 #include "e_unknown.h"
 
 #include "effect_library.h"
@@ -88,8 +89,7 @@ void E_Root::render_with_context(RenderContext& ctx) {
     if (this->config.clear) {
         memset(ctx.framebuffers[0].data, 0, ctx.w * ctx.h * sizeof(pixel_rgb0_8));
     }
-    char visdata[2][2][576];
-    ctx.audio.to_legacy_visdata(visdata);
+    auto visdata = ctx.audio.visdata;
     for (auto& effect : this->children) {
         if (!effect->enabled) {
             continue;
@@ -104,7 +104,44 @@ void E_Root::render_with_context(RenderContext& ctx) {
             ctx.swap_framebuffers();
         }
     }
-    ctx.copy_secondary_to_output_framebuffer_if_needed();
+    if (ctx.needs_output_write()) {
+        this->write_output(ctx, visdata);
+    }
+}
+
+void E_Root::write_output(RenderContext& ctx, char visdata[2][2][576]) {
+    int num_threads = 1;
+    if (config_smp && config_smp_mt > 1 && ctx.h > 1) {
+        num_threads = config_smp_mt;
+        if (num_threads > MAX_SMP_THREADS) {
+            num_threads = MAX_SMP_THREADS;
+        }
+    }
+    if (num_threads < 2) {
+        ctx.write_output();
+        return;
+    }
+    this->output_ctx = &ctx;
+    E_EffectList::smp_render_list(num_threads,
+                                  this,
+                                  visdata,
+                                  ctx.audio.is_beat,
+                                  (int32_t*)ctx.framebuffers[0].data,
+                                  (int32_t*)ctx.framebuffers[1].data,
+                                  ctx.w,
+                                  ctx.h);
+    this->output_ctx = nullptr;
+}
+
+void E_Root::smp_render(int this_thread,
+                        int max_threads,
+                        char[2][2][576],
+                        int,
+                        int*,
+                        int*,
+                        int,
+                        int) {
+    this->output_ctx->write_output(this_thread, max_threads);
 }
 
 void E_Root::load_legacy(unsigned char* data, int len) {
@@ -111,6 +111,15 @@ class E_Root : public Configurable_Effect<Root_Info, Root_Config> {
                        int w,
                        int h);
     virtual void render_with_context(RenderContext& ctx);
+    // Writes the final frame to the output buffer in parallel, see `write_output()`.
+    virtual void smp_render(int this_thread,
+                            int max_threads,
+                            char visdata[2][2][576],
+                            int is_beat,
+                            int* framebuffer,
+                            int* fbout,
+                            int w,
+                            int h);
     virtual void load_legacy(unsigned char* data, int len);
     virtual int save_legacy(unsigned char* data);
     virtual E_Root* clone() { return new E_Root(*this); }
@@ -120,6 +129,9 @@ class E_Root : public Configurable_Effect<Root_Info, Root_Config> {
     void end_buffer_context();
 
    private:
+    void write_output(RenderContext& ctx, char visdata[2][2][576]);
+    RenderContext* output_ctx = nullptr;
+
     // these are our framebuffers (formerly nb_save)
     int buffers_w[NUM_GLOBAL_BUFFERS] = {};
     int buffers_h[NUM_GLOBAL_BUFFERS] = {};
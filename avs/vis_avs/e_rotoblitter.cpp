@@ -55,50 +55,46 @@ void RotoBlitter_Info::on_zoom_change(Effect* component,
     rotoblitter->current_zoom = rotoblitter->config.zoom;
 }
 
-E_RotoBlitter::E_RotoBlitter(AVS_Instance* avs) : Configurable_Effect(avs) {
+E_RotoBlitter::E_RotoBlitter(AVS_Instance* avs)
+    : Configurable_Effect(avs),
+      ds_dx(0),
+      dt_dx(0),
+      ds_dy(0),
+      dt_dy(0),
+      s_start(0),
+      t_start(0) {
     this->current_zoom = this->config.zoom;
     this->direction = 1;
     this->current_rotation = 1.0;
-    last_w = 0;
-    last_h = 0;
-    w_mul = nullptr;
 }
 
-E_RotoBlitter::~E_RotoBlitter() {
-    if (w_mul) {
-        free(w_mul);
-    }
-    w_mul = nullptr;
-    last_w = last_h = 0;
-}
+E_RotoBlitter::~E_RotoBlitter() {}
 
-int E_RotoBlitter::render(char[2][2][576],
+int E_RotoBlitter::render(char visdata[2][2][576],
                           int is_beat,
                           int* framebuffer,
                           int* fbout,
                           int w,
                           int h) {
-    if (last_w != w || last_h != h || !w_mul) {
-        int x;
-        if (w_mul) {
-            free(w_mul);
-        }
-        last_w = w;
-        last_h = h;
-        w_mul = (int*)malloc(sizeof(int) * h);
-        for (x = 0; x < h; x++) {
-            w_mul[x] = x * w;
-        }
+    this->smp_begin(1, visdata, is_beat, framebuffer, fbout, w, h);
+    if (is_beat & 0x80000000) {
+        return 0;
     }
+    this->smp_render(0, 1, visdata, is_beat, framebuffer, fbout, w, h);
+    return this->smp_finish(visdata, is_beat, framebuffer, fbout, w, h);
+}
 
+int E_RotoBlitter::smp_begin(int max_threads,
+                             char[2][2][576],
+                             int is_beat,
+                             int*,
+                             int*,
+                             int w,
+                             int h) {
     if (is_beat & 0x80000000) {
         return 0;
     }
 
-    auto dest = (unsigned int*)fbout;
-    auto src = (unsigned int*)framebuffer;
-    auto bdest = (unsigned int*)framebuffer;
-
     if (is_beat && this->config.on_beat_reverse_enable) {
         this->direction = -this->direction;
     }
@@ -137,82 +133,86 @@ int E_RotoBlitter::render(char[2][2][576],
 
     double theta = (double)this->config.rotate * this->current_rotation;
     double temp;
-    int ds_dx, dt_dx, ds_dy, dt_dy, s, t, sstart, tstart;
-    int x;
 
     temp = cos((theta)*M_PI / 180.0) * f_zoom;
-    ds_dx = (int)(temp * 65536.0);
-    dt_dy = (int)(temp * 65536.0);
+    this->ds_dx = (int)(temp * 65536.0);
+    this->dt_dy = (int)(temp * 65536.0);
     temp = sin((theta)*M_PI / 180.0) * f_zoom;
-    ds_dy = -(int)(temp * 65536.0);
-    dt_dx = (int)(temp * 65536.0);
-
-    s = sstart = -(((w - 1) / 2) * ds_dx + ((h - 1) / 2) * ds_dy)
-                 + (w - 1) * (32768 + (1 << 20));
-    t = tstart = -(((w - 1) / 2) * dt_dx + ((h - 1) / 2) * dt_dy)
-                 + (h - 1) * (32768 + (1 << 20));
-    int ds, dt;
-    ds = (w - 1) << 16;
-    dt = (h - 1) << 16;
-    int y = h;
-    if (ds_dx > -ds && ds_dx < ds && dt_dx > -dt && dt_dx < dt) {
-        while (y--) {
-            if (ds) {
-                s %= ds;
-            }
-            if (dt) {
-                t %= dt;
-            }
-            if (s < 0) {
-                s += ds;
-            }
-            if (t < 0) {
-                t += dt;
-            }
-            x = w;
+    this->ds_dy = -(int)(temp * 65536.0);
+    this->dt_dx = (int)(temp * 65536.0);
+
+    this->s_start = -(((w - 1) / 2) * this->ds_dx + ((h - 1) / 2) * this->ds_dy)
+                    + (w - 1) * (32768 + (1 << 20));
+    this->t_start = -(((w - 1) / 2) * this->dt_dx + ((h - 1) / 2) * this->dt_dy)
+                    + (h - 1) * (32768 + (1 << 20));
+    return max_threads;
+}
 
-#define DO_LOOP(Z)  \
-    while (x--) {   \
-        Z;          \
-        s += ds_dx; \
-        t += dt_dx; \
+void E_RotoBlitter::smp_render(int this_thread,
+                               int max_threads,
+                               char[2][2][576],
+                               int,
+                               int* framebuffer,
+                               int* fbout,
+                               int w,
+                               int h) {
+    int32_t ds = (w - 1) << 16;
+    int32_t dt = (h - 1) << 16;
+    if (this->ds_dx <= -ds || this->ds_dx >= ds || this->dt_dx <= -dt
+        || this->dt_dx >= dt) {
+        return;
     }
-#define DO_LOOPS(Z)                                          \
-    if (ds_dx <= 0 && dt_dx <= 0)                            \
-        DO_LOOP(if (t < 0) t += dt; if (s < 0) s += ds; Z)   \
-    else if (ds_dx <= 0)                                     \
-        DO_LOOP(if (t >= dt) t -= dt; if (s < 0) s += ds; Z) \
-    else if (dt_dx <= 0)                                     \
-        DO_LOOP(if (t < 0) t += dt; if (s >= ds) s -= ds; Z) \
-    else                                                     \
-        DO_LOOP(if (t >= dt) t -= dt; if (s >= ds) s -= ds; Z)
-
-            if (this->config.bilinear && this->config.blend_mode == BLEND_SIMPLE_5050) {
-                uint32_t src_bilinear;
-                DO_LOOPS(src_bilinear = blend_bilinear_2x2(
-                             &src[(s >> 16) + w_mul[t >> 16]], w, s, t);
-                         blend_5050_1px(&src_bilinear, bdest, dest);
-                         bdest++;
-                         dest++)
-            } else if (this->config.bilinear) {
-                DO_LOOPS(*dest++ = blend_bilinear_2x2(
-                             &src[(s >> 16) + w_mul[t >> 16]], w, s, t))
-            } else if (this->config.blend_mode == BLEND_SIMPLE_REPLACE) {
-                DO_LOOPS(*dest++ = src[(s >> 16) + w_mul[t >> 16]])
-            } else {
-                DO_LOOPS(blend_5050_1px(&src[(s >> 16) + w_mul[t >> 16]], bdest, dest);
-                         bdest++;
-                         dest++)
-            }
 
-            s = (sstart += ds_dy);
-            t = (tstart += dt_dy);
-        }
+    if (max_threads < 1) {
+        max_threads = 1;
+    }
+    int start_l = (this_thread * h) / max_threads;
+    int end_l;
+    if (this_thread >= max_threads - 1) {
+        end_l = h;
+    } else {
+        end_l = ((this_thread + 1) * h) / max_threads;
     }
 
-    return 1;
+    auto src = (uint32_t*)framebuffer;
+    for (int y = start_l; y < end_l; y++) {
+        // The start coordinates are accumulated (with overflow) from the top row, and
+        // then wrapped around the source image.
+        int32_t s = (int32_t)((uint32_t)this->s_start + (uint32_t)y * this->ds_dy);
+        int32_t t = (int32_t)((uint32_t)this->t_start + (uint32_t)y * this->dt_dy);
+        s %= ds;
+        t %= dt;
+        if (s < 0) {
+            s += ds;
+        }
+        if (t < 0) {
+            t += dt;
+        }
+        auto dest = (uint32_t*)&fbout[y * w];
+        blend_affine_row(src,
+                         w,
+                         s,
+                         t,
+                         this->ds_dx,
+                         this->dt_dx,
+                         ds,
+                         dt,
+                         this->config.bilinear,
+                         dest,
+                         w);
+        if (this->config.blend_mode == BLEND_SIMPLE_5050) {
+            auto bdest = &src[y * w];
+            int x = w & ~3;
+            blend_5050(dest, bdest, dest, x, 1);
+            for (; x < w; x++) {
+                blend_5050_1px(&dest[x], &bdest[x], &dest[x]);
+            }
+        }
+    }
 }
 
+int E_RotoBlitter::smp_finish(char[2][2][576], int, int*, int*, int, int) { return 1; }
+
 void E_RotoBlitter::load_legacy(unsigned char* data, int len) {
     int pos = 0;
     if (len - pos >= 4) {
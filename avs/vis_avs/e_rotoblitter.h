@@ -21,6 +21,7 @@ struct RotoBlitter_Info : public Effect_Info {
     static constexpr char const* help = "";
     static constexpr int32_t legacy_id = 9;
     static constexpr char* legacy_ape_id = NULL;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static const char* const* blend_modes(int64_t* length_out) {
         *length_out = 2;
@@ -74,12 +75,39 @@ class E_RotoBlitter : public Configurable_Effect<RotoBlitter_Info, RotoBlitter_C
     virtual int save_legacy(unsigned char* data);
     virtual E_RotoBlitter* clone() { return new E_RotoBlitter(*this); }
 
+    virtual bool can_multithread() { return true; }
+    virtual int smp_begin(int max_threads,
+                          char visdata[2][2][576],
+                          int is_beat,
+                          int* framebuffer,
+                          int* fbout,
+                          int w,
+                          int h);
+    virtual void smp_render(int this_thread,
+                            int max_threads,
+                            char visdata[2][2][576],
+                            int is_beat,
+                            int* framebuffer,
+                            int* fbout,
+                            int w,
+                            int h);
+    virtual int smp_finish(char visdata[2][2][576],
+                           int is_beat,
+                           int* framebuffer,
+                           int* fbout,
+                           int w,
+                           int h);
+
    private:
     int64_t current_zoom;
     int64_t direction;
     double current_rotation;
 
-    int last_w;
-    int last_h;
-    int* w_mul;
+    // The current frame's transform, in 16.16 fixed-point source coordinates.
+    int32_t ds_dx;
+    int32_t dt_dx;
+    int32_t ds_dy;
+    int32_t dt_dy;
+    int32_t s_start;
+    int32_t t_start;
 };
@@ -48,6 +48,11 @@ constexpr Parameter Simple_Info::color_params[];
 E_Simple::E_Simple(AVS_Instance* avs) : Configurable_Effect(avs) {}
 E_Simple::~E_Simple() {}
 
+uint32_t E_Simple::audio_dependencies() {
+    return this->config.audio_source == AUDIO_WAVEFORM ? AUDIO_DEPENDS_OSC
+                                                       : AUDIO_DEPENDS_SPEC;
+}
+
 int E_Simple::render(char visdata[2][2][576],
                      int is_beat,
                      int* framebuffer,
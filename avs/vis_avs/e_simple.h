@@ -63,6 +63,7 @@ class E_Simple : public Configurable_Effect<Simple_Info, Simple_Config> {
     virtual void load_legacy(unsigned char* data, int len);
     virtual int save_legacy(unsigned char* data);
     virtual E_Simple* clone() { return new E_Simple(*this); }
+    virtual uint32_t audio_dependencies();
 
     uint32_t color_pos;
 };
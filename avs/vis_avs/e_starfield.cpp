@@ -33,6 +33,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "blend.h"
 
+#include <immintrin.h>
+
 #define GET_INT() \
     (data[pos] | (data[pos + 1] << 8) | (data[pos + 2] << 16) | (data[pos + 3] << 24))
 
@@ -98,19 +100,19 @@ void E_Starfield::initialize_stars() {
         this->abs_stars = 4095;
     }
     for (int i = 0; i < this->abs_stars; i++) {
-        this->stars[i].x = (rand() % this->width) - this->x_off;
-        this->stars[i].y = (rand() % this->height) - this->y_off;
-        this->stars[i].z = (float)(rand() % 255);
-        this->stars[i].speed = (float)(rand() % 9 + 1) / 10;
+        this->stars.x[i] = (rand() % this->width) - this->x_off;
+        this->stars.y[i] = (rand() % this->height) - this->y_off;
+        this->stars.z[i] = (float)(rand() % 255);
+        this->stars.speed[i] = (float)(rand() % 9 + 1) / 10;
     }
 }
 
 void E_Starfield::set_cur_speed() { this->current_speed = this->config.speed; }
 
 void E_Starfield::create_star(int i) {
-    this->stars[i].x = (rand() % this->width) - this->x_off;
-    this->stars[i].y = (rand() % this->height) - this->y_off;
-    this->stars[i].z = (float)this->z_off;
+    this->stars.x[i] = (rand() % this->width) - this->x_off;
+    this->stars.y[i] = (rand() % this->height) - this->y_off;
+    this->stars.z[i] = (float)this->z_off;
 }
 
 // A very rough variant of the adjustable blend mode. Kept for pixel compatability.
@@ -125,6 +127,140 @@ static uint32_t inline blend_adjustable_rough(uint32_t a, uint32_t b, uint32_t v
     return ((a >> 4) & 0x0F0F0F) * (16 - v) + (((b >> 4) & 0x0F0F0F) * v);
 }
 
+// Stars at depth z are projected to (x * 128 / z, y * 128 / z), in integer math. The
+// SIMD versions divide in double, whose truncated quotients of 32-bit integers are
+// exact.
+static inline int32_t starfield_project_1px(int x,
+                                            int y,
+                                            float z,
+                                            int x_off,
+                                            int y_off,
+                                            int w,
+                                            int h) {
+    if ((int)z <= 0) {
+        return -1;
+    }
+    int nx = ((x << 7) / (int)z) + x_off;
+    int ny = ((y << 7) / (int)z) + y_off;
+    if ((nx > 0) && (nx < w) && (ny > 0) && (ny < h)) {
+        return ny * w + nx;
+    }
+    return -1;
+}
+
+#ifdef SIMD_MODE_X86_SSE
+static inline __m128i starfield_div_4x_x86v128(__m128i dividend, __m128i divisor) {
+    __m128d lo = _mm_div_pd(_mm_cvtepi32_pd(dividend), _mm_cvtepi32_pd(divisor));
+    __m128d hi = _mm_div_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(dividend, dividend)),
+                            _mm_cvtepi32_pd(_mm_unpackhi_epi64(divisor, divisor)));
+    return _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo), _mm_cvttpd_epi32(hi));
+}
+
+static inline void starfield_project_4px_x86v128(const int* x,
+                                                 const int* y,
+                                                 const float* z,
+                                                 int x_off,
+                                                 int y_off,
+                                                 int w,
+                                                 int h,
+                                                 int32_t* out) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i z_int = _mm_cvttps_epi32(_mm_loadu_ps(z));
+    __m128i visible = _mm_cmpgt_epi32(z_int, zero);
+    // Divide hidden stars by 1 instead of <= 0.
+    __m128i divisor = _mm_or_si128(_mm_and_si128(visible, z_int),
+                                   _mm_andnot_si128(visible, _mm_set1_epi32(1)));
+    __m128i nx = starfield_div_4x_x86v128(
+        _mm_slli_epi32(_mm_loadu_si128((__m128i*)x), 7), divisor);
+    __m128i ny = starfield_div_4x_x86v128(
+        _mm_slli_epi32(_mm_loadu_si128((__m128i*)y), 7), divisor);
+    nx = _mm_add_epi32(nx, _mm_set1_epi32(x_off));
+    ny = _mm_add_epi32(ny, _mm_set1_epi32(y_off));
+    visible = _mm_and_si128(visible, _mm_cmpgt_epi32(nx, zero));
+    visible = _mm_and_si128(visible, _mm_cmpgt_epi32(_mm_set1_epi32(w), nx));
+    visible = _mm_and_si128(visible, _mm_cmpgt_epi32(ny, zero));
+    visible = _mm_and_si128(visible, _mm_cmpgt_epi32(_mm_set1_epi32(h), ny));
+    int32_t nx_4x[4];
+    int32_t ny_4x[4];
+    int32_t visible_4x[4];
+    _mm_storeu_si128((__m128i*)nx_4x, nx);
+    _mm_storeu_si128((__m128i*)ny_4x, ny);
+    _mm_storeu_si128((__m128i*)visible_4x, visible);
+    for (int i = 0; i < 4; i++) {
+        out[i] = visible_4x[i] ? ny_4x[i] * w + nx_4x[i] : -1;
+    }
+}
+#endif
+
+#ifdef __AVX2__
+static inline __m256i starfield_div_8x_x86v256(__m256i dividend, __m256i divisor) {
+    __m128i dividend_hi = _mm256_extracti128_si256(dividend, 1);
+    __m128i divisor_hi = _mm256_extracti128_si256(divisor, 1);
+    __m256d lo = _mm256_div_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(dividend)),
+                               _mm256_cvtepi32_pd(_mm256_castsi256_si128(divisor)));
+    __m256d hi = _mm256_div_pd(_mm256_cvtepi32_pd(dividend_hi),
+                               _mm256_cvtepi32_pd(divisor_hi));
+    return _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm256_cvttpd_epi32(lo)), _mm256_cvttpd_epi32(hi), 1);
+}
+
+static inline void starfield_project_8px_x86v256(const int* x,
+                                                 const int* y,
+                                                 const float* z,
+                                                 int x_off,
+                                                 int y_off,
+                                                 int w,
+                                                 int h,
+                                                 int32_t* out) {
+    __m256i zero = _mm256_setzero_si256();
+    __m256i z_int = _mm256_cvttps_epi32(_mm256_loadu_ps(z));
+    __m256i visible = _mm256_cmpgt_epi32(z_int, zero);
+    __m256i divisor = _mm256_blendv_epi8(_mm256_set1_epi32(1), z_int, visible);
+    __m256i nx = starfield_div_8x_x86v256(
+        _mm256_slli_epi32(_mm256_loadu_si256((__m256i*)x), 7), divisor);
+    __m256i ny = starfield_div_8x_x86v256(
+        _mm256_slli_epi32(_mm256_loadu_si256((__m256i*)y), 7), divisor);
+    nx = _mm256_add_epi32(nx, _mm256_set1_epi32(x_off));
+    ny = _mm256_add_epi32(ny, _mm256_set1_epi32(y_off));
+    __m256i w_8x = _mm256_set1_epi32(w);
+    visible = _mm256_and_si256(visible, _mm256_cmpgt_epi32(nx, zero));
+    visible = _mm256_and_si256(visible, _mm256_cmpgt_epi32(w_8x, nx));
+    visible = _mm256_and_si256(visible, _mm256_cmpgt_epi32(ny, zero));
+    visible = _mm256_and_si256(visible, _mm256_cmpgt_epi32(_mm256_set1_epi32(h), ny));
+    __m256i offset = _mm256_add_epi32(_mm256_mullo_epi32(ny, w_8x), nx);
+    offset = _mm256_blendv_epi8(_mm256_set1_epi32(-1), offset, visible);
+    _mm256_storeu_si256((__m256i*)out, offset);
+}
+#endif
+
+// Write each star's framebuffer offset to `out`, or -1 if it's not visible.
+static void starfield_project(const int* x,
+                              const int* y,
+                              const float* z,
+                              int n,
+                              int x_off,
+                              int y_off,
+                              int w,
+                              int h,
+                              int32_t* out) {
+    int i = 0;
+#ifdef __AVX2__
+    for (; i + 8 <= n; i += 8) {
+        starfield_project_8px_x86v256(
+            &x[i], &y[i], &z[i], x_off, y_off, w, h, &out[i]);
+    }
+#endif
+#ifdef SIMD_MODE_X86_SSE
+    for (; i + 4 <= n; i += 4) {
+        starfield_project_4px_x86v128(
+            &x[i], &y[i], &z[i], x_off, y_off, w, h, &out[i]);
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = starfield_project_1px(x[i], y[i], z[i], x_off, y_off, w, h);
+    }
+}
+
 int E_Starfield::render(char[2][2][576],
                         int is_beat,
                         int* framebuffer,
@@ -149,37 +285,38 @@ int E_Starfield::render(char[2][2][576],
         return 0;
     }
 
+    starfield_project(this->stars.x,
+                      this->stars.y,
+                      this->stars.z,
+                      this->abs_stars,
+                      this->x_off,
+                      this->y_off,
+                      w,
+                      h,
+                      this->star_offset);
     for (int i = 0; i < this->abs_stars; i++) {
-        if ((int)this->stars[i].z > 0) {
-            int nx = ((this->stars[i].x << 7) / (int)this->stars[i].z) + this->x_off;
-            int ny = ((this->stars[i].y << 7) / (int)this->stars[i].z) + this->y_off;
-            if ((nx > 0) && (nx < w) && (ny > 0) && (ny < h)) {
-                uint32_t brightness =
-                    (int)((255 - (int)this->stars[i].z) * this->stars[i].speed);
-                if (this->config.color != 0xFFFFFF) {
-                    brightness = blend_adjustable_rough(
-                        (brightness | (brightness << 8) | (brightness << 16)),
-                        this->config.color,
-                        brightness >> 4);
-                } else {
-                    brightness = (brightness | (brightness << 8) | (brightness << 16));
-                }
-                auto dest = (uint32_t*)&framebuffer[ny * w + nx];
-                switch (this->config.blend_mode) {
-                    case BLEND_SIMPLE_ADDITIVE:
-                        blend_add_1px(&brightness, dest, dest);
-                        break;
-                    case BLEND_SIMPLE_5050:
-                        blend_5050_1px(&brightness, dest, dest);
-                        break;
-                    default: framebuffer[ny * w + nx] = brightness; break;
-                }
-                this->stars[i].ox = nx;
-                this->stars[i].oy = ny;
-                this->stars[i].z -= this->stars[i].speed * this->current_speed;
+        if (this->star_offset[i] >= 0) {
+            uint32_t brightness =
+                (int)((255 - (int)this->stars.z[i]) * this->stars.speed[i]);
+            if (this->config.color != 0xFFFFFF) {
+                brightness = blend_adjustable_rough(
+                    (brightness | (brightness << 8) | (brightness << 16)),
+                    this->config.color,
+                    brightness >> 4);
             } else {
-                this->create_star(i);
+                brightness = (brightness | (brightness << 8) | (brightness << 16));
+            }
+            auto dest = (uint32_t*)&framebuffer[this->star_offset[i]];
+            switch (this->config.blend_mode) {
+                case BLEND_SIMPLE_ADDITIVE:
+                    blend_add_1px(&brightness, dest, dest);
+                    break;
+                case BLEND_SIMPLE_5050:
+                    blend_5050_1px(&brightness, dest, dest);
+                    break;
+                default: *dest = brightness; break;
             }
+            this->stars.z[i] -= this->stars.speed[i] * this->current_speed;
         } else {
             this->create_star(i);
         }
@@ -20,6 +20,7 @@ struct Starfield_Info : public Effect_Info {
     static constexpr char const* help = "";
     static constexpr int32_t legacy_id = 27;
     static constexpr char const* legacy_ape_id = nullptr;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static void initialize(Effect*, const Parameter*, const std::vector<int64_t>&);
     static void set_cur_speed(Effect*, const Parameter*, const std::vector<int64_t>&);
@@ -56,13 +57,14 @@ struct Starfield_Info : public Effect_Info {
     EFFECT_INFO_GETTERS;
 };
 
-struct StarField_Star {
-    int x = 0;
-    int y = 0;
-    float z = 0;
-    float speed = 0.0;
-    int ox = 0;
-    int oy = 0;
+#define STARFIELD_MAX_STARS 4096
+
+// The stars' positions and speeds, each in its own array for batched projection.
+struct StarField_Stars {
+    int x[STARFIELD_MAX_STARS] = {};
+    int y[STARFIELD_MAX_STARS] = {};
+    float z[STARFIELD_MAX_STARS] = {};
+    float speed[STARFIELD_MAX_STARS] = {};
 };
 
 class E_Starfield : public Configurable_Effect<Starfield_Info, Starfield_Config> {
@@ -95,5 +97,7 @@ class E_Starfield : public Configurable_Effect<Starfield_Info, Starfield_Config>
     double current_speed;
     float on_beat_speed_diff;
     int on_beat_cooldown;
-    StarField_Star stars[4096];
+    StarField_Stars stars;
+    // Each star's framebuffer offset in the current frame, or -1 if it's not visible.
+    int32_t star_offset[STARFIELD_MAX_STARS];
 };
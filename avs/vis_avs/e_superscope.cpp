@@ -33,6 +33,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "avs_eelif.h"
 #include "blend.h"
+#include "effect_common.h"
 #include "linedraw.h"
 
 #define PUT_INT(y)                   \
@@ -95,9 +96,31 @@ static inline int makeint(double t) {
 int E_SuperScope::render(char visdata[2][2][576],
                          int is_beat,
                          int* framebuffer,
-                         int*,
+                         int* fbout,
                          int w,
                          int h) {
+    if (this->smp_begin(1, visdata, is_beat, framebuffer, fbout, w, h) < 1) {
+        return 0;
+    }
+    this->smp_render(0, 1, visdata, is_beat, framebuffer, fbout, w, h);
+    return this->smp_finish(visdata, is_beat, framebuffer, fbout, w, h);
+}
+
+uint32_t E_SuperScope::audio_dependencies() {
+    uint32_t source = this->config.audio_source == AUDIO_WAVEFORM ? AUDIO_DEPENDS_OSC
+                                                                  : AUDIO_DEPENDS_SPEC;
+    return Programmable_Effect::audio_dependencies() | source;
+}
+
+int E_SuperScope::smp_finish(char[2][2][576], int, int*, int*, int, int) { return 0; }
+
+int E_SuperScope::smp_begin(int max_threads,
+                            char visdata[2][2][576],
+                            int is_beat,
+                            int*,
+                            int*,
+                            int w,
+                            int h) {
     if (this->recompile_if_needed()) {
         // Resetting "n" to 100 and running init again on every section's recompile is a
         // bit weird but replicates the original's behavior.
@@ -106,6 +129,7 @@ int E_SuperScope::render(char visdata[2][2][576],
         *this->vars.n = 100.0;
         this->need_init = true;
     }
+    this->segments.clear();
     if (is_beat & 0x80000000 || this->config.colors.empty()) {
         return 0;
     }
@@ -158,12 +182,12 @@ int E_SuperScope::render(char visdata[2][2][576],
     this->init_variables(
         w, h, is_beat, current_color, (uint32_t)this->config.draw_mode);
     if (this->need_init) {
-        this->code_init.exec(visdata);
+        this->code_init.exec();
         this->need_init = false;
     }
-    this->code_frame.exec(visdata);
+    this->code_frame.exec();
     if (is_beat) {
-        this->code_beat.exec(visdata);
+        this->code_beat.exec();
     }
     if (this->code_point.is_valid()) {
         bool is_first_point = true;
@@ -182,7 +206,7 @@ int E_SuperScope::render(char visdata[2][2][576],
             *this->vars.v = audio_value / 128.0 - 1.0;
             *this->vars.i = (double)i / (double)(num_lines - 1);
             *this->vars.skip = 0.0;
-            this->code_point.exec(visdata);
+            this->code_point.exec();
             int x = (*this->vars.x + 1.0) * w * 0.5;
             int y = (*this->vars.y + 1.0) * h * 0.5;
             if (*this->vars.skip < 0.00001) {
@@ -191,21 +215,15 @@ int E_SuperScope::render(char visdata[2][2][576],
                                      | (makeint(*this->vars.red) << 16);
                 if (*this->vars.drawmode < 0.00001) {
                     if (y >= 0 && y < h && x >= 0 && x < w) {
-                        uint32_t* dest = (uint32_t*)framebuffer + x + y * w;
-                        blend_default_1px(&thiscolor, dest, dest);
+                        this->segments.push_back({x, y, x, y, thiscolor, 0});
                     }
                 } else {
                     if (!is_first_point) {
                         if ((thiscolor & 0xffffff) || (g_line_blend_mode & 0xff) != 1) {
-                            line((uint32_t*)framebuffer,
-                                 lx,
-                                 ly,
-                                 x,
-                                 y,
-                                 w,
-                                 h,
-                                 thiscolor,
-                                 (int)(*this->vars.linesize + 0.5));
+                            // Same clamping as line() does.
+                            int lw = (int)(*this->vars.linesize + 0.5);
+                            lw = max(min(lw, 255), 1);
+                            this->segments.push_back({lx, ly, x, y, thiscolor, lw});
                         }
                     }  // is_first_point
                 }  // line
@@ -215,10 +233,66 @@ int E_SuperScope::render(char visdata[2][2][576],
             ly = y;
         }
     }
+    if (this->segments.empty()) {
+        return 0;
+    }
+
+    // Lines may draw up to their width around their vertical extent.
+    this->tiles.reset(h, SUPERSCOPE_TILE_HEIGHT);
+    for (uint32_t i = 0; i < this->segments.size(); i++) {
+        const SuperScope_Segment& segment = this->segments[i];
+        this->tiles.add(i,
+                        min(segment.y0, segment.y1) - (int64_t)segment.width,
+                        max(segment.y0, segment.y1) + (int64_t)segment.width);
+    }
+    this->tiles.finish();
+    this->line_blend_mode = g_line_blend_mode;
+    return max_threads;
+}
 
-    return 0;
+void E_SuperScope::smp_render(int this_thread,
+                              int max_threads,
+                              char[2][2][576],
+                              int,
+                              int* framebuffer,
+                              int*,
+                              int w,
+                              int h) {
+    int num_tiles = this->tiles.num_tiles();
+    int first_tile = this_thread * num_tiles / max_threads;
+    int end_tile = this_thread >= max_threads - 1
+                       ? num_tiles
+                       : (this_thread + 1) * num_tiles / max_threads;
+    auto fb = (uint32_t*)framebuffer;
+    line_blend_dispatch(this->line_blend_mode, [&](const auto& blend) {
+        for (int t = first_tile; t < end_tile; t++) {
+            int clip_top = this->tiles.tile_top(t);
+            int clip_bottom = this->tiles.tile_bottom(t);
+            const uint32_t* end = this->tiles.items_end(t);
+            for (const uint32_t* i = this->tiles.items_begin(t); i < end; i++) {
+                const SuperScope_Segment& segment = this->segments[*i];
+                if (segment.width == 0) {
+                    blend.px(segment.color, fb + segment.x0 + segment.y0 * w);
+                } else {
+                    line(blend,
+                         fb,
+                         segment.x0,
+                         segment.y0,
+                         segment.x1,
+                         segment.y1,
+                         w,
+                         h,
+                         segment.color,
+                         segment.width,
+                         clip_top,
+                         clip_bottom);
+                }
+            }
+        }
+    });
 }
 
+
 void SuperScope_Vars::register_(void* vm_context) {
     this->w = NSEEL_VM_regvar(vm_context, "w");
     this->n = NSEEL_VM_regvar(vm_context, "n");
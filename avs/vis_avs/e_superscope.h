@@ -3,10 +3,15 @@
 #include "effect.h"
 #include "effect_info.h"
 #include "effect_programmable.h"
+#include "tile_bins.h"
 
 #include "../platform.h"
 
 #include <string>
+#include <vector>
+
+// Height of the row strips segments are binned into for parallel rasterization.
+#define SUPERSCOPE_TILE_HEIGHT 16
 
 struct SuperScope_Color_Config : public Effect_Config {
     uint64_t color = 0x000000;
@@ -57,6 +62,7 @@ struct SuperScope_Info : public Effect_Info {
         " Anybody want to send me better text to put here? Please :)\r\n";
     static constexpr int32_t legacy_id = 36;
     static constexpr char* legacy_ape_id = NULL;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static constexpr int32_t num_examples = 14;
     static constexpr SuperScope_Example examples[num_examples] = {
@@ -347,6 +353,17 @@ struct SuperScope_Vars : public Variables {
     virtual void init(int, int, int, va_list);
 };
 
+// A dot or line, as generated by the point code. Drawn after all points have run.
+struct SuperScope_Segment {
+    int32_t x0;
+    int32_t y0;
+    int32_t x1;
+    int32_t y1;
+    uint32_t color;
+    // Line width, or 0 for a single dot at x0, y0.
+    int32_t width;
+};
+
 class E_SuperScope
     : public Programmable_Effect<SuperScope_Info, SuperScope_Config, SuperScope_Vars> {
    public:
@@ -361,6 +378,33 @@ class E_SuperScope
     virtual void load_legacy(unsigned char* data, int len);
     virtual int save_legacy(unsigned char* data);
     virtual E_SuperScope* clone() { return new E_SuperScope(*this); }
+    virtual uint32_t audio_dependencies();
+
+    virtual bool can_multithread() { return true; }
+    virtual int smp_begin(int max_threads,
+                          char visdata[2][2][576],
+                          int is_beat,
+                          int* framebuffer,
+                          int* fbout,
+                          int w,
+                          int h);
+    virtual void smp_render(int this_thread,
+                            int max_threads,
+                            char visdata[2][2][576],
+                            int is_beat,
+                            int* framebuffer,
+                            int* fbout,
+                            int w,
+                            int h);
+    virtual int smp_finish(char visdata[2][2][576],
+                           int is_beat,
+                           int* framebuffer,
+                           int* fbout,
+                           int w,
+                           int h);
 
     uint32_t color_pos;
+    std::vector<SuperScope_Segment> segments;
+    Tile_Bins tiles;
+    int32_t line_blend_mode;
 };
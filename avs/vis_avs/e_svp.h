@@ -18,6 +18,8 @@ struct SVP_Info : public Effect_Info {
     static constexpr char const* help = "";
     static constexpr int32_t legacy_id = 10;
     static constexpr char* legacy_ape_id = NULL;
+    static constexpr uint32_t audio_dependencies =
+        AUDIO_DEPENDS_OSC | AUDIO_DEPENDS_SPEC;
 
     static const char* const* library_files(int64_t* length_out);
 
@@ -1,5 +1,4 @@
 #include "e_texer2.h"
-#include "e_texer2_macros.h"
 
 #include "avs_eelif.h"
 #include "blend.h"
@@ -10,6 +9,7 @@
 
 #include "../util.h"
 
+#include <immintrin.h>
 #include <math.h>
 #include <stdio.h>
 
@@ -87,7 +87,10 @@ E_Texer2::E_Texer2(AVS_Instance* avs)
       image_flipped(NULL),
       image_mirrored(NULL),
       image_rot180(NULL),
-      image_lock(lock_init()) {
+      image_lock(lock_init()),
+      splat_resize(false),
+      splat_colorize(false),
+      line_blend_mode(0) {
     this->config.init.assign(this->info.examples[0].init);
     this->config.frame.assign(this->info.examples[0].frame);
     this->config.beat.assign(this->info.examples[0].beat);
@@ -220,8 +223,20 @@ struct RECTf {
     double bottom;
 };
 
-void E_Texer2::DrawParticle(int* framebuffer,
-                            pixel_rgb0_8* texture,
+static inline int RoundToInt(double x) {
+#ifdef SIMD_MODE_X86_SSE
+    // Rounds to nearest even, like the x87 default the original code relied on.
+    return _mm_cvtsd_si32(_mm_set_sd(x));
+#else
+    return (int)lrint(x);
+#endif
+}
+
+static inline int FloorToInt(double f) { return (int)f; }
+
+static inline double Fractional(double f) { return f - (int)f; }
+
+void E_Texer2::add_particle(const pixel_rgb0_8* texture,
                             int w,
                             int h,
                             double x,
@@ -232,19 +247,17 @@ void E_Texer2::DrawParticle(int* framebuffer,
     // Adjust width/height
     --w;
     --h;
-    --(this->iw);  // member vars, restore later!
-    --(this->ih);
+    int iw = this->iw - 1;
+    int ih = this->ih - 1;
 
     // Texture Coordinates
     double x0 = 0.0;
     double y0 = 0.0;
 
-    /***************************************************************************/
-    /***************************************************************************/
-    /*   Scaling renderer                                                      */
-    /***************************************************************************/
-    /***************************************************************************/
-    if (this->config.resize) {
+    Texer2_Splat splat;
+    splat.texture = texture;
+    splat.color = color;
+    if (this->splat_resize) {
         RECTf r;
         // Determine area rectangle,
         // correct with half pixel for correct pixel coverage
@@ -261,7 +274,7 @@ void E_Texer2::DrawParticle(int* framebuffer,
 
         // Visiblity culling
         if ((r2.right < 0.0f) || (r2.left > w) || (r2.bottom < 0.0f) || (r2.top > h)) {
-            goto skippart;
+            return;
         }
 
         // Subpixel adjustment for first texel
@@ -284,414 +297,48 @@ void E_Texer2::DrawParticle(int* framebuffer,
             r2.bottom = h;
         }
 
-        {
-            double fx0 = x0 * iw;
-            double fy0 = y0 * ih;
-
-            int cx0 = RoundToInt(fx0);
-            int cy0 = RoundToInt(fy0);
-
-            // fixed point fractional part of first coordinate
-            int dx = 65535 - FloorToInt((.5f - (fx0 - cx0)) * 65536.0);
-            int dy = 65535 - FloorToInt((.5f - (fy0 - cy0)) * 65536.0);
-
-            // 'texel per pixel' steps
-            double scx = (iw - 1) / (r.right - r.left + 1);
-            double scy = (ih - 1) / (r.bottom - r.top + 1);
-            int sdx = FloorToInt(scx * 65536.0);
-            int sdy = FloorToInt(scy * 65536.0);
-
-            // fixed point corrected coordinate
-            cx0 = (cx0 << 16) + dx;
-            cy0 = (cy0 << 16) + dy;
+        double fx0 = x0 * iw;
+        double fy0 = y0 * ih;
 
-            if (cx0 < 0) {
-                cx0 += sdx;
-                ++r2.left;
-            }
-            if (cy0 < 0) {
-                cy0 += sdy;
-                ++r2.top;
-            }
+        int cx0 = RoundToInt(fx0);
+        int cy0 = RoundToInt(fy0);
 
-            // Cull subpixel sized particles
-            if ((r2.right <= r2.left) || (r2.bottom <= r2.top)) {
-                goto skippart;
-            }
+        // fixed point fractional part of first coordinate
+        int dx = 65535 - FloorToInt((.5f - (fx0 - cx0)) * 65536.0);
+        int dy = 65535 - FloorToInt((.5f - (fy0 - cy0)) * 65536.0);
 
-            // Prepare filter color
-            T2_PREP_MASK_COLOR
-
-            switch (g_line_blend_mode & 0xFF) {
-                case BLEND_REPLACE: {
-                    int64_t mmxxor = 0x00FF00FF00FF00FF;
-                    int tot = r2.right - r2.left;
-                    int* outp = &framebuffer[r2.top * (w + 1) + r2.left];
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        T2_SCALE_BLEND_ASM_ENTER(t2_scale_loop_rep)
-#ifdef _MSC_VER
-                        __asm {
-                            psrlw mm0, 8
-                            packuswb mm0, mm0
-                        }
-#else  // GCC
-                        "psrlw     %%mm0, 8\n\t"
-                        "packuswb  %%mm0, %%mm0\n\t"
-#endif
-                        T2_SCALE_BLEND_ASM_LEAVE(t2_scale_loop_rep)
-                        cy0 += sdy;
-                        outp += w + 1;
-                    }
-                    break;
-                }
+        // 'texel per pixel' steps
+        double scx = (iw - 1) / (r.right - r.left + 1);
+        double scy = (ih - 1) / (r.bottom - r.top + 1);
+        int sdx = FloorToInt(scx * 65536.0);
+        int sdy = FloorToInt(scy * 65536.0);
 
-                case BLEND_ADDITIVE: {
-                    int64_t mmxxor = 0x00FF00FF00FF00FF;
-                    int tot = r2.right - r2.left;
-                    int* outp = &framebuffer[r2.top * (w + 1) + r2.left];
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        T2_SCALE_BLEND_ASM_ENTER(t2_scale_loop_add)
-#ifdef _MSC_VER
-                        __asm {
-                            psrlw mm0, 8
-                            packuswb mm0, mm0
-
-                                // save
-                            paddusb mm0, qword ptr [edi]
-                        }
-#else  // GCC
-                        "psrlw      %%mm0, 8\n\t"
-                        "packuswb   %%mm0, %%mm0\n\t"
-                        "paddusb    %%mm0, qword ptr [%%edi]\n\t"
-#endif
-                        T2_SCALE_BLEND_ASM_LEAVE(t2_scale_loop_add)
-                        cy0 += sdy;
-                        outp += w + 1;
-                    }
-                    break;
-                }
+        // fixed point corrected coordinate
+        cx0 = (int)((uint32_t)cx0 << 16) + dx;
+        cy0 = (int)((uint32_t)cy0 << 16) + dy;
 
-                case BLEND_MAXIMUM: {
-                    int signmask = 0x808080;
-                    T2_SCALE_MINMAX_SIGNMASK
-                    int64_t mmxxor = 0x00FF00FF00FF00FF;
-                    int tot = r2.right - r2.left;
-                    int* outp = &framebuffer[r2.top * (w + 1) + r2.left];
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        T2_SCALE_BLEND_ASM_ENTER(t2_scale_loop_max)
-#ifdef _MSC_VER
-                        __asm {
-                            // movd mm6, signmask;
-                            psrlw mm0, 8
-                            packuswb mm0, mm0
-
-                                // save
-                            movd mm1, dword ptr [edi]
-                            pxor mm0, mm6
-                            mov eax, 0xFFFFFF
-                            pxor mm1, mm6
-                            movd mm5, eax
-                            movq mm2, mm1
-                            pcmpgtb mm2, mm0
-                            movq mm3, mm2
-                            pxor mm3, mm5
-                            pxor mm5, mm5
-                            pand mm0, mm3
-                            pand mm1, mm2
-                            por mm0, mm1
-                            pxor mm0, mm6
-                        }
-#else  // GCC
-                        /*"movd      %%mm6, %[signmask]\n\t"*/
-                        "psrlw     %%mm0, 8\n\t"
-                        "packuswb  %%mm0, %%mm0\n\t"
-
-                        // save
-                        "movd      %%mm1, dword ptr [%%edi]\n\t"
-                        "pxor      %%mm0, %%mm6\n\t"
-                        "mov       %%eax, 0xFFFFFF\n\t"
-                        "pxor      %%mm1, %%mm6\n\t"
-                        "movd      %%mm5, %%eax\n\t"
-                        "movq      %%mm2, %%mm1\n\t"
-                        "pcmpgtb   %%mm2, %%mm0\n\t"
-                        "movq      %%mm3, %%mm2\n\t"
-                        "pxor      %%mm3, %%mm5\n\t"
-                        "pxor      %%mm5, %%mm5\n\t"
-                        "pand      %%mm0, %%mm3\n\t"
-                        "pand      %%mm1, %%mm2\n\t"
-                        "por       %%mm0, %%mm1\n\t"
-                        "pxor      %%mm0, %%mm6\n\t"
-#endif
-                        T2_SCALE_BLEND_ASM_LEAVE(t2_scale_loop_max)
-                        cy0 += sdy;
-                        outp += w + 1;
-                    }
-                    break;
-                }
-
-                case BLEND_5050: {
-                    int64_t mmxxor = 0x00FF00FF00FF00FF;
-                    int tot = r2.right - r2.left;
-                    int* outp = &framebuffer[r2.top * (w + 1) + r2.left];
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        T2_SCALE_BLEND_ASM_ENTER(t2_scale_loop_50)
-#ifdef _MSC_VER
-                        __asm {
-
-                            // save
-                            movd mm1, dword ptr [edi]
-                            psrlw mm0, 8
-                            punpcklbw mm1, mm5
-                            paddusw mm0, mm1
-                            psrlw mm0, 1
-                            packuswb mm0, mm0
-                        }
-#else  // GCC
-                        "movd       %%mm1, dword ptr [%%edi]\n\t"
-                        "psrlw      %%mm0, 8\n\t"
-                        "punpcklbw  %%mm1, %%mm5\n\t"
-                        "paddusw    %%mm0, %%mm1\n\t"
-                        "psrlw      %%mm0, 1\n\t"
-                        "packuswb   %%mm0, %%mm0\n\t"
-#endif
-                        T2_SCALE_BLEND_ASM_LEAVE(t2_scale_loop_50)
-                        cy0 += sdy;
-                        outp += w + 1;
-                    }
-                    break;
-                }
-
-                case BLEND_SUB1: {
-                    int64_t mmxxor = 0x00FF00FF00FF00FF;
-                    int tot = r2.right - r2.left;
-                    int* outp = &framebuffer[r2.top * (w + 1) + r2.left];
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        T2_SCALE_BLEND_ASM_ENTER(t2_scale_loop_sub1)
-#ifdef _MSC_VER
-                        __asm {
-                            psrlw mm0, 8
-                            packuswb mm0, mm0
-
-                                // save
-                            movd mm1, dword ptr [edi]
-                            psubusb mm1, mm0
-                            movq mm0, mm1
-                        }
-#else  // GCC
-                        "psrlw %%mm0, 8\n\t"
-                        "packuswb %%mm0, %%mm0\n\t"
-
-                        // save
-                        "movd %%mm1, dword ptr [%%edi]\n\t"
-                        "psubusb %%mm1, %%mm0\n\t"
-                        "movq %%mm0, %%mm1\n\t"
-#endif
-                        T2_SCALE_BLEND_ASM_LEAVE(t2_scale_loop_sub1)
-                        cy0 += sdy;
-                        outp += w + 1;
-                    }
-                    break;
-                }
-
-                case BLEND_SUB2: {
-                    int64_t mmxxor = 0x00FF00FF00FF00FF;
-                    int tot = r2.right - r2.left;
-                    int* outp = &framebuffer[r2.top * (w + 1) + r2.left];
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        T2_SCALE_BLEND_ASM_ENTER(t2_scale_loop_sub2)
-#ifdef _MSC_VER
-                        __asm {
-                            psrlw mm0, 8
-                            packuswb mm0, mm0
-
-                                // save
-                            psubusb mm0, qword ptr [edi]
-                        }
-#else  // GCC
-                        "psrlw %%mm0, 8\n\t"
-                        "packuswb %%mm0, %%mm0\n\t"
-
-                        // save
-                        "psubusb %%mm0, qword ptr [%%edi]\n\t"
-#endif
-                        T2_SCALE_BLEND_ASM_LEAVE(t2_scale_loop_sub2)
-                        cy0 += sdy;
-                        outp += w + 1;
-                    }
-                    break;
-                }
-
-                case BLEND_MULTIPLY: {
-                    int64_t mmxxor = 0x00FF00FF00FF00FF;
-                    int tot = r2.right - r2.left;
-                    int* outp = &framebuffer[r2.top * (w + 1) + r2.left];
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        T2_SCALE_BLEND_ASM_ENTER(t2_scale_loop_mul)
-#ifdef _MSC_VER
-                        __asm {
-                            psrlw mm0, 8
-
-                            // save
-                            movd mm1, dword ptr [edi]
-                            punpcklbw mm1, mm5
-                            pmullw mm1, mm0
-                            psrlw mm1, 8
-                            packuswb mm1, mm1
-                            movq mm0, mm1
-                        }
-#else  // GCC
-                        "psrlw %%mm0, 8\n\t"
-
-                        // save
-                        "movd %%mm1, dword ptr [%%edi]\n\t"
-                        "punpcklbw %%mm1, %%mm5\n\t"
-                        "pmullw %%mm1, %%mm0\n\t"
-                        "psrlw %%mm1, 8\n\t"
-                        "packuswb %%mm1, %%mm1\n\t"
-                        "movq %%mm0, %%mm1\n\t"
-#endif
-                        T2_SCALE_BLEND_ASM_LEAVE(t2_scale_loop_mul)
-                        cy0 += sdy;
-                        outp += w + 1;
-                    }
-                    break;
-                }
-
-                case BLEND_ADJUSTABLE: {
-                    int64_t alphavalue = 0x0;
-                    int64_t* alpha = &alphavalue;
-                    int t = (g_line_blend_mode & 0xFF00) >> 8;
-                    int64_t mmxxor = 0x00FF00FF00FF00FF;
-                    T2_SCALE_BLEND_AND_STORE_ALPHA
-                    int tot = r2.right - r2.left;
-                    int* outp = &framebuffer[r2.top * (w + 1) + r2.left];
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        T2_SCALE_BLEND_ASM_ENTER(t2_scale_loop_adj)
-#ifdef _MSC_VER
-                        __asm {
-                            psrlw mm0, 8
-
-                            // Merged filter/alpha
-                            // save
-                            movd mm1, dword ptr [edi]
-                            punpcklbw mm1, mm5
-                            pmullw mm1, mm6
-                            psrlw mm1, 8
-                            pmullw mm0, alpha
-                            psrlw mm0, 8
-                            paddusw mm0, mm1
-                            packuswb mm0, mm0
-                        }
-#else  // GCC
-                        "psrlw      %%mm0, 8\n\t"
-
-                        // Merged filter/alpha
-                        // save
-                        "movd       %%mm1, dword ptr [%%edi]\n\t"
-                        "punpcklbw  %%mm1, %%mm5\n\t"
-                        "pmullw     %%mm1, %%mm6\n\t"
-                        "psrlw      %%mm1, 8\n\t"
-                        "pmullw     %%mm0, qword ptr %[alpha]\n\t"
-                        "psrlw      %%mm0, 8\n\t"
-                        "paddusw    %%mm0, %%mm1\n\t"
-                        "packuswb   %%mm0, %%mm0\n\t"
-#endif
-                        T2_SCALE_BLEND_ASM_LEAVE(t2_scale_loop_adj, ASM_M_ARG(alpha))
-                        cy0 += sdy;
-                        outp += w + 1;
-                    }
-                    break;
-                }
-
-                case BLEND_XOR: {
-                    int64_t mmxxor = 0x00FF00FF00FF00FF;
-                    int tot = r2.right - r2.left;
-                    int* outp = &framebuffer[r2.top * (w + 1) + r2.left];
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        T2_SCALE_BLEND_ASM_ENTER(t2_scale_loop_xor)
-#ifdef _MSC_VER
-                        __asm {
-                            psrlw mm0, 8
-                            packuswb mm0, mm0
-                            pxor mm0, qword ptr [edi]
-                        }
-#else  // GCC
-                        "psrlw  %%mm0, 8\n\t"
-                        "packuswb %%mm0, %%mm0\n\t"
-                        "pxor   %%mm0, qword ptr [%%edi]\n\t"
-#endif
-                        T2_SCALE_BLEND_ASM_LEAVE(t2_scale_loop_xor)
-                        cy0 += sdy;
-                        outp += w + 1;
-                    }
-                    break;
-                }
+        if (cx0 < 0) {
+            cx0 += sdx;
+            ++r2.left;
+        }
+        if (cy0 < 0) {
+            cy0 += sdy;
+            ++r2.top;
+        }
 
-                case BLEND_MINIMUM: {
-                    int signmask = 0x808080;
-                    int64_t mmxxor = 0x00FF00FF00FF00FF;
-                    int tot = r2.right - r2.left;
-                    int* outp = &framebuffer[r2.top * (w + 1) + r2.left];
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        T2_SCALE_BLEND_ASM_ENTER(t2_scale_loop_min)
-#ifdef _MSC_VER
-                        __asm {
-                            movd mm6, signmask
-                            psrlw mm0, 8
-                            packuswb mm0, mm0
-
-                                // save
-                            movd mm1, dword ptr [edi]
-                            pxor mm0, mm6
-                            mov eax, 0xFFFFFF
-                            pxor mm1, mm6
-                            movd mm5, eax
-                            movq mm2, mm1
-                            pcmpgtb mm2, mm0
-                            movq mm3, mm2
-                            pxor mm3, mm5
-                            pxor mm5, mm5
-                            pand mm0, mm2
-                            pand mm1, mm3
-                            por mm0, mm1
-                            pxor mm0, mm6
-                        }
-#else  // GCC
-                        "movd      %%mm6, %[signmask]\n\t"
-                        "psrlw     %%mm0, 8\n\t"
-                        "packuswb  %%mm0, %%mm0\n\t"
-
-                        // save
-                        "movd      %%mm1, dword ptr [%%edi]\n\t"
-                        "pxor      %%mm0, %%mm6\n\t"
-                        "mov       %%eax, 0xFFFFFF\n\t"
-                        "pxor      %%mm1, %%mm6\n\t"
-                        "movd      %%mm5, %%eax\n\t"
-                        "movq      %%mm2, %%mm1\n\t"
-                        "pcmpgtb   %%mm2, %%mm0\n\t"
-                        "movq      %%mm3, %%mm2\n\t"
-                        "pxor      %%mm3, %%mm5\n\t"
-                        "pxor      %%mm5, %%mm5\n\t"
-                        "pand      %%mm0, %%mm2\n\t"
-                        "pand      %%mm1, %%mm3\n\t"
-                        "por       %%mm0, %%mm1\n\t"
-                        "pxor      %%mm0, %%mm6\n\t"
-#endif
-                        T2_SCALE_BLEND_ASM_LEAVE(t2_scale_loop_min, ASM_M_ARG(signmask))
-                        cy0 += sdy;
-                        outp += w + 1;
-                    }
-                    break;
-                }
-            }
+        // Cull subpixel sized particles
+        if ((r2.right <= r2.left) || (r2.bottom <= r2.top)) {
+            return;
         }
+        splat.left = r2.left;
+        splat.top = r2.top;
+        splat.right = r2.right;
+        splat.bottom = r2.bottom;
+        splat.tex_x = cx0;
+        splat.tex_y = cy0;
+        splat.step_x = sdx;
+        splat.step_y = sdy;
     } else {
-        /***************************************************************************/
-        /***************************************************************************/
-        /*   Non-scaling renderer                                                  */
-        /***************************************************************************/
-        /***************************************************************************/
-
         RECTi r;
         // Determine exact position, original size
         r.left = (RoundToInt((x * .5f + .5f) * w) - iw / 2);
@@ -699,12 +346,11 @@ void E_Texer2::DrawParticle(int* framebuffer,
         r.right = r.left + iw - 1;
         r.bottom = r.top + ih - 1;
 
-        RECTi r2;
-        memcpy(&r2, &r, sizeof(RECTi));
+        RECTi r2 = r;
 
         // Visiblity culling
         if ((r2.right < 0) || (r2.left > w) || (r2.bottom < 0) || (r2.top > h)) {
-            goto skippart;
+            return;
         }
 
         // Window edge clipping
@@ -724,832 +370,305 @@ void E_Texer2::DrawParticle(int* framebuffer,
         }
 
         if ((r2.right <= r2.left) || (r2.bottom <= r2.top)) {
-            goto skippart;
+            return;
         }
+        splat.left = r2.left;
+        splat.top = r2.top;
+        splat.right = r2.right;
+        splat.bottom = r2.bottom;
+        splat.tex_x = RoundToInt(x0 * iw);
+        splat.tex_y = RoundToInt(y0 * ih);
+        splat.step_x = 1;
+        splat.step_y = 1;
+    }
+    this->splats.push_back(splat);
+}
 
-        int cx0 = RoundToInt(x0 * iw);
-        int cy0 = RoundToInt(y0 * ih);
-
-        int ty = cy0;
-
-        if (this->config.colorize) {
-            // Second easiest path, masking, but no scaling
-            T2_PREP_MASK_COLOR
-            switch (g_line_blend_mode & 0xFF) {
-                case BLEND_REPLACE: {
-                    T2_NONSCALE_PUSH_ESI_EDI
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        int* outp = &framebuffer[y * (w + 1) + r2.left];
-                        pixel_rgb0_8* inp = &texture[ty * (iw + 1) + cx0];
-                        int tot = (r2.right - r2.left);
-                        T2_NONSCALE_BLEND_ASM_ENTER(t2_nonscale_mask_loop_rep)
-#ifdef _MSC_VER
-                        __asm {
-                            movd mm0, dword ptr [esi]
-
-                            punpcklbw mm0, mm5
-                            pmullw mm0, mm7
-                            psrlw mm0, 8
-                            packuswb mm0, mm0
-
-                            movd dword ptr [edi], mm0
-                        }
-#else  // GCC
-                        "movd       %%mm0, dword ptr [%%esi]\n\t"
-
-                            "punpcklbw  %%mm0, %%mm5\n\t"
-                            "pmullw     %%mm0, %%mm7\n\t"
-                            "psrlw      %%mm0, 8\n\t"
-                            "packuswb   %%mm0, %%mm0\n\t"
-
-                            "movd       dword ptr [%%edi], %%mm0\n\t"
-#endif
-                        T2_NONSCALE_BLEND_ASM_LEAVE(t2_nonscale_mask_loop_rep)
-                        ++ty;
-                    }
-                    T2_NONSCALE_POP_EDI_ESI
-                    break;
-                }
-
-                case BLEND_ADDITIVE: {
-                    T2_NONSCALE_PUSH_ESI_EDI
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        int* outp = &framebuffer[y * (w + 1) + r2.left];
-                        pixel_rgb0_8* inp = &texture[ty * (iw + 1) + cx0];
-                        int tot = (r2.right - r2.left);
-                        T2_NONSCALE_BLEND_ASM_ENTER(t2_nonscale_mask_loop_add)
-#ifdef _MSC_VER
-                        __asm {
-                            movd mm0, dword ptr [edi]
-                            movd mm1, dword ptr [esi]
-
-                            punpcklbw mm1, mm5
-                            pmullw mm1, mm7
-                            psrlw mm1, 8
-                            packuswb mm1, mm1
-
-                            paddusb mm0, mm1
-                            movd dword ptr [edi], mm0
-                        }
-#else  // GCC
-                        "movd       %%mm0, dword ptr [%%edi]\n\t"
-                            "movd       %%mm1, dword ptr [%%esi]\n\t"
-
-                            "punpcklbw  %%mm1, %%mm5\n\t"
-                            "pmullw     %%mm1, %%mm7\n\t"
-                            "psrlw      %%mm1, 8\n\t"
-                            "packuswb   %%mm1, %%mm1\n\t"
-
-                            "paddusb    %%mm0, %%mm1\n\t"
-                            "movd       dword ptr [%%edi], %%mm0\n\t"
-#endif
-                        T2_NONSCALE_BLEND_ASM_LEAVE(t2_nonscale_mask_loop_add)
-                        ++ty;
-                    }
-                    T2_NONSCALE_POP_EDI_ESI
-                    break;
-                }
-
-                case BLEND_MAXIMUM: {
-                    int maxmask = 0xFFFFFF;   // -> mm4
-                    int signmask = 0x808080;  // -> mm6
-                    T2_NONSCALE_PUSH_ESI_EDI
-                    T2_NONSCALE_MINMAX_MASKS
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        int* outp = &framebuffer[y * (w + 1) + r2.left];
-                        pixel_rgb0_8* inp = &texture[ty * (iw + 1) + cx0];
-                        int tot = (r2.right - r2.left);
-                        T2_NONSCALE_BLEND_ASM_ENTER(t2_nonscale_mask_loop_max)
-#ifdef _MSC_VER
-                        __asm {
-                            movd mm0, dword ptr [edi]
-                            movd mm1, dword ptr [esi]
-
-                            punpcklbw mm1, mm5
-                            pmullw mm1, mm7
-                            psrlw mm1, 8
-                            packuswb mm1, mm1
-
-                            pxor mm0, mm6
-                            pxor mm1, mm6
-                            movq mm2, mm1
-                            pcmpgtb mm2, mm0
-                            movq mm3, mm2
-                            pxor mm3, mm4
-                            pand mm0, mm3
-                            pand mm1, mm2
-                            por mm0, mm1
-                            pxor mm0, mm6
-                            movd dword ptr [edi], mm0
-                        }
-#else  // GCC
-                        "movd       %%mm0, dword ptr [%%edi]\n\t"
-                            "movd       %%mm1, dword ptr [%%esi]\n\t"
-
-                            "punpcklbw  %%mm1, %%mm5\n\t"
-                            "pmullw     %%mm1, %%mm7\n\t"
-                            "psrlw      %%mm1, 8\n\t"
-                            "packuswb   %%mm1, %%mm1\n\t"
-
-                            "pxor       %%mm0, %%mm6\n\t"
-                            "pxor       %%mm1, %%mm6\n\t"
-                            "movq       %%mm2, %%mm1\n\t"
-                            "pcmpgtb    %%mm2, %%mm0\n\t"
-                            "movq       %%mm3, %%mm2\n\t"
-                            "pxor       %%mm3, %%mm4\n\t"
-                            "pand       %%mm0, %%mm3\n\t"
-                            "pand       %%mm1, %%mm2\n\t"
-                            "por        %%mm0, %%mm1\n\t"
-                            "pxor       %%mm0, %%mm6\n\t"
-                            "movd       dword ptr [%%edi], %%mm0\n\t"
-#endif
-                        T2_NONSCALE_BLEND_ASM_LEAVE(t2_nonscale_mask_loop_max)
-                        ++ty;
-                    }
-                    T2_NONSCALE_POP_EDI_ESI
-                    break;
-                }
-
-                case BLEND_5050: {
-                    T2_NONSCALE_PUSH_ESI_EDI
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        int* outp = &framebuffer[y * (w + 1) + r2.left];
-                        pixel_rgb0_8* inp = &texture[ty * (iw + 1) + cx0];
-                        int tot = (r2.right - r2.left);
-                        T2_NONSCALE_BLEND_ASM_ENTER(t2_nonscale_mask_loop_50)
-#ifdef _MSC_VER
-                        __asm {
-                            movd mm0, dword ptr [edi]
-                            movd mm1, dword ptr [esi]
-
-                            punpcklbw mm1, mm5
-                            pmullw mm1, mm7
-                            psrlw mm1, 8
-                            packuswb mm1, mm1
-
-                            punpcklbw mm0, mm5
-                            punpcklbw mm1, mm5
-                            paddusw mm0, mm1
-                            psrlw mm0, 1
-                            packuswb mm0, mm0
-                            movd dword ptr [edi], mm0
-                        }
-#else  // GCC
-                        "movd       %%mm0, dword ptr [%%edi]\n\t"
-                            "movd       %%mm1, dword ptr [%%esi]\n\t"
-
-                            "punpcklbw  %%mm1, %%mm5\n\t"
-                            "pmullw     %%mm1, %%mm7\n\t"
-                            "psrlw      %%mm1, 8\n\t"
-                            "packuswb   %%mm1, %%mm1\n\t"
-
-                            "punpcklbw  %%mm0, %%mm5\n\t"
-                            "punpcklbw  %%mm1, %%mm5\n\t"
-                            "paddusw    %%mm0, %%mm1\n\t"
-                            "psrlw      %%mm0, 1\n\t"
-                            "packuswb   %%mm0, %%mm0\n\t"
-                            "movd       dword ptr [%%edi], %%mm0\n\t"
-#endif
-                        T2_NONSCALE_BLEND_ASM_LEAVE(t2_nonscale_mask_loop_50)
-                        ++ty;
-                    }
-                    T2_NONSCALE_POP_EDI_ESI
-                    break;
-                }
-
-                case BLEND_SUB1: {
-                    T2_NONSCALE_PUSH_ESI_EDI
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        int* outp = &framebuffer[y * (w + 1) + r2.left];
-                        pixel_rgb0_8* inp = &texture[ty * (iw + 1) + cx0];
-                        int tot = (r2.right - r2.left);
-                        T2_NONSCALE_BLEND_ASM_ENTER(t2_nonscale_mask_loop_sub1)
-#ifdef _MSC_VER
-                        __asm {
-                            movd mm0, dword ptr [edi]
-                            movd mm1, dword ptr [esi]
-
-                            punpcklbw mm1, mm5
-                            pmullw mm1, mm7
-                            psrlw mm1, 8
-                            packuswb mm1, mm1
-
-                            psubusb mm0, mm1
-                            movd dword ptr [edi], mm0
-                        }
-#else  // GCC
-                        "movd       %%mm0, dword ptr [%%edi]\n\t"
-                            "movd       %%mm1, dword ptr [%%esi]\n\t"
-
-                            "punpcklbw  %%mm1, %%mm5\n\t"
-                            "pmullw     %%mm1, %%mm7\n\t"
-                            "psrlw      %%mm1, 8\n\t"
-                            "packuswb   %%mm1, %%mm1\n\t"
-
-                            "psubusb    %%mm0, %%mm1\n\t"
-                            "movd       dword ptr [%%edi], %%mm0\n\t"
-#endif
-                        T2_NONSCALE_BLEND_ASM_LEAVE(t2_nonscale_mask_loop_sub1)
-                        ++ty;
-                    }
-                    T2_NONSCALE_POP_EDI_ESI
-                    break;
-                }
+/*
+Particles are colorized (multiplied with the particle color, which is white if
+colorizing is off) unless they are drawn at their original size and without
+colorizing, and then blended onto the framebuffer with the line blend mode. The three
+ways of drawing differ slightly in how they round the "multiply" and "adjustable" blend
+modes, as did the original code.
+*/
+enum Texer2_Source {
+    TEXER2_SOURCE_RESIZED = 0,  // bilinear-filtered and colorized
+    TEXER2_SOURCE_COLORIZED,    // original size and colorized
+    TEXER2_SOURCE_PLAIN,        // original size
+};
 
-                case BLEND_SUB2: {
-                    T2_NONSCALE_PUSH_ESI_EDI
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        int* outp = &framebuffer[y * (w + 1) + r2.left];
-                        pixel_rgb0_8* inp = &texture[ty * (iw + 1) + cx0];
-                        int tot = (r2.right - r2.left);
-                        T2_NONSCALE_BLEND_ASM_ENTER(t2_nonscale_mask_loop_sub2)
-#ifdef _MSC_VER
-                        __asm {
-                            movd mm0, dword ptr [esi]
-
-                            punpcklbw mm0, mm5
-                            pmullw mm0, mm7
-                            psrlw mm0, 8
-                            packuswb mm0, mm0
-
-                            psubusb mm0, qword ptr [edi]
-                            movd dword ptr [edi], mm0
-                        }
-#else  // GCC
-                        "movd       %%mm0, dword ptr [%%esi]\n\t"
-
-                            "punpcklbw  %%mm0, %%mm5\n\t"
-                            "pmullw     %%mm0, %%mm7\n\t"
-                            "psrlw      %%mm0, 8\n\t"
-                            "packuswb   %%mm0, %%mm0\n\t"
-
-                            "psubusb    %%mm0, qword ptr [%%edi]\n\t"
-                            "movd       dword ptr [%%edi], %%mm0\n\t"
-#endif
-                        T2_NONSCALE_BLEND_ASM_LEAVE(t2_nonscale_mask_loop_sub2)
-                        ++ty;
-                    }
-                    T2_NONSCALE_POP_EDI_ESI
-                    break;
+template <int blend_mode, int source>
+static inline uint32_t texer2_blend_px_c(uint32_t dest,
+                                         uint32_t texel,
+                                         uint32_t color,
+                                         uint32_t alpha) {
+    uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        uint32_t d = dest >> shift & 0xff;
+        uint32_t t = texel >> shift & 0xff;
+        uint32_t c = color >> shift & 0xff;
+        uint32_t s = source == TEXER2_SOURCE_PLAIN ? t : t * c >> 8;
+        uint32_t result;
+        switch (blend_mode) {
+            default:
+            case BLEND_REPLACE: result = s; break;
+            case BLEND_ADDITIVE: result = min(d + s, 255); break;
+            case BLEND_MAXIMUM: result = max(d, s); break;
+            case BLEND_5050: result = (d + s) >> 1; break;
+            case BLEND_SUB1: result = d > s ? d - s : 0; break;
+            case BLEND_SUB2: result = s > d ? s - d : 0; break;
+            case BLEND_MULTIPLY:
+                result = source == TEXER2_SOURCE_COLORIZED ? (d * t >> 8) * c >> 8
+                                                           : d * s >> 8;
+                break;
+            case BLEND_ADJUSTABLE:
+                if (source == TEXER2_SOURCE_RESIZED) {
+                    result = (d * (255 - alpha) >> 8) + (s * alpha >> 8);
+                } else {
+                    result = min(d * alpha + s * (256 - alpha), 0xffff) >> 8;
                 }
+                break;
+            case BLEND_XOR: result = d ^ s; break;
+            case BLEND_MINIMUM: result = min(d, s); break;
+        }
+        out |= result << shift;
+    }
+    return out;
+}
 
-                case BLEND_MULTIPLY: {
-                    T2_NONSCALE_PUSH_ESI_EDI
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        int* outp = &framebuffer[y * (w + 1) + r2.left];
-                        pixel_rgb0_8* inp = &texture[ty * (iw + 1) + cx0];
-                        int tot = (r2.right - r2.left);
-                        T2_NONSCALE_BLEND_ASM_ENTER(t2_nonscale_mask_loop_mul)
-#ifdef _MSC_VER
-                        __asm {
-                            movd mm0, dword ptr [edi]
-                            movd mm1, dword ptr [esi]
-
-                            punpcklbw mm0, mm5
-                            punpcklbw mm1, mm5
-                            pmullw mm0, mm1
-                            psrlw mm0, 8
-                            // Merged filter/mul
-                            pmullw mm0, mm7
-                            psrlw mm0, 8
-                            packuswb mm0, mm0
-                            movd dword ptr [edi], mm0
-                        }
-#else  // GCC
-                        "movd       %%mm0, dword ptr [%%edi]\n\t"
-                            "movd       %%mm1, dword ptr [%%esi]\n\t"
-                            "punpcklbw  %%mm0, %%mm5\n\t"
-                            "punpcklbw  %%mm1, %%mm5\n\t"
-                            "pmullw     %%mm0, %%mm1\n\t"
-                            "psrlw      %%mm0, 8\n\t"
-                            // Merged filter/mul
-                            "pmullw     %%mm0, %%mm7\n\t"
-                            "psrlw      %%mm0, 8\n\t"
-                            "packuswb   %%mm0, %%mm0\n\t"
-                            "movd       dword ptr [%%edi], %%mm0\n\t"
-#endif
-                        T2_NONSCALE_BLEND_ASM_LEAVE(t2_nonscale_mask_loop_mul)
-                        ++ty;
-                    }
-                    T2_NONSCALE_POP_EDI_ESI
-                    break;
-                }
+// Filter the 2x2 texels at `x` (16.16 fixed-point) in `row`, weighted by the 8-bit
+// fractional parts of `x` and of the row's coordinate, `lerp_y`.
+static inline uint32_t texer2_bilinear_c(const uint32_t* row,
+                                         uint32_t stride,
+                                         uint32_t x,
+                                         uint32_t lerp_y) {
+    const uint32_t* a = &row[x >> 16];
+    uint32_t lerp_x = x >> 8 & 0xff;
+    uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        uint32_t top = ((a[1] >> shift & 0xff) * lerp_x >> 8)
+                       + ((a[0] >> shift & 0xff) * (255 - lerp_x) >> 8);
+        uint32_t bottom = ((a[stride] >> shift & 0xff) * (255 - lerp_x) >> 8)
+                          + ((a[stride + 1] >> shift & 0xff) * lerp_x >> 8);
+        out |= ((bottom * lerp_y >> 8) + (top * (255 - lerp_y) >> 8)) << shift;
+    }
+    return out;
+}
 
-                case BLEND_ADJUSTABLE: {
-                    int64_t alphavalue = 0x0;
-                    int64_t* alpha = &alphavalue;
-                    // TODO [bugfix]: shouldn't salpha be 255, not 256?
-                    // it's used to calculate 256 - alpha, and if max_alpha = 255,
-                    // then...
-                    int64_t salpha = 0x0100010001000100;
-                    int t = (g_line_blend_mode & 0xFF00) >> 8;
-                    T2_NONSCALE_BLEND_AND_STORE_ALPHA
-                    T2_NONSCALE_PUSH_ESI_EDI
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        int* outp = &framebuffer[y * (w + 1) + r2.left];
-                        pixel_rgb0_8* inp = &texture[ty * (iw + 1) + cx0];
-                        int tot = (r2.right - r2.left);
-                        T2_NONSCALE_BLEND_ASM_ENTER(t2_nonscale_mask_loop_adj)
-#ifdef _MSC_VER
-                        __asm {
-                            movd mm0, dword ptr [edi]
-                            movd mm1, dword ptr [esi]
-
-                            punpcklbw mm0, mm5
-                            punpcklbw mm1, mm5
-                                // Merged filter/alpha
-                            pmullw    mm1, mm7
-                            psrlw     mm1, 8
-
-                            pmullw    mm0, mm6;  // * alph
-                            pmullw    mm1, mm3;  // * 256 - alph
-
-                            paddusw   mm0, mm1
-                            psrlw     mm0, 8
-                            packuswb  mm0, mm0
-                            movd dword ptr [edi], mm0
-                        }
-#else  // GCC
-                        "movd       %%mm0, dword ptr [%%edi]\n\t"
-                            "movd       %%mm1, dword ptr [%%esi]\n\t"
-
-                            "punpcklbw  %%mm0, %%mm5\n\t"
-                            "punpcklbw  %%mm1, %%mm5\n\t"
-                            // Merged filter/alpha
-                            "pmullw     %%mm1, %%mm7\n\t"
-                            "psrlw      %%mm1, 8\n\t"
-
-                            "pmullw     %%mm0, %%mm6\n\t" // * alpha
-                            "pmullw     %%mm1, %%mm3\n\t" // * 256 - alpha
-
-                            "paddusw    %%mm0, %%mm1\n\t"
-                            "psrlw      %%mm0, 8\n\t"
-                            "packuswb   %%mm0, %%mm0\n\t"
-                            "movd       dword ptr [%%edi], %%mm0\n\t"
-#endif
-                        T2_NONSCALE_BLEND_ASM_LEAVE(t2_nonscale_mask_loop_adj)
-                        ++ty;
-                    }
-                    T2_NONSCALE_POP_EDI_ESI
-                    break;
-                }
+// The texture row feeding framebuffer row `y` of `splat`, and for resized particles
+// the 8-bit vertical filter weight.
+static inline const uint32_t* texer2_tex_row(const Texer2_Splat& splat,
+                                             int source,
+                                             int stride,
+                                             int y,
+                                             uint32_t* lerp_y) {
+    uint32_t tex_y;
+    if (source == TEXER2_SOURCE_RESIZED) {
+        uint32_t cy = splat.tex_y + (uint32_t)(y - splat.top) * splat.step_y;
+        tex_y = cy >> 16;
+        *lerp_y = cy >> 8 & 0xff;
+    } else {
+        tex_y = splat.tex_y + (y - splat.top);
+        *lerp_y = 0;
+    }
+    return (const uint32_t*)splat.texture + tex_y * stride;
+}
 
-                case BLEND_XOR: {
-                    T2_NONSCALE_PUSH_ESI_EDI
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        int* outp = &framebuffer[y * (w + 1) + r2.left];
-                        pixel_rgb0_8* inp = &texture[ty * (iw + 1) + cx0];
-                        int tot = (r2.right - r2.left);
-                        T2_NONSCALE_BLEND_ASM_ENTER(t2_nonscale_mask_loop_xor)
-#ifdef _MSC_VER
-                        __asm {
-                            movd mm0, dword ptr [edi]
-                            movd mm1, dword ptr [esi]
-
-                            punpcklbw mm1, mm5
-                            pmullw mm1, mm7
-                            psrlw mm1, 8
-                            packuswb mm1, mm1
-
-                            pxor mm0, mm1
-                            movd dword ptr [edi], mm0
-                        }
-#else  // GCC
-                        "movd       %%mm0, dword ptr [%%edi]\n\t"
-                            "movd       %%mm1, dword ptr [%%esi]\n\t"
-
-                            "punpcklbw  %%mm1, %%mm5\n\t"
-                            "pmullw     %%mm1, %%mm7\n\t"
-                            "psrlw      %%mm1, 8\n\t"
-                            "packuswb   %%mm1, %%mm1\n\t"
-
-                            "pxor       %%mm0, %%mm1\n\t"
-                            "movd       dword ptr [%%edi], %%mm0\n\t"
-#endif
-                        T2_NONSCALE_BLEND_ASM_LEAVE(t2_nonscale_mask_loop_xor)
-                        ++ty;
-                    }
-                    T2_NONSCALE_POP_EDI_ESI
-                    break;
-                }
+template <int blend_mode, int source>
+static void texer2_draw_rows_c(const Texer2_Splat& splat,
+                               uint32_t* framebuffer,
+                               int w,
+                               int stride,
+                               int y_start,
+                               int y_end,
+                               uint32_t alpha) {
+    int count = splat.right - splat.left + 1;
+    for (int y = y_start; y < y_end; y++) {
+        uint32_t lerp_y;
+        const uint32_t* tex = texer2_tex_row(splat, source, stride, y, &lerp_y);
+        uint32_t* out = &framebuffer[y * w + splat.left];
+        uint32_t cx = splat.tex_x;
+        for (int i = 0; i < count; i++, cx += splat.step_x) {
+            uint32_t texel = source == TEXER2_SOURCE_RESIZED
+                                 ? texer2_bilinear_c(tex, stride, cx, lerp_y)
+                                 : tex[cx];
+            out[i] = texer2_blend_px_c<blend_mode, source>(
+                out[i], texel, splat.color, alpha);
+        }
+    }
+}
 
-                case BLEND_MINIMUM: {
-                    int maxmask = 0xFFFFFF;
-                    int signmask = 0x808080;
-                    T2_NONSCALE_PUSH_ESI_EDI
-                    T2_NONSCALE_MINMAX_MASKS
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        int* outp = &framebuffer[y * (w + 1) + r2.left];
-                        pixel_rgb0_8* inp = &texture[ty * (iw + 1) + cx0];
-                        int tot = (r2.right - r2.left);
-                        T2_NONSCALE_BLEND_ASM_ENTER(t2_nonscale_mask_loop_min)
-#ifdef _MSC_VER
-                        __asm {
-                            movd mm0, dword ptr [edi]
-                            movd mm1, dword ptr [esi]
-
-                            punpcklbw mm1, mm5
-                            pmullw mm1, mm7
-                            psrlw mm1, 8
-                            packuswb mm1, mm1
-
-                            pxor mm0, mm6
-                            pxor mm1, mm6
-                            movq mm2, mm1
-                            pcmpgtb mm2, mm0
-                            movq mm3, mm2
-                            pxor mm3, mm4
-                            pand mm0, mm2
-                            pand mm1, mm3
-                            por mm0, mm1
-                            pxor mm0, mm6
-                            movd dword ptr [edi], mm0
-                        }
-#else  // GCC
-                        "movd       %%mm0, dword ptr [%%edi]\n\t"
-                            "movd       %%mm1, dword ptr [%%esi]\n\t"
-
-                            "punpcklbw  %%mm1, %%mm5\n\t"
-                            "pmullw     %%mm1, %%mm7\n\t"
-                            "psrlw      %%mm1, 8\n\t"
-                            "packuswb   %%mm1, %%mm1\n\t"
-
-                            "pxor       %%mm0, %%mm6\n\t"
-                            "pxor       %%mm1, %%mm6\n\t"
-                            "movq       %%mm2, %%mm1\n\t"
-                            "pcmpgtb    %%mm2, %%mm0\n\t"
-                            "movq       %%mm3, %%mm2\n\t"
-                            "pxor       %%mm3, %%mm4\n\t"
-                            "pand       %%mm0, %%mm2\n\t"
-                            "pand       %%mm1, %%mm3\n\t"
-                            "por        %%mm0, %%mm1\n\t"
-                            "pxor       %%mm0, %%mm6\n\t"
-                            "movd       dword ptr [%%edi], %%mm0\n\t"
-#endif
-                        T2_NONSCALE_BLEND_ASM_LEAVE(t2_nonscale_mask_loop_min)
-                        ++ty;
-                    }
-                    T2_NONSCALE_POP_EDI_ESI
-                    break;
-                }
+#ifdef SIMD_MODE_X86_SSE
+template <int blend_mode, int source>
+static inline __m128i texer2_blend_4px_x86v128(__m128i dest,
+                                               __m128i texel,
+                                               __m128i color_16x8,
+                                               __m128i alpha_16x8) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i d_lo = _mm_unpacklo_epi8(dest, zero);
+    __m128i d_hi = _mm_unpackhi_epi8(dest, zero);
+    __m128i t_lo = _mm_unpacklo_epi8(texel, zero);
+    __m128i t_hi = _mm_unpackhi_epi8(texel, zero);
+    __m128i s_lo = t_lo;
+    __m128i s_hi = t_hi;
+    __m128i s = texel;
+    if (source != TEXER2_SOURCE_PLAIN) {
+        s_lo = _mm_srli_epi16(_mm_mullo_epi16(t_lo, color_16x8), 8);
+        s_hi = _mm_srli_epi16(_mm_mullo_epi16(t_hi, color_16x8), 8);
+        s = _mm_packus_epi16(s_lo, s_hi);
+    }
+    __m128i out_lo;
+    __m128i out_hi;
+    switch (blend_mode) {
+        default:
+        case BLEND_REPLACE: return s;
+        case BLEND_ADDITIVE: return _mm_adds_epu8(dest, s);
+        case BLEND_MAXIMUM: return _mm_max_epu8(dest, s);
+        case BLEND_5050:
+            out_lo = _mm_srli_epi16(_mm_add_epi16(d_lo, s_lo), 1);
+            out_hi = _mm_srli_epi16(_mm_add_epi16(d_hi, s_hi), 1);
+            return _mm_packus_epi16(out_lo, out_hi);
+        case BLEND_SUB1: return _mm_subs_epu8(dest, s);
+        case BLEND_SUB2: return _mm_subs_epu8(s, dest);
+        case BLEND_MULTIPLY:
+            if (source == TEXER2_SOURCE_COLORIZED) {
+                out_lo = _mm_srli_epi16(_mm_mullo_epi16(d_lo, t_lo), 8);
+                out_hi = _mm_srli_epi16(_mm_mullo_epi16(d_hi, t_hi), 8);
+                out_lo = _mm_srli_epi16(_mm_mullo_epi16(out_lo, color_16x8), 8);
+                out_hi = _mm_srli_epi16(_mm_mullo_epi16(out_hi, color_16x8), 8);
+            } else {
+                out_lo = _mm_srli_epi16(_mm_mullo_epi16(d_lo, s_lo), 8);
+                out_hi = _mm_srli_epi16(_mm_mullo_epi16(d_hi, s_hi), 8);
             }
-        } else {
-            // Most basic path, no scaling or masking
-            T2_ZERO_MM5
-            switch (g_line_blend_mode & 0xFF) {
-                case BLEND_REPLACE: {
-                    // the push order was reversed (edi, esi) in the original code here
-                    // (and only here) -- i assume that was not intentional...
-                    T2_NONSCALE_PUSH_ESI_EDI
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        int* outp = &framebuffer[y * (w + 1) + r2.left];
-                        pixel_rgb0_8* inp = &texture[ty * (iw + 1) + cx0];
-                        int tot = (r2.right - r2.left);
-                        T2_NONSCALE_BLEND_ASM_ENTER(t2_nonscale_nonmask_loop_rep)
-#ifdef _MSC_VER
-                        __asm {
-                            movd mm0, dword ptr [esi]
-                            movd dword ptr [edi], mm0
-                        }
-#else  // GCC
-                        "movd  %%mm0, dword ptr [%%esi]\n\t"
-                            "movd  dword ptr [%%edi], %%mm0\n\t"
-#endif
-                        T2_NONSCALE_BLEND_ASM_LEAVE(t2_nonscale_nonmask_loop_rep)
-                        ++ty;
-                    }
-                    T2_NONSCALE_POP_EDI_ESI
-                    break;
-                }
-
-                case BLEND_ADDITIVE: {
-                    T2_NONSCALE_PUSH_ESI_EDI
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        int* outp = &framebuffer[y * (w + 1) + r2.left];
-                        pixel_rgb0_8* inp = &texture[ty * (iw + 1) + cx0];
-                        int tot = (r2.right - r2.left);
-                        T2_NONSCALE_BLEND_ASM_ENTER(t2_nonscale_nonmask_loop_add)
-#ifdef _MSC_VER
-                        __asm {
-                            movd mm0, dword ptr [edi]
-                            paddusb mm0, qword ptr [esi]
-                            movd dword ptr [edi], mm0
-                        }
-#else  // GCC
-                        "movd     %%mm0, dword ptr [%%edi]\n\t"
-                            "paddusb  %%mm0, qword ptr [%%esi]\n\t"
-                            "movd     dword ptr [%%edi], %%mm0\n\t"
-#endif
-                        T2_NONSCALE_BLEND_ASM_LEAVE(t2_nonscale_nonmask_loop_add)
-                        ++ty;
-                    }
-                    T2_NONSCALE_POP_EDI_ESI
-                    break;
-                }
-
-                case BLEND_MAXIMUM: {
-                    int maxmask = 0xFFFFFF;
-                    int signmask = 0x808080;
-                    T2_NONSCALE_PUSH_ESI_EDI
-                    T2_NONSCALE_MINMAX_MASKS
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        int* outp = &framebuffer[y * (w + 1) + r2.left];
-                        pixel_rgb0_8* inp = &texture[ty * (iw + 1) + cx0];
-                        int tot = (r2.right - r2.left);
-                        T2_NONSCALE_BLEND_ASM_ENTER(t2_nonscale_nonmask_loop_max)
-#ifdef _MSC_VER
-                        __asm {
-                            movd mm0, dword ptr [edi]
-                            movd mm1, dword ptr [esi]
-                            pxor mm0, mm6
-                            pxor mm1, mm6
-                            movq mm2, mm1
-                            pcmpgtb mm2, mm0
-                            movq mm3, mm2
-                            pxor mm3, mm4
-                            pand mm0, mm3
-                            pand mm1, mm2
-                            por mm0, mm1
-                            pxor mm0, mm6
-                            movd dword ptr [edi], mm0
-                        }
-#else  // GCC
-                        "movd     %%mm0, dword ptr [%%edi]\n\t"
-                            "movd     %%mm1, dword ptr [%%esi]\n\t"
-                            "pxor     %%mm0, %%mm6\n\t"
-                            "pxor     %%mm1, %%mm6\n\t"
-                            "movq     %%mm2, %%mm1\n\t"
-                            "pcmpgtb  %%mm2, %%mm0\n\t"
-                            "movq     %%mm3, %%mm2\n\t"
-                            "pxor     %%mm3, %%mm4\n\t"
-                            "pand     %%mm0, %%mm3\n\t"
-                            "pand     %%mm1, %%mm2\n\t"
-                            "por      %%mm0, %%mm1\n\t"
-                            "pxor     %%mm0, %%mm6\n\t"
-                            "movd     dword ptr [%%edi], %%mm0\n\t"
-#endif
-                        T2_NONSCALE_BLEND_ASM_LEAVE(t2_nonscale_nonmask_loop_max)
-                        ++ty;
-                    }
-                    T2_NONSCALE_POP_EDI_ESI
-                    break;
-                }
-
-                case BLEND_5050: {
-                    T2_NONSCALE_PUSH_ESI_EDI
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        int* outp = &framebuffer[y * (w + 1) + r2.left];
-                        pixel_rgb0_8* inp = &texture[ty * (iw + 1) + cx0];
-                        int tot = (r2.right - r2.left);
-                        T2_NONSCALE_BLEND_ASM_ENTER(t2_nonscale_nonmask_loop_50)
-#ifdef _MSC_VER
-                        __asm {
-                            movd mm0, dword ptr [edi]
-                            movd mm1, dword ptr [esi]
-                            punpcklbw mm0, mm5
-                            punpcklbw mm1, mm5
-                            paddusw mm0, mm1
-                            psrlw mm0, 1
-                            packuswb mm0, mm0
-                            movd dword ptr [edi], mm0
-                        }
-#else  // GCC
-                        "movd       %%mm0, dword ptr [%%edi]\n\t"
-                            "movd       %%mm1, dword ptr [%%esi]\n\t"
-                            "punpcklbw  %%mm0, %%mm5\n\t"
-                            "punpcklbw  %%mm1, %%mm5\n\t"
-                            "paddusw    %%mm0, %%mm1\n\t"
-                            "psrlw      %%mm0, 1\n\t"
-                            "packuswb   %%mm0, %%mm0\n\t"
-                            "movd       dword ptr [%%edi], %%mm0\n\t"
-#endif
-                        T2_NONSCALE_BLEND_ASM_LEAVE(t2_nonscale_nonmask_loop_50)
-                        ++ty;
-                    }
-                    T2_NONSCALE_POP_EDI_ESI
-                    break;
-                }
-
-                case BLEND_SUB1: {
-                    T2_NONSCALE_PUSH_ESI_EDI
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        int* outp = &framebuffer[y * (w + 1) + r2.left];
-                        pixel_rgb0_8* inp = &texture[ty * (iw + 1) + cx0];
-                        int tot = (r2.right - r2.left);
-                        T2_NONSCALE_BLEND_ASM_ENTER(t2_nonscale_nonmask_loop_sub1)
-#ifdef _MSC_VER
-                        __asm {
-                            movd mm0, dword ptr [edi]
-                            psubusb mm0, qword ptr [esi]
-                            movd dword ptr [edi], mm0
-                        }
-#else  // GCC
-                        "movd     %%mm0, dword ptr [%%edi]\n\t"
-                            "psubusb  %%mm0, qword ptr [%%esi]\n\t"
-                            "movd     dword ptr [%%edi], %%mm0\n\t"
-#endif
-                        T2_NONSCALE_BLEND_ASM_LEAVE(t2_nonscale_nonmask_loop_sub1)
-                        ++ty;
-                    }
-                    T2_NONSCALE_POP_EDI_ESI
-                    break;
-                }
-
-                case BLEND_SUB2: {
-                    T2_NONSCALE_PUSH_ESI_EDI
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        int* outp = &framebuffer[y * (w + 1) + r2.left];
-                        pixel_rgb0_8* inp = &texture[ty * (iw + 1) + cx0];
-                        int tot = (r2.right - r2.left);
-                        T2_NONSCALE_BLEND_ASM_ENTER(t2_nonscale_nonmask_loop_sub2)
-#ifdef _MSC_VER
-                        __asm {
-                            movd mm0, dword ptr [esi]
-                            psubusb mm0, qword ptr [edi]
-                            movd dword ptr [edi], mm0
-                        }
-#else  // GCC
-                        "movd     %%mm0, dword ptr [%%esi]\n\t"
-                            "psubusb  %%mm0, qword ptr [%%edi]\n\t"
-                            "movd     dword ptr [%%edi], %%mm0\n\t"
-#endif
-                        T2_NONSCALE_BLEND_ASM_LEAVE(t2_nonscale_nonmask_loop_sub2)
-                        ++ty;
-                    }
-                    T2_NONSCALE_POP_EDI_ESI
-                    break;
-                }
-
-                case BLEND_MULTIPLY: {
-                    T2_NONSCALE_PUSH_ESI_EDI
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        int* outp = &framebuffer[y * (w + 1) + r2.left];
-                        pixel_rgb0_8* inp = &texture[ty * (iw + 1) + cx0];
-                        int tot = (r2.right - r2.left);
-                        T2_NONSCALE_BLEND_ASM_ENTER(t2_nonscale_nonmask_loop_mul)
-#ifdef _MSC_VER
-                        __asm {
-                            movd mm0, dword ptr [edi]
-                            movd mm1, dword ptr [esi]
-                            punpcklbw mm0, mm5
-                            punpcklbw mm1, mm5
-                            pmullw mm0, mm1
-                            psrlw mm0, 8
-                            packuswb mm0, mm0
-                            movd dword ptr [edi], mm0
-                        }
-#else  // GCC
-                        "movd       %%mm0, dword ptr [%%edi]\n\t"
-                            "movd       %%mm1, dword ptr [%%esi]\n\t"
-                            "punpcklbw  %%mm0, %%mm5\n\t"
-                            "punpcklbw  %%mm1, %%mm5\n\t"
-                            "pmullw     %%mm0, %%mm1\n\t"
-                            "psrlw      %%mm0, 8\n\t"
-                            "packuswb   %%mm0, %%mm0\n\t"
-                            "movd       dword ptr [%%edi], %%mm0\n\t"
-#endif
-                        T2_NONSCALE_BLEND_ASM_LEAVE(t2_nonscale_nonmask_loop_mul)
-                        ++ty;
-                    }
-                    T2_NONSCALE_POP_EDI_ESI
-                    break;
-                }
-
-                case BLEND_ADJUSTABLE: {
-                    int64_t alphavalue = 0x0;
-                    int64_t* alpha = &alphavalue;
-                    // TODO [bugfix]: shouldn't salpha be 255, not 256?
-                    // it's used to calculate 256 - alpha, and if max_alpha = 255,
-                    // then...
-                    int64_t salpha = 0x0100010001000100;
-                    int t = (g_line_blend_mode & 0xFF00) >> 8;
-                    T2_NONSCALE_BLEND_AND_STORE_ALPHA
-                    T2_NONSCALE_PUSH_ESI_EDI
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        int* outp = &framebuffer[y * (w + 1) + r2.left];
-                        pixel_rgb0_8* inp = &texture[ty * (iw + 1) + cx0];
-                        int tot = (r2.right - r2.left);
-                        T2_NONSCALE_BLEND_ASM_ENTER(t2_nonscale_nonmask_loop_adj)
-#ifdef _MSC_VER
-                        __asm {
-                            movd mm0, dword ptr [edi]
-                            movd mm1, dword ptr [esi]
-
-                            punpcklbw mm0, mm5
-                            punpcklbw mm1, mm5
-
-                            pmullw    mm0, mm6;  // * alph
-                            pmullw    mm1, mm3;  // * 256 - alph
-
-                            paddusw   mm0, mm1
-                            psrlw     mm0, 8
-                            packuswb  mm0, mm0
-                            movd dword ptr [edi], mm0
-                        }
-#else  // GCC
-                        "movd       %%mm0, dword ptr [%%edi]\n\t"
-                            "movd       %%mm1, dword ptr [%%esi]\n\t"
-
-                            "punpcklbw  %%mm0, %%mm5\n\t"
-                            "punpcklbw  %%mm1, %%mm5\n\t"
-
-                            "pmullw     %%mm0, %%mm6\n\t" // * alpha
-                            "pmullw     %%mm1, %%mm3\n\t" // * 256 - alpha
-
-                            "paddusw    %%mm0, %%mm1\n\t"
-                            "psrlw      %%mm0, 8\n\t"
-                            "packuswb   %%mm0, %%mm0\n\t"
-                            "movd       dword ptr [%%edi], %%mm0\n\t"
-#endif
-                        T2_NONSCALE_BLEND_ASM_LEAVE(t2_nonscale_nonmask_loop_adj)
-                        ++ty;
-                    }
-                    T2_NONSCALE_POP_EDI_ESI
-                    break;
-                }
-
-                case BLEND_XOR: {
-                    T2_NONSCALE_PUSH_ESI_EDI
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        int* outp = &framebuffer[y * (w + 1) + r2.left];
-                        pixel_rgb0_8* inp = &texture[ty * (iw + 1) + cx0];
-                        int tot = (r2.right - r2.left);
-                        T2_NONSCALE_BLEND_ASM_ENTER(t2_nonscale_nonmask_loop_xor)
-#ifdef _MSC_VER
-                        __asm {
-                            movd mm0, dword ptr [edi]
-                            pxor mm0, qword ptr [esi]
-                            movd dword ptr [edi], mm0
-                        }
-#else  // GCC
-                        "movd  %%mm0, dword ptr [%%edi]\n\t"
-                            "pxor  %%mm0, qword ptr [%%esi]\n\t"
-                            "movd  dword ptr [%%edi], %%mm0\n\t"
-#endif
-                        T2_NONSCALE_BLEND_ASM_LEAVE(t2_nonscale_nonmask_loop_xor)
-                        ++ty;
-                    }
-                    T2_NONSCALE_POP_EDI_ESI
-                    break;
-                }
+            return _mm_packus_epi16(out_lo, out_hi);
+        case BLEND_ADJUSTABLE:
+            if (source == TEXER2_SOURCE_RESIZED) {
+                __m128i inv_alpha = _mm_sub_epi16(_mm_set1_epi16(255), alpha_16x8);
+                out_lo = _mm_add_epi16(
+                    _mm_srli_epi16(_mm_mullo_epi16(d_lo, inv_alpha), 8),
+                    _mm_srli_epi16(_mm_mullo_epi16(s_lo, alpha_16x8), 8));
+                out_hi = _mm_add_epi16(
+                    _mm_srli_epi16(_mm_mullo_epi16(d_hi, inv_alpha), 8),
+                    _mm_srli_epi16(_mm_mullo_epi16(s_hi, alpha_16x8), 8));
+            } else {
+                __m128i inv_alpha = _mm_sub_epi16(_mm_set1_epi16(256), alpha_16x8);
+                out_lo = _mm_adds_epu16(_mm_mullo_epi16(d_lo, alpha_16x8),
+                                        _mm_mullo_epi16(s_lo, inv_alpha));
+                out_hi = _mm_adds_epu16(_mm_mullo_epi16(d_hi, alpha_16x8),
+                                        _mm_mullo_epi16(s_hi, inv_alpha));
+                out_lo = _mm_srli_epi16(out_lo, 8);
+                out_hi = _mm_srli_epi16(out_hi, 8);
+            }
+            return _mm_packus_epi16(out_lo, out_hi);
+        case BLEND_XOR: return _mm_xor_si128(dest, s);
+        case BLEND_MINIMUM: return _mm_min_epu8(dest, s);
+    }
+}
 
-                case BLEND_MINIMUM: {
-                    int maxmask = 0xFFFFFF;
-                    int signmask = 0x808080;
-                    T2_NONSCALE_PUSH_ESI_EDI
-                    T2_NONSCALE_MINMAX_MASKS
-                    for (int y = r2.top; y <= r2.bottom; ++y) {
-                        int* outp = &framebuffer[y * (w + 1) + r2.left];
-                        pixel_rgb0_8* inp = &texture[ty * (iw + 1) + cx0];
-                        int tot = (r2.right - r2.left);
-                        T2_NONSCALE_BLEND_ASM_ENTER(t2_nonscale_nonmask_loop_min)
-#ifdef _MSC_VER
-                        __asm {
-                            movd mm0, dword ptr [edi]
-                            movd mm1, dword ptr [esi]
-                            pxor mm0, mm6
-                            pxor mm1, mm6
-                            movq mm2, mm1
-                            pcmpgtb mm2, mm0
-                            movq mm3, mm2
-                            pxor mm3, mm4
-                            pand mm0, mm2
-                            pand mm1, mm3
-                            por mm0, mm1
-                            pxor mm0, mm6
-                            movd dword ptr [edi], mm0
-                        }
-#else  // GCC
-                        "movd     %%mm0, dword ptr [%%edi]\n\t"
-                            "movd     %%mm1, dword ptr [%%esi]\n\t"
-                            "pxor     %%mm0, %%mm6\n\t"
-                            "pxor     %%mm1, %%mm6\n\t"
-                            "movq     %%mm2, %%mm1\n\t"
-                            "pcmpgtb  %%mm2, %%mm0\n\t"
-                            "movq     %%mm3, %%mm2\n\t"
-                            "pxor     %%mm3, %%mm4\n\t"
-                            "pand     %%mm0, %%mm2\n\t"
-                            "pand     %%mm1, %%mm3\n\t"
-                            "por      %%mm0, %%mm1\n\t"
-                            "pxor     %%mm0, %%mm6\n\t"
-                            "movd     dword ptr [%%edi], %%mm0\n\t"
-#endif
-                        T2_NONSCALE_BLEND_ASM_LEAVE(t2_nonscale_nonmask_loop_min)
-                        ++ty;
-                    }
-                    T2_NONSCALE_POP_EDI_ESI
-                    break;
-                }
+template <int blend_mode, int source>
+static void texer2_draw_rows_x86v128(const Texer2_Splat& splat,
+                                     uint32_t* framebuffer,
+                                     int w,
+                                     int stride,
+                                     int y_start,
+                                     int y_end,
+                                     uint32_t alpha) {
+    __m128i color_16x8 =
+        _mm_unpacklo_epi8(_mm_cvtsi32_si128(splat.color), _mm_setzero_si128());
+    color_16x8 = _mm_unpacklo_epi64(color_16x8, color_16x8);
+    __m128i alpha_16x8 = _mm_set1_epi16(alpha);
+    int count = splat.right - splat.left + 1;
+    for (int y = y_start; y < y_end; y++) {
+        uint32_t lerp_y;
+        const uint32_t* tex = texer2_tex_row(splat, source, stride, y, &lerp_y);
+        uint32_t* out = &framebuffer[y * w + splat.left];
+        uint32_t cx = splat.tex_x;
+        int i = 0;
+        for (; i < count - 3; i += 4) {
+            __m128i texel;
+            if (source == TEXER2_SOURCE_RESIZED) {
+                uint32_t step = splat.step_x;
+                texel = _mm_set_epi32(
+                    texer2_bilinear_c(tex, stride, cx + step * 3, lerp_y),
+                    texer2_bilinear_c(tex, stride, cx + step * 2, lerp_y),
+                    texer2_bilinear_c(tex, stride, cx + step, lerp_y),
+                    texer2_bilinear_c(tex, stride, cx, lerp_y));
+                cx += step * 4;
+            } else {
+                texel = _mm_loadu_si128((__m128i*)&tex[cx]);
+                cx += 4;
             }
+            __m128i dest = _mm_loadu_si128((__m128i*)&out[i]);
+            dest = texer2_blend_4px_x86v128<blend_mode, source>(
+                dest, texel, color_16x8, alpha_16x8);
+            _mm_storeu_si128((__m128i*)&out[i], dest);
+        }
+        for (; i < count; i++, cx += splat.step_x) {
+            uint32_t texel = source == TEXER2_SOURCE_RESIZED
+                                 ? texer2_bilinear_c(tex, stride, cx, lerp_y)
+                                 : tex[cx];
+            out[i] = texer2_blend_px_c<blend_mode, source>(
+                out[i], texel, splat.color, alpha);
         }
     }
+}
+#endif
 
-skippart:
-    ++(this->iw);  // restore member vars!
-    ++(this->ih);
+template <int blend_mode, int source>
+static void texer2_draw_tile(const Texer2_Splat* splats,
+                             const Tile_Bins& tiles,
+                             int tile,
+                             uint32_t* framebuffer,
+                             int w,
+                             int stride,
+                             uint32_t alpha) {
+    int clip_top = tiles.tile_top(tile);
+    int clip_bottom = tiles.tile_bottom(tile);
+    const uint32_t* end = tiles.items_end(tile);
+    for (const uint32_t* i = tiles.items_begin(tile); i < end; i++) {
+        const Texer2_Splat& splat = splats[*i];
+        int y_start = max(splat.top, clip_top);
+        int y_end = min(splat.bottom + 1, clip_bottom);
+#ifdef SIMD_MODE_X86_SSE
+        texer2_draw_rows_x86v128<blend_mode, source>(
+            splat, framebuffer, w, stride, y_start, y_end, alpha);
+#else
+        texer2_draw_rows_c<blend_mode, source>(
+            splat, framebuffer, w, stride, y_start, y_end, alpha);
+#endif
+    }
+}
 
-    // Perhaps removing all fpu stuff here and doing one emms globally would be better?
-    EMMS
+// Pick the kernel for the blend mode once per tile. Unknown modes draw nothing, as
+// before.
+template <int source>
+static void texer2_draw_tile_dispatch(int32_t line_blend_mode,
+                                      const Texer2_Splat* splats,
+                                      const Tile_Bins& tiles,
+                                      int tile,
+                                      uint32_t* framebuffer,
+                                      int w,
+                                      int stride) {
+    uint32_t alpha = line_blend_mode >> 8 & 0xff;
+#define TEXER2_DRAW_TILE_CASE(MODE)                                  \
+    case MODE:                                                       \
+        texer2_draw_tile<MODE, source>(                              \
+            splats, tiles, tile, framebuffer, w, stride, alpha);     \
+        break
+    switch (line_blend_mode & 0xff) {
+        TEXER2_DRAW_TILE_CASE(BLEND_REPLACE);
+        TEXER2_DRAW_TILE_CASE(BLEND_ADDITIVE);
+        TEXER2_DRAW_TILE_CASE(BLEND_MAXIMUM);
+        TEXER2_DRAW_TILE_CASE(BLEND_5050);
+        TEXER2_DRAW_TILE_CASE(BLEND_SUB1);
+        TEXER2_DRAW_TILE_CASE(BLEND_SUB2);
+        TEXER2_DRAW_TILE_CASE(BLEND_MULTIPLY);
+        TEXER2_DRAW_TILE_CASE(BLEND_ADJUSTABLE);
+        TEXER2_DRAW_TILE_CASE(BLEND_XOR);
+        TEXER2_DRAW_TILE_CASE(BLEND_MINIMUM);
+        default: break;
+    }
+#undef TEXER2_DRAW_TILE_CASE
 }
 
 inline double wrap_diff_to_plusminus1(double x) { return round(x / 2.0) * 2.0; }
@@ -1574,19 +693,33 @@ bool overlaps_edge(double wrapped_coord,
 int E_Texer2::render(char visdata[2][2][576],
                      int is_beat,
                      int* framebuffer,
-                     int*,
+                     int* fbout,
                      int w,
                      int h) {
+    if (this->smp_begin(1, visdata, is_beat, framebuffer, fbout, w, h) < 1) {
+        return 0;
+    }
+    this->smp_render(0, 1, visdata, is_beat, framebuffer, fbout, w, h);
+    return this->smp_finish(visdata, is_beat, framebuffer, fbout, w, h);
+}
+
+int E_Texer2::smp_begin(int max_threads,
+                        char visdata[2][2][576],
+                        int is_beat,
+                        int*,
+                        int*,
+                        int w,
+                        int h) {
     this->recompile_if_needed();
     this->init_variables(w, h, is_beat, this->iw, this->ih);
     if (this->need_init || (is_beat & 0x80000000)) {
         *this->vars.n = 0.0f;
-        this->code_init.exec(visdata);
+        this->code_init.exec();
         this->need_init = false;
     }
-    this->code_frame.exec(visdata);
+    this->code_frame.exec();
     if ((is_beat & 0x00000001)) {
-        this->code_beat.exec(visdata);
+        this->code_beat.exec();
     }
     int n = RoundToInt((double)*this->vars.n);
     n = max(0, min(65536, n));
@@ -1595,7 +728,11 @@ int E_Texer2::render(char visdata[2][2][576],
         return 0;
     }
 
+    // Held until smp_finish(), since the splats point into the images.
     lock_lock(this->image_lock);
+    this->splats.clear();
+    this->splat_resize = this->config.resize;
+    this->splat_colorize = this->config.colorize;
     double step = 1.0 / (n - 1);
     double i = 0.0;
     for (int j = 0; j < n; ++j) {
@@ -1605,7 +742,7 @@ int E_Texer2::render(char visdata[2][2][576],
             ((int)visdata[1][0][j * 575 / n] + (int)visdata[1][1][j * 575 / n]) / 256.0;
         i += step;
 
-        this->code_point.exec(visdata);
+        this->code_point.exec();
 
         if (*this->vars.skip != 0.0) {
             continue;
@@ -1624,7 +761,7 @@ int E_Texer2::render(char visdata[2][2][576],
         color |= min(255, max(0, RoundToInt(255.0f * (double)*this->vars.green))) << 8;
         color |= min(255, max(0, RoundToInt(255.0f * (double)*this->vars.red))) << 16;
 
-        if (!this->config.colorize) {
+        if (!this->splat_colorize) {
             color = 0xFFFFFF;
         }
 
@@ -1656,27 +793,63 @@ int E_Texer2::render(char visdata[2][2][576],
             double sign_x2 = x > 0 ? 2.0 : -2.0;
             double sign_y2 = y > 0 ? 2.0 : -2.0;
             if (overlaps_x) {
-                DrawParticle(
-                    framebuffer, texture, w, h, x - sign_x2, y, szx, szy, color);
+                this->add_particle(texture, w, h, x - sign_x2, y, szx, szy, color);
             }
             if (overlaps_y) {
-                DrawParticle(
-                    framebuffer, texture, w, h, x, y - sign_y2, szx, szy, color);
+                this->add_particle(texture, w, h, x, y - sign_y2, szx, szy, color);
             }
             if (overlaps_x && overlaps_y) {
-                DrawParticle(framebuffer,
-                             texture,
-                             w,
-                             h,
-                             x - sign_x2,
-                             y - sign_y2,
-                             szx,
-                             szy,
-                             color);
+                this->add_particle(
+                    texture, w, h, x - sign_x2, y - sign_y2, szx, szy, color);
             }
         }
-        DrawParticle(framebuffer, texture, w, h, x, y, szx, szy, color);
+        this->add_particle(texture, w, h, x, y, szx, szy, color);
     }
+    // The effect list doesn't call smp_finish() on preinit, so release the lock here.
+    if (this->splats.empty() || (is_beat & 0x80000000)) {
+        lock_unlock(this->image_lock);
+        return 0;
+    }
+
+    this->tiles.reset(h, TEXER_II_TILE_HEIGHT);
+    for (uint32_t s = 0; s < this->splats.size(); s++) {
+        this->tiles.add(s, this->splats[s].top, this->splats[s].bottom);
+    }
+    this->tiles.finish();
+    this->line_blend_mode = g_line_blend_mode;
+    return max_threads;
+}
+
+void E_Texer2::smp_render(int this_thread,
+                          int max_threads,
+                          char[2][2][576],
+                          int,
+                          int* framebuffer,
+                          int*,
+                          int w,
+                          int) {
+    int num_tiles = this->tiles.num_tiles();
+    int first_tile = this_thread * num_tiles / max_threads;
+    int end_tile = this_thread >= max_threads - 1
+                       ? num_tiles
+                       : (this_thread + 1) * num_tiles / max_threads;
+    auto fb = (uint32_t*)framebuffer;
+    const Texer2_Splat* splats = this->splats.data();
+    for (int t = first_tile; t < end_tile; t++) {
+        if (this->splat_resize) {
+            texer2_draw_tile_dispatch<TEXER2_SOURCE_RESIZED>(
+                this->line_blend_mode, splats, this->tiles, t, fb, w, this->iw);
+        } else if (this->splat_colorize) {
+            texer2_draw_tile_dispatch<TEXER2_SOURCE_COLORIZED>(
+                this->line_blend_mode, splats, this->tiles, t, fb, w, this->iw);
+        } else {
+            texer2_draw_tile_dispatch<TEXER2_SOURCE_PLAIN>(
+                this->line_blend_mode, splats, this->tiles, t, fb, w, this->iw);
+        }
+    }
+}
+
+int E_Texer2::smp_finish(char[2][2][576], int, int*, int*, int, int) {
     lock_unlock(this->image_lock);
     return 0;
 }
@@ -5,6 +5,7 @@
 #include "effect_info.h"
 #include "effect_programmable.h"
 #include "pixel_format.h"
+#include "tile_bins.h"
 
 #include "../platform.h"
 
@@ -17,6 +18,9 @@
 
 #define TEXER_II_DEFAULT_IMAGE_STRING "(default image)"
 
+// Height of the row strips particles are binned into for parallel drawing.
+#define TEXER_II_TILE_HEIGHT 16
+
 struct Texer2_Config : public Effect_Config {
     int64_t version = TEXER_II_VERSION_CURRENT;
     std::string image;
@@ -108,6 +112,8 @@ struct Texer2_Info : public Effect_Info {
 
     static constexpr int32_t legacy_id = -1;
     static constexpr char* legacy_ape_id = "Acko.net: Texer II";
+    static constexpr uint32_t audio_dependencies =
+        AUDIO_DEPENDS_OSC | AUDIO_DEPENDS_BEAT;
 
     static constexpr int32_t num_examples = 4;
     static constexpr Texer2_Example examples[num_examples] = {
@@ -259,6 +265,23 @@ struct Texer2_Vars : public Variables {
     virtual void init(int, int, int, va_list);
 };
 
+// A particle's image, clipped to the screen and ready to draw.
+struct Texer2_Splat {
+    const pixel_rgb0_8* texture;
+    uint32_t color;
+    // Screen rectangle, inclusive.
+    int32_t left;
+    int32_t top;
+    int32_t right;
+    int32_t bottom;
+    // Texture coordinates of the top-left pixel and their steps per pixel. 16.16
+    // fixed-point when resizing, whole texels (and no steps) otherwise.
+    uint32_t tex_x;
+    uint32_t tex_y;
+    uint32_t step_x;
+    uint32_t step_y;
+};
+
 class E_Texer2 : public Programmable_Effect<Texer2_Info, Texer2_Config, Texer2_Vars> {
    public:
     E_Texer2(AVS_Instance* avs);
@@ -279,8 +302,30 @@ class E_Texer2 : public Programmable_Effect<Texer2_Info, Texer2_Config, Texer2_V
     void load_default_image();
     void delete_image();
 
-    void DrawParticle(int* framebuffer,
-                      pixel_rgb0_8* texture,
+    virtual bool can_multithread() { return true; }
+    virtual int smp_begin(int max_threads,
+                          char visdata[2][2][576],
+                          int is_beat,
+                          int* framebuffer,
+                          int* fbout,
+                          int w,
+                          int h);
+    virtual void smp_render(int this_thread,
+                            int max_threads,
+                            char visdata[2][2][576],
+                            int is_beat,
+                            int* framebuffer,
+                            int* fbout,
+                            int w,
+                            int h);
+    virtual int smp_finish(char visdata[2][2][576],
+                           int is_beat,
+                           int* framebuffer,
+                           int* fbout,
+                           int w,
+                           int h);
+
+    void add_particle(const pixel_rgb0_8* texture,
                       int w,
                       int h,
                       double x,
@@ -299,4 +344,10 @@ class E_Texer2 : public Programmable_Effect<Texer2_Info, Texer2_Config, Texer2_V
     pixel_rgb0_8* image_rot180;
 
     lock_t* image_lock;
+    std::vector<Texer2_Splat> splats;
+    Tile_Bins tiles;
+    // Settings captured for the frame being drawn.
+    bool splat_resize;
+    bool splat_colorize;
+    int32_t line_blend_mode;
 };
@@ -32,6 +32,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "e_timescope.h"
 
 #include "blend.h"
+#include "effect_common.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -78,18 +79,23 @@ int E_Timescope::render(char visdata[2][2][576],
     r = (uint32_t)this->config.color & 0xff;
     g = ((uint32_t)this->config.color >> 8) & 0xff;
     b = ((uint32_t)this->config.color >> 16) & 0xff;
-    for (int32_t i = 0; i < h; i++) {
-        uint32_t px;
-        px = audio_data[(i * this->config.bands) / h] & 0xFF;
-        px = (r * px) / 256 + (((g * px) / 256) << 8) + (((b * px) / 256) << 16);
-        switch (this->config.blend_mode) {
-            default:
-            case TIMESCOPE_BLEND_DEFAULT: blend_default_1px(&px, fb, fb); break;
-            case TIMESCOPE_BLEND_ADDITIVE: blend_add_1px(&px, fb, fb); break;
-            case TIMESCOPE_BLEND_5050: blend_5050_1px(&px, fb, fb); break;
-            case TIMESCOPE_BLEND_REPLACE: blend_replace_1px(&px, fb); break;
+    auto draw = [&](const auto& blend) {
+        for (int32_t i = 0; i < h; i++) {
+            uint32_t px;
+            px = audio_data[(i * this->config.bands) / h] & 0xFF;
+            px = (r * px) / 256 + (((g * px) / 256) << 8) + (((b * px) / 256) << 16);
+            blend.px(px, fb);
+            fb += w;
         }
-        fb += w;
+    };
+    switch (this->config.blend_mode) {
+        default:
+        case TIMESCOPE_BLEND_DEFAULT:
+            line_blend_dispatch(g_line_blend_mode, draw);
+            break;
+        case TIMESCOPE_BLEND_ADDITIVE: draw(Line_Blend<BLEND_ADDITIVE>(0)); break;
+        case TIMESCOPE_BLEND_5050: draw(Line_Blend<BLEND_5050>(0)); break;
+        case TIMESCOPE_BLEND_REPLACE: draw(Line_Blend<BLEND_REPLACE>(0)); break;
     }
 
     return 0;
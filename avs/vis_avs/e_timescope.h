@@ -24,6 +24,7 @@ struct Timescope_Info : public Effect_Info {
     static constexpr char const* help = "";
     static constexpr int32_t legacy_id = 39;
     static constexpr char const* legacy_ape_id = nullptr;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_SPEC;
 
     static const char* const* blend_modes(int64_t* length_out) {
         *length_out = 4;
@@ -4,7 +4,9 @@
 #include "blend.h"
 #include "effect_common.h"
 
+#include <immintrin.h>
 #include <math.h>
+#include <stdlib.h>
 
 #define NUM_COLOR_VALUES 256   // 2 ^ BITS_PER_CHANNEL (i.e. 8)
 #define IS_BEAT_MASK     0x01  // something else might be encoded in the higher bytes
@@ -88,22 +90,39 @@ inline unsigned char col_to_int(double col) {
 int E_Triangle::render(char visdata[2][2][576],
                        int is_beat,
                        int* framebuffer,
-                       int*,
+                       int* fbout,
                        int w,
                        int h) {
+    if (this->smp_begin(1, visdata, is_beat, framebuffer, fbout, w, h) < 1) {
+        return 0;
+    }
+    this->smp_render(0, 1, visdata, is_beat, framebuffer, fbout, w, h);
+    return this->smp_finish(visdata, is_beat, framebuffer, fbout, w, h);
+}
+
+int E_Triangle::smp_finish(char[2][2][576], int, int*, int*, int, int) { return 0; }
+
+int E_Triangle::smp_begin(int max_threads,
+                          char[2][2][576],
+                          int is_beat,
+                          int*,
+                          int*,
+                          int w,
+                          int h) {
     this->init_depthbuffer_if_needed(w, h);
     this->recompile_if_needed();
     if (this->need_init) {
         *this->vars.n = 0;
-        this->code_init.exec(visdata);
+        this->code_init.exec();
         this->need_init = false;
     }
     this->init_variables(w, h, is_beat & IS_BEAT_MASK);
-    this->code_frame.exec(visdata);
+    this->code_frame.exec();
     if (is_beat & IS_BEAT_MASK) {
-        this->code_beat.exec(visdata);
+        this->code_beat.exec();
     }
     this->depth_buffer->reset_if_needed(w, h, *this->vars.zbclear != 0.0);
+    this->parts.clear();
     int triangle_count = round(*this->vars.n);
     if (triangle_count > 0) {
         double step = 1.0;
@@ -116,7 +135,7 @@ int E_Triangle::render(char visdata[2][2][576],
         *this->vars.i = i;
         for (int k = 0; k < triangle_count; ++k) {
             *this->vars.skip = 0.0;
-            this->code_point.exec(visdata);
+            this->code_point.exec();
             if (*this->vars.skip != 0.0) {
                 continue;
             }
@@ -132,26 +151,50 @@ int E_Triangle::render(char visdata[2][2][576],
                  z_to_depthbuffer(*this->vars.z1)},
             };
 
-            unsigned int color;
+            unsigned int color = 0;
             unsigned char* color_bytes = (unsigned char*)&color;
             color_bytes[0] = col_to_int(*this->vars.blue1);
             color_bytes[1] = col_to_int(*this->vars.green1);
             color_bytes[2] = col_to_int(*this->vars.red1);
 
-            this->draw_triangle(
-                framebuffer, w, h, vertices, *this->vars.zbuf != 0.0f, color);
+            this->setup_triangle(w, h, vertices, *this->vars.zbuf != 0.0f, color);
 
             i += step;
             *this->vars.i = i;
         }
     }
-    return 0;
+    if (this->parts.empty() || (is_beat & 0x80000000)) {
+        return 0;
+    }
+
+    this->tiles.reset(h, TRIANGLE_TILE_HEIGHT);
+    for (uint32_t p = 0; p < this->parts.size(); p++) {
+        this->tiles.add(p, this->parts[p].top, this->parts[p].bottom - 1);
+    }
+    this->tiles.finish();
+    this->line_blend_mode = g_line_blend_mode;
+    return max_threads;
+}
+
+static Triangle_Edge triangle_edge(const Vertex& from, const Vertex& to) {
+    Triangle_Edge edge;
+    edge.x0 = from.x;
+    edge.y0 = from.y;
+    edge.dx = (int64_t)to.x - from.x;
+    edge.dy = (int64_t)to.y - from.y;
+    // The scanline code computes an edge's x in row y as
+    //     x0 + (dx * (y - y0)) / dy
+    // with integer division, i.e. truncated towards x0, and covers pixels from there on
+    // rightwards. Expressed as `at(x, y) > 0`, that needs a bias depending on the
+    // direction of truncation.
+    edge.bias = edge.dx >= 0 ? edge.dy : 1;
+    return edge;
 }
 
 /**
- * Drawing triangles works by successively drawing the horizontal lines between one
- * longer and two shorter edges, where length is _only_ measured vertically, i.e. the
- * absolute difference |y1-y2|.
+ * Triangles are drawn by successively drawing the horizontal lines between one longer
+ * and two shorter edges, where length is _only_ measured vertically, i.e. the absolute
+ * difference |y1-y2|.
  *
  * Consider the following triangle:
  *
@@ -164,21 +207,26 @@ int E_Triangle::render(char visdata[2][2][576],
  *    3
  *
  * First the 3 vertices are sorted according to their y-coordinates. The lines between
- * edges 1-3 and 1-2 (filled with +) will then get drawn first, and the lines between
- * edges 1-3 and 2-3 (filled with =) after that.
+ * edges 1-3 and 1-2 (filled with +) make up the first part of the triangle, and the
+ * lines between edges 1-3 and 2-3 (filled with =) the second part.
  *
  * See https://joshbeam.com/articles/triangle_rasterization/ for a full description.
  *
+ * Instead of walking the lines, each part is rasterized from the two edges' half-space
+ * functions, in blocks of 8x8 pixels (see triangle_draw_part()). The rounding and
+ * clipping of the original line-drawing code is retained exactly: The row of the top
+ * vertex, the last pixel of each line and the last column of the screen are never
+ * drawn.
+ *
  * In our case, an additional depth-buffer check is performed and pixels will only be
- * actually drawn to the framebuffer if the triangle has a lower z1 value than the
+ * actually drawn to the framebuffer if the triangle's z1 value is at least the
  * depth-buffer value at that pixel.
  */
-void E_Triangle::draw_triangle(int* framebuffer,
-                               int w,
-                               int h,
-                               Vertex vertices[3],
-                               bool use_depthbuffer,
-                               unsigned int color) {
+void E_Triangle::setup_triangle(int w,
+                                int h,
+                                Vertex vertices[3],
+                                bool use_depthbuffer,
+                                unsigned int color) {
     this->sort_vertices(vertices);
     Vertex v1 = vertices[0];
     Vertex v2 = vertices[1];
@@ -189,56 +237,230 @@ void E_Triangle::draw_triangle(int* framebuffer,
     }
     int midy = max(-1, min(h - 1, v2.y));
     int endy = max(-1, min(h, v3.y));
-    int fb_index = w * y;
 
-    for (; y <= midy; fb_index += w, y++) {
-        int startx = ((v2.x - v1.x) * (y - v1.y)) / (v2.y - v1.y) + v1.x;
-        int endx = ((v3.x - v1.x) * (y - v1.y)) / (v3.y - v1.y) + v1.x;
-        this->draw_line(
-            framebuffer, fb_index, startx, endx, v1.z, w, use_depthbuffer, color);
+    Triangle_Part part;
+    part.left = max(0, min(v1.x, min(v2.x, v3.x)));
+    part.right = min(w - 1, max(v1.x, max(v2.x, v3.x)));
+    if (part.right <= part.left) {
+        return;
+    }
+    part.z = (uint32_t)v1.z;
+    part.color = color;
+    part.use_depthbuffer = use_depthbuffer;
+    part.b = triangle_edge(v1, v3);
+    if (y <= midy) {
+        part.a = triangle_edge(v1, v2);
+        part.top = y;
+        part.bottom = midy + 1;
+        this->parts.push_back(part);
+        y = midy + 1;
+    }
+    if (y < endy) {
+        part.a = triangle_edge(v2, v3);
+        part.top = y;
+        part.bottom = endy;
+        this->parts.push_back(part);
+    }
+}
+
+// How much of the pixel rectangle (x0, y0)-(x1, y1), inclusive, lies right of `edge`:
+// 1 if all of it, 0 if none and -1 if some.
+static int triangle_edge_coverage(const Triangle_Edge& edge,
+                                  int x0,
+                                  int y0,
+                                  int x1,
+                                  int y1) {
+    if (edge.at(x0, edge.dx > 0 ? y1 : y0) > 0) {
+        return 1;
+    }
+    if (edge.at(x1, edge.dx > 0 ? y0 : y1) <= 0) {
+        return 0;
+    }
+    return -1;
+}
+
+// The first x at or after `x0` but not after `x1` to the right of `edge` in row `y`.
+static int triangle_edge_start(const Triangle_Edge& edge, int x0, int x1, int y) {
+    int64_t e = edge.at(x0, y);
+    if (e > 0) {
+        return x0;
     }
-    for (; y < endy; fb_index += w, y++) {
-        int startx = ((v3.x - v2.x) * (y - v2.y)) / (v3.y - v2.y) + v2.x;
-        int endx = ((v3.x - v1.x) * (y - v1.y)) / (v3.y - v1.y) + v1.x;
-        this->draw_line(
-            framebuffer, fb_index, startx, endx, v1.z, w, use_depthbuffer, color);
+    int64_t x = x0 + -e / edge.dy + 1;
+    return x < x1 ? (int)x : x1;
+}
+
+static void triangle_depth_span_c(uint32_t* framebuffer,
+                                  uint32_t* depth,
+                                  int start,
+                                  int end,
+                                  uint32_t z,
+                                  uint32_t color) {
+    for (int x = start; x < end; x++) {
+        if (z >= depth[x]) {
+            depth[x] = z;
+            framebuffer[x] = color;
+        }
     }
 }
 
-inline void E_Triangle::draw_line(int* framebuffer,
-                                  int fb_index,
-                                  int startx,
-                                  int endx,
-                                  uint64_t z,
-                                  int w,
-                                  bool use_depthbuffer,
-                                  unsigned int color) {
-    if (startx > endx) {
-        int tmp = startx;
-        startx = endx;
-        endx = tmp;
+#ifdef SIMD_MODE_X86_SSE
+// Depth-test and draw the pixels `start` through `end` (exclusive) of the 8 pixels at
+// `framebuffer` & `depth` with coverage masks.
+static void triangle_depth_8px_x86v128(uint32_t* framebuffer,
+                                       uint32_t* depth,
+                                       int start,
+                                       int end,
+                                       uint32_t z,
+                                       uint32_t color) {
+    // There's no unsigned compare before SSE4.1, flip the sign bits to compare signed.
+    __m128i sign = _mm_set1_epi32(0x80000000);
+    __m128i z_signed = _mm_set1_epi32(z ^ 0x80000000);
+    __m128i z_4x32 = _mm_set1_epi32(z);
+    __m128i color_4x32 = _mm_set1_epi32(color);
+    __m128i start_4x32 = _mm_set1_epi32(start - 1);
+    __m128i end_4x32 = _mm_set1_epi32(end);
+    __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+    for (int i = 0; i < 8; i += 4) {
+        __m128i coverage = _mm_and_si128(_mm_cmpgt_epi32(index, start_4x32),
+                                         _mm_cmpgt_epi32(end_4x32, index));
+        __m128i d = _mm_loadu_si128((__m128i*)&depth[i]);
+        __m128i fail = _mm_cmpgt_epi32(_mm_xor_si128(d, sign), z_signed);
+        __m128i mask = _mm_andnot_si128(fail, coverage);
+        __m128i fb = _mm_loadu_si128((__m128i*)&framebuffer[i]);
+        d = _mm_or_si128(_mm_and_si128(mask, z_4x32), _mm_andnot_si128(mask, d));
+        fb = _mm_or_si128(_mm_and_si128(mask, color_4x32), _mm_andnot_si128(mask, fb));
+        _mm_storeu_si128((__m128i*)&depth[i], d);
+        _mm_storeu_si128((__m128i*)&framebuffer[i], fb);
+        index = _mm_add_epi32(index, _mm_set1_epi32(4));
     }
-    if (endx < 0 || startx >= w) {
+}
+#endif
+
+/**
+ * Draw the rows `clip_top` through `clip_bottom` (exclusive) of `part`.
+ *
+ * Without depth buffering, each row is blended as a single span, since the blend
+ * functions' SIMD and scalar paths round differently and splitting spans would change
+ * the result.
+ *
+ * With depth buffering, the part is drawn in blocks of 8x8 pixels. Blocks entirely
+ * outside the part, or entirely behind the depth buffer's lower bound for the block,
+ * are skipped. Blocks inside the part are drawn without further edge tests, and only
+ * the blocks on the part's edges need the per-row coverage of both edges.
+ */
+template <class Blend>
+static void triangle_draw_part(const Triangle_Part& part,
+                               const Blend& blend,
+                               uint32_t* framebuffer,
+                               TriangleDepthBuffer* depth_buffer,
+                               int w,
+                               int clip_top,
+                               int clip_bottom) {
+    const int block_size = TRIANGLE_BLOCK_SIZE;
+    int top = max(part.top, clip_top);
+    int bottom = min(part.bottom, clip_bottom);
+    if (!part.use_depthbuffer) {
+        for (int y = top; y < bottom; y++) {
+            int start_a = triangle_edge_start(part.a, part.left, part.right, y);
+            int start_b = triangle_edge_start(part.b, part.left, part.right, y);
+            int start = min(start_a, start_b);
+            int end = max(start_a, start_b);
+            if (start < end) {
+                blend.fill(part.color, &framebuffer[y * w + start], end - start);
+            }
+        }
         return;
     }
-    startx = max(startx, 0);
-    endx = min(endx, w - 1);
-    fb_index += startx;
-    int fb_endx = fb_index + (endx - startx);
-    if (use_depthbuffer) {
-        for (; fb_index < fb_endx; fb_index++) {
-            if (z >= this->depth_buffer->buffer[fb_index]) {
-                this->depth_buffer->buffer[fb_index] = z;
-                framebuffer[fb_index] = color;
-            } else {
+    for (int by = top - top % block_size; by < bottom; by += block_size) {
+        int y0 = max(by, top);
+        int y1 = min(by + block_size, bottom);
+        unsigned int* block_min =
+            &depth_buffer->block_min[(by / block_size) * depth_buffer->blocks_w];
+        for (int bx = part.left - part.left % block_size; bx < part.right;
+             bx += block_size) {
+            int x0 = max(bx, part.left);
+            int x1 = min(bx + block_size, part.right);
+            if (part.z < block_min[bx / block_size]) {
                 continue;
             }
+            int coverage_a = triangle_edge_coverage(part.a, x0, y0, x1 - 1, y1 - 1);
+            int coverage_b = triangle_edge_coverage(part.b, x0, y0, x1 - 1, y1 - 1);
+            bool full = false;
+            if (coverage_a >= 0 && coverage_b >= 0) {
+                if (coverage_a == coverage_b) {
+                    continue;
+                }
+                full = true;
+            }
+            bool whole_block = x1 - x0 == block_size && y1 - y0 == block_size;
+            for (int y = y0; y < y1; y++) {
+                int start = x0;
+                int end = x1;
+                if (!full) {
+                    int start_a = triangle_edge_start(part.a, x0, x1, y);
+                    int start_b = triangle_edge_start(part.b, x0, x1, y);
+                    start = min(start_a, start_b);
+                    end = max(start_a, start_b);
+                }
+                if (start >= end) {
+                    continue;
+                }
+                uint32_t* fb_row = &framebuffer[y * w];
+                uint32_t* depth_row = &depth_buffer->buffer[y * w];
+#ifdef SIMD_MODE_X86_SSE
+                if (x1 - x0 == block_size) {
+                    triangle_depth_8px_x86v128(&fb_row[x0],
+                                               &depth_row[x0],
+                                               start - x0,
+                                               end - x0,
+                                               part.z,
+                                               part.color);
+                    continue;
+                }
+#endif
+                triangle_depth_span_c(
+                    fb_row, depth_row, start, end, part.z, part.color);
+            }
+            // Every pixel of the block is now at least this deep.
+            if (full && whole_block) {
+                block_min[bx / block_size] = max(block_min[bx / block_size], part.z);
+            }
         }
-    } else {
-        blend_default_fill(color, (uint32_t*)&framebuffer[fb_index], endx - startx);
     }
 }
 
+void E_Triangle::smp_render(int this_thread,
+                            int max_threads,
+                            char[2][2][576],
+                            int,
+                            int* framebuffer,
+                            int*,
+                            int w,
+                            int) {
+    int num_tiles = this->tiles.num_tiles();
+    int first_tile = this_thread * num_tiles / max_threads;
+    int end_tile = this_thread >= max_threads - 1
+                       ? num_tiles
+                       : (this_thread + 1) * num_tiles / max_threads;
+    auto fb = (uint32_t*)framebuffer;
+    line_blend_dispatch(this->line_blend_mode, [&](const auto& blend) {
+        for (int t = first_tile; t < end_tile; t++) {
+            int clip_top = this->tiles.tile_top(t);
+            int clip_bottom = this->tiles.tile_bottom(t);
+            const uint32_t* end = this->tiles.items_end(t);
+            for (const uint32_t* i = this->tiles.items_begin(t); i < end; i++) {
+                triangle_draw_part(this->parts[*i],
+                                   blend,
+                                   fb,
+                                   this->depth_buffer,
+                                   w,
+                                   clip_top,
+                                   clip_bottom);
+            }
+        }
+    });
+}
+
 inline void E_Triangle::sort_vertices(Vertex v[3]) {
     Vertex tmp_vertex;
     char p12 = v[0].y <= v[1].y;
@@ -290,21 +512,32 @@ inline void E_Triangle::sort_vertices(Vertex v[3]) {
 }
 
 /* Depth buffer */
-TriangleDepthBuffer::TriangleDepthBuffer(unsigned int w, unsigned int h) : w(w), h(h) {
-    this->buffer = new unsigned int[w * h];
-    memset(this->buffer, 0, w * h * sizeof(unsigned int));
+TriangleDepthBuffer::TriangleDepthBuffer(unsigned int w, unsigned int h)
+    : w(w), h(h), blocks_w((w + TRIANGLE_BLOCK_SIZE - 1) / TRIANGLE_BLOCK_SIZE) {
+    unsigned int blocks_h = (h + TRIANGLE_BLOCK_SIZE - 1) / TRIANGLE_BLOCK_SIZE;
+    this->buffer = (unsigned int*)calloc(w * h, sizeof(unsigned int));
+    this->block_min =
+        (unsigned int*)calloc(this->blocks_w * blocks_h, sizeof(unsigned int));
+}
+TriangleDepthBuffer::~TriangleDepthBuffer() {
+    free(this->buffer);
+    free(this->block_min);
 }
-TriangleDepthBuffer::~TriangleDepthBuffer() { delete[] this->buffer; }
 
 void TriangleDepthBuffer::reset_if_needed(unsigned int w, unsigned int h, bool clear) {
     // TODO [bug]: lock(triangle_depth_buffer)
     if (clear || this->w != w || this->h != h) {
         // TODO [feature]: The existing depth-buffer could be resized here.
         free(this->buffer);
+        free(this->block_min);
         this->w = w;
         this->h = h;
+        this->blocks_w = (w + TRIANGLE_BLOCK_SIZE - 1) / TRIANGLE_BLOCK_SIZE;
+        unsigned int blocks_h = (h + TRIANGLE_BLOCK_SIZE - 1) / TRIANGLE_BLOCK_SIZE;
         /* Allocating with calloc() is noticeably faster than with new[]() */
         this->buffer = (unsigned int*)calloc(w * h, sizeof(unsigned int));
+        this->block_min =
+            (unsigned int*)calloc(this->blocks_w * blocks_h, sizeof(unsigned int));
     }
     // TODO [bug]: unlock(triangle_depth_buffer)
 }
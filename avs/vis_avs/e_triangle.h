@@ -3,8 +3,13 @@
 #include "effect.h"
 #include "effect_info.h"
 #include "effect_programmable.h"
+#include "tile_bins.h"
 
 #include <string>
+#include <vector>
+
+#define TRIANGLE_TILE_HEIGHT 32
+#define TRIANGLE_BLOCK_SIZE  8
 
 struct Triangle_Config : public Effect_Config {
     std::string init = "";
@@ -19,6 +24,7 @@ struct Triangle_Info : public Effect_Info {
     static constexpr char const* help = "";
     static constexpr int32_t legacy_id = -1;
     static constexpr char* legacy_ape_id = "Render: Triangle";
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static void recompile(Effect*, const Parameter*, const std::vector<int64_t>&);
     static constexpr uint32_t num_parameters = 4;
@@ -66,6 +72,9 @@ class TriangleDepthBuffer {
     unsigned int w;
     unsigned int h;
     unsigned int* buffer;
+    // A lower bound of the depth values in each 8x8 block, for rejecting whole blocks.
+    unsigned int blocks_w;
+    unsigned int* block_min;
 
     TriangleDepthBuffer(unsigned int w, unsigned int h);
     ~TriangleDepthBuffer();
@@ -78,6 +87,40 @@ typedef struct {
     uint64_t z;
 } Vertex;
 
+/**
+ * A triangle edge as a half-space: `at(x, y)` is positive for pixels to the right of
+ * the edge, with the edge's x position in each row truncated towards the edge's start
+ * as in a classic scanline rasterizer.
+ */
+struct Triangle_Edge {
+    int64_t x0;
+    int64_t y0;
+    int64_t dx;
+    int64_t dy;  // always > 0
+    int64_t bias;
+
+    int64_t at(int64_t x, int64_t y) const {
+        return (x - this->x0) * this->dy - this->dx * (y - this->y0) + this->bias;
+    }
+};
+
+/**
+ * The rows of a triangle between its long edge `b` and one of its short edges `a`.
+ * A pixel is covered if it's to the right of exactly one of the two edges.
+ */
+struct Triangle_Part {
+    Triangle_Edge a;
+    Triangle_Edge b;
+    // Screen rectangle, right and bottom exclusive.
+    int left;
+    int top;
+    int right;
+    int bottom;
+    uint32_t z;
+    uint32_t color;
+    bool use_depthbuffer;
+};
+
 class E_Triangle
     : public Programmable_Effect<Triangle_Info, Triangle_Config, Triangle_Vars> {
    public:
@@ -93,24 +136,42 @@ class E_Triangle
     virtual int save_legacy(unsigned char* data);
     virtual E_Triangle* clone() { return new E_Triangle(*this); }
 
+    virtual bool can_multithread() { return true; }
+    virtual int smp_begin(int max_threads,
+                          char visdata[2][2][576],
+                          int is_beat,
+                          int* framebuffer,
+                          int* fbout,
+                          int w,
+                          int h);
+    virtual void smp_render(int this_thread,
+                            int max_threads,
+                            char visdata[2][2][576],
+                            int is_beat,
+                            int* framebuffer,
+                            int* fbout,
+                            int w,
+                            int h);
+    virtual int smp_finish(char visdata[2][2][576],
+                           int is_beat,
+                           int* framebuffer,
+                           int* fbout,
+                           int w,
+                           int h);
+
    private:
     static unsigned int instance_count;
     static TriangleDepthBuffer* depth_buffer;
     bool need_depth_buffer = false;
     void init_depthbuffer_if_needed(int w, int h);
-    inline void draw_triangle(int* framebuffer,
-                              int w,
-                              int h,
-                              Vertex vertices[3],
-                              bool use_depthbuffer,
-                              unsigned int color);
-    inline void draw_line(int* framebuffer,
-                          int fb_index,
-                          int startx,
-                          int endx,
-                          uint64_t z,
-                          int w,
-                          bool use_depthbuffer,
-                          unsigned int color);
+    void setup_triangle(int w,
+                        int h,
+                        Vertex vertices[3],
+                        bool use_depthbuffer,
+                        unsigned int color);
     inline void sort_vertices(Vertex vertices[3]);
+
+    std::vector<Triangle_Part> parts;
+    Tile_Bins tiles;
+    int32_t line_blend_mode = 0;
 };
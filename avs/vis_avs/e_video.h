@@ -27,6 +27,7 @@ struct Video_Info : public Effect_Info {
     static constexpr char const* help = "This effect was formerly known as \"AVI\".";
     static constexpr int32_t legacy_id = 32;
     static constexpr char* legacy_ape_id = NULL;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static const char* const* video_files(int64_t* length_out);
     static const char* const* blend_modes(int64_t* length_out) {
@@ -35,6 +35,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "e_videodelay.h"
 
+#include "instance.h"
+
 #define GET_INT() \
     (data[pos] | (data[pos + 1] << 8) | (data[pos + 2] << 16) | (data[pos + 3] << 24))
 #define PUT_INT(y)                   \
@@ -76,13 +78,24 @@ E_VideoDelay::E_VideoDelay(AVS_Instance* avs)
       buffersize(1),
       virtual_buffersize(1),
       old_virtual_buffersize(1),
-      buffer(calloc(this->buffersize, 1)),
+      buffer(avs->framebuffer_pool.acquire(this->buffersize)),
       in_out_pos(this->buffer),
       frames_since_beat(0),
       frame_delay(10),
       old_frame_mem(0) {}
 
-E_VideoDelay::~E_VideoDelay() { free(this->buffer); }
+E_VideoDelay::E_VideoDelay(const E_VideoDelay& other)
+    : Configurable_Effect(other),
+      buffersize(1),
+      virtual_buffersize(1),
+      old_virtual_buffersize(1),
+      buffer(other.avs->framebuffer_pool.acquire(this->buffersize)),
+      in_out_pos(this->buffer),
+      frames_since_beat(0),
+      frame_delay(other.frame_delay),
+      old_frame_mem(0) {}
+
+E_VideoDelay::~E_VideoDelay() { this->avs->framebuffer_pool.release(this->buffer); }
 
 int E_VideoDelay::render(char[2][2][576],
                          int is_beat,
@@ -94,6 +107,7 @@ int E_VideoDelay::render(char[2][2][576],
         return 0;
     }
 
+    auto& pool = this->avs->framebuffer_pool;
     this->frame_mem = w * h * 4;
     if (this->config.use_beats) {
         if (is_beat) {
@@ -113,20 +127,20 @@ int E_VideoDelay::render(char[2][2][576],
         if (this->virtual_buffersize != this->old_virtual_buffersize) {
             if (this->virtual_buffersize > this->old_virtual_buffersize) {
                 if (this->virtual_buffersize > this->buffersize) {
-                    free(this->buffer);
+                    pool.release(this->buffer);
                     if (this->config.use_beats) {
                         this->buffersize = 2 * this->virtual_buffersize;
                         if (this->buffersize > this->frame_mem * 400) {
                             this->buffersize = this->frame_mem * 400;
                         }
-                        this->buffer = calloc(this->buffersize, 1);
+                        this->buffer = pool.acquire(this->buffersize);
                         if (this->buffer == NULL) {
                             this->buffersize = this->virtual_buffersize;
-                            this->buffer = calloc(this->buffersize, 1);
+                            this->buffer = pool.acquire(this->buffersize);
                         }
                     } else {
                         this->buffersize = this->virtual_buffersize;
-                        this->buffer = calloc(this->buffersize, 1);
+                        this->buffer = pool.acquire(this->buffersize);
                     }
                     this->in_out_pos = this->buffer;
                     if (this->buffer == NULL) {
@@ -167,17 +181,17 @@ int E_VideoDelay::render(char[2][2][576],
             this->old_virtual_buffersize = this->virtual_buffersize;
         }
     } else {
-        free(this->buffer);
+        pool.release(this->buffer);
         if (this->config.use_beats) {
             this->buffersize = 2 * this->virtual_buffersize;
-            this->buffer = calloc(this->buffersize, 1);
+            this->buffer = pool.acquire(this->buffersize);
             if (this->buffer == NULL) {
                 this->buffersize = this->virtual_buffersize;
-                this->buffer = calloc(this->buffersize, 1);
+                this->buffer = pool.acquire(this->buffersize);
             }
         } else {
             this->buffersize = this->virtual_buffersize;
-            this->buffer = calloc(this->buffersize, 1);
+            this->buffer = pool.acquire(this->buffersize);
         }
         this->in_out_pos = this->buffer;
         if (this->buffer == NULL) {
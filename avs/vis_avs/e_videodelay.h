@@ -14,6 +14,7 @@ struct VideoDelay_Info : public Effect_Info {
     static constexpr char const* help = "";
     static constexpr int32_t legacy_id = -1;
     static constexpr char* legacy_ape_id = "Holden04: Video Delay";
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static void on_use_beats_change(Effect*,
                                     const Parameter*,
@@ -40,6 +41,8 @@ struct VideoDelay_Info : public Effect_Info {
 class E_VideoDelay : public Configurable_Effect<VideoDelay_Info, VideoDelay_Config> {
    public:
     E_VideoDelay(AVS_Instance* avs);
+    // Copies start with an empty delay buffer of their own.
+    E_VideoDelay(const E_VideoDelay& other);
     virtual ~E_VideoDelay();
     virtual int render(char visdata[2][2][576],
                        int is_beat,
@@ -44,16 +44,130 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define GET_INT() \
     (data[pos] | (data[pos + 1] << 8) | (data[pos + 2] << 16) | (data[pos + 3] << 24))
 
-#define _R(x)         ((x) & 0xff)
-#define _G(x)         (((x)) & 0xff00)
-#define _B(x)         (((x)) & 0xff0000)
-#define _RGB(r, g, b) ((r) | ((g) & 0xff00) | ((b) & 0xff0000))
-
 E_Water::E_Water(AVS_Instance* avs)
     : Configurable_Effect(avs), lastframe(NULL), lastframe_size(0) {}
 E_Water::~E_Water() { free(this->lastframe); }
 
-static const int zero = 0;
+/* Sums up to four neighbours per channel, halves the sum (if `shift` is 1), subtracts
+   the previous frame's value and clamps. Missing neighbours at the edges are 0. */
+static inline uint32_t water_px_c(uint32_t n0,
+                                  uint32_t n1,
+                                  uint32_t n2,
+                                  uint32_t n3,
+                                  int shift,
+                                  uint32_t prev) {
+    uint32_t out = 0;
+    for (int c = 0; c < 24; c += 8) {
+        int v = ((n0 >> c) & 0xff) + ((n1 >> c) & 0xff) + ((n2 >> c) & 0xff)
+                + ((n3 >> c) & 0xff);
+        v = (v >> shift) - (int)((prev >> c) & 0xff);
+        out |= (uint32_t)(v < 0 ? 0 : (v > 255 ? 255 : v)) << c;
+    }
+    return out;
+}
+
+#ifdef SIMD_MODE_X86_SSE
+template <bool up, bool down>
+static inline void water_4px_x86v128(const uint32_t* f,
+                                     const uint32_t* last,
+                                     uint32_t* of,
+                                     int w) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i right = _mm_loadu_si128((__m128i*)&f[1]);
+    __m128i left = _mm_loadu_si128((__m128i*)&f[-1]);
+    __m128i prev = _mm_loadu_si128((__m128i*)last);
+    __m128i f_2px_lo = _mm_adds_epu16(_mm_unpacklo_epi8(right, zero),
+                                      _mm_unpacklo_epi8(left, zero));
+    __m128i f_2px_hi = _mm_adds_epu16(_mm_unpackhi_epi8(right, zero),
+                                      _mm_unpackhi_epi8(left, zero));
+    if (down) {
+        __m128i down_4px = _mm_loadu_si128((__m128i*)&f[w]);
+        f_2px_lo = _mm_adds_epu16(f_2px_lo, _mm_unpacklo_epi8(down_4px, zero));
+        f_2px_hi = _mm_adds_epu16(f_2px_hi, _mm_unpackhi_epi8(down_4px, zero));
+    }
+    if (up) {
+        __m128i up_4px = _mm_loadu_si128((__m128i*)&f[-w]);
+        f_2px_lo = _mm_adds_epu16(f_2px_lo, _mm_unpacklo_epi8(up_4px, zero));
+        f_2px_hi = _mm_adds_epu16(f_2px_hi, _mm_unpackhi_epi8(up_4px, zero));
+    }
+    f_2px_lo = _mm_srli_epi16(f_2px_lo, 1);
+    f_2px_hi = _mm_srli_epi16(f_2px_hi, 1);
+    f_2px_lo = _mm_subs_epu16(f_2px_lo, _mm_unpacklo_epi8(prev, zero));
+    f_2px_hi = _mm_subs_epu16(f_2px_hi, _mm_unpackhi_epi8(prev, zero));
+    _mm_storeu_si128((__m128i*)of, _mm_packus_epi16(f_2px_lo, f_2px_hi));
+}
+
+#ifdef __AVX2__
+template <bool up, bool down>
+static inline void water_8px_x86v256(const uint32_t* f,
+                                     const uint32_t* last,
+                                     uint32_t* of,
+                                     int w) {
+    // The unpack and pack instructions work within 128-bit lanes, so the pixel order
+    // is retained without any extra shuffling.
+    __m256i zero = _mm256_setzero_si256();
+    __m256i right = _mm256_loadu_si256((__m256i*)&f[1]);
+    __m256i left = _mm256_loadu_si256((__m256i*)&f[-1]);
+    __m256i prev = _mm256_loadu_si256((__m256i*)last);
+    __m256i f_4px_lo = _mm256_adds_epu16(_mm256_unpacklo_epi8(right, zero),
+                                         _mm256_unpacklo_epi8(left, zero));
+    __m256i f_4px_hi = _mm256_adds_epu16(_mm256_unpackhi_epi8(right, zero),
+                                         _mm256_unpackhi_epi8(left, zero));
+    if (down) {
+        __m256i down_8px = _mm256_loadu_si256((__m256i*)&f[w]);
+        f_4px_lo = _mm256_adds_epu16(f_4px_lo, _mm256_unpacklo_epi8(down_8px, zero));
+        f_4px_hi = _mm256_adds_epu16(f_4px_hi, _mm256_unpackhi_epi8(down_8px, zero));
+    }
+    if (up) {
+        __m256i up_8px = _mm256_loadu_si256((__m256i*)&f[-w]);
+        f_4px_lo = _mm256_adds_epu16(f_4px_lo, _mm256_unpacklo_epi8(up_8px, zero));
+        f_4px_hi = _mm256_adds_epu16(f_4px_hi, _mm256_unpackhi_epi8(up_8px, zero));
+    }
+    f_4px_lo = _mm256_srli_epi16(f_4px_lo, 1);
+    f_4px_hi = _mm256_srli_epi16(f_4px_hi, 1);
+    f_4px_lo = _mm256_subs_epu16(f_4px_lo, _mm256_unpacklo_epi8(prev, zero));
+    f_4px_hi = _mm256_subs_epu16(f_4px_hi, _mm256_unpackhi_epi8(prev, zero));
+    _mm256_storeu_si256((__m256i*)of, _mm256_packus_epi16(f_4px_lo, f_4px_hi));
+}
+#endif  // __AVX2__
+#endif  // SIMD_MODE_X86_SSE
+
+/* Renders one row. `up` and `down` are false for the top and bottom row respectively.
+   See the filter matrices in E_Water::smp_render() below. */
+template <bool up, bool down>
+static void water_row(const uint32_t* f, const uint32_t* last, uint32_t* of, int w) {
+    // The edge pixels are only halved if they have three neighbours, i.e. not in the
+    // corners.
+    constexpr int edge_shift = up && down ? 1 : 0;
+    of[0] = water_px_c(f[1], up ? f[-w] : 0, down ? f[w] : 0, 0, edge_shift, last[0]);
+    int x = 1;
+#ifdef SIMD_MODE_X86_SSE
+#ifdef __AVX2__
+    for (; x + 8 <= w - 1; x += 8) {
+        water_8px_x86v256<up, down>(&f[x], &last[x], &of[x], w);
+    }
+#endif
+    for (; x + 4 <= w - 1; x += 4) {
+        water_4px_x86v128<up, down>(&f[x], &last[x], &of[x], w);
+    }
+#endif
+    // Non-SIMD version, but also fills the remaining pixels at the end of each row in
+    // SIMD mode.
+    for (; x < w - 1; x++) {
+        of[x] = water_px_c(f[x - 1],
+                           f[x + 1],
+                           up ? f[x - w] : 0,
+                           down ? f[x + w] : 0,
+                           1,
+                           last[x]);
+    }
+    of[w - 1] = water_px_c(f[w - 2],
+                           up ? f[-1] : 0,
+                           down ? f[2 * w - 1] : 0,
+                           0,
+                           edge_shift,
+                           last[w - 1]);
+}
 
 int E_Water::render(char visdata[2][2][576],
                     int is_beat,
@@ -124,15 +238,6 @@ void E_Water::smp_render(int this_thread,
     of += skip_pix;
     last += skip_pix;
 
-    int at_top = 0, at_bottom = 0;
-
-    if (!this_thread) {
-        at_top = 1;
-    }
-    if (this_thread >= max_threads - 1) {
-        at_bottom = 1;
-    }
-
     /*
     Convolution filters (where p is the previous frame's value):
 
@@ -153,393 +258,22 @@ void E_Water::smp_render(int this_thread,
        1  0                0  ½  0           0  1
       -p  1          . . . ½ -p  ½ . . .     1 -p
     */
-    {
-        // top line
-        if (at_top) {
-            int x;
-
-            // left edge
-            {
-                int r = _R(f[1]);
-                int g = _G(f[1]);
-                int b = _B(f[1]);
-                r += _R(f[w]);
-                g += _G(f[w]);
-                b += _B(f[w]);
-                f++;
-
-                r -= _R(last[0]);
-                g -= _G(last[0]);
-                b -= _B(last[0]);
-                last++;
-
-                if (r < 0) {
-                    r = 0;
-                } else if (r > 255) {
-                    r = 255;
-                }
-                if (g < 0) {
-                    g = 0;
-                } else if (g > 255 * 256) {
-                    g = 255 * 256;
-                }
-                if (b < 0) {
-                    b = 0;
-                } else if (b > 255 * 65536) {
-                    b = 255 * 65536;
-                }
-                *of++ = _RGB(r, g, b);
-            }
-
-            // middle of line
-            x = (w - 2);
-            while (x--) {
-                int r = _R(f[1]);
-                int g = _G(f[1]);
-                int b = _B(f[1]);
-                r += _R(f[-1]);
-                g += _G(f[-1]);
-                b += _B(f[-1]);
-                r += _R(f[w]);
-                g += _G(f[w]);
-                b += _B(f[w]);
-                f++;
-
-                r /= 2;
-                g /= 2;
-                b /= 2;
-
-                r -= _R(last[0]);
-                g -= _G(last[0]);
-                b -= _B(last[0]);
-                last++;
-
-                if (r < 0) {
-                    r = 0;
-                } else if (r > 255) {
-                    r = 255;
-                }
-                if (g < 0) {
-                    g = 0;
-                } else if (g > 255 * 256) {
-                    g = 255 * 256;
-                }
-                if (b < 0) {
-                    b = 0;
-                } else if (b > 255 * 65536) {
-                    b = 255 * 65536;
-                }
-                *of++ = _RGB(r, g, b);
-            }
-
-            // right block
-            {
-                int r = _R(f[-1]);
-                int g = _G(f[-1]);
-                int b = _B(f[-1]);
-                r += _R(f[w]);
-                g += _G(f[w]);
-                b += _B(f[w]);
-                f++;
-
-                r -= _R(last[0]);
-                g -= _G(last[0]);
-                b -= _B(last[0]);
-                last++;
-
-                if (r < 0) {
-                    r = 0;
-                } else if (r > 255) {
-                    r = 255;
-                }
-                if (g < 0) {
-                    g = 0;
-                } else if (g > 255 * 256) {
-                    g = 255 * 256;
-                }
-                if (b < 0) {
-                    b = 0;
-                } else if (b > 255 * 65536) {
-                    b = 255 * 65536;
-                }
-                *of++ = _RGB(r, g, b);
-            }
-        }
-
-        // middle block
-        {
-            int y = outh - at_top - at_bottom;
-            while (y--) {
-                int x;
-
-                // left edge
-                {
-                    int r = _R(f[1]);
-                    int g = _G(f[1]);
-                    int b = _B(f[1]);
-                    r += _R(f[w]);
-                    g += _G(f[w]);
-                    b += _B(f[w]);
-                    r += _R(f[-w]);
-                    g += _G(f[-w]);
-                    b += _B(f[-w]);
-                    f++;
-
-                    r /= 2;
-                    g /= 2;
-                    b /= 2;
-
-                    r -= _R(last[0]);
-                    g -= _G(last[0]);
-                    b -= _B(last[0]);
-                    last++;
-
-                    if (r < 0) {
-                        r = 0;
-                    } else if (r > 255) {
-                        r = 255;
-                    }
-                    if (g < 0) {
-                        g = 0;
-                    } else if (g > 255 * 256) {
-                        g = 255 * 256;
-                    }
-                    if (b < 0) {
-                        b = 0;
-                    } else if (b > 255 * 65536) {
-                        b = 255 * 65536;
-                    }
-                    *of++ = _RGB(r, g, b);
-                }
-
-                // middle of line
-                x = (w - 2);
-#ifdef SIMD_MODE_X86_SSE
-                __m128i zero = _mm_setzero_si128();
-                while (x >= 4) {
-                    __m128i right = _mm_loadu_si128((__m128i*)&f[1]);
-                    __m128i left = _mm_loadu_si128((__m128i*)&f[-1]);
-                    __m128i down = _mm_loadu_si128((__m128i*)&f[w]);
-                    __m128i up = _mm_loadu_si128((__m128i*)&f[-w]);
-                    __m128i prev = _mm_loadu_si128((__m128i*)last);
-                    __m128i f_2px_lo = _mm_adds_epu16(_mm_unpacklo_epi8(right, zero),
-                                                      _mm_unpacklo_epi8(left, zero));
-                    __m128i f_2px_hi = _mm_adds_epu16(_mm_unpackhi_epi8(right, zero),
-                                                      _mm_unpackhi_epi8(left, zero));
-                    f_2px_lo = _mm_adds_epu16(f_2px_lo, _mm_unpacklo_epi8(down, zero));
-                    f_2px_hi = _mm_adds_epu16(f_2px_hi, _mm_unpackhi_epi8(down, zero));
-                    f_2px_lo = _mm_adds_epu16(f_2px_lo, _mm_unpacklo_epi8(up, zero));
-                    f_2px_hi = _mm_adds_epu16(f_2px_hi, _mm_unpackhi_epi8(up, zero));
-                    f_2px_lo = _mm_srli_epi16(f_2px_lo, 1);
-                    f_2px_hi = _mm_srli_epi16(f_2px_hi, 1);
-                    f_2px_lo = _mm_subs_epu16(f_2px_lo, _mm_unpacklo_epi8(prev, zero));
-                    f_2px_hi = _mm_subs_epu16(f_2px_hi, _mm_unpackhi_epi8(prev, zero));
-                    __m128i f_4x = _mm_packus_epi16(f_2px_lo, f_2px_hi);
-                    _mm_storeu_si128((__m128i*)of, f_4x);
-                    f += 4;
-                    last += 4;
-                    of += 4;
-                    x -= 4;
-                }
-#endif
-                // Non-SIMD version, but also fill remaining 2 pixels at the end of each
-                // row in SIMD mode (because 4*n width - 2 border pixels = 2 remaining).
-                while (x--) {
-                    int r = _R(f[1]);
-                    int g = _G(f[1]);
-                    int b = _B(f[1]);
-                    r += _R(f[-1]);
-                    g += _G(f[-1]);
-                    b += _B(f[-1]);
-                    r += _R(f[w]);
-                    g += _G(f[w]);
-                    b += _B(f[w]);
-                    r += _R(f[-w]);
-                    g += _G(f[-w]);
-                    b += _B(f[-w]);
-                    f++;
-
-                    r /= 2;
-                    g /= 2;
-                    b /= 2;
-
-                    r -= _R(last[0]);
-                    g -= _G(last[0]);
-                    b -= _B(last[0]);
-                    last++;
-
-                    if (r < 0) {
-                        r = 0;
-                    } else if (r > 255) {
-                        r = 255;
-                    }
-                    if (g < 0) {
-                        g = 0;
-                    } else if (g > 255 * 256) {
-                        g = 255 * 256;
-                    }
-                    if (b < 0) {
-                        b = 0;
-                    } else if (b > 255 * 65536) {
-                        b = 255 * 65536;
-                    }
-                    *of++ = _RGB(r, g, b);
-                }
-
-                // right block
-                {
-                    int r = _R(f[-1]);
-                    int g = _G(f[-1]);
-                    int b = _B(f[-1]);
-                    r += _R(f[w]);
-                    g += _G(f[w]);
-                    b += _B(f[w]);
-                    r += _R(f[-w]);
-                    g += _G(f[-w]);
-                    b += _B(f[-w]);
-                    f++;
-
-                    r /= 2;
-                    g /= 2;
-                    b /= 2;
-
-                    r -= _R(last[0]);
-                    g -= _G(last[0]);
-                    b -= _B(last[0]);
-                    last++;
-
-                    if (r < 0) {
-                        r = 0;
-                    } else if (r > 255) {
-                        r = 255;
-                    }
-                    if (g < 0) {
-                        g = 0;
-                    } else if (g > 255 * 256) {
-                        g = 255 * 256;
-                    }
-                    if (b < 0) {
-                        b = 0;
-                    } else if (b > 255 * 65536) {
-                        b = 255 * 65536;
-                    }
-                    *of++ = _RGB(r, g, b);
-                }
-            }
-        }
-        // bottom line
-        if (at_bottom) {
-            int x;
-
-            // left edge
-            {
-                int r = _R(f[1]);
-                int g = _G(f[1]);
-                int b = _B(f[1]);
-                r += _R(f[-w]);
-                g += _G(f[-w]);
-                b += _B(f[-w]);
-                f++;
-
-                r -= _R(last[0]);
-                g -= _G(last[0]);
-                b -= _B(last[0]);
-                last++;
-
-                if (r < 0) {
-                    r = 0;
-                } else if (r > 255) {
-                    r = 255;
-                }
-                if (g < 0) {
-                    g = 0;
-                } else if (g > 255 * 256) {
-                    g = 255 * 256;
-                }
-                if (b < 0) {
-                    b = 0;
-                } else if (b > 255 * 65536) {
-                    b = 255 * 65536;
-                }
-                *of++ = _RGB(r, g, b);
-            }
-
-            // middle of line
-            x = (w - 2);
-            while (x--) {
-                int r = _R(f[1]);
-                int g = _G(f[1]);
-                int b = _B(f[1]);
-                r += _R(f[-1]);
-                g += _G(f[-1]);
-                b += _B(f[-1]);
-                r += _R(f[-w]);
-                g += _G(f[-w]);
-                b += _B(f[-w]);
-                f++;
-
-                r /= 2;
-                g /= 2;
-                b /= 2;
-
-                r -= _R(last[0]);
-                g -= _G(last[0]);
-                b -= _B(last[0]);
-                last++;
-
-                if (r < 0) {
-                    r = 0;
-                } else if (r > 255) {
-                    r = 255;
-                }
-                if (g < 0) {
-                    g = 0;
-                } else if (g > 255 * 256) {
-                    g = 255 * 256;
-                }
-                if (b < 0) {
-                    b = 0;
-                } else if (b > 255 * 65536) {
-                    b = 255 * 65536;
-                }
-                *of++ = _RGB(r, g, b);
-            }
-
-            // right block
-            {
-                int r = _R(f[-1]);
-                int g = _G(f[-1]);
-                int b = _B(f[-1]);
-                r += _R(f[-w]);
-                g += _G(f[-w]);
-                b += _B(f[-w]);
-                f++;
-
-                r -= _R(last[0]);
-                g -= _G(last[0]);
-                b -= _B(last[0]);
-                last++;
-
-                if (r < 0) {
-                    r = 0;
-                } else if (r > 255) {
-                    r = 255;
-                }
-                if (g < 0) {
-                    g = 0;
-                } else if (g > 255 * 256) {
-                    g = 255 * 256;
-                }
-                if (b < 0) {
-                    b = 0;
-                } else if (b > 255 * 65536) {
-                    b = 255 * 65536;
-                }
-                *of++ = _RGB(r, g, b);
-            }
+    for (int y = start_l; y < end_l; y++) {
+        bool up = y > 0;
+        bool down = y < h - 1;
+        if (up && down) {
+            water_row<true, true>(f, last, of, w);
+        } else if (down) {
+            water_row<false, true>(f, last, of, w);
+        } else if (up) {
+            water_row<true, false>(f, last, of, w);
+        } else {
+            water_row<false, false>(f, last, of, w);
         }
+        f += w;
+        last += w;
+        of += w;
     }
-
     memcpy(this->lastframe + skip_pix, framebuffer + skip_pix, w * outh * sizeof(int));
 }
 
@@ -31,6 +31,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include "e_waterbump.h"
 
+#include <immintrin.h>
 #include <math.h>
 #include <stdlib.h>
 
@@ -135,29 +136,83 @@ void E_WaterBump::HeightBlob(int x, int y, int radius, int height, int page) {
 }
 */
 
-void E_WaterBump::CalcWater(int npage, int fluidity) {
-    int newh;
-    int count = this->buffer_w + 1;
+#ifdef SIMD_MODE_X86_SSE
+/* The heights easily exceed 16 bits with a large depth, so the simulation uses 32-bit
+   lanes, which also keeps it identical to the C version. */
+static inline void calc_water_4px_x86v128(const int* old_row,
+                                          int* new_row,
+                                          int w,
+                                          __m128i fluidity) {
+    __m128i sum = _mm_add_epi32(_mm_loadu_si128((__m128i*)&old_row[w]),
+                                _mm_loadu_si128((__m128i*)&old_row[-w]));
+    sum = _mm_add_epi32(sum, _mm_loadu_si128((__m128i*)&old_row[1]));
+    sum = _mm_add_epi32(sum, _mm_loadu_si128((__m128i*)&old_row[-1]));
+    sum = _mm_add_epi32(sum, _mm_loadu_si128((__m128i*)&old_row[-w - 1]));
+    sum = _mm_add_epi32(sum, _mm_loadu_si128((__m128i*)&old_row[-w + 1]));
+    sum = _mm_add_epi32(sum, _mm_loadu_si128((__m128i*)&old_row[w - 1]));
+    sum = _mm_add_epi32(sum, _mm_loadu_si128((__m128i*)&old_row[w + 1]));
+    __m128i newh =
+        _mm_sub_epi32(_mm_srai_epi32(sum, 2), _mm_loadu_si128((__m128i*)new_row));
+    newh = _mm_sub_epi32(newh, _mm_sra_epi32(newh, fluidity));
+    _mm_storeu_si128((__m128i*)new_row, newh);
+}
+
+#ifdef __AVX2__
+static inline void calc_water_8px_x86v256(const int* old_row,
+                                          int* new_row,
+                                          int w,
+                                          __m128i fluidity) {
+    __m256i sum = _mm256_add_epi32(_mm256_loadu_si256((__m256i*)&old_row[w]),
+                                   _mm256_loadu_si256((__m256i*)&old_row[-w]));
+    sum = _mm256_add_epi32(sum, _mm256_loadu_si256((__m256i*)&old_row[1]));
+    sum = _mm256_add_epi32(sum, _mm256_loadu_si256((__m256i*)&old_row[-1]));
+    sum = _mm256_add_epi32(sum, _mm256_loadu_si256((__m256i*)&old_row[-w - 1]));
+    sum = _mm256_add_epi32(sum, _mm256_loadu_si256((__m256i*)&old_row[-w + 1]));
+    sum = _mm256_add_epi32(sum, _mm256_loadu_si256((__m256i*)&old_row[w - 1]));
+    sum = _mm256_add_epi32(sum, _mm256_loadu_si256((__m256i*)&old_row[w + 1]));
+    __m256i newh = _mm256_sub_epi32(_mm256_srai_epi32(sum, 2),
+                                    _mm256_loadu_si256((__m256i*)new_row));
+    newh = _mm256_sub_epi32(newh, _mm256_sra_epi32(newh, fluidity));
+    _mm256_storeu_si256((__m256i*)new_row, newh);
+}
+#endif  // __AVX2__
+#endif  // SIMD_MODE_X86_SSE
 
+/* Each new height only depends on the other page's heights, so any range of rows can
+   be calculated independently of the others. The border rows and columns stay 0. */
+void E_WaterBump::CalcWater(int npage, int fluidity, int start_l, int end_l) {
+    int w = this->buffer_w;
     int* newptr = this->buffers[npage];
     int* oldptr = this->buffers[!npage];
 
-    int x, y;
-
-    for (y = (this->buffer_h - 1) * this->buffer_w; count < y; count += 2) {
-        for (x = count + this->buffer_w - 2; count < x; count++) {
+    start_l = max(start_l, 1);
+    end_l = min(end_l, this->buffer_h - 1);
+#ifdef SIMD_MODE_X86_SSE
+    __m128i fluidity_shift = _mm_cvtsi32_si128(fluidity);
+#endif
+    for (int y = start_l; y < end_l; y++) {
+        int* new_row = &newptr[y * w];
+        int* old_row = &oldptr[y * w];
+        int x = 1;
+#ifdef SIMD_MODE_X86_SSE
+#ifdef __AVX2__
+        for (; x + 8 <= w - 1; x += 8) {
+            calc_water_8px_x86v256(&old_row[x], &new_row[x], w, fluidity_shift);
+        }
+#endif
+        for (; x + 4 <= w - 1; x += 4) {
+            calc_water_4px_x86v128(&old_row[x], &new_row[x], w, fluidity_shift);
+        }
+#endif
+        for (; x < w - 1; x++) {
             // This does the eight-pixel method.  It looks much better.
+            int newh = ((old_row[x + w] + old_row[x - w] + old_row[x + 1]
+                         + old_row[x - 1] + old_row[x - w - 1] + old_row[x - w + 1]
+                         + old_row[x + w - 1] + old_row[x + w + 1])
+                        >> 2)
+                       - new_row[x];
 
-            newh = ((oldptr[count + this->buffer_w] + oldptr[count - this->buffer_w]
-                     + oldptr[count + 1] + oldptr[count - 1]
-                     + oldptr[count - this->buffer_w - 1]
-                     + oldptr[count - this->buffer_w + 1]
-                     + oldptr[count + this->buffer_w - 1]
-                     + oldptr[count + this->buffer_w + 1])
-                    >> 2)
-                   - newptr[count];
-
-            newptr[count] = newh - (newh >> fluidity);
+            new_row[x] = newh - (newh >> fluidity);
         }
     }
 }
@@ -194,12 +249,27 @@ void E_WaterBump::CalcWaterSludge(int npage, int fluidity)
 }
 */
 
-int E_WaterBump::render(char[2][2][576],
+int E_WaterBump::render(char visdata[2][2][576],
                         int is_beat,
                         int* framebuffer,
                         int* fbout,
                         int w,
                         int h) {
+    this->smp_begin(1, visdata, is_beat, framebuffer, fbout, w, h);
+    if (is_beat & 0x80000000) {
+        return 0;
+    }
+    this->smp_render(0, 1, visdata, is_beat, framebuffer, fbout, w, h);
+    return this->smp_finish(visdata, is_beat, framebuffer, fbout, w, h);
+}
+
+int E_WaterBump::smp_begin(int max_threads,
+                           char[2][2][576],
+                           int is_beat,
+                           int*,
+                           int*,
+                           int w,
+                           int h) {
     if (this->buffer_w != w || this->buffer_h != h) {
         free(this->buffers[0]);
         free(this->buffers[1]);
@@ -213,7 +283,7 @@ int E_WaterBump::render(char[2][2][576],
         this->buffer_h = h;
     }
     if (is_beat & 0x80000000) {
-        return 0;
+        return max_threads;
     }
 
     if (is_beat) {
@@ -245,7 +315,99 @@ int E_WaterBump::render(char[2][2][576],
         }
         //	HeightBlob(-1,-1,80/2,1400,this->page);
     }
+    // See displace_odd_width() below.
+    return (w & 1) ? 1 : max_threads;
+}
+
+void E_WaterBump::smp_render(int this_thread,
+                             int max_threads,
+                             char[2][2][576],
+                             int,
+                             int* framebuffer,
+                             int* fbout,
+                             int w,
+                             int h) {
+    if (max_threads < 1) {
+        max_threads = 1;
+    }
+    int start_l = (this_thread * h) / max_threads;
+    int end_l;
+    if (this_thread >= max_threads - 1) {
+        end_l = h;
+    } else {
+        end_l = ((this_thread + 1) * h) / max_threads;
+    }
+
+    // Displacement reads the current page, the simulation writes the other one. Both
+    // only ever write into their own band, so there's no need to synchronize.
+    if (w & 1) {
+        this->displace_odd_width(framebuffer, fbout);
+    } else {
+        this->displace(framebuffer, fbout, start_l, end_l);
+    }
+    this->CalcWater(!this->page, this->config.fluidity, start_l, end_l);
+}
+
+int E_WaterBump::smp_finish(char[2][2][576], int, int*, int*, int, int) {
+    this->page = !this->page;
+    return 1;
+}
+
+void E_WaterBump::displace(int* framebuffer, int* fbout, int start_l, int end_l) {
+    int w = this->buffer_w;
+    int len = this->buffer_h * w;
+    int* ptr = this->buffers[this->page];
+
+    start_l = max(start_l, 1);
+    end_l = min(end_l, this->buffer_h - 1);
+#if defined(SIMD_MODE_X86_SSE) && defined(__AVX2__)
+    __m256i len_8x = _mm256_set1_epi32(len);
+    __m256i w_8x = _mm256_set1_epi32(w);
+    __m256i minus_one_8x = _mm256_set1_epi32(-1);
+    __m256i lane_offsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+#endif
+    for (int y = start_l; y < end_l; y++) {
+        int offset = y * w + 1;
+        int row_end = y * w + w - 1;
+#if defined(SIMD_MODE_X86_SSE) && defined(__AVX2__)
+        for (; offset + 8 <= row_end; offset += 8) {
+            __m256i height = _mm256_loadu_si256((__m256i*)&ptr[offset]);
+            __m256i dx = _mm256_sub_epi32(
+                height, _mm256_loadu_si256((__m256i*)&ptr[offset + 1]));
+            __m256i dy = _mm256_sub_epi32(
+                height, _mm256_loadu_si256((__m256i*)&ptr[offset + w]));
+            __m256i ofs = _mm256_add_epi32(_mm256_set1_epi32(offset), lane_offsets);
+            ofs = _mm256_add_epi32(
+                ofs, _mm256_mullo_epi32(w_8x, _mm256_srai_epi32(dy, 3)));
+            ofs = _mm256_add_epi32(ofs, _mm256_srai_epi32(dx, 3));
+            __m256i in_range = _mm256_and_si256(_mm256_cmpgt_epi32(len_8x, ofs),
+                                                _mm256_cmpgt_epi32(ofs, minus_one_8x));
+            __m256i out = _mm256_mask_i32gather_epi32(
+                _mm256_loadu_si256((__m256i*)&framebuffer[offset]),
+                framebuffer,
+                ofs,
+                in_range,
+                sizeof(int));
+            _mm256_storeu_si256((__m256i*)&fbout[offset], out);
+        }
+#endif
+        for (; offset < row_end; offset++) {
+            int dx = ptr[offset] - ptr[offset + 1];
+            int dy = ptr[offset] - ptr[offset + w];
+            int ofs = offset + w * (dy >> 3) + (dx >> 3);
+            if ((ofs < len) && (ofs > -1)) {
+                fbout[offset] = framebuffer[ofs];
+            } else {
+                fbout[offset] = framebuffer[offset];
+            }
+        }
+    }
+}
 
+/* The original loop processes two pixels at a time and so walks off the end of each
+   row by one pixel if the width is odd, shifting all subsequent rows. Since this
+   doesn't map to row bands, it's kept as-is and run single-threaded. */
+void E_WaterBump::displace_odd_width(int* framebuffer, int* fbout) {
     int dx, dy;
     int x, y;
     int ofs, len = this->buffer_h * this->buffer_w;
@@ -276,12 +438,6 @@ int E_WaterBump::render(char[2][2][576],
             }
         }
     }
-
-    CalcWater(!this->page, this->config.fluidity);
-
-    this->page = !this->page;
-
-    return 1;
 }
 
 void E_WaterBump::load_legacy(unsigned char* data, int len) {
@@ -20,6 +20,7 @@ struct WaterBump_Info : public Effect_Info {
     static constexpr char const* help = "";
     static constexpr int32_t legacy_id = 31;
     static constexpr char const* legacy_ape_id = nullptr;
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_BEAT;
 
     static constexpr uint32_t num_parameters = 6;
     static constexpr Parameter parameters[num_parameters] = {
@@ -52,8 +53,33 @@ class E_WaterBump : public Configurable_Effect<WaterBump_Info, WaterBump_Config>
     virtual int save_legacy(unsigned char* data);
     virtual E_WaterBump* clone() { return new E_WaterBump(*this); }
 
+    virtual bool can_multithread() { return true; }
+    virtual int smp_begin(int max_threads,
+                          char visdata[2][2][576],
+                          int is_beat,
+                          int* framebuffer,
+                          int* fbout,
+                          int w,
+                          int h);
+    virtual void smp_render(int this_thread,
+                            int max_threads,
+                            char visdata[2][2][576],
+                            int is_beat,
+                            int* framebuffer,
+                            int* fbout,
+                            int w,
+                            int h);
+    virtual int smp_finish(char visdata[2][2][576],
+                           int is_beat,
+                           int* framebuffer,
+                           int* fbout,
+                           int w,
+                           int h);
+
     void SineBlob(int x, int y, int radius, int height, int page);
-    void CalcWater(int npage, int fluidity);
+    void CalcWater(int npage, int fluidity, int start_l, int end_l);
+    void displace(int* framebuffer, int* fbout, int start_l, int end_l);
+    void displace_odd_width(int* framebuffer, int* fbout);
     /*
     void CalcWaterSludge(int npage, int fluidity);
     void HeightBlob(int x, int y, int radius, int height, int page);
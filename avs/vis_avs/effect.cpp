@@ -1,5 +1,7 @@
 #include "effect.h"
 
+#include "instance.h"
+
 #include "../platform.h"  // min/max
 
 #include <stdint.h>
@@ -56,6 +58,7 @@ Effect* Effect::insert(Effect* to_insert,
     if (relative_to == this) {
         if (direction == INSERT_CHILD) {
             this->children.push_back(to_insert);
+            this->audio_dependencies_changed();
             return to_insert;
         } else {
             return NULL;
@@ -71,6 +74,7 @@ Effect* Effect::insert(Effect* to_insert,
                     (*child)->insert(to_insert, *child, direction);
                     break;
             }
+            this->audio_dependencies_changed();
             return to_insert;
         }
         Effect* subtree_result = (*child)->insert(to_insert, relative_to, direction);
@@ -90,6 +94,7 @@ Effect* Effect::lift(Effect* to_lift) {
         if (*child == to_lift) {
             lifted = *child;
             this->children.erase(child);
+            this->audio_dependencies_changed();
             break;
         } else {
             Effect* subtree_result = (*child)->lift(to_lift);
@@ -144,6 +149,7 @@ Effect* Effect::duplicate(Effect* to_duplicate) {
         if (*child == to_duplicate) {
             Effect* duplicate_ = (*child)->clone();
             this->children.insert(++child, duplicate_);
+            this->audio_dependencies_changed();
             return duplicate_;
         }
         Effect* subtree_result = (*child)->duplicate(to_duplicate);
@@ -169,6 +175,7 @@ bool Effect::is_ancestor_of(Effect* descendent) {
 void Effect::set_enabled(bool enabled) {
     this->enabled = enabled;
     this->on_enable(enabled);
+    this->audio_dependencies_changed();
 }
 
 Effect* Effect::find_by_handle(AVS_Component_Handle handle) {
@@ -187,6 +194,22 @@ Effect* Effect::find_by_handle(AVS_Component_Handle handle) {
     return NULL;
 }
 
+uint32_t Effect::audio_dependencies_with_children() {
+    uint32_t dependencies = this->audio_dependencies();
+    for (auto child : this->children) {
+        if (child->enabled) {
+            dependencies |= child->audio_dependencies_with_children();
+        }
+    }
+    return dependencies;
+}
+
+void Effect::audio_dependencies_changed() {
+    if (this->avs != nullptr) {
+        this->avs->audio_dependencies_changed();
+    }
+}
+
 const AVS_Component_Handle* Effect::get_child_handles_for_api() {
     AVS_Component_Handle* old_handles = this->child_handles_for_api;
     AVS_Component_Handle* new_handles = new AVS_Component_Handle[this->children.size()];
@@ -51,6 +51,21 @@ class Effect {
     virtual void on_enable(bool enabled) { (void)enabled; }
     Effect* find_by_handle(AVS_Component_Handle handle);
     const AVS_Component_Handle* get_child_handles_for_api();
+    /**
+     * The audio data this effect reads while rendering, as `Audio_Dependency` flags.
+     * Defaults to what the effect's info declares, effects whose dependencies vary
+     * with their config or code add to that.
+     */
+    virtual uint32_t audio_dependencies() {
+        return this->get_info()->get_audio_dependencies();
+    }
+    // The audio dependencies of this effect and all of its enabled descendants.
+    uint32_t audio_dependencies_with_children();
+    /**
+     * Tell the instance that the preset's audio dependencies may have changed, because
+     * the tree or an effect's config was edited.
+     */
+    void audio_dependencies_changed();
 
     virtual Effect* clone() = 0;
     virtual bool can_have_child_components() = 0;
@@ -251,6 +266,7 @@ class Configurable_Effect : public Effect {
         if (param->on_value_change != NULL) {
             param->on_value_change(this, param, parameter_path);
         }
+        this->audio_dependencies_changed();
         if (this->trace_parameter_changes) {
             auto prefix = trace_prefix(this->info.name, param->name, parameter_path);
             log_info("%s %s",
@@ -342,6 +358,7 @@ class Configurable_Effect : public Effect {
             if (param->on_list_add != NULL) {
                 param->on_list_add(this, param, parameter_path, before, 0);
             }
+            this->audio_dependencies_changed();
             if (this->trace_parameter_changes) {
                 auto prefix =
                     trace_prefix(this->info.name, param->name, parameter_path);
@@ -363,6 +380,9 @@ class Configurable_Effect : public Effect {
         }
         auto addr = this->get_config_address(param, parameter_path);
         bool success = param->list_move(addr, &from, &to);
+        if (success) {
+            this->audio_dependencies_changed();
+        }
         if (success && param->on_list_move != NULL) {
             param->on_list_move(this, param, parameter_path, from, to);
             if (this->trace_parameter_changes) {
@@ -386,6 +406,9 @@ class Configurable_Effect : public Effect {
         auto addr = this->get_config_address(param, parameter_path);
         bool success =
             param->list_remove(addr, param->num_child_parameters_min, &to_remove);
+        if (success) {
+            this->audio_dependencies_changed();
+        }
         if (success && param->on_list_remove != NULL) {
             param->on_list_remove(this, param, parameter_path, to_remove, 0);
             if (this->trace_parameter_changes) {
@@ -407,6 +430,7 @@ class Configurable_Effect : public Effect {
             return false;
         }
         param->on_value_change(this, param, parameter_path);
+        this->audio_dependencies_changed();
         if (this->trace_parameter_changes) {
             auto prefix = trace_prefix(this->info.name, param->name, parameter_path);
             log_info("%s triggered", prefix.c_str());
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "audio.h"
 #include "avs_editor.h"
 #include "handles.h"
 
@@ -469,6 +470,12 @@ struct Effect_Info {
     }
     virtual bool can_have_child_components() const { return false; }
     virtual bool is_createable_by_user() const { return true; }
+    /**
+     * The `Audio_Dependency` flags for the audio data the effect reads, regardless of
+     * its config. Redeclare `audio_dependencies` in effects that use any.
+     */
+    static constexpr uint32_t audio_dependencies = AUDIO_DEPENDS_NONE;
+    virtual uint32_t get_audio_dependencies() const { return AUDIO_DEPENDS_NONE; }
     const Parameter* get_parameter_from_handle(AVS_Parameter_Handle to_find) {
         return Effect_Info::_get_parameter_from_handle(
             this->get_num_parameters(), this->get_parameters(), to_find);
@@ -584,14 +591,17 @@ bool operator!=(const Effect_Info& a, const Effect_Info* b);
  */
 // Use this first one only for effects that have no parameters, i.e. only "enable".
 // Use EFFECT_INFO_GETTERS for all other effects.
-#define EFFECT_INFO_GETTERS_NO_PARAMETERS                             \
-    static constexpr AVS_Effect_Handle handle = COMPTIME_HANDLE;      \
-    virtual uint32_t get_handle() const { return this->handle; }      \
-    virtual const char* get_group() const { return this->group; }     \
-    virtual const char* get_name() const { return this->name; }       \
-    virtual const char* get_help() const { return this->help; }       \
-    virtual int32_t get_legacy_id() const { return this->legacy_id; } \
-    virtual const char* get_legacy_ape_id() const { return this->legacy_ape_id; }
+#define EFFECT_INFO_GETTERS_NO_PARAMETERS                                         \
+    static constexpr AVS_Effect_Handle handle = COMPTIME_HANDLE;                  \
+    virtual uint32_t get_handle() const { return this->handle; }                  \
+    virtual const char* get_group() const { return this->group; }                 \
+    virtual const char* get_name() const { return this->name; }                   \
+    virtual const char* get_help() const { return this->help; }                   \
+    virtual int32_t get_legacy_id() const { return this->legacy_id; }             \
+    virtual const char* get_legacy_ape_id() const { return this->legacy_ape_id; } \
+    virtual uint32_t get_audio_dependencies() const {                             \
+        return this->audio_dependencies;                                          \
+    }
 
 #define EFFECT_INFO_GETTERS                                                      \
     EFFECT_INFO_GETTERS_NO_PARAMETERS                                            \
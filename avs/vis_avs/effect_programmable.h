@@ -123,15 +123,18 @@ class Code_Section {
         this->need_recompile = false;
         return true;
     }
-    void exec(char visdata[2][2][576]) {
+    void exec() {
         if (this->code == NULL) {
             return;
         }
         lock_lock(this->code_lock);
-        AVS_EEL_IF_Execute(this->avs, this->code, visdata);
+        AVS_EEL_IF_Execute(this->code);
         lock_unlock(this->code_lock);
     }
     bool is_valid() { return this->code != NULL; }
+    uint32_t audio_dependencies() const {
+        return AVS_EEL_IF_audio_dependencies(this->code_str.c_str());
+    }
 };
 
 template <class Info_T,
@@ -233,6 +236,14 @@ class Programmable_Effect
 
     virtual void on_load() { this->need_full_recompile(); }
 
+    // Add whatever audio the effect's code reads through the EEL audio functions.
+    virtual uint32_t audio_dependencies() {
+        return Super::audio_dependencies() | this->code_init.audio_dependencies()
+               | this->code_frame.audio_dependencies()
+               | this->code_beat.audio_dependencies()
+               | this->code_point.audio_dependencies();
+    }
+
    protected:
     void swap(Programmable_Effect& other) {
         std::swap(this->vm_context, other.vm_context);
@@ -0,0 +1,327 @@
+#include "fft.h"
+
+#include <cmath>
+#include <cstring>
+#ifdef SIMD_MODE_X86_SSE
+#include <immintrin.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+Stereo_FFT::Stereo_FFT(size_t size, AVS_Spectrum_Window window) {
+    this->resize(size, window);
+}
+
+static float fft_window_value(AVS_Spectrum_Window window, size_t i, size_t size) {
+    // Periodic windows, i.e. for `size + 1` points without the last one, which is what
+    // the FFT repeats implicitly.
+    double phase = 2.0 * M_PI * (double)i / (double)size;
+    switch (window) {
+        case AVS_SPECTRUM_WINDOW_HANN: return (float)(0.5 - 0.5 * cos(phase));
+        case AVS_SPECTRUM_WINDOW_BLACKMAN_HARRIS:
+            return (float)(0.35875 - 0.48829 * cos(phase) + 0.14128 * cos(2.0 * phase)
+                           - 0.01168 * cos(3.0 * phase));
+        case AVS_SPECTRUM_WINDOW_RECTANGULAR:
+        default: return 1.0f;
+    }
+}
+
+void Stereo_FFT::resize(size_t size, AVS_Spectrum_Window window) {
+    if (size == this->fft_size && window == this->window_type) {
+        return;
+    }
+    this->fft_size = size;
+    this->window_type = window;
+    this->window.resize(size);
+    double window_sum = 0.0;
+    double window_sum_squares = 0.0;
+    for (size_t i = 0; i < size; i++) {
+        this->window[i] = fft_window_value(window, i, size);
+        window_sum += this->window[i];
+        window_sum_squares += this->window[i] * this->window[i];
+    }
+    this->equivalent_noise_bandwidth =
+        (float)((double)size * window_sum_squares / (window_sum * window_sum));
+    // A sine wave's energy is split between the positive and negative frequency bins,
+    // and the separation of the two channels halves the magnitudes once more.
+    this->normalization = (float)(2.0 / window_sum * 0.5);
+    // Stage n (n = size, size/2, ..., 2) needs the twiddles exp(-2πi * p / n) for
+    // p < n/2, that's size - 1 in total.
+    this->twiddles_re.clear();
+    this->twiddles_im.clear();
+    for (size_t n = size; n >= 2; n /= 2) {
+        for (size_t p = 0; p < n / 2; p++) {
+            double angle = -2.0 * M_PI * (double)p / (double)n;
+            this->twiddles_re.push_back((float)cos(angle));
+            this->twiddles_im.push_back((float)sin(angle));
+        }
+    }
+    for (int i = 0; i < 2; i++) {
+        this->work_re[i].resize(size);
+        this->work_im[i].resize(size);
+    }
+}
+
+/*
+ * One radix-2 decimation-in-frequency Stockham stage, with `s` sub-transforms of
+ * length `2 * m` interleaved in `x`. For each p < m and q < s:
+ *
+ *     a = x[q + s * p]
+ *     b = x[q + s * (p + m)]
+ *     y[q + s * 2p]       = a + b
+ *     y[q + s * (2p + 1)] = (a - b) * w[p]
+ */
+static void fft_stage_c(const float* x_re,
+                        const float* x_im,
+                        float* y_re,
+                        float* y_im,
+                        const float* w_re,
+                        const float* w_im,
+                        size_t m,
+                        size_t s) {
+    for (size_t p = 0; p < m; p++) {
+        for (size_t q = 0; q < s; q++) {
+            size_t a = q + s * p;
+            size_t b = q + s * (p + m);
+            float diff_re = x_re[a] - x_re[b];
+            float diff_im = x_im[a] - x_im[b];
+            y_re[q + s * 2 * p] = x_re[a] + x_re[b];
+            y_im[q + s * 2 * p] = x_im[a] + x_im[b];
+            y_re[q + s * (2 * p + 1)] = diff_re * w_re[p] - diff_im * w_im[p];
+            y_im[q + s * (2 * p + 1)] = diff_re * w_im[p] + diff_im * w_re[p];
+        }
+    }
+}
+
+#ifdef SIMD_MODE_X86_SSE
+// The first stage, with s = 1: Vectorized across p, outputs interleaved.
+static void fft_stage_first_x86v128(const float* x_re,
+                                    const float* x_im,
+                                    float* y_re,
+                                    float* y_im,
+                                    const float* w_re,
+                                    const float* w_im,
+                                    size_t m) {
+    for (size_t p = 0; p < m; p += 4) {
+        __m128 a_re = _mm_loadu_ps(&x_re[p]);
+        __m128 a_im = _mm_loadu_ps(&x_im[p]);
+        __m128 b_re = _mm_loadu_ps(&x_re[p + m]);
+        __m128 b_im = _mm_loadu_ps(&x_im[p + m]);
+        __m128 tw_re = _mm_loadu_ps(&w_re[p]);
+        __m128 tw_im = _mm_loadu_ps(&w_im[p]);
+        __m128 sum_re = _mm_add_ps(a_re, b_re);
+        __m128 sum_im = _mm_add_ps(a_im, b_im);
+        __m128 diff_re = _mm_sub_ps(a_re, b_re);
+        __m128 diff_im = _mm_sub_ps(a_im, b_im);
+        __m128 rot_re =
+            _mm_sub_ps(_mm_mul_ps(diff_re, tw_re), _mm_mul_ps(diff_im, tw_im));
+        __m128 rot_im =
+            _mm_add_ps(_mm_mul_ps(diff_re, tw_im), _mm_mul_ps(diff_im, tw_re));
+        _mm_storeu_ps(&y_re[2 * p], _mm_unpacklo_ps(sum_re, rot_re));
+        _mm_storeu_ps(&y_re[2 * p + 4], _mm_unpackhi_ps(sum_re, rot_re));
+        _mm_storeu_ps(&y_im[2 * p], _mm_unpacklo_ps(sum_im, rot_im));
+        _mm_storeu_ps(&y_im[2 * p + 4], _mm_unpackhi_ps(sum_im, rot_im));
+    }
+}
+
+// Later stages, with s >= 4: Vectorized across q, with the twiddle factor broadcast.
+static void fft_stage_x86v128(const float* x_re,
+                              const float* x_im,
+                              float* y_re,
+                              float* y_im,
+                              const float* w_re,
+                              const float* w_im,
+                              size_t m,
+                              size_t s) {
+    for (size_t p = 0; p < m; p++) {
+        __m128 tw_re = _mm_set1_ps(w_re[p]);
+        __m128 tw_im = _mm_set1_ps(w_im[p]);
+        const float* a_re = &x_re[s * p];
+        const float* a_im = &x_im[s * p];
+        const float* b_re = &x_re[s * (p + m)];
+        const float* b_im = &x_im[s * (p + m)];
+        float* sum_re = &y_re[s * 2 * p];
+        float* sum_im = &y_im[s * 2 * p];
+        float* rot_re = &y_re[s * (2 * p + 1)];
+        float* rot_im = &y_im[s * (2 * p + 1)];
+        for (size_t q = 0; q < s; q += 4) {
+            __m128 ar = _mm_loadu_ps(&a_re[q]);
+            __m128 ai = _mm_loadu_ps(&a_im[q]);
+            __m128 br = _mm_loadu_ps(&b_re[q]);
+            __m128 bi = _mm_loadu_ps(&b_im[q]);
+            __m128 diff_re = _mm_sub_ps(ar, br);
+            __m128 diff_im = _mm_sub_ps(ai, bi);
+            _mm_storeu_ps(&sum_re[q], _mm_add_ps(ar, br));
+            _mm_storeu_ps(&sum_im[q], _mm_add_ps(ai, bi));
+            _mm_storeu_ps(
+                &rot_re[q],
+                _mm_sub_ps(_mm_mul_ps(diff_re, tw_re), _mm_mul_ps(diff_im, tw_im)));
+            _mm_storeu_ps(
+                &rot_im[q],
+                _mm_add_ps(_mm_mul_ps(diff_re, tw_im), _mm_mul_ps(diff_im, tw_re)));
+        }
+    }
+}
+#endif
+
+#if defined(SIMD_MODE_X86_SSE) && defined(__AVX2__)
+// Like `fft_stage_x86v128()`, for s >= 8.
+static void fft_stage_x86v256(const float* x_re,
+                              const float* x_im,
+                              float* y_re,
+                              float* y_im,
+                              const float* w_re,
+                              const float* w_im,
+                              size_t m,
+                              size_t s) {
+    for (size_t p = 0; p < m; p++) {
+        __m256 tw_re = _mm256_set1_ps(w_re[p]);
+        __m256 tw_im = _mm256_set1_ps(w_im[p]);
+        const float* a_re = &x_re[s * p];
+        const float* a_im = &x_im[s * p];
+        const float* b_re = &x_re[s * (p + m)];
+        const float* b_im = &x_im[s * (p + m)];
+        float* sum_re = &y_re[s * 2 * p];
+        float* sum_im = &y_im[s * 2 * p];
+        float* rot_re = &y_re[s * (2 * p + 1)];
+        float* rot_im = &y_im[s * (2 * p + 1)];
+        for (size_t q = 0; q < s; q += 8) {
+            __m256 ar = _mm256_loadu_ps(&a_re[q]);
+            __m256 ai = _mm256_loadu_ps(&a_im[q]);
+            __m256 br = _mm256_loadu_ps(&b_re[q]);
+            __m256 bi = _mm256_loadu_ps(&b_im[q]);
+            __m256 diff_re = _mm256_sub_ps(ar, br);
+            __m256 diff_im = _mm256_sub_ps(ai, bi);
+            _mm256_storeu_ps(&sum_re[q], _mm256_add_ps(ar, br));
+            _mm256_storeu_ps(&sum_im[q], _mm256_add_ps(ai, bi));
+            _mm256_storeu_ps(&rot_re[q],
+                             _mm256_sub_ps(_mm256_mul_ps(diff_re, tw_re),
+                                           _mm256_mul_ps(diff_im, tw_im)));
+            _mm256_storeu_ps(&rot_im[q],
+                             _mm256_add_ps(_mm256_mul_ps(diff_re, tw_im),
+                                           _mm256_mul_ps(diff_im, tw_re)));
+        }
+    }
+}
+#endif
+
+void Stereo_FFT::transform() {
+    int in = 0;
+    size_t twiddle_offset = 0;
+    for (size_t n = this->fft_size, s = 1; n >= 2; n /= 2, s *= 2) {
+        size_t m = n / 2;
+        const float* x_re = this->work_re[in].data();
+        const float* x_im = this->work_im[in].data();
+        float* y_re = this->work_re[1 - in].data();
+        float* y_im = this->work_im[1 - in].data();
+        const float* w_re = &this->twiddles_re[twiddle_offset];
+        const float* w_im = &this->twiddles_im[twiddle_offset];
+#ifdef SIMD_MODE_X86_SSE
+        if (s == 1) {
+            fft_stage_first_x86v128(x_re, x_im, y_re, y_im, w_re, w_im, m);
+#ifdef __AVX2__
+        } else if (s >= 8) {
+            fft_stage_x86v256(x_re, x_im, y_re, y_im, w_re, w_im, m, s);
+#endif
+        } else if (s >= 4) {
+            fft_stage_x86v128(x_re, x_im, y_re, y_im, w_re, w_im, m, s);
+        } else {
+            fft_stage_c(x_re, x_im, y_re, y_im, w_re, w_im, m, s);
+        }
+#else
+        fft_stage_c(x_re, x_im, y_re, y_im, w_re, w_im, m, s);
+#endif
+        twiddle_offset += m;
+        in = 1 - in;
+    }
+    this->result = in;
+}
+
+/*
+ * With z = FFT(left + i * right), and zc[k] = conj(z[size - k]):
+ *
+ *     FFT(left)[k]  = (z[k] + zc[k]) / 2
+ *     FFT(right)[k] = (z[k] - zc[k]) / 2i
+ *
+ * The division by 2 is part of the normalization.
+ */
+static void fft_separate_c(const float* re,
+                           const float* im,
+                           float* left_out,
+                           float* right_out,
+                           size_t size,
+                           size_t first_bin,
+                           size_t end_bin,
+                           float normalization) {
+    for (size_t k = first_bin; k < end_bin; k++) {
+        size_t j = (size - k) & (size - 1);
+        float l_re = re[k] + re[j];
+        float l_im = im[k] - im[j];
+        float r_re = re[k] - re[j];
+        float r_im = im[k] + im[j];
+        left_out[k] = sqrtf(l_re * l_re + l_im * l_im) * normalization;
+        right_out[k] = sqrtf(r_re * r_re + r_im * r_im) * normalization;
+    }
+}
+
+#ifdef SIMD_MODE_X86_SSE
+static void fft_separate_x86v128(const float* re,
+                                 const float* im,
+                                 float* left_out,
+                                 float* right_out,
+                                 size_t size,
+                                 float normalization) {
+    // Bin 0 pairs with itself, bins 1 to size/2 pair with size - 1 down to size/2.
+    // size/2 is a multiple of 4, so there's no remainder.
+    fft_separate_c(re, im, left_out, right_out, size, 0, 1, normalization);
+    __m128 scale = _mm_set1_ps(normalization);
+    for (size_t k = 1; k <= size / 2; k += 4) {
+        size_t j = size - k - 3;
+        __m128 re_k = _mm_loadu_ps(&re[k]);
+        __m128 im_k = _mm_loadu_ps(&im[k]);
+        __m128 re_j = _mm_shuffle_ps(
+            _mm_loadu_ps(&re[j]), _mm_loadu_ps(&re[j]), _MM_SHUFFLE(0, 1, 2, 3));
+        __m128 im_j = _mm_shuffle_ps(
+            _mm_loadu_ps(&im[j]), _mm_loadu_ps(&im[j]), _MM_SHUFFLE(0, 1, 2, 3));
+        __m128 l_re = _mm_add_ps(re_k, re_j);
+        __m128 l_im = _mm_sub_ps(im_k, im_j);
+        __m128 r_re = _mm_sub_ps(re_k, re_j);
+        __m128 r_im = _mm_add_ps(im_k, im_j);
+        __m128 l_sq = _mm_add_ps(_mm_mul_ps(l_re, l_re), _mm_mul_ps(l_im, l_im));
+        __m128 r_sq = _mm_add_ps(_mm_mul_ps(r_re, r_re), _mm_mul_ps(r_im, r_im));
+        _mm_storeu_ps(&left_out[k], _mm_mul_ps(_mm_sqrt_ps(l_sq), scale));
+        _mm_storeu_ps(&right_out[k], _mm_mul_ps(_mm_sqrt_ps(r_sq), scale));
+    }
+}
+#endif
+
+void Stereo_FFT::magnitudes(const float* left,
+                            const float* right,
+                            float* left_out,
+                            float* right_out) {
+    float* re = this->work_re[0].data();
+    float* im = this->work_im[0].data();
+    const float* window = this->window.data();
+    for (size_t i = 0; i < this->fft_size; i++) {
+        re[i] = left[i] * window[i];
+        im[i] = right[i] * window[i];
+    }
+    this->transform();
+    re = this->work_re[this->result].data();
+    im = this->work_im[this->result].data();
+#ifdef SIMD_MODE_X86_SSE
+    fft_separate_x86v128(
+        re, im, left_out, right_out, this->fft_size, this->normalization);
+#else
+    fft_separate_c(re,
+                   im,
+                   left_out,
+                   right_out,
+                   this->fft_size,
+                   0,
+                   this->fft_size / 2 + 1,
+                   this->normalization);
+#endif
+}
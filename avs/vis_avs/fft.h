@@ -0,0 +1,63 @@
+#pragma once
+
+#include "avs.h"
+
+#include <stddef.h>
+#include <vector>
+
+/**
+ * Magnitude spectra of two real signals, usually the left and right audio channels,
+ * computed together in a single complex FFT: The left channel goes into the real part,
+ * the right channel into the imaginary part, and the two spectra are separated again
+ * using the symmetry of real-input FFTs.
+ *
+ * The FFT is a radix-2 Stockham FFT on separate real and imaginary arrays, which needs
+ * no bit-reversal pass and has contiguous inner loops that map well onto SIMD.
+ */
+class Stereo_FFT {
+   public:
+    static constexpr size_t min_size = 64;
+    static constexpr size_t max_size = 8192;
+
+    explicit Stereo_FFT(size_t size = 1024,
+                        AVS_Spectrum_Window window = AVS_SPECTRUM_WINDOW_HANN);
+    /**
+     * Prepare for `size` input samples, which must be a power of 2 between `min_size`
+     * and `max_size`. Does nothing if neither size nor window changed.
+     */
+    void resize(size_t size, AVS_Spectrum_Window window);
+    size_t size() const { return this->fft_size; }
+    // The number of output bins, from 0Hz up to and including half the sample rate.
+    size_t num_bins() const { return this->fft_size / 2 + 1; }
+    /**
+     * Calculate the windowed magnitude spectra of `size()` samples each from `left` and
+     * `right` into `num_bins()` values each in `left_out` and `right_out`. Magnitudes
+     * are normalized, so that a full-scale sine wave results in a peak of about 1.
+     */
+    void magnitudes(const float* left,
+                    const float* right,
+                    float* left_out,
+                    float* right_out);
+    /**
+     * The window's equivalent noise bandwidth in bins. The sum of the squared
+     * magnitudes of a band, divided by this, is twice the band's mean power.
+     */
+    float noise_bandwidth() const { return this->equivalent_noise_bandwidth; }
+
+   private:
+    void transform();
+
+    size_t fft_size = 0;
+    AVS_Spectrum_Window window_type = AVS_SPECTRUM_WINDOW_HANN;
+    std::vector<float> window;
+    // Twiddle factors for all stages, one after the other.
+    std::vector<float> twiddles_re;
+    std::vector<float> twiddles_im;
+    // Ping-pong buffers for the FFT stages.
+    std::vector<float> work_re[2];
+    std::vector<float> work_im[2];
+    // Which of the work buffers holds the result after `transform()`.
+    int result = 0;
+    float normalization = 1.0f;
+    float equivalent_noise_bandwidth = 1.0f;
+};
@@ -0,0 +1,149 @@
+#include "framebuffer_pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <sys/mman.h>  // madvise
+#elif defined(_WIN32)
+#include <malloc.h>  // _aligned_malloc
+#endif
+
+// Buffer sizes are rounded up to whole pages, so that slightly different requests can
+// share buffers.
+#define POOL_SIZE_GRANULARITY 4096
+#define POOL_HUGE_PAGE_SIZE   (2 * 1024 * 1024)
+
+// Each block starts with a header holding the buffer size, padded to the alignment.
+// The buffer handed out follows right after.
+#define POOL_HEADER_SIZE Framebuffer_Pool::alignment
+
+Framebuffer_Pool::Framebuffer_Pool() : lock(lock_init()) {}
+
+Framebuffer_Pool::~Framebuffer_Pool() {
+    for (auto& buffer : this->idle) {
+        Framebuffer_Pool::free_block(buffer.block);
+    }
+    lock_destroy(this->lock);
+}
+
+void* Framebuffer_Pool::allocate_block(size_t size) {
+    size_t total_size = POOL_HEADER_SIZE + size;
+    void* block = nullptr;
+#ifdef _WIN32
+    block = _aligned_malloc(total_size, Framebuffer_Pool::alignment);
+#else
+    size_t block_alignment = Framebuffer_Pool::alignment;
+#ifdef __linux__
+    if (total_size >= POOL_HUGE_PAGE_SIZE) {
+        block_alignment = POOL_HUGE_PAGE_SIZE;
+    }
+#endif
+    if (posix_memalign(&block, block_alignment, total_size) != 0) {
+        return nullptr;
+    }
+#ifdef __linux__
+    if (total_size >= POOL_HUGE_PAGE_SIZE) {
+        // Only a hint, fine to fail if transparent huge pages are disabled.
+        madvise(block, total_size, MADV_HUGEPAGE);
+    }
+#endif
+#endif
+    if (block != nullptr) {
+        *(size_t*)block = size;
+    }
+    return block;
+}
+
+void Framebuffer_Pool::free_block(void* block) {
+#ifdef _WIN32
+    _aligned_free(block);
+#else
+    free(block);
+#endif
+}
+
+void* Framebuffer_Pool::acquire(size_t size, bool zero) {
+    size_t requested_size = size;
+    size = (size + POOL_SIZE_GRANULARITY - 1) / POOL_SIZE_GRANULARITY
+           * POOL_SIZE_GRANULARITY;
+    if (size == 0) {
+        size = POOL_SIZE_GRANULARITY;
+    }
+    void* block = nullptr;
+    lock_lock(this->lock);
+    // Prefer the most recently returned buffer, it's most likely still in the cache.
+    for (size_t i = this->idle.size(); i > 0; i--) {
+        if (this->idle[i - 1].size == size) {
+            block = this->idle[i - 1].block;
+            this->idle[i - 1] = this->idle.back();
+            this->idle.pop_back();
+            break;
+        }
+    }
+    if (block == nullptr) {
+        lock_unlock(this->lock);
+        block = Framebuffer_Pool::allocate_block(size);
+        if (block == nullptr) {
+            return nullptr;
+        }
+        lock_lock(this->lock);
+        this->num_allocations++;
+        this->bytes_allocated += size;
+    }
+    this->bytes_borrowed += size;
+    lock_unlock(this->lock);
+    auto buffer = (uint8_t*)block + POOL_HEADER_SIZE;
+    if (zero) {
+        memset(buffer, 0, requested_size);
+    }
+    return buffer;
+}
+
+void Framebuffer_Pool::release(void* buffer) {
+    if (buffer == nullptr) {
+        return;
+    }
+    void* block = (uint8_t*)buffer - POOL_HEADER_SIZE;
+    size_t size = *(size_t*)block;
+    lock_lock(this->lock);
+    this->idle.push_back({block, size, this->frame});
+    this->bytes_borrowed -= size;
+    lock_unlock(this->lock);
+}
+
+void Framebuffer_Pool::free_idle(size_t index) {
+    Framebuffer_Pool::free_block(this->idle[index].block);
+    this->bytes_allocated -= this->idle[index].size;
+    this->idle[index] = this->idle.back();
+    this->idle.pop_back();
+}
+
+void Framebuffer_Pool::end_frame() {
+    lock_lock(this->lock);
+    this->frame++;
+    for (size_t i = 0; i < this->idle.size();) {
+        if (this->frame - this->idle[i].released_frame > max_idle_frames) {
+            this->free_idle(i);
+        } else {
+            i++;
+        }
+    }
+    while (this->bytes_allocated - this->bytes_borrowed > max_idle_bytes) {
+        size_t oldest = 0;
+        for (size_t i = 1; i < this->idle.size(); i++) {
+            if (this->idle[i].released_frame < this->idle[oldest].released_frame) {
+                oldest = i;
+            }
+        }
+        this->free_idle(oldest);
+    }
+    lock_unlock(this->lock);
+}
+
+Framebuffer_Pool::Stats Framebuffer_Pool::stats() {
+    lock_lock(this->lock);
+    Stats stats = {this->num_allocations, this->bytes_allocated, this->bytes_borrowed};
+    lock_unlock(this->lock);
+    return stats;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "../platform.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * A per-instance pool of large buffers, mostly full frames, for effects and the
+ * renderer to borrow and return. Returned buffers are kept around and handed out again
+ * for the same size, so that buffers which are dropped and re-created every so often,
+ * e.g. because an effect list is only enabled on beat, don't go through the heap each
+ * time. Buffers that nobody has borrowed for a while are freed at the end of a frame.
+ *
+ * All buffers are aligned to 64 bytes. Large buffers are backed by transparent huge
+ * pages where the platform supports it.
+ *
+ * Borrowing and returning is thread-safe.
+ */
+class Framebuffer_Pool {
+   public:
+    static constexpr size_t alignment = 64;
+    // Free buffers after they haven't been borrowed for this many frames.
+    static constexpr uint64_t max_idle_frames = 300;
+    /**
+     * Free the least recently returned buffers right away while more than this many
+     * bytes are idle. Buffers of sizes that aren't asked for again, like Video Delay's
+     * after the delay changed, would otherwise pile up until they're old enough.
+     */
+    static constexpr size_t max_idle_bytes = 128 * 1024 * 1024;
+
+    Framebuffer_Pool();
+    ~Framebuffer_Pool();
+    Framebuffer_Pool(const Framebuffer_Pool&) = delete;
+    Framebuffer_Pool& operator=(const Framebuffer_Pool&) = delete;
+
+    /**
+     * Borrow a buffer of at least `size` bytes. If `zero` is set, the buffer's first
+     * `size` bytes are cleared, like with calloc(). Returns `nullptr` if out of memory.
+     */
+    void* acquire(size_t size, bool zero = true);
+    // Give back a buffer from `acquire()`. `buffer` may be `nullptr`.
+    void release(void* buffer);
+    /**
+     * Call once at the end of each frame, to free buffers that went unused for long,
+     * or too many of them.
+     */
+    void end_frame();
+
+    struct Stats {
+        // Number of allocations from the heap, since creation of the pool.
+        uint64_t num_allocations;
+        // Bytes currently allocated, both borrowed and idle.
+        size_t bytes_allocated;
+        // Bytes currently borrowed.
+        size_t bytes_borrowed;
+    };
+    Stats stats();
+
+   private:
+    struct Idle_Buffer {
+        void* block;
+        size_t size;
+        uint64_t released_frame;
+    };
+    static void* allocate_block(size_t size);
+    static void free_block(void* block);
+    void free_idle(size_t index);
+
+    lock_t* lock;
+    std::vector<Idle_Buffer> idle;
+    uint64_t frame = 0;
+    uint64_t num_allocations = 0;
+    size_t bytes_allocated = 0;
+    size_t bytes_borrowed = 0;
+};
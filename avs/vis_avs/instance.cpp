@@ -10,7 +10,34 @@
 
 #include "../3rdparty/WDL-EEL2/eel2/ns-eel.h"
 
+#include <cmath>
 #include <cstdio>
+#include <cstring>
+
+// Scale a frame to a different size, nearest neighbor.
+static void resample_frame(const pixel_rgb0_8* src,
+                           size_t src_w,
+                           size_t src_h,
+                           pixel_rgb0_8* dest,
+                           size_t w,
+                           size_t h) {
+    if (src_w == w && src_h == h) {
+        memcpy(dest, src, w * h * sizeof(pixel_rgb0_8));
+        return;
+    }
+    size_t dxpos = (src_w << 16) / w;
+    size_t dypos = (src_h << 16) / h;
+    size_t ypos = 0;
+    for (size_t y = 0; y < h; y++) {
+        const pixel_rgb0_8* row = &src[src_w * (ypos >> 16)];
+        size_t xpos = 0;
+        for (size_t x = 0; x < w; x++) {
+            *dest++ = row[xpos >> 16];
+            xpos += dxpos;
+        }
+        ypos += dypos;
+    }
+}
 
 AVS_Instance::AVS_Instance(const char* base_path,
                            AVS_Audio_Source audio_source,
@@ -22,8 +49,11 @@ AVS_Instance::AVS_Instance(const char* base_path,
       root(this),
       root_secondary(this),
       transition(this),
-      render_lock(lock_init()) {
+      render_lock(lock_init()),
+      global_buffers_lock(lock_init()),
+      audio_file_lock(lock_init()) {
     make_effect_lib();
+    this->audio.beat_detection_enabled = this->beat_source == AVS_BEAT_INTERNAL;
     if (this->audio_source == AVS_AUDIO_INTERNAL) {
         this->audio.audio_in_start();
     }
@@ -33,12 +63,20 @@ AVS_Instance::~AVS_Instance() {
     if (this->audio_source == AVS_AUDIO_INTERNAL) {
         this->audio.audio_in_stop();
     }
+    delete this->audio_file;
+    lock_destroy(this->audio_file_lock);
     for (auto& effect : this->scrap) {
         delete effect;
     }
     NSEEL_VM_FreeGRAM(&this->eel_state.global_ram);
     lock_destroy(this->render_lock);
-    delete this->global_buffers;
+    for (auto& buffer : this->global_buffers) {
+        this->framebuffer_pool.release(buffer.data);
+    }
+    lock_destroy(this->global_buffers_lock);
+    this->framebuffer_pool.release(this->render_buffers[0]);
+    this->framebuffer_pool.release(this->render_buffers[1]);
+    this->framebuffer_pool.release(this->scaled_buffer);
     free(this->preset_legacy_save_buffer);
 }
 
@@ -48,45 +86,199 @@ bool AVS_Instance::render_frame(void* framebuffer,
                                 size_t width,
                                 size_t height,
                                 AVS_Pixel_Format pixel_format) {
-    this->init_global_buffers_if_needed(width, height, pixel_format);
+    uint64_t start_time_us = timer_us();
+    size_t render_width = width;
+    size_t render_height = height;
+    const Bilinear_Scaler* scaler = nullptr;
+    if (this->render_scale < AVS_Instance::render_scale_steps) {
+        const size_t half_step = AVS_Instance::render_scale_steps / 2;
+        render_width = (width * this->render_scale + half_step)
+                       / AVS_Instance::render_scale_steps;
+        render_height = (height * this->render_scale + half_step)
+                        / AVS_Instance::render_scale_steps;
+        render_width = render_width > 0 ? render_width : 1;
+        render_height = render_height > 0 ? render_height : 1;
+        this->render_scaler.resize(render_width, render_height, width, height);
+        scaler = &this->render_scaler;
+    }
     this->update_time(time_in_ms);
-    auto render_context = RenderContext(
-        width, height, pixel_format, *this->global_buffers, this->audio, framebuffer);
-    this->audio.get();
+    if (this->audio_source == AVS_AUDIO_FILE) {
+        lock_lock(this->audio_file_lock);
+        this->feed_audio_file(time_in_ms);
+        lock_unlock(this->audio_file_lock);
+    }
+    bool output_is_framebuffer = pixel_format == AVS_PIXEL_RGB0_8 && scaler == nullptr;
+    size_t frame_size = render_width * render_height * sizeof(pixel_rgb0_8);
+    this->carry_over_previous_frame(framebuffer,
+                                    width,
+                                    height,
+                                    pixel_format,
+                                    output_is_framebuffer,
+                                    render_width,
+                                    render_height);
+    this->resize_pooled_buffer(
+        this->render_buffers[1], this->render_buffer_sizes[1], frame_size);
+    bool needs_scaled_buffer = scaler != nullptr && pixel_format != AVS_PIXEL_RGB0_8;
+    this->resize_pooled_buffer(
+        this->scaled_buffer,
+        this->scaled_buffer_size,
+        needs_scaled_buffer ? width * height * sizeof(pixel_rgb0_8) : 0);
+    RenderContext render_context(
+        render_width,
+        render_height,
+        pixel_format,
+        this->audio,
+        output_is_framebuffer ? framebuffer : this->render_buffers[0],
+        this->render_buffers[1],
+        framebuffer,
+        scaler,
+        (pixel_rgb0_8*)this->scaled_buffer);
+    if (this->audio_dependencies_dirty.exchange(false)) {
+        this->audio.set_dependencies(this->root.audio_dependencies_with_children());
+    }
+    this->audio.get(this->current_time_in_ms);
     if (this->beat_source == AVS_BEAT_EXTERNAL) {
         this->audio.is_beat = is_beat;
     } else if (this->beat_source == AVS_BEAT_INTERNAL && is_beat) {
         log_warn("`is_beat` is set to true but beat_source is AVS_BEAT_INTERNAL");
     }
     this->root.render_with_context(render_context);
+    if (!output_is_framebuffer
+        && render_context.framebuffers[0].data != this->render_buffers[0]) {
+        // The next frame starts from the final one, so make it the primary buffer.
+        std::swap(this->render_buffers[0], this->render_buffers[1]);
+    }
 
     // char visdata[2][2][AUDIO_BUFFER_LEN];
     // this->root.render(
     //     visdata, is_beat, (int*)framebuffer, (int*)framebuffer, width, height);
 
+    this->framebuffer_pool.end_frame();
+    this->update_render_scale((double)(timer_us() - start_time_us) / 1000.0);
+    return true;
+}
+
+void* AVS_Instance::resize_pooled_buffer(void*& buffer,
+                                         size_t& buffer_size,
+                                         size_t size) {
+    if (buffer_size != size) {
+        this->framebuffer_pool.release(buffer);
+        buffer = size > 0 ? this->framebuffer_pool.acquire(size) : nullptr;
+        buffer_size = buffer != nullptr ? size : 0;
+    }
+    return buffer;
+}
+
+void AVS_Instance::carry_over_previous_frame(void* framebuffer,
+                                             size_t width,
+                                             size_t height,
+                                             AVS_Pixel_Format pixel_format,
+                                             bool output_is_framebuffer,
+                                             size_t render_width,
+                                             size_t render_height) {
+    auto previous = (const pixel_rgb0_8*)this->render_buffers[0];
+    if (this->previous_frame_in_output) {
+        // The output only still holds the previous frame if the caller passes the same
+        // kind of buffer again.
+        bool output_unchanged = pixel_format == AVS_PIXEL_RGB0_8
+                                && this->previous_frame_w == width
+                                && this->previous_frame_h == height;
+        previous = output_unchanged ? (const pixel_rgb0_8*)framebuffer : nullptr;
+    }
+    if (output_is_framebuffer) {
+        if (!this->previous_frame_in_output && previous != nullptr) {
+            resample_frame(previous,
+                           this->previous_frame_w,
+                           this->previous_frame_h,
+                           (pixel_rgb0_8*)framebuffer,
+                           width,
+                           height);
+        }
+        this->resize_pooled_buffer(
+            this->render_buffers[0], this->render_buffer_sizes[0], 0);
+    } else if (this->render_buffers[0] == nullptr
+               || this->previous_frame_w != render_width
+               || this->previous_frame_h != render_height) {
+        size_t frame_size = render_width * render_height * sizeof(pixel_rgb0_8);
+        auto resized = (pixel_rgb0_8*)this->framebuffer_pool.acquire(
+            frame_size, previous == nullptr);
+        if (resized != nullptr && previous != nullptr) {
+            resample_frame(previous,
+                           this->previous_frame_w,
+                           this->previous_frame_h,
+                           resized,
+                           render_width,
+                           render_height);
+        }
+        this->framebuffer_pool.release(this->render_buffers[0]);
+        this->render_buffers[0] = resized;
+        this->render_buffer_sizes[0] = resized != nullptr ? frame_size : 0;
+    }
+    this->previous_frame_w = render_width;
+    this->previous_frame_h = render_height;
+    this->previous_frame_in_output = output_is_framebuffer;
+}
+
+bool AVS_Instance::set_render_scaling(double target_frame_time_ms, double min_scale) {
+    if (!(min_scale > 0.0 && min_scale <= 1.0)) {
+        this->error = "Minimum render scale must be greater than 0 and at most 1";
+        return false;
+    }
+    if (std::isnan(target_frame_time_ms)) {
+        this->error = "Target frame time must be a number";
+        return false;
+    }
+    this->render_scale_target_ms = target_frame_time_ms;
+    this->render_scale_min = (int)(min_scale * AVS_Instance::render_scale_steps + 0.5);
+    if (this->render_scale_min < 1) {
+        this->render_scale_min = 1;
+    }
+    if (this->render_scale < this->render_scale_min) {
+        this->render_scale = this->render_scale_min;
+    }
+    this->render_scale_frame_time_ms = 0.0;
+    this->render_scale_cooldown = 0;
+    if (this->render_scale_target_ms <= 0.0) {
+        this->render_scale = AVS_Instance::render_scale_steps;
+    }
     return true;
 }
 
-void AVS_Instance::init_global_buffers_if_needed(size_t width,
-                                                 size_t height,
-                                                 AVS_Pixel_Format pixel_format) {
-    if (this->global_buffers != nullptr
-        && ((*this->global_buffers)[0].w != width
-            || (*this->global_buffers)[0].h != height
-            || (*this->global_buffers)[0].pixel_format != pixel_format)) {
-        delete this->global_buffers;
-        this->global_buffers = nullptr;
+void AVS_Instance::update_render_scale(double frame_time_ms) {
+    if (this->render_scale_target_ms <= 0.0) {
+        return;
+    }
+    // Average over the last couple of frames, to not react to single outliers.
+    if (this->render_scale_frame_time_ms <= 0.0) {
+        this->render_scale_frame_time_ms = frame_time_ms;
+    } else {
+        this->render_scale_frame_time_ms =
+            this->render_scale_frame_time_ms * 0.9 + frame_time_ms * 0.1;
     }
-    if (this->global_buffers == nullptr) {
-        this->global_buffers = new std::array<Buffer, AVS_Instance::num_global_buffers>{
-            Buffer(width, height, pixel_format),
-            Buffer(width, height, pixel_format),
-            Buffer(width, height, pixel_format),
-            Buffer(width, height, pixel_format),
-            Buffer(width, height, pixel_format),
-            Buffer(width, height, pixel_format),
-            Buffer(width, height, pixel_format),
-            Buffer(width, height, pixel_format)};
+    if (this->render_scale_cooldown > 0) {
+        this->render_scale_cooldown--;
+        return;
+    }
+    int scale = this->render_scale;
+    if (this->render_scale_frame_time_ms > this->render_scale_target_ms) {
+        if (scale > this->render_scale_min) {
+            scale--;
+        }
+    } else if (scale < AVS_Instance::render_scale_steps) {
+        // Frame time is roughly proportional to the pixel count. Only step up if the
+        // next size is expected to stay clearly below the target, otherwise the scale
+        // would oscillate between two steps.
+        double growth = (double)(scale + 1) / (double)scale;
+        if (this->render_scale_frame_time_ms * growth * growth
+            < this->render_scale_target_ms * 0.85) {
+            scale++;
+        }
+    }
+    if (scale != this->render_scale) {
+        double growth = (double)scale / (double)this->render_scale;
+        this->render_scale_frame_time_ms *= growth * growth;
+        this->render_scale = scale;
+        this->render_scale_cooldown = AVS_Instance::render_scale_cooldown_frames;
     }
 }
 
@@ -134,20 +326,132 @@ int32_t AVS_Instance::audio_set(const float* audio_left,
                                 size_t audio_length,
                                 size_t samples_per_second,
                                 int64_t end_time_samples) {
-    if (this->audio_source == AVS_AUDIO_INTERNAL) {
-        this->error = "audio_set() is not supported with AVS_AUDIO_INTERNAL";
+    if (this->audio_source != AVS_AUDIO_EXTERNAL) {
+        this->error = "audio_set() is only supported with AVS_AUDIO_EXTERNAL";
         return -1;
     }
     return this->audio.set(
         audio_left, audio_right, audio_length, samples_per_second, end_time_samples);
 }
 
+bool AVS_Instance::audio_spectrum_set(size_t fft_size, AVS_Spectrum_Window window) {
+    if (window < AVS_SPECTRUM_WINDOW_HANN || window > AVS_SPECTRUM_WINDOW_RECTANGULAR) {
+        this->error = "Unknown spectrum window";
+        return false;
+    }
+    if (!this->audio.set_spectrum(fft_size, window)) {
+        this->error = "FFT size must be a power of 2 from 64 to 8192";
+        return false;
+    }
+    return true;
+}
+
+bool AVS_Instance::audio_analysis_rate_set(size_t samples_per_second) {
+    if (!this->audio.set_analysis_rate(samples_per_second)) {
+        this->error = "Analysis rate must be from 8000 to 192000 Hz";
+        return false;
+    }
+    return true;
+}
+
+bool AVS_Instance::audio_bands_set(const double* band_edges_hz,
+                                   size_t num_bands,
+                                   double attack_ms,
+                                   double decay_ms) {
+    if (!this->audio.set_bands(band_edges_hz, num_bands, attack_ms, decay_ms)) {
+        this->error =
+            "Bands must be 1 to 16 with increasing edges, times must not be negative";
+        return false;
+    }
+    return true;
+}
+
+bool AVS_Instance::audio_presentation_offset_set(double offset_ms) {
+    if (!this->audio.set_presentation_offset(offset_ms)) {
+        this->error = "Presentation offset must be from -10000 to 10000 ms";
+        return false;
+    }
+    return true;
+}
+
+bool AVS_Instance::audio_file_set(const char* file_path) {
+    if (this->audio_source != AVS_AUDIO_FILE) {
+        this->error = "audio_file_set() is only supported with AVS_AUDIO_FILE";
+        return false;
+    }
+    bool success = true;
+    Audio_File* audio_file = nullptr;
+    if (file_path != nullptr && file_path[0] != '\0') {
+        audio_file = new Audio_File(file_path);
+        if (audio_file->error != nullptr) {
+            this->error = std::string("Cannot open audio file: ") + audio_file->error;
+            delete audio_file;
+            audio_file = nullptr;
+            success = false;
+        }
+    }
+    // The render thread may be reading from the current file, so only swap it out
+    // while it's not. Stopping the old file's decoder can take a while, do that after.
+    lock_lock(this->audio_file_lock);
+    std::swap(this->audio_file, audio_file);
+    this->audio_file_position = 0;
+    this->audio_file_realtime_start_ms = -1;
+    lock_unlock(this->audio_file_lock);
+    delete audio_file;
+    return success;
+}
+
+void AVS_Instance::feed_audio_file(int64_t time_in_ms) {
+    if (this->audio_file == nullptr) {
+        return;
+    }
+    if (time_in_ms < 0) {
+        if (this->audio_file_realtime_start_ms < 0) {
+            this->audio_file_realtime_start_ms = (int64_t)timer_ms();
+        }
+        time_in_ms = (int64_t)timer_ms() - this->audio_file_realtime_start_ms;
+    }
+    auto samples_per_second = (int64_t)this->audio_file->samples_per_second();
+    int64_t end = time_in_ms * samples_per_second / 1000;
+    if (end <= this->audio_file_position) {
+        return;
+    }
+    int64_t start = this->audio_file_position;
+    if (end - start > (int64_t)AVS_Instance::audio_file_max_feed_samples) {
+        start = end - (int64_t)AVS_Instance::audio_file_max_feed_samples;
+    }
+    auto length = (size_t)(end - start);
+    if (this->audio_file_left.size() < length) {
+        this->audio_file_left.resize(AVS_Instance::audio_file_max_feed_samples);
+        this->audio_file_right.resize(AVS_Instance::audio_file_max_feed_samples);
+    }
+    this->audio_file->read(start,
+                           this->audio_file_left.data(),
+                           this->audio_file_right.data(),
+                           length);
+    this->audio_file_samples_fed += (int64_t)length;
+    this->audio.set(this->audio_file_left.data(),
+                    this->audio_file_right.data(),
+                    length,
+                    samples_per_second,
+                    this->audio_file_samples_fed);
+    this->audio_file_position = end;
+}
+
 int32_t AVS_Instance::audio_device_count() { return 1; }
 
 const char* const* AVS_Instance::audio_device_names() { return this->audio_devices; }
 
 void AVS_Instance::audio_device_set(int32_t device) {}
 
+bool AVS_Instance::audio_device_latency_set(uint32_t latency_samples) {
+    if (!this->audio.set_input_latency(latency_samples)) {
+        this->error = "Audio device latency must be at most 8192 samples";
+        return false;
+    }
+    return true;
+}
+
 bool AVS_Instance::preset_load_file(const char* file_path, bool with_transition) {
     bool success = false;
     FILE* fp = fopen(file_path, "rb");
@@ -196,6 +500,7 @@ bool AVS_Instance::preset_load(const std::string& preset, bool with_transition)
     lock_lock(this->render_lock);
     this->root.swap(this->root_secondary);
     lock_unlock(this->render_lock);
+    this->audio_dependencies_changed();
     // this->root.print_tree();
     return true;
 }
@@ -219,6 +524,7 @@ bool AVS_Instance::preset_load_legacy(const uint8_t* preset,
         lock_lock(this->render_lock);
         this->root.swap(this->root_secondary);
         lock_unlock(this->render_lock);
+        this->audio_dependencies_changed();
         this->root.print_tree();
         return true;
     }
@@ -305,7 +611,10 @@ const uint8_t* AVS_Instance::preset_save_legacy(size_t* preset_length_out,
     return this->preset_legacy_save_buffer;
 }
 
-void AVS_Instance::clear() { this->root = E_Root(this); }
+void AVS_Instance::clear() {
+    this->root = E_Root(this);
+    this->audio_dependencies_changed();
+}
 void AVS_Instance::clear_secondary() { this->root_secondary = E_Root(this); }
 
 const char* AVS_Instance::error_str() { return this->error.c_str(); }
@@ -317,11 +626,56 @@ Effect* AVS_Instance::get_component_from_handle(AVS_Component_Handle component)
     return this->root.find_by_handle(component);
 }
 
-void* AVS_Instance::get_buffer(size_t, size_t, int32_t buffer_num, bool) {
-    if (buffer_num >= 0 && (uint32_t)buffer_num <= AVS_Instance::num_global_buffers) {
-        return (*this->global_buffers)[buffer_num].data;
+void* AVS_Instance::get_buffer(size_t w,
+                               size_t h,
+                               int32_t buffer_num,
+                               bool allocate_if_needed) {
+    if (buffer_num < 0 || (uint32_t)buffer_num >= AVS_Instance::num_global_buffers
+        || w == 0 || h == 0) {
+        return nullptr;
+    }
+    lock_lock(this->global_buffers_lock);
+    auto& buffer = this->global_buffers[buffer_num];
+    if (buffer.data == nullptr) {
+        if (allocate_if_needed) {
+            buffer.data = (pixel_rgb0_8*)this->framebuffer_pool.acquire(
+                w * h * sizeof(pixel_rgb0_8));
+            if (buffer.data != nullptr) {
+                buffer.w = w;
+                buffer.h = h;
+            }
+        }
+    } else if (buffer.w != w || buffer.h != h) {
+        // Keep the contents across resizes, scaled to the new size (nearest neighbor).
+        auto resized = (pixel_rgb0_8*)this->framebuffer_pool.acquire(
+            w * h * sizeof(pixel_rgb0_8), false);
+        if (resized != nullptr) {
+            resample_frame(buffer.data, buffer.w, buffer.h, resized, w, h);
+            buffer.w = w;
+            buffer.h = h;
+        }
+        this->framebuffer_pool.release(buffer.data);
+        buffer.data = resized;
+    }
+    void* data = buffer.data;
+    lock_unlock(this->global_buffers_lock);
+    return data;
+}
+
+void AVS_Instance::memory_stats(AVS_Memory_Stats* stats_out) {
+    size_t global_buffer_bytes = 0;
+    lock_lock(this->global_buffers_lock);
+    for (auto& buffer : this->global_buffers) {
+        if (buffer.data != nullptr) {
+            global_buffer_bytes += buffer.w * buffer.h * sizeof(pixel_rgb0_8);
+        }
     }
-    return nullptr;
+    lock_unlock(this->global_buffers_lock);
+    auto pool_stats = this->framebuffer_pool.stats();
+    stats_out->framebuffer_bytes_allocated = pool_stats.bytes_allocated;
+    stats_out->framebuffer_bytes_in_use = pool_stats.bytes_borrowed;
+    stats_out->framebuffer_num_allocations = pool_stats.num_allocations;
+    stats_out->global_buffer_bytes = global_buffer_bytes;
 }
 
 int64_t AVS_Instance::get_current_time_in_ms() { return this->current_time_in_ms; }
@@ -4,14 +4,18 @@
 #include "e_root.h"
 
 #include "audio.h"
+#include "audio_file.h"
 #include "avs.h"
 #include "avs_editor.h"
 #include "effect.h"
 #include "effect_info.h"
+#include "framebuffer_pool.h"
 #include "render_context.h"
+#include "scaler.h"
 
 #include "../platform.h"
 
+#include <atomic>
 #include <string>
 
 class AVS_Instance {
@@ -27,14 +31,24 @@ class AVS_Instance {
                       size_t width,
                       size_t height,
                       AVS_Pixel_Format pixel_format);
+    bool set_render_scaling(double target_frame_time_ms, double min_scale);
     int32_t audio_set(const float* audio_left,
                       const float* audio_right,
                       size_t audio_length,
                       size_t samples_per_second,
                       int64_t end_time_ms);
+    bool audio_spectrum_set(size_t fft_size, AVS_Spectrum_Window window);
+    bool audio_analysis_rate_set(size_t samples_per_second);
+    bool audio_bands_set(const double* band_edges_hz,
+                         size_t num_bands,
+                         double attack_ms,
+                         double decay_ms);
+    bool audio_presentation_offset_set(double offset_ms);
+    bool audio_file_set(const char* file_path);
     int32_t audio_device_count();
     const char* const* audio_device_names();
     void audio_device_set(int32_t device);
+    bool audio_device_latency_set(uint32_t latency_samples);
     bool preset_load_file(const char* file_path, bool with_transition = false);
     bool preset_load(const std::string& preset, bool with_transition = false);
     bool preset_load_legacy(const uint8_t* preset,
@@ -57,13 +71,22 @@ class AVS_Instance {
     Effect_Info* get_effect_from_handle(AVS_Effect_Handle effect);
     Effect* get_component_from_handle(AVS_Component_Handle component);
 
+    /**
+     * Return global buffer `buffer_num` with a size of `w` x `h`, or `nullptr` if
+     * it's not in use yet and `allocate_if_needed` is not set. Buffers are allocated
+     * and cleared on first use, and rescaled if the requested size differs from their
+     * current one.
+     */
     void* get_buffer(size_t w,
                      size_t h,
                      int32_t buffer_num,
                      bool allocate_if_needed = false);
-    void init_global_buffers_if_needed(size_t width,
-                                       size_t height,
-                                       AVS_Pixel_Format pixel_format);
+    void memory_stats(AVS_Memory_Stats* stats_out);
+    /**
+     * Collect the preset's audio dependencies again before the next frame. Called by
+     * effects whenever the tree or their config changes.
+     */
+    void audio_dependencies_changed() { this->audio_dependencies_dirty = true; }
 
     void update_time(int64_t time_in_ms);
 
@@ -84,6 +107,12 @@ class AVS_Instance {
     std::string error;
     const char* audio_devices[1] = {""};
 
+    /**
+     * Large buffers for effects to borrow. Needs to be declared before any effects, so
+     * that it's destroyed after them.
+     */
+    Framebuffer_Pool framebuffer_pool;
+
     E_Root root;
     /** Used for transitioning between presets. */
     E_Root root_secondary;
@@ -99,7 +128,6 @@ class AVS_Instance {
            all EEL VMs (i.e. an intra-effect shared code context) but we need separation
            per AVS instance. */
         void* global_ram;
-        char visdata[2][2][AUDIO_BUFFER_LEN];
         bool log_errors;
         const char* (*pre_compile_hook)(void* ctx, char* code, void* avs_instance);
         void (*post_compile_hook)(void* avs_instance);
@@ -120,7 +148,62 @@ class AVS_Instance {
    private:
     static constexpr char const* legacy_file_magic = "Nullsoft AVS Preset 0.2\x1a";
     static constexpr size_t num_global_buffers = 8;
-    std::array<Buffer, num_global_buffers>* global_buffers = nullptr;
+    struct Global_Buffer {
+        pixel_rgb0_8* data = nullptr;
+        size_t w = 0;
+        size_t h = 0;
+    };
+    // Effects may request global buffers from several threads at once.
+    lock_t* global_buffers_lock;
+    Global_Buffer global_buffers[num_global_buffers];
+    /**
+     * The framebuffers presets render into, unless the output buffer is used directly.
+     * The first one holds the previous frame, so it needs to be kept between frames.
+     */
+    void* render_buffers[2] = {nullptr, nullptr};
+    size_t render_buffer_sizes[2] = {0, 0};
+    /**
+     * The size of the previous frame, and whether it was rendered into the output
+     * directly instead of `render_buffers[0]`.
+     */
+    size_t previous_frame_w = 0;
+    size_t previous_frame_h = 0;
+    bool previous_frame_in_output = false;
+    /**
+     * Move the previous frame to where the next one will be rendered, scaled to the
+     * render size if that changed, so that feedback presets don't start over from
+     * black whenever the render scale or the output pixel format changes.
+     */
+    void carry_over_previous_frame(void* framebuffer,
+                                   size_t width,
+                                   size_t height,
+                                   AVS_Pixel_Format pixel_format,
+                                   bool output_is_framebuffer,
+                                   size_t render_width,
+                                   size_t render_height);
+    // The scaled-up frame, before conversion to the output pixel format.
+    void* scaled_buffer = nullptr;
+    size_t scaled_buffer_size = 0;
+    void* resize_pooled_buffer(void*& buffer, size_t& buffer_size, size_t size);
+    /**
+     * For AVS_AUDIO_FILE: Pass the file's audio up to the current frame time to
+     * `audio`. In video mode `time_in_ms` is the position in the file, in realtime mode
+     * the file plays from the first frame after it was opened. Needs `audio_file_lock`.
+     */
+    void feed_audio_file(int64_t time_in_ms);
+    // More than this at once would only overwrite itself in the audio ring.
+    static constexpr size_t audio_file_max_feed_samples = 16384;
+    // Guards `audio_file` and its playback state against `audio_file_set()`.
+    lock_t* audio_file_lock;
+    Audio_File* audio_file = nullptr;
+    // The file position up to which audio was passed on, in samples.
+    int64_t audio_file_position = 0;
+    int64_t audio_file_realtime_start_ms = -1;
+    // Keeps the time passed to `audio` monotonic, even across files.
+    int64_t audio_file_samples_fed = 0;
+    std::vector<float> audio_file_left;
+    std::vector<float> audio_file_right;
+    std::atomic<bool> audio_dependencies_dirty{true};
     std::string preset_save_buffer;
     uint8_t* preset_legacy_save_buffer = nullptr;
 
@@ -129,6 +212,23 @@ class AVS_Instance {
         AVS_TIME_MODE_REALTIME = 0,
         AVS_TIME_MODE_VIDEO = 1,
     };
+    /**
+     * Dynamic resolution scaling: The render size is a multiple of 1/16th of the output
+     * size, stepped down whenever the average frame time is above the target, and up
+     * again when the larger size is expected to fit well within it. After each step a
+     * number of frames is rendered before the next one, so that global & effect
+     * buffers don't get resized constantly.
+     */
+    static constexpr int render_scale_steps = 16;
+    static constexpr int render_scale_cooldown_frames = 30;
+    void update_render_scale(double frame_time_ms);
+    double render_scale_target_ms = 0.0;
+    int render_scale_min = render_scale_steps / 2;
+    int render_scale = render_scale_steps;
+    int render_scale_cooldown = 0;
+    double render_scale_frame_time_ms = 0.0;
+    Bilinear_Scaler render_scaler;
+
     int64_t current_time_in_ms = -1;
     int last_time_mode = AVS_TIME_MODE_UNKNOWN;
     int64_t time_mode_switch_offset = 0;
@@ -35,15 +35,13 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "../platform.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <math.h>
 
-#define SWAP(x, y, temp) \
-    (temp) = (x);        \
-    (x) = (y);           \
-    (y) = (temp)
-#define ABS(x) ((x) < 0 ? -(x) : (x))
-
-void line(uint32_t* fb,
+template <typename Blend>
+void line(const Blend& blend,
+          uint32_t* fb,
           int x1,
           int y1,
           int x2,
@@ -51,9 +49,11 @@ void line(uint32_t* fb,
           int width,
           int height,
           uint32_t color,
-          int lw) {
-    int dy = ABS(y2 - y1);
-    int dx = ABS(x2 - x1);
+          int lw,
+          int clip_top,
+          int clip_bottom) {
+    int dy = std::abs(y2 - y1);
+    int dx = std::abs(x2 - x1);
 
     if (lw < 1) {
         lw = 1;
@@ -66,8 +66,8 @@ void line(uint32_t* fb,
     {
         x1 -= lw2;
         if (x1 + lw >= 0 && x1 < width) {
-            int d = max(min(y1, y2), 0);
-            int ye = min(max(y1, y2), height - 1);
+            int d = max(max(min(y1, y2), 0), clip_top);
+            int ye = min(min(max(y1, y2), height - 1), clip_bottom);
             if (x1 < 0) {
                 lw += x1;
                 x1 = 0;
@@ -76,14 +76,9 @@ void line(uint32_t* fb,
                 lw = width - x1;
             }
             fb += d * width + x1;
-            width -= lw;
             if (lw > 0) {
                 while (d++ < ye) {
-                    int x = lw;
-                    while (x--) {
-                        blend_default_1px(&color, fb, fb);
-                        fb++;
-                    }
+                    blend.fill(color, fb, lw);
                     fb += width;
                 }
             }
@@ -93,27 +88,24 @@ void line(uint32_t* fb,
     if (y1 == y2)  // optimize horizontal draw.
     {
         y1 -= lw2;
-        if (y1 + lw >= 0 && y1 < height) {
+        if (y1 + lw >= clip_top && y1 < clip_bottom) {
             int d = max(min(x1, x2), 0);
             int xe = min(max(x1, x2), width - 1);
-            if (y1 < 0) {
-                lw += y1;
+            if (y1 < clip_top) {
+                lw -= clip_top - y1;
 
-                y1 = 0;
+                y1 = clip_top;
             }
-            if (y1 + lw >= height) {
-                lw = height - y1;
+            if (y1 + lw >= clip_bottom) {
+                lw = clip_bottom - y1;
             }
             fb += y1 * width + d;
-            width -= xe - d;
-            int y = lw;
-            while (y--) {
-                int lt = d;
-                while (lt++ < xe) {
-                    blend_default_1px(&color, fb, fb);
-                    fb++;
+            if (xe > d) {
+                int y = lw;
+                while (y--) {
+                    blend.fill(color, fb, xe - d);
+                    fb += width;
                 }
-                fb += width;
             }
         }
         return;
@@ -161,9 +153,8 @@ void line(uint32_t* fb,
 #endif
 
         if (x2 < x1) {
-            int temp;
-            SWAP(x1, x2, temp);
-            SWAP(y1, y2, temp);
+            std::swap(x1, x2);
+            std::swap(y1, y2);
         }
 
         int yincr = y2 > y1 ? 1 : -1;
@@ -193,15 +184,15 @@ void line(uint32_t* fb,
                 int yp = y1;
                 int ype = y1 + lw;
                 uint32_t* newfb = fb + offs;
-                if (yp < 0) {
-                    newfb -= yp * width;
-                    yp = 0;
+                if (yp < clip_top) {
+                    newfb += (clip_top - yp) * width;
+                    yp = clip_top;
                 }
-                if (ype > height) {
-                    ype = height;
+                if (ype > clip_bottom) {
+                    ype = clip_bottom;
                 }
                 while (yp++ < ype) {
-                    blend_default_1px(&color, fb, newfb);
+                    blend.px(color, newfb);
                     newfb += width;
                 }
                 if (d < 0) {
@@ -224,9 +215,8 @@ void line(uint32_t* fb,
     }
 #endif
         if (y2 < y1) {
-            int temp;
-            SWAP(x1, x2, temp);
-            SWAP(y1, y2, temp);
+            std::swap(x1, x2);
+            std::swap(y1, y2);
         }
 
         int yincr = (x2 > x1) ? 1 : -1;
@@ -235,7 +225,7 @@ void line(uint32_t* fb,
         int NEincr = d - dy;
         x1 -= lw2;
         int offs = y1 * width + x1;
-        if (y2 >= 0 && y1 < height) {
+        if (y2 >= 0 && y1 < clip_bottom) {
             if (y1 < 0) {
                 int v;
                 v = yincr * -y1;
@@ -247,8 +237,8 @@ void line(uint32_t* fb,
                 offs += v - y1 * width;
                 y1 = 0;
             }
-            if (y2 > height) {
-                y2 = height;
+            if (y2 > clip_bottom) {
+                y2 = clip_bottom;
             }
             while (y1 < y2) {
                 int xp = x1;
@@ -261,9 +251,8 @@ void line(uint32_t* fb,
                 if (xpe > width) {
                     xpe = width;
                 }
-                while (xp++ < xpe) {
-                    blend_default_1px(&color, fb, newfb);
-                    newfb++;
+                if (xpe > xp && y1 >= clip_top) {
+                    blend.fill(color, newfb, xpe - xp);
                 }
 
                 if (d < 0) {
@@ -279,3 +268,65 @@ void line(uint32_t* fb,
         }
     }
 }
+
+template <typename Blend>
+void line(const Blend& blend,
+          uint32_t* fb,
+          int x1,
+          int y1,
+          int x2,
+          int y2,
+          int width,
+          int height,
+          uint32_t color,
+          int lw) {
+    line(blend, fb, x1, y1, x2, y2, width, height, color, lw, 0, height);
+}
+
+#define LINE_INSTANTIATE(mode)                  \
+    template void line(const Line_Blend<mode>&, \
+                       uint32_t*,               \
+                       int,                     \
+                       int,                     \
+                       int,                     \
+                       int,                     \
+                       int,                     \
+                       int,                     \
+                       uint32_t,                \
+                       int);                    \
+    template void line(const Line_Blend<mode>&, \
+                       uint32_t*,               \
+                       int,                     \
+                       int,                     \
+                       int,                     \
+                       int,                     \
+                       int,                     \
+                       int,                     \
+                       uint32_t,                \
+                       int,                     \
+                       int,                     \
+                       int);
+LINE_INSTANTIATE(0)
+LINE_INSTANTIATE(1)
+LINE_INSTANTIATE(2)
+LINE_INSTANTIATE(3)
+LINE_INSTANTIATE(4)
+LINE_INSTANTIATE(5)
+LINE_INSTANTIATE(6)
+LINE_INSTANTIATE(7)
+LINE_INSTANTIATE(8)
+LINE_INSTANTIATE(9)
+
+void line(uint32_t* fb,
+          int x1,
+          int y1,
+          int x2,
+          int y2,
+          int width,
+          int height,
+          uint32_t color,
+          int lw) {
+    line_blend_dispatch(g_line_blend_mode, [&](const auto& blend) {
+        line(blend, fb, x1, y1, x2, y2, width, height, color, lw);
+    });
+}
@@ -1,7 +1,12 @@
+#pragma once
+
+#include "blend.h"
+
 #include <stdint.h>
 
 extern int g_line_blend_mode;
 
+// Draw a line of width `lw`, blended with the `g_line_blend_mode` setting.
 void line(uint32_t* fb,
           int x1,
           int y1,
@@ -11,3 +16,34 @@ void line(uint32_t* fb,
           int height,
           uint32_t color,
           int lw);
+
+// Same as above, with the blend mode resolved beforehand, see `line_blend_dispatch()`.
+// Instantiated for all `Line_Blend` modes.
+template <typename Blend>
+void line(const Blend& blend,
+          uint32_t* fb,
+          int x1,
+          int y1,
+          int x2,
+          int y2,
+          int width,
+          int height,
+          uint32_t color,
+          int lw);
+
+// Same as above, but only draws into rows `clip_top` to `clip_bottom - 1`, which must
+// lie within the framebuffer. Drawing a line band by band gives the same pixels as
+// drawing it at once.
+template <typename Blend>
+void line(const Blend& blend,
+          uint32_t* fb,
+          int x1,
+          int y1,
+          int x2,
+          int y2,
+          int width,
+          int height,
+          uint32_t color,
+          int lw,
+          int clip_top,
+          int clip_bottom);
@@ -471,8 +471,6 @@ static unsigned int WINAPI RenderThread(LPVOID) {
                 extern int g_dlg_w, g_dlg_h, g_dlg_fps;
 
                 lock_lock(g_single_instance->render_lock);
-                g_single_instance->init_global_buffers_if_needed(
-                    w, h, AVS_PIXEL_RGB0_8);
                 int t = g_single_instance->root.render(
                     vis_data, beat, s ? fb2 : fb, s ? fb : fb2, w, h);
                 lock_unlock(g_single_instance->render_lock);
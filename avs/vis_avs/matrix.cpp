@@ -31,6 +31,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 #include "matrix.h"
 
+#include <immintrin.h>
 #include <math.h>
 #include <string.h>  // memcpy, memset
 
@@ -85,3 +86,161 @@ void matrixApply(float* m,
     *outy = x * m[4] + y * m[5] + z * m[6] + m[7];
     *outz = x * m[8] + y * m[9] + z * m[10] + m[11];
 }
+
+static inline int32_t matrix_project_1px(const float* m,
+                                         float x,
+                                         float y,
+                                         float z,
+                                         float zoom,
+                                         float min_scale,
+                                         int w,
+                                         int h) {
+    float out_x, out_y, out_z;
+    matrixApply((float*)m, x, y, z, &out_x, &out_y, &out_z);
+    float scale = zoom / out_z;
+    if (!(scale > min_scale)) {
+        return -1;
+    }
+    int screen_x = (int)(out_x * scale) + w / 2;
+    int screen_y = (int)(out_y * scale) + h / 2;
+    if (screen_y >= 0 && screen_y < h && screen_x >= 0 && screen_x < w) {
+        return screen_y * w + screen_x;
+    }
+    return -1;
+}
+
+#ifdef SIMD_MODE_X86_SSE
+// SSE2 has no 32-bit multiply, but the low halves of the 64-bit products will do.
+static inline __m128i matrix_mullo_epi32_x86v128(__m128i a, __m128i b) {
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static inline void matrix_project_4px_x86v128(const float* m,
+                                              const float* x,
+                                              const float* y,
+                                              const float* z,
+                                              float zoom,
+                                              float min_scale,
+                                              int w,
+                                              int h,
+                                              int32_t* out) {
+    __m128 x_4x = _mm_loadu_ps(x);
+    __m128 y_4x = _mm_loadu_ps(y);
+    __m128 z_4x = _mm_loadu_ps(z);
+    // Same operation order as matrixApply().
+    __m128 out_x = _mm_add_ps(
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(x_4x, _mm_set1_ps(m[0])),
+                              _mm_mul_ps(y_4x, _mm_set1_ps(m[1]))),
+                   _mm_mul_ps(z_4x, _mm_set1_ps(m[2]))),
+        _mm_set1_ps(m[3]));
+    __m128 out_y = _mm_add_ps(
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(x_4x, _mm_set1_ps(m[4])),
+                              _mm_mul_ps(y_4x, _mm_set1_ps(m[5]))),
+                   _mm_mul_ps(z_4x, _mm_set1_ps(m[6]))),
+        _mm_set1_ps(m[7]));
+    __m128 out_z = _mm_add_ps(
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(x_4x, _mm_set1_ps(m[8])),
+                              _mm_mul_ps(y_4x, _mm_set1_ps(m[9]))),
+                   _mm_mul_ps(z_4x, _mm_set1_ps(m[10]))),
+        _mm_set1_ps(m[11]));
+    __m128 scale = _mm_div_ps(_mm_set1_ps(zoom), out_z);
+    __m128i visible = _mm_castps_si128(_mm_cmpgt_ps(scale, _mm_set1_ps(min_scale)));
+    // Out-of-range values convert to INT_MIN, and end up off-screen.
+    __m128i screen_x = _mm_add_epi32(_mm_cvttps_epi32(_mm_mul_ps(out_x, scale)),
+                                     _mm_set1_epi32(w / 2));
+    __m128i screen_y = _mm_add_epi32(_mm_cvttps_epi32(_mm_mul_ps(out_y, scale)),
+                                     _mm_set1_epi32(h / 2));
+    __m128i minus_one = _mm_set1_epi32(-1);
+    __m128i w_4x = _mm_set1_epi32(w);
+    __m128i h_4x = _mm_set1_epi32(h);
+    visible = _mm_and_si128(visible, _mm_cmpgt_epi32(screen_x, minus_one));
+    visible = _mm_and_si128(visible, _mm_cmpgt_epi32(w_4x, screen_x));
+    visible = _mm_and_si128(visible, _mm_cmpgt_epi32(screen_y, minus_one));
+    visible = _mm_and_si128(visible, _mm_cmpgt_epi32(h_4x, screen_y));
+    __m128i offset =
+        _mm_add_epi32(matrix_mullo_epi32_x86v128(screen_y, w_4x), screen_x);
+    offset = _mm_or_si128(_mm_and_si128(visible, offset),
+                          _mm_andnot_si128(visible, minus_one));
+    _mm_storeu_si128((__m128i*)out, offset);
+}
+#endif
+
+#ifdef __AVX2__
+static inline void matrix_project_8px_x86v256(const float* m,
+                                              const float* x,
+                                              const float* y,
+                                              const float* z,
+                                              float zoom,
+                                              float min_scale,
+                                              int w,
+                                              int h,
+                                              int32_t* out) {
+    __m256 x_8x = _mm256_loadu_ps(x);
+    __m256 y_8x = _mm256_loadu_ps(y);
+    __m256 z_8x = _mm256_loadu_ps(z);
+    // Same operation order as matrixApply(), and no FMA, which would round differently.
+    __m256 out_x = _mm256_add_ps(
+        _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x_8x, _mm256_set1_ps(m[0])),
+                                    _mm256_mul_ps(y_8x, _mm256_set1_ps(m[1]))),
+                      _mm256_mul_ps(z_8x, _mm256_set1_ps(m[2]))),
+        _mm256_set1_ps(m[3]));
+    __m256 out_y = _mm256_add_ps(
+        _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x_8x, _mm256_set1_ps(m[4])),
+                                    _mm256_mul_ps(y_8x, _mm256_set1_ps(m[5]))),
+                      _mm256_mul_ps(z_8x, _mm256_set1_ps(m[6]))),
+        _mm256_set1_ps(m[7]));
+    __m256 out_z = _mm256_add_ps(
+        _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x_8x, _mm256_set1_ps(m[8])),
+                                    _mm256_mul_ps(y_8x, _mm256_set1_ps(m[9]))),
+                      _mm256_mul_ps(z_8x, _mm256_set1_ps(m[10]))),
+        _mm256_set1_ps(m[11]));
+    __m256 scale = _mm256_div_ps(_mm256_set1_ps(zoom), out_z);
+    __m256i visible = _mm256_castps_si256(
+        _mm256_cmp_ps(scale, _mm256_set1_ps(min_scale), _CMP_GT_OQ));
+    __m256i screen_x = _mm256_add_epi32(
+        _mm256_cvttps_epi32(_mm256_mul_ps(out_x, scale)), _mm256_set1_epi32(w / 2));
+    __m256i screen_y = _mm256_add_epi32(
+        _mm256_cvttps_epi32(_mm256_mul_ps(out_y, scale)), _mm256_set1_epi32(h / 2));
+    __m256i minus_one = _mm256_set1_epi32(-1);
+    __m256i w_8x = _mm256_set1_epi32(w);
+    __m256i h_8x = _mm256_set1_epi32(h);
+    visible = _mm256_and_si256(visible, _mm256_cmpgt_epi32(screen_x, minus_one));
+    visible = _mm256_and_si256(visible, _mm256_cmpgt_epi32(w_8x, screen_x));
+    visible = _mm256_and_si256(visible, _mm256_cmpgt_epi32(screen_y, minus_one));
+    visible = _mm256_and_si256(visible, _mm256_cmpgt_epi32(h_8x, screen_y));
+    __m256i offset = _mm256_add_epi32(_mm256_mullo_epi32(screen_y, w_8x), screen_x);
+    offset = _mm256_blendv_epi8(minus_one, offset, visible);
+    _mm256_storeu_si256((__m256i*)out, offset);
+}
+#endif
+
+void matrixProject(const float* m,
+                   const float* x,
+                   const float* y,
+                   const float* z,
+                   int n,
+                   float zoom,
+                   float min_scale,
+                   int w,
+                   int h,
+                   int32_t* out) {
+    int i = 0;
+#ifdef __AVX2__
+    for (; i + 8 <= n; i += 8) {
+        matrix_project_8px_x86v256(
+            m, &x[i], &y[i], &z[i], zoom, min_scale, w, h, &out[i]);
+    }
+#endif
+#ifdef SIMD_MODE_X86_SSE
+    for (; i + 4 <= n; i += 4) {
+        matrix_project_4px_x86v128(
+            m, &x[i], &y[i], &z[i], zoom, min_scale, w, h, &out[i]);
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = matrix_project_1px(m, x[i], y[i], z[i], zoom, min_scale, w, h);
+    }
+}
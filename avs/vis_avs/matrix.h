@@ -1,3 +1,7 @@
+#pragma once
+
+#include <stdint.h>
+
 void matrixRotate(float matrix[], char m, float Deg);
 void matrixTranslate(float m[], float x, float y, float z);
 void matrixMultiply(float* dest, float src[]);
@@ -8,3 +12,18 @@ void matrixApply(float* m,
                  float* outx,
                  float* outy,
                  float* outz);
+
+/* Transform the `n` points (`x[i]`, `y[i]`, `z[i]`) by `m`, and project them onto a
+   `w`x`h` screen with the perspective scale `zoom / z`. Each point's framebuffer offset
+   is written to `out[i]`, or -1 if the point is off-screen or its scale isn't greater
+   than `min_scale`. Equivalent to matrixApply() per point. */
+void matrixProject(const float* m,
+                   const float* x,
+                   const float* y,
+                   const float* z,
+                   int n,
+                   float zoom,
+                   float min_scale,
+                   int w,
+                   int h,
+                   int32_t* out);
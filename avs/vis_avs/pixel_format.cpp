@@ -0,0 +1,304 @@
+#include "pixel_format.h"
+
+#include <string.h>  // memcpy
+
+#include <immintrin.h>
+
+size_t pixel_format_frame_size(AVS_Pixel_Format pixel_format, size_t w, size_t h) {
+    size_t chroma_size = ((w + 1) / 2) * ((h + 1) / 2);
+    switch (pixel_format) {
+        case AVS_PIXEL_I420:
+        case AVS_PIXEL_NV12: return w * h + 2 * chroma_size;
+        default:
+        case AVS_PIXEL_RGB0_8:
+        case AVS_PIXEL_BGRA_8:
+        case AVS_PIXEL_RGBA_8: return w * h * sizeof(pixel_rgb0_8);
+    }
+}
+
+/* RGBA */
+
+static void convert_row_bgra_8_c(const pixel_rgb0_8* src, uint32_t* dest, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        dest[i] = src[i] | 0xff000000;
+    }
+}
+
+static void convert_row_rgba_8_c(const pixel_rgb0_8* src, uint32_t* dest, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        pixel_rgb0_8 px = src[i];
+        dest[i] =
+            ((px >> 16) & 0xff) | (px & 0xff00) | ((px & 0xff) << 16) | 0xff000000;
+    }
+}
+
+#ifdef SIMD_MODE_X86_SSE
+static void convert_row_bgra_8_x86v128(const pixel_rgb0_8* src,
+                                       uint32_t* dest,
+                                       size_t n) {
+    const __m128i alpha = _mm_set1_epi32((int32_t)0xff000000);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i px = _mm_loadu_si128((const __m128i*)&src[i]);
+        _mm_storeu_si128((__m128i*)&dest[i], _mm_or_si128(px, alpha));
+    }
+    convert_row_bgra_8_c(&src[i], &dest[i], n - i);
+}
+
+static void convert_row_rgba_8_x86v128(const pixel_rgb0_8* src,
+                                       uint32_t* dest,
+                                       size_t n) {
+    const __m128i alpha = _mm_set1_epi32((int32_t)0xff000000);
+    const __m128i swap_r_b =
+        _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i px = _mm_loadu_si128((const __m128i*)&src[i]);
+        px = _mm_shuffle_epi8(px, swap_r_b);
+        _mm_storeu_si128((__m128i*)&dest[i], _mm_or_si128(px, alpha));
+    }
+    convert_row_rgba_8_c(&src[i], &dest[i], n - i);
+}
+#endif
+
+/* YUV */
+
+// BT.709 in limited ("TV") range, with 8 bits of fixed-point precision. Luma is
+// computed per pixel. Chroma is computed from the sum of each 2x2 block of pixels,
+// hence the additional 2 bits of shift. The coefficients are in pixel_rgb0_8's memory
+// order: B, G, R.
+#define Y_B 16
+#define Y_G 157
+#define Y_R 47
+#define U_B 112
+#define U_G (-86)
+#define U_R (-26)
+#define V_B (-10)
+#define V_G (-102)
+#define V_R 112
+
+static void convert_row_y_c(const pixel_rgb0_8* src, uint8_t* dest, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        int32_t b = src[i] & 0xff;
+        int32_t g = (src[i] >> 8) & 0xff;
+        int32_t r = (src[i] >> 16) & 0xff;
+        dest[i] = (uint8_t)(((Y_B * b + Y_G * g + Y_R * r + 128) >> 8) + 16);
+    }
+}
+
+// Write `n` chroma samples computed from rows `src0` and `src1` into `dest_u` and
+// `dest_v`, each `stride` bytes apart (1 for planar, 2 for interleaved). The last
+// column is repeated if the row width `w` is odd.
+static void convert_row_uv_c(const pixel_rgb0_8* src0,
+                             const pixel_rgb0_8* src1,
+                             size_t w,
+                             size_t first,
+                             size_t n,
+                             uint8_t* dest_u,
+                             uint8_t* dest_v,
+                             size_t stride) {
+    for (size_t i = first; i < first + n; i++) {
+        size_t x0 = i * 2;
+        size_t x1 = x0 + 1 < w ? x0 + 1 : x0;
+        pixel_rgb0_8 px[4] = {src0[x0], src0[x1], src1[x0], src1[x1]};
+        int32_t b = 0;
+        int32_t g = 0;
+        int32_t r = 0;
+        for (auto p : px) {
+            b += p & 0xff;
+            g += (p >> 8) & 0xff;
+            r += (p >> 16) & 0xff;
+        }
+        int32_t u = ((U_B * b + U_G * g + U_R * r + 512) >> 10) + 128;
+        int32_t v = ((V_B * b + V_G * g + V_R * r + 512) >> 10) + 128;
+        dest_u[i * stride] = (uint8_t)u;
+        dest_v[i * stride] = (uint8_t)v;
+    }
+}
+
+#ifdef SIMD_MODE_X86_SSE
+static void convert_row_y_x86v128(const pixel_rgb0_8* src, uint8_t* dest, size_t n) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i coeffs = _mm_setr_epi16(Y_B, Y_G, Y_R, 0, Y_B, Y_G, Y_R, 0);
+    const __m128i round = _mm_set1_epi32(128);
+    const __m128i offset = _mm_set1_epi16(16);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i px0 = _mm_loadu_si128((const __m128i*)&src[i]);
+        __m128i px1 = _mm_loadu_si128((const __m128i*)&src[i + 4]);
+        // madd leaves B*cb+G*cg and R*cr for each pixel, hadd sums the two up.
+        __m128i y0 = _mm_hadd_epi32(
+            _mm_madd_epi16(_mm_unpacklo_epi8(px0, zero), coeffs),
+            _mm_madd_epi16(_mm_unpackhi_epi8(px0, zero), coeffs));
+        __m128i y1 = _mm_hadd_epi32(
+            _mm_madd_epi16(_mm_unpacklo_epi8(px1, zero), coeffs),
+            _mm_madd_epi16(_mm_unpackhi_epi8(px1, zero), coeffs));
+        y0 = _mm_srli_epi32(_mm_add_epi32(y0, round), 8);
+        y1 = _mm_srli_epi32(_mm_add_epi32(y1, round), 8);
+        __m128i y = _mm_add_epi16(_mm_packs_epi32(y0, y1), offset);
+        _mm_storel_epi64((__m128i*)&dest[i], _mm_packus_epi16(y, y));
+    }
+    convert_row_y_c(&src[i], &dest[i], n - i);
+}
+
+// Sum up 2x2 blocks of 4 pixels from each of two rows, into 16-bit B, G, R, 0 for each
+// of the 2 blocks.
+static inline __m128i convert_sum_2x2_x86v128(__m128i row0, __m128i row1) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i left = _mm_add_epi16(_mm_unpacklo_epi8(row0, zero),
+                                 _mm_unpacklo_epi8(row1, zero));
+    __m128i right = _mm_add_epi16(_mm_unpackhi_epi8(row0, zero),
+                                  _mm_unpackhi_epi8(row1, zero));
+    left = _mm_add_epi16(left, _mm_srli_si128(left, 8));
+    right = _mm_add_epi16(right, _mm_srli_si128(right, 8));
+    return _mm_unpacklo_epi64(left, right);
+}
+
+static void convert_row_uv_x86v128(const pixel_rgb0_8* src0,
+                                   const pixel_rgb0_8* src1,
+                                   size_t w,
+                                   size_t n,
+                                   uint8_t* dest_u,
+                                   uint8_t* dest_v,
+                                   size_t stride) {
+    const __m128i coeffs_u = _mm_setr_epi16(U_B, U_G, U_R, 0, U_B, U_G, U_R, 0);
+    const __m128i coeffs_v = _mm_setr_epi16(V_B, V_G, V_R, 0, V_B, V_G, V_R, 0);
+    const __m128i round = _mm_set1_epi32(512);
+    const __m128i offset = _mm_set1_epi32(128);
+    size_t i = 0;
+    // Whole blocks of 8 pixels only, the odd last column is left to the C version.
+    for (; (i + 4) * 2 <= w; i += 4) {
+        const pixel_rgb0_8* p0 = &src0[i * 2];
+        const pixel_rgb0_8* p1 = &src1[i * 2];
+        __m128i sum01 = convert_sum_2x2_x86v128(_mm_loadu_si128((const __m128i*)p0),
+                                                _mm_loadu_si128((const __m128i*)p1));
+        __m128i sum23 =
+            convert_sum_2x2_x86v128(_mm_loadu_si128((const __m128i*)&p0[4]),
+                                    _mm_loadu_si128((const __m128i*)&p1[4]));
+        __m128i u = _mm_hadd_epi32(_mm_madd_epi16(sum01, coeffs_u),
+                                   _mm_madd_epi16(sum23, coeffs_u));
+        __m128i v = _mm_hadd_epi32(_mm_madd_epi16(sum01, coeffs_v),
+                                   _mm_madd_epi16(sum23, coeffs_v));
+        u = _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(u, round), 10), offset);
+        v = _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(v, round), 10), offset);
+        __m128i uv = _mm_packs_epi32(u, v);
+        uv = _mm_packus_epi16(uv, uv);  // U0 U1 U2 U3 V0 V1 V2 V3
+        if (stride == 2) {
+            uv = _mm_unpacklo_epi8(uv, _mm_srli_si128(uv, 4));
+            _mm_storel_epi64((__m128i*)&dest_u[i * 2], uv);
+        } else {
+            int32_t u4 = _mm_cvtsi128_si32(uv);
+            int32_t v4 = _mm_cvtsi128_si32(_mm_srli_si128(uv, 4));
+            memcpy(&dest_u[i], &u4, sizeof(u4));
+            memcpy(&dest_v[i], &v4, sizeof(v4));
+        }
+    }
+    convert_row_uv_c(src0, src1, w, i, n - i, dest_u, dest_v, stride);
+}
+#endif
+
+static void convert_rows_yuv(const pixel_rgb0_8* src,
+                             uint8_t* dest,
+                             bool interleaved_uv,
+                             size_t w,
+                             size_t h,
+                             size_t first_chroma_row,
+                             size_t end_chroma_row) {
+    size_t chroma_w = (w + 1) / 2;
+    size_t chroma_h = (h + 1) / 2;
+    uint8_t* plane_y = dest;
+    uint8_t* plane_u = dest + w * h;
+    uint8_t* plane_v = interleaved_uv ? plane_u + 1 : plane_u + chroma_w * chroma_h;
+    size_t stride = interleaved_uv ? 2 : 1;
+    for (size_t cy = first_chroma_row; cy < end_chroma_row; cy++) {
+        size_t y0 = cy * 2;
+        size_t y1 = y0 + 1 < h ? y0 + 1 : y0;
+        const pixel_rgb0_8* row0 = &src[y0 * w];
+        const pixel_rgb0_8* row1 = &src[y1 * w];
+        uint8_t* row_u = &plane_u[cy * chroma_w * stride];
+        uint8_t* row_v = &plane_v[cy * chroma_w * stride];
+#ifdef SIMD_MODE_X86_SSE
+        convert_row_y_x86v128(row0, &plane_y[y0 * w], w);
+        if (y1 != y0) {
+            convert_row_y_x86v128(row1, &plane_y[y1 * w], w);
+        }
+        convert_row_uv_x86v128(row0, row1, w, chroma_w, row_u, row_v, stride);
+#else
+        convert_row_y_c(row0, &plane_y[y0 * w], w);
+        if (y1 != y0) {
+            convert_row_y_c(row1, &plane_y[y1 * w], w);
+        }
+        convert_row_uv_c(row0, row1, w, 0, chroma_w, row_u, row_v, stride);
+#endif
+    }
+}
+
+void pixel_format_band_rows(AVS_Pixel_Format pixel_format,
+                            size_t h,
+                            int this_thread,
+                            int max_threads,
+                            size_t* first_row,
+                            size_t* end_row) {
+    // YUV formats are split on pairs of rows, since they share their chroma rows.
+    bool is_yuv = pixel_format == AVS_PIXEL_I420 || pixel_format == AVS_PIXEL_NV12;
+    size_t num_rows = is_yuv ? (h + 1) / 2 : h;
+    size_t first = this_thread * num_rows / max_threads;
+    size_t end = this_thread >= max_threads - 1
+                     ? num_rows
+                     : (this_thread + 1) * num_rows / max_threads;
+    *first_row = is_yuv ? first * 2 : first;
+    *end_row = is_yuv ? (end * 2 < h ? end * 2 : h) : end;
+}
+
+void convert_rgb0_8_rows(const pixel_rgb0_8* src,
+                         void* dest,
+                         AVS_Pixel_Format dest_pixel_format,
+                         size_t w,
+                         size_t h,
+                         size_t first_row,
+                         size_t end_row) {
+    if (dest_pixel_format == AVS_PIXEL_I420 || dest_pixel_format == AVS_PIXEL_NV12) {
+        convert_rows_yuv(src,
+                         (uint8_t*)dest,
+                         dest_pixel_format == AVS_PIXEL_NV12,
+                         w,
+                         h,
+                         first_row / 2,
+                         (end_row + 1) / 2);
+        return;
+    }
+    const pixel_rgb0_8* src_rows = &src[first_row * w];
+    uint32_t* dest_rows = &((uint32_t*)dest)[first_row * w];
+    size_t n = (end_row - first_row) * w;
+    switch (dest_pixel_format) {
+        default:
+        case AVS_PIXEL_RGB0_8:
+            memcpy(dest_rows, src_rows, n * sizeof(pixel_rgb0_8));
+            break;
+#ifdef SIMD_MODE_X86_SSE
+        case AVS_PIXEL_BGRA_8:
+            convert_row_bgra_8_x86v128(src_rows, dest_rows, n);
+            break;
+        case AVS_PIXEL_RGBA_8:
+            convert_row_rgba_8_x86v128(src_rows, dest_rows, n);
+            break;
+#else
+        case AVS_PIXEL_BGRA_8: convert_row_bgra_8_c(src_rows, dest_rows, n); break;
+        case AVS_PIXEL_RGBA_8: convert_row_rgba_8_c(src_rows, dest_rows, n); break;
+#endif
+    }
+}
+
+void convert_rgb0_8_frame(const pixel_rgb0_8* src,
+                          void* dest,
+                          AVS_Pixel_Format dest_pixel_format,
+                          size_t w,
+                          size_t h,
+                          int this_thread,
+                          int max_threads) {
+    size_t first_row;
+    size_t end_row;
+    pixel_format_band_rows(
+        dest_pixel_format, h, this_thread, max_threads, &first_row, &end_row);
+    convert_rgb0_8_rows(src, dest, dest_pixel_format, w, h, first_row, end_row);
+}
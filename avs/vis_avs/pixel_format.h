@@ -2,6 +2,7 @@
 
 #include "avs.h"
 
+#include <stddef.h>
 #include <stdint.h>
 
 typedef uint32_t pixel_rgb0_8;
@@ -29,6 +30,49 @@ inline size_t pixel_size(AVS_Pixel_Format pixel_format) {
 }
 */
 
+/**
+ * The size in bytes of a whole frame of `w` x `h` pixels in `pixel_format`. This may be
+ * any of the output formats, not just the ones effects render in.
+ */
+size_t pixel_format_frame_size(AVS_Pixel_Format pixel_format, size_t w, size_t h);
+
+/**
+ * Convert a whole frame `src` of `w` x `h` internal RGB0_8 pixels into `dest`, in
+ * `dest_pixel_format`. The frame may be converted in parts by multiple threads, pass
+ * each thread's number as `this_thread` and the total number of threads as
+ * `max_threads`.
+ */
+void convert_rgb0_8_frame(const pixel_rgb0_8* src,
+                          void* dest,
+                          AVS_Pixel_Format dest_pixel_format,
+                          size_t w,
+                          size_t h,
+                          int this_thread = 0,
+                          int max_threads = 1);
+
+/**
+ * The rows `first_row` up to (excluding) `end_row` of a frame of height `h` that thread
+ * number `this_thread` of `max_threads` handles when converting to `pixel_format`.
+ */
+void pixel_format_band_rows(AVS_Pixel_Format pixel_format,
+                            size_t h,
+                            int this_thread,
+                            int max_threads,
+                            size_t* first_row,
+                            size_t* end_row);
+
+/**
+ * Convert rows `first_row` up to (excluding) `end_row` of `src` into `dest`, like
+ * `convert_rgb0_8_frame()`. For YUV formats `first_row` must be even.
+ */
+void convert_rgb0_8_rows(const pixel_rgb0_8* src,
+                         void* dest,
+                         AVS_Pixel_Format dest_pixel_format,
+                         size_t w,
+                         size_t h,
+                         size_t first_row,
+                         size_t end_row);
+
 #define AVS_PIXEL_COLOR_MASK_RGB0_8 0x00ffffff
 // #define AVS_PIXEL_COLOR_MASK_ARGB_8 0x00ffffff
 // #define AVS_PIXEL_COLOR_MASK_RGB0_10 0x3fffffff
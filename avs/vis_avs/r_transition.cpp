@@ -64,11 +64,12 @@ uint32_t Transition::init_thread_func(void* p) {
     if (transition->config.preinit_low_priority) {
         thread_decrease_priority(thread_current());
     }
-    int* fb = (int*)calloc(transition->last_w * transition->last_h, sizeof(int));
+    auto fb = (int*)transition->avs->framebuffer_pool.acquire(
+        transition->last_w * transition->last_h * sizeof(int));
     char last_visdata[2][2][576] = {{{0}}};
     transition->avs->root_secondary.render(
         last_visdata, (int)0x80000000, fb, fb, transition->last_w, transition->last_h);
-    free(fb);
+    transition->avs->framebuffer_pool.release(fb);
 
     transition->transition_flags = TRANSITION_NORMAL;
     return 0;
@@ -197,14 +198,14 @@ void Transition::clean_prev_renders_if_needed() {
 }
 
 void Transition::reset_framebuffers() {
-    free(this->framebuffers_primary[0]);
-    this->framebuffers_primary[0] = nullptr;
-    free(this->framebuffers_primary[1]);
-    this->framebuffers_primary[1] = nullptr;
-    free(this->framebuffers_secondary[0]);
-    this->framebuffers_secondary[0] = nullptr;
-    free(this->framebuffers_secondary[1]);
-    this->framebuffers_secondary[1] = nullptr;
+    for (auto& fb : this->framebuffers_primary) {
+        this->avs->framebuffer_pool.release(fb);
+        fb = nullptr;
+    }
+    for (auto& fb : this->framebuffers_secondary) {
+        this->avs->framebuffer_pool.release(fb);
+        fb = nullptr;
+    }
 }
 
 #define PI 3.14159265358979323846
@@ -280,13 +281,13 @@ int Transition::render(char visdata[2][2][576],
     if (this->last_w != w || this->last_h != h || !this->framebuffers_primary[0]) {
         this->last_w = w;
         this->last_h = h;
+        this->reset_framebuffers();
+        auto& pool = this->avs->framebuffer_pool;
         for (auto& fb : this->framebuffers_primary) {
-            free(fb);
-            fb = (int*)calloc(this->last_w * this->last_h, sizeof(int));
+            fb = (int*)pool.acquire(this->last_w * this->last_h * sizeof(int));
         }
         for (auto& fb : this->framebuffers_secondary) {
-            free(fb);
-            fb = (int*)calloc(this->last_w * this->last_h, sizeof(int));
+            fb = (int*)pool.acquire(this->last_w * this->last_h * sizeof(int));
         }
     }
 
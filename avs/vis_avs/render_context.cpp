@@ -67,15 +67,20 @@ void Buffer::swap(Buffer& other) {
 RenderContext::RenderContext(size_t w,
                              size_t h,
                              AVS_Pixel_Format pixel_format,
-                             std::array<Buffer, 8>& global_buffers,
                              Audio& audio,
-                             void* external_buffer)
-    : w(w),
+                             void* framebuffer,
+                             void* secondary_framebuffer,
+                             void* output,
+                             const Bilinear_Scaler* scaler,
+                             pixel_rgb0_8* scaled)
+    : framebuffers{Buffer(w, h, AVS_PIXEL_RGB0_8, framebuffer),
+                   Buffer(w, h, AVS_PIXEL_RGB0_8, secondary_framebuffer)},
+      w(w),
       h(h),
       pixel_format(pixel_format),
-      framebuffers{Buffer(w, h, pixel_format, external_buffer),
-                   Buffer(w, h, pixel_format)},
-      global_buffers(global_buffers),
+      output(output),
+      scaler(scaler),
+      scaled(scaled),
       audio(audio) {}
 
 void RenderContext::swap_framebuffers() {
@@ -83,16 +88,45 @@ void RenderContext::swap_framebuffers() {
     this->needs_final_fb_copy = !this->needs_final_fb_copy;
 }
 
-void RenderContext::copy_secondary_to_output_framebuffer_if_needed() {
-    if (this->needs_final_fb_copy) {
-        // In the swapped state the final effect rendered to the secondary
-        // buffer, so the output pointer is in framebuffers[1], the other one.
-        // Swap the buffers one last time & then copy the contents of the
-        // last-used buffer to the one with the output pointer. The final swap is
-        // needed so that the output pointer is in framebuffers[0] again. For the
-        // next frame the previous contents of the secondary buffer are never
-        // considered and can be left as-is.
-        this->swap_framebuffers();
-        this->framebuffers[0] = this->framebuffers[1];
+bool RenderContext::needs_output_write() const {
+    // The final effect always leaves its result in framebuffers[0].
+    return this->output != nullptr
+           && (this->scaler != nullptr || this->output != this->framebuffers[0].data);
+}
+
+void RenderContext::write_output(int this_thread, int max_threads) {
+    auto frame = (const pixel_rgb0_8*)this->framebuffers[0].data;
+    if (this->scaler != nullptr) {
+        size_t first_row;
+        size_t end_row;
+        pixel_format_band_rows(this->pixel_format,
+                               this->scaler->dest_h,
+                               this_thread,
+                               max_threads,
+                               &first_row,
+                               &end_row);
+        if (this->pixel_format == AVS_PIXEL_RGB0_8) {
+            this->scaler->scale_rows(
+                frame, (pixel_rgb0_8*)this->output, first_row, end_row);
+            return;
+        }
+        this->scaler->scale_rows(frame, this->scaled, first_row, end_row);
+        convert_rgb0_8_rows(this->scaled,
+                            this->output,
+                            this->pixel_format,
+                            this->scaler->dest_w,
+                            this->scaler->dest_h,
+                            first_row,
+                            end_row);
+        return;
     }
+    // This is either a plain copy, if the final effect rendered to the secondary buffer
+    // in RGB0_8, or the conversion to a different output pixel format.
+    convert_rgb0_8_frame(frame,
+                         this->output,
+                         this->pixel_format,
+                         this->w,
+                         this->h,
+                         this_thread,
+                         max_threads);
 }
@@ -2,8 +2,7 @@
 
 #include "audio.h"
 #include "pixel_format.h"
-
-#include <array>
+#include "scaler.h"
 
 struct Buffer {
     size_t w = 0;
@@ -31,11 +30,25 @@ struct Buffer {
 };
 
 struct RenderContext {
+    // Effects always render in RGB0_8. If the output pixel format is the same and the
+    // frame isn't scaled, the output buffer is usually framebuffers[0] itself.
     Buffer framebuffers[2];
     size_t w = 0;
     size_t h = 0;
+    // The pixel format of the output buffer.
     AVS_Pixel_Format pixel_format = AVS_PIXEL_RGB0_8;
-    std::array<Buffer, 8>& global_buffers;
+    void* output = nullptr;
+    // If set, the frame is rendered at `w` x `h` and scaled up to the output size.
+    const Bilinear_Scaler* scaler = nullptr;
+    // Space for the scaled-up frame, if it needs conversion to a different output pixel
+    // format.
+    pixel_rgb0_8* scaled = nullptr;
+    /**
+     * The audio for this frame, with only the data the preset's effects declared in
+     * their `audio_dependencies` up to date. E.g. `audio.levels` for the band energies
+     * and overall levels needs `AUDIO_DEPENDS_LEVELS`, `audio.tempo` needs
+     * `AUDIO_DEPENDS_TEMPO`.
+     */
     Audio& audio;
     bool is_preinit = false;
     bool needs_final_fb_copy = false;
@@ -43,9 +56,21 @@ struct RenderContext {
     RenderContext(size_t w,
                   size_t h,
                   AVS_Pixel_Format pixel_format,
-                  std::array<Buffer, 8>& global_buffers,
                   Audio& audio,
-                  void* external_buffer = nullptr);
+                  void* framebuffer,
+                  void* secondary_framebuffer,
+                  void* output = nullptr,
+                  const Bilinear_Scaler* scaler = nullptr,
+                  pixel_rgb0_8* scaled = nullptr);
     void swap_framebuffers();
-    void copy_secondary_to_output_framebuffer_if_needed();
+    /**
+     * Whether the final frame still has to be copied or converted to the output buffer
+     * with `write_output()`, because it's not already in there.
+     */
+    bool needs_output_write() const;
+    /**
+     * Copy or convert the part of the final frame belonging to `this_thread` into the
+     * output buffer. See `convert_rgb0_8_frame()`.
+     */
+    void write_output(int this_thread = 0, int max_threads = 1);
 };
@@ -0,0 +1,246 @@
+#include "resampler.h"
+
+#include <cmath>
+#include <cstring>
+#ifdef SIMD_MODE_X86_SSE
+#include <immintrin.h>
+#endif
+
+// The cutoff frequency (where the filter is at -6dB) relative to the lower of the two
+// sample rates. The transition band reaches a little beyond the Nyquist frequency, so
+// only the top few hundred Hz alias, in exchange for a flat passband up to ~17kHz.
+#define RESAMPLER_CUTOFF 0.45
+// The Kaiser window's beta, for a stopband attenuation of about 60dB.
+#define RESAMPLER_KAISER_BETA 6.0
+
+// The modified Bessel function of the first kind, order 0, for the Kaiser window.
+static double bessel_i0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 64; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+bool Resampler::set_rates(size_t input_rate, size_t output_rate) {
+    if (input_rate == this->in_rate && output_rate == this->out_rate) {
+        return false;
+    }
+    this->in_rate = input_rate;
+    this->out_rate = output_rate;
+    if (input_rate == output_rate || input_rate == 0 || output_rate == 0) {
+        this->num_taps = 0;
+        return true;
+    }
+    double ratio = (double)output_rate / (double)input_rate;
+    double bandwidth = ratio < 1.0 ? ratio : 1.0;
+    auto num_taps = (size_t)ceil((double)Resampler::taps_per_output_sample / bandwidth);
+    num_taps = (num_taps + 7) & ~(size_t)7;
+    if (num_taps > Resampler::max_taps) {
+        num_taps = Resampler::max_taps;
+    }
+    this->num_taps = num_taps;
+    this->step = 1.0 / ratio;
+
+    // Tap `k` of phase `p` is at a distance of `k - center - p / num_phases` input
+    // samples from the output sample.
+    double cutoff = RESAMPLER_CUTOFF * bandwidth;
+    double center = (double)(num_taps / 2 - 1);
+    double half_width = (double)num_taps / 2.0;
+    double window_scale = 1.0 / bessel_i0(RESAMPLER_KAISER_BETA);
+    this->coefficients.resize((Resampler::num_phases + 1) * num_taps);
+    std::vector<double> row(num_taps);
+    for (size_t p = 0; p <= Resampler::num_phases; p++) {
+        double fraction = (double)p / (double)Resampler::num_phases;
+        double sum = 0.0;
+        for (size_t k = 0; k < num_taps; k++) {
+            double t = (double)k - center - fraction;
+            double x = t / half_width;
+            double window = 0.0;
+            if (x > -1.0 && x < 1.0) {
+                window = bessel_i0(RESAMPLER_KAISER_BETA * sqrt(1.0 - x * x))
+                         * window_scale;
+            }
+            double phase = M_PI * 2.0 * cutoff * t;
+            double sinc = phase == 0.0 ? 1.0 : sin(phase) / phase;
+            row[k] = sinc * window;
+            sum += row[k];
+        }
+        // Normalize each phase to unity gain at 0Hz.
+        for (size_t k = 0; k < num_taps; k++) {
+            this->coefficients[p * num_taps + k] = (float)(row[k] / sum);
+        }
+    }
+
+    this->input_left.assign(num_taps + Resampler::block_length, 0.0f);
+    this->input_right.assign(num_taps + Resampler::block_length, 0.0f);
+    // Start with enough silence that the first output sample is centered on the first
+    // input sample.
+    this->input_length = num_taps / 2 - 1;
+    this->position = 0.0;
+    auto max_output_length =
+        (size_t)ceil((double)Resampler::block_length / this->step) + 2;
+    this->output_left.resize(max_output_length);
+    this->output_right.resize(max_output_length);
+    return true;
+}
+
+/**
+ * Calculate the dot products of both `left` and `right` with both `h0` and `h1` into
+ * `sums_out`, in the order left·h0, left·h1, right·h0, right·h1.
+ *
+ * With SSE, `length` must be a multiple of 4.
+ */
+#ifdef SIMD_MODE_X86_SSE
+static void dot_products_x86v128(const float* left,
+                                 const float* right,
+                                 const float* h0,
+                                 const float* h1,
+                                 size_t length,
+                                 float sums_out[4]) {
+    __m128 left0 = _mm_setzero_ps();
+    __m128 left1 = _mm_setzero_ps();
+    __m128 right0 = _mm_setzero_ps();
+    __m128 right1 = _mm_setzero_ps();
+    for (size_t i = 0; i < length; i += 4) {
+        __m128 l = _mm_loadu_ps(&left[i]);
+        __m128 r = _mm_loadu_ps(&right[i]);
+        __m128 c0 = _mm_loadu_ps(&h0[i]);
+        __m128 c1 = _mm_loadu_ps(&h1[i]);
+        left0 = _mm_add_ps(left0, _mm_mul_ps(l, c0));
+        left1 = _mm_add_ps(left1, _mm_mul_ps(l, c1));
+        right0 = _mm_add_ps(right0, _mm_mul_ps(r, c0));
+        right1 = _mm_add_ps(right1, _mm_mul_ps(r, c1));
+    }
+    // After transposing, adding up the rows gives all four horizontal sums at once.
+    _MM_TRANSPOSE4_PS(left0, left1, right0, right1);
+    __m128 sums = _mm_add_ps(_mm_add_ps(left0, left1), _mm_add_ps(right0, right1));
+    _mm_storeu_ps(sums_out, sums);
+}
+#else
+static void dot_products_c(const float* left,
+                           const float* right,
+                           const float* h0,
+                           const float* h1,
+                           size_t length,
+                           float sums_out[4]) {
+    float left0 = 0.0f;
+    float left1 = 0.0f;
+    float right0 = 0.0f;
+    float right1 = 0.0f;
+    for (size_t i = 0; i < length; i++) {
+        left0 += left[i] * h0[i];
+        left1 += left[i] * h1[i];
+        right0 += right[i] * h0[i];
+        right1 += right[i] * h1[i];
+    }
+    sums_out[0] = left0;
+    sums_out[1] = left1;
+    sums_out[2] = right0;
+    sums_out[3] = right1;
+}
+#endif
+
+size_t Resampler::convert(Audio_Ring& ring) {
+    size_t num_taps = this->num_taps;
+    size_t output_length = 0;
+    while (true) {
+        auto index = (size_t)this->position;
+        if (index + num_taps > this->input_length) {
+            break;
+        }
+        double phase = (this->position - (double)index) * Resampler::num_phases;
+        auto row = (size_t)phase;
+        auto fraction = (float)(phase - (double)row);
+        const float* h0 = &this->coefficients[row * num_taps];
+        float sums[4];
+#ifdef SIMD_MODE_X86_SSE
+        dot_products_x86v128(&this->input_left[index],
+                             &this->input_right[index],
+                             h0,
+                             h0 + num_taps,
+                             num_taps,
+                             sums);
+#else
+        dot_products_c(&this->input_left[index],
+                       &this->input_right[index],
+                       h0,
+                       h0 + num_taps,
+                       num_taps,
+                       sums);
+#endif
+        this->output_left[output_length] = sums[0] + (sums[1] - sums[0]) * fraction;
+        this->output_right[output_length] = sums[2] + (sums[3] - sums[2]) * fraction;
+        output_length++;
+        this->position += this->step;
+    }
+    // Keep only the input that's still needed for the next output samples.
+    auto consumed = (size_t)this->position;
+    if (consumed > this->input_length) {
+        consumed = this->input_length;
+    }
+    size_t remaining = this->input_length - consumed;
+    memmove(this->input_left.data(),
+            &this->input_left[consumed],
+            remaining * sizeof(float));
+    memmove(this->input_right.data(),
+            &this->input_right[consumed],
+            remaining * sizeof(float));
+    this->input_length = remaining;
+    this->position -= (double)consumed;
+    ring.write(this->output_left.data(), this->output_right.data(), output_length);
+    return output_length;
+}
+
+size_t Resampler::write(const float* left,
+                        const float* right,
+                        size_t num_samples,
+                        Audio_Ring& ring) {
+    if (this->num_taps == 0) {
+        ring.write(left, right, num_samples);
+        return num_samples;
+    }
+    size_t num_written = 0;
+    while (num_samples > 0) {
+        size_t length = num_samples < Resampler::block_length ? num_samples
+                                                              : Resampler::block_length;
+        memcpy(&this->input_left[this->input_length], left, length * sizeof(float));
+        memcpy(&this->input_right[this->input_length], right, length * sizeof(float));
+        this->input_length += length;
+        num_written += this->convert(ring);
+        left += length;
+        right += length;
+        num_samples -= length;
+    }
+    return num_written;
+}
+
+size_t Resampler::write(const AudioFrame* frames,
+                        size_t num_samples,
+                        Audio_Ring& ring) {
+    if (this->num_taps == 0) {
+        ring.write(frames, num_samples);
+        return num_samples;
+    }
+    size_t num_written = 0;
+    while (num_samples > 0) {
+        size_t length = num_samples < Resampler::block_length ? num_samples
+                                                              : Resampler::block_length;
+        float* left = &this->input_left[this->input_length];
+        float* right = &this->input_right[this->input_length];
+        for (size_t i = 0; i < length; i++) {
+            left[i] = frames[i].left;
+            right[i] = frames[i].right;
+        }
+        this->input_length += length;
+        num_written += this->convert(ring);
+        frames += length;
+        num_samples -= length;
+    }
+    return num_written;
+}
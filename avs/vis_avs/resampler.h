@@ -0,0 +1,68 @@
+#pragma once
+
+#include "audio_in.h"
+#include "audio_ring.h"
+
+#include <stddef.h>
+#include <vector>
+
+/**
+ * A streaming sample-rate converter for stereo audio, writing into an Audio_Ring.
+ *
+ * It's a polyphase FIR filter: A Kaiser-windowed sinc lowpass, cut off just below the
+ * lower of the two Nyquist frequencies, is tabulated at `num_phases` fractional sample
+ * offsets. Each output sample is computed from the latest input samples and the two
+ * nearest phases, interpolated linearly, so any ratio of rates works with the same
+ * table.
+ *
+ * Input is converted in blocks of at most `block_length` samples, so once the rates are
+ * set no memory is allocated. If both rates are the same, samples are passed through.
+ */
+class Resampler {
+   public:
+    static constexpr size_t block_length = 1024;
+    static constexpr size_t num_phases = 256;
+    // The filter length is chosen so that it spans this many output samples.
+    static constexpr size_t taps_per_output_sample = 32;
+    // But not longer than this, for extreme downsampling ratios.
+    static constexpr size_t max_taps = 256;
+
+    Resampler() = default;
+    Resampler(const Resampler&) = delete;
+    Resampler& operator=(const Resampler&) = delete;
+
+    /**
+     * Prepare for converting from `input_rate` to `output_rate`. If either one changed,
+     * previous input is discarded. Returns whether anything changed.
+     */
+    bool set_rates(size_t input_rate, size_t output_rate);
+    size_t input_rate() const { return this->in_rate; }
+    size_t output_rate() const { return this->out_rate; }
+
+    // Convert samples and append them to `ring`. Returns the number of samples written.
+    size_t write(const float* left,
+                 const float* right,
+                 size_t num_samples,
+                 Audio_Ring& ring);
+    size_t write(const AudioFrame* frames, size_t num_samples, Audio_Ring& ring);
+
+   private:
+    size_t convert(Audio_Ring& ring);
+
+    size_t in_rate = 0;
+    size_t out_rate = 0;
+    size_t num_taps = 0;
+    // Input samples per output sample.
+    double step = 1.0;
+    // Where the next output sample is, in input samples from the start of `input_*`.
+    double position = 0.0;
+    // `num_phases + 1` rows of `num_taps` coefficients each, the last row is one sample
+    // after the first one, to interpolate towards.
+    std::vector<float> coefficients;
+    // Input not yet used up by previous blocks, followed by the current block.
+    std::vector<float> input_left;
+    std::vector<float> input_right;
+    size_t input_length = 0;
+    std::vector<float> output_left;
+    std::vector<float> output_right;
+};
@@ -0,0 +1,170 @@
+#include "scaler.h"
+
+#include <immintrin.h>
+
+// Fill `index` and `weights` for scaling `src_size` pixels to `dest_size` pixels. The
+// second source pixel is always `index + 1`, so unless the source is a single pixel
+// wide, the last destination pixels interpolate fully towards the last source pixel
+// instead of past it.
+static void scaler_make_table(size_t src_size,
+                              size_t dest_size,
+                              std::vector<uint32_t>& index,
+                              std::vector<uint32_t>& weights) {
+    index.resize(dest_size);
+    weights.resize(dest_size);
+    double step = (double)src_size / (double)dest_size;
+    for (size_t i = 0; i < dest_size; i++) {
+        double pos = ((double)i + 0.5) * step - 0.5;
+        if (pos < 0.0) {
+            pos = 0.0;
+        }
+        auto first = (uint32_t)pos;
+        auto weight = (uint32_t)((pos - first) * 256.0 + 0.5);
+        if (weight >= 256) {
+            first++;
+            weight = 0;
+        }
+        if (src_size < 2) {
+            first = 0;
+            weight = 0;
+        } else if (first >= src_size - 1) {
+            first = src_size - 2;
+            weight = 256;
+        }
+        index[i] = first;
+        weights[i] = (256 - weight) | (weight << 16);
+    }
+}
+
+void Bilinear_Scaler::resize(size_t src_w, size_t src_h, size_t dest_w, size_t dest_h) {
+    if (src_w == this->src_w && src_h == this->src_h && dest_w == this->dest_w
+        && dest_h == this->dest_h) {
+        return;
+    }
+    this->src_w = src_w;
+    this->src_h = src_h;
+    this->dest_w = dest_w;
+    this->dest_h = dest_h;
+    scaler_make_table(src_w, dest_w, this->x_index, this->x_weights);
+    scaler_make_table(src_h, dest_h, this->y_index, this->y_weights);
+}
+
+// Interpolate in two steps, horizontally and then vertically, rounding to 8 bits after
+// each, so that the C and SIMD versions produce the same result.
+static inline uint32_t scaler_lerp_channel(uint32_t a, uint32_t b, uint32_t weights) {
+    return (a * (weights & 0xffff) + b * (weights >> 16) + 128) >> 8;
+}
+
+static void scaler_row_c(const pixel_rgb0_8* row0,
+                         const pixel_rgb0_8* row1,
+                         pixel_rgb0_8* dest,
+                         size_t src_w,
+                         const uint32_t* x_index,
+                         const uint32_t* x_weights,
+                         uint32_t y_weights,
+                         size_t first,
+                         size_t end) {
+    for (size_t x = first; x < end; x++) {
+        size_t x0 = x_index[x];
+        size_t x1 = x0 + 1 < src_w ? x0 + 1 : x0;
+        pixel_rgb0_8 result = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            uint32_t top = scaler_lerp_channel(
+                (row0[x0] >> shift) & 0xff, (row0[x1] >> shift) & 0xff, x_weights[x]);
+            uint32_t bottom = scaler_lerp_channel(
+                (row1[x0] >> shift) & 0xff, (row1[x1] >> shift) & 0xff, x_weights[x]);
+            result |= scaler_lerp_channel(top, bottom, y_weights) << shift;
+        }
+        dest[x] = result;
+    }
+}
+
+#ifdef SIMD_MODE_X86_SSE
+// Horizontally interpolate the two pixels in the low 8 bytes of `pair`, with each
+// channel's two values next to each other already, and return 32-bit channel values.
+static inline __m128i scaler_lerp_px_x86v128(__m128i pair, uint32_t weights) {
+    __m128i channels = _mm_unpacklo_epi8(pair, _mm_setzero_si128());
+    __m128i lerped = _mm_madd_epi16(channels, _mm_set1_epi32((int32_t)weights));
+    return _mm_srli_epi32(_mm_add_epi32(lerped, _mm_set1_epi32(128)), 8);
+}
+
+static void scaler_row_x86v128(const pixel_rgb0_8* row0,
+                               const pixel_rgb0_8* row1,
+                               pixel_rgb0_8* dest,
+                               size_t src_w,
+                               const uint32_t* x_index,
+                               const uint32_t* x_weights,
+                               uint32_t y_weights,
+                               size_t dest_w) {
+    size_t x = 0;
+    if (src_w >= 2) {
+        // Reorder 2 adjacent pixels B0 G0 R0 X0 B1 G1 R1 X1 to B0 B1 G0 G1 R0 R1 X0 X1.
+        const __m128i interleave =
+            _mm_setr_epi8(0, 4, 1, 5, 2, 6, 3, 7, 8, 12, 9, 13, 10, 14, 11, 15);
+        const __m128i vertical_weights = _mm_set1_epi32((int32_t)y_weights);
+        const __m128i round = _mm_set1_epi32(128);
+        for (; x + 2 <= dest_w; x += 2) {
+            const pixel_rgb0_8* a0 = &row0[x_index[x]];
+            const pixel_rgb0_8* b0 = &row0[x_index[x + 1]];
+            const pixel_rgb0_8* a1 = &row1[x_index[x]];
+            const pixel_rgb0_8* b1 = &row1[x_index[x + 1]];
+            __m128i top = _mm_shuffle_epi8(
+                _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)a0),
+                                   _mm_loadl_epi64((const __m128i*)b0)),
+                interleave);
+            __m128i bottom = _mm_shuffle_epi8(
+                _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)a1),
+                                   _mm_loadl_epi64((const __m128i*)b1)),
+                interleave);
+            __m128i top_a = scaler_lerp_px_x86v128(top, x_weights[x]);
+            __m128i top_b =
+                scaler_lerp_px_x86v128(_mm_srli_si128(top, 8), x_weights[x + 1]);
+            __m128i bottom_a = scaler_lerp_px_x86v128(bottom, x_weights[x]);
+            __m128i bottom_b =
+                scaler_lerp_px_x86v128(_mm_srli_si128(bottom, 8), x_weights[x + 1]);
+            // Pair up top and bottom values as 16 bits each, and interpolate again.
+            __m128i a = _mm_or_si128(top_a, _mm_slli_epi32(bottom_a, 16));
+            __m128i b = _mm_or_si128(top_b, _mm_slli_epi32(bottom_b, 16));
+            a = _mm_madd_epi16(a, vertical_weights);
+            b = _mm_madd_epi16(b, vertical_weights);
+            a = _mm_srli_epi32(_mm_add_epi32(a, round), 8);
+            b = _mm_srli_epi32(_mm_add_epi32(b, round), 8);
+            __m128i result = _mm_packs_epi32(a, b);
+            _mm_storel_epi64((__m128i*)&dest[x], _mm_packus_epi16(result, result));
+        }
+    }
+    scaler_row_c(row0, row1, dest, src_w, x_index, x_weights, y_weights, x, dest_w);
+}
+#endif
+
+void Bilinear_Scaler::scale_rows(const pixel_rgb0_8* src,
+                                 pixel_rgb0_8* dest,
+                                 size_t first_row,
+                                 size_t end_row) const {
+    for (size_t y = first_row; y < end_row; y++) {
+        size_t y0 = this->y_index[y];
+        size_t y1 = y0 + 1 < this->src_h ? y0 + 1 : y0;
+        const pixel_rgb0_8* row0 = &src[y0 * this->src_w];
+        const pixel_rgb0_8* row1 = &src[y1 * this->src_w];
+#ifdef SIMD_MODE_X86_SSE
+        scaler_row_x86v128(row0,
+                           row1,
+                           &dest[y * this->dest_w],
+                           this->src_w,
+                           this->x_index.data(),
+                           this->x_weights.data(),
+                           this->y_weights[y],
+                           this->dest_w);
+#else
+        scaler_row_c(row0,
+                     row1,
+                     &dest[y * this->dest_w],
+                     this->src_w,
+                     this->x_index.data(),
+                     this->x_weights.data(),
+                     this->y_weights[y],
+                     0,
+                     this->dest_w);
+#endif
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "pixel_format.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Bilinear scaling of whole RGB0_8 frames, with pixel centers aligned between source
+ * and destination. Meant for upscaling, since downscaling by more than a factor of 2
+ * skips source pixels.
+ */
+class Bilinear_Scaler {
+   public:
+    // Prepare for scaling `src_w` x `src_h` frames to `dest_w` x `dest_h`. Does nothing
+    // if the sizes didn't change since the last call.
+    void resize(size_t src_w, size_t src_h, size_t dest_w, size_t dest_h);
+    // Write rows `first_row` up to (excluding) `end_row` of the destination frame.
+    void scale_rows(const pixel_rgb0_8* src,
+                    pixel_rgb0_8* dest,
+                    size_t first_row,
+                    size_t end_row) const;
+
+    size_t src_w = 0;
+    size_t src_h = 0;
+    size_t dest_w = 0;
+    size_t dest_h = 0;
+
+   private:
+    // For each destination column/row, the first of the two source pixels to
+    // interpolate between, and the weights of the first and second one (out of 256)
+    // packed into the low and high 16 bits.
+    std::vector<uint32_t> x_index;
+    std::vector<uint32_t> x_weights;
+    std::vector<uint32_t> y_index;
+    std::vector<uint32_t> y_weights;
+};
@@ -0,0 +1,277 @@
+#include "tempo_tracker.h"
+
+#include <cmath>
+#include <cstring>
+
+// The rate onset strengths are collected at, in frames per second, give or take.
+#define TEMPO_FRAME_RATE 100.0
+// Estimate only once this many frames were collected, ~2.5s.
+#define TEMPO_MIN_HISTORY_LENGTH 256
+// Onset strengths are compared to their average over this many frames on either side.
+#define TEMPO_DETREND_FRAMES 8
+// The number of multiples of a period, including itself, that add to its score.
+#define TEMPO_NUM_HARMONICS 4
+// The preferred tempo, and how quickly the preference falls off, in octaves.
+#define TEMPO_PREFERRED_BPM 120.0
+#define TEMPO_PREFERENCE_OCTAVES 1.0
+// Periods within this ratio of the current one are the same tempo, and adjust it.
+#define TEMPO_SAME_PERIOD_TOLERANCE 0.04
+#define TEMPO_PERIOD_SMOOTHING 0.25
+#define TEMPO_CONFIDENCE_SMOOTHING 0.25
+// A different period has to win this many updates in a row to replace the current one.
+#define TEMPO_NUM_UPDATES_TO_SWITCH 4
+// The number of past beats the phase is matched against, and their decreasing weight.
+#define TEMPO_PHASE_BEATS 8
+#define TEMPO_PHASE_DECAY 0.8
+
+Tempo_Tracker::Tempo_Tracker() { this->reset(); }
+
+void Tempo_Tracker::reset() {
+    memset(this->history, 0, sizeof(this->history));
+    this->history_head = 0;
+    this->history_length = 0;
+    this->frame_strength = 0.0f;
+    this->frame_hops = 0;
+    this->frames_until_update = Tempo_Tracker::update_interval;
+    this->period = 0.0;
+    this->confidence = 0.0;
+    this->candidate_period = 0.0;
+    this->candidate_count = 0;
+    this->publish({0.0, 0.0, 0.0, 0.0, this->samples_per_second});
+}
+
+void Tempo_Tracker::add(float onset_strength,
+                        int64_t time,
+                        size_t samples_per_hop,
+                        size_t samples_per_second) {
+    if (samples_per_second != this->samples_per_second
+        || samples_per_hop * this->hops_per_frame != this->samples_per_frame) {
+        this->samples_per_second = samples_per_second;
+        double hops_per_frame =
+            (double)samples_per_second / (double)samples_per_hop / TEMPO_FRAME_RATE;
+        this->hops_per_frame =
+            hops_per_frame < 1.5 ? 1 : (size_t)(hops_per_frame + 0.5);
+        this->samples_per_frame = samples_per_hop * this->hops_per_frame;
+        this->reset();
+    }
+    this->frame_strength += onset_strength;
+    if (++this->frame_hops < this->hops_per_frame) {
+        return;
+    }
+    this->history[this->history_head] = this->frame_strength;
+    this->history_head = (this->history_head + 1) % Tempo_Tracker::history_size;
+    if (this->history_length < Tempo_Tracker::history_size) {
+        this->history_length++;
+    }
+    this->frame_strength = 0.0f;
+    this->frame_hops = 0;
+    if (--this->frames_until_update == 0) {
+        this->frames_until_update = Tempo_Tracker::update_interval;
+        if (this->history_length >= TEMPO_MIN_HISTORY_LENGTH) {
+            this->update(time);
+        }
+    }
+}
+
+void Tempo_Tracker::update(int64_t time) {
+    size_t length = this->history_length;
+    float onsets[Tempo_Tracker::history_size];
+    size_t start = (this->history_head + Tempo_Tracker::history_size - length)
+                   % Tempo_Tracker::history_size;
+    for (size_t i = 0; i < length; i++) {
+        onsets[i] = this->history[(start + i) % Tempo_Tracker::history_size];
+    }
+
+    // Keep only what stands out from the local average, so that the autocorrelation
+    // follows the onsets rather than the overall loudness.
+    float sums[Tempo_Tracker::history_size + 1];
+    sums[0] = 0.0f;
+    for (size_t i = 0; i < length; i++) {
+        sums[i + 1] = sums[i] + onsets[i];
+    }
+    float mean = 0.0f;
+    for (size_t i = 0; i < length; i++) {
+        size_t first = i > TEMPO_DETREND_FRAMES ? i - TEMPO_DETREND_FRAMES : 0;
+        size_t end = i + TEMPO_DETREND_FRAMES + 1;
+        end = end < length ? end : length;
+        float local_mean = (sums[end] - sums[first]) / (float)(end - first);
+        onsets[i] = onsets[i] > local_mean ? onsets[i] - local_mean : 0.0f;
+        mean += onsets[i];
+    }
+    mean /= (float)length;
+
+    double frames_per_second =
+        (double)this->samples_per_second / (double)this->samples_per_frame;
+    auto max_period = (size_t)ceil(frames_per_second * 60.0 / Tempo_Tracker::min_bpm);
+    size_t max_lag = max_period * TEMPO_NUM_HARMONICS + 1;
+    max_lag = max_lag < length * 3 / 4 ? max_lag : length * 3 / 4;
+    float autocorrelation[Tempo_Tracker::history_size];
+    for (size_t lag = 0; lag <= max_lag; lag++) {
+        float sum = 0.0f;
+        for (size_t i = lag; i < length; i++) {
+            sum += (onsets[i] - mean) * (onsets[i - lag] - mean);
+        }
+        autocorrelation[lag] = sum / (float)(length - lag);
+    }
+    if (!(autocorrelation[0] > 1e-9f)) {
+        // Silence or a constant signal.
+        this->confidence *= 1.0 - TEMPO_CONFIDENCE_SMOOTHING;
+    } else {
+        double period = this->find_period(autocorrelation, max_lag);
+        if (period <= 0.0) {
+            this->confidence *= 1.0 - TEMPO_CONFIDENCE_SMOOTHING;
+        } else if (this->period == 0.0
+                   || fabs(period / this->period - 1.0) < TEMPO_SAME_PERIOD_TOLERANCE) {
+            this->period = this->period == 0.0
+                               ? period
+                               : this->period
+                                     + (period - this->period) * TEMPO_PERIOD_SMOOTHING;
+            this->candidate_count = 0;
+        } else {
+            bool same_candidate = this->candidate_count > 0
+                                  && fabs(period / this->candidate_period - 1.0)
+                                         < TEMPO_SAME_PERIOD_TOLERANCE;
+            this->candidate_count = same_candidate ? this->candidate_count + 1 : 1;
+            this->candidate_period = period;
+            if (this->candidate_count >= TEMPO_NUM_UPDATES_TO_SWITCH) {
+                this->period = period;
+                this->candidate_count = 0;
+            }
+        }
+        if (this->period > 0.0 && period > 0.0) {
+            // How strongly the onsets repeat at the current period.
+            auto lag = (size_t)(this->period + 0.5);
+            lag = lag <= max_lag ? lag : max_lag;
+            double strength = autocorrelation[lag] / autocorrelation[0];
+            strength = strength > 0.0 ? (strength < 1.0 ? strength : 1.0) : 0.0;
+            this->confidence +=
+                (strength - this->confidence) * TEMPO_CONFIDENCE_SMOOTHING;
+        }
+    }
+    if (this->period == 0.0) {
+        return;
+    }
+
+    double offset = Tempo_Tracker::find_beat_offset(onsets, length, this->period);
+    // `time` is the end of the newest frame, take the middle.
+    double beat_time = (double)time - 0.5 * (double)this->samples_per_frame
+                       - offset * (double)this->samples_per_frame;
+    this->publish({
+        60.0 * frames_per_second / this->period,
+        this->confidence,
+        this->period * (double)this->samples_per_frame,
+        beat_time,
+        this->samples_per_second,
+    });
+}
+
+// Return the period in frames that best explains the autocorrelation, or 0 if none.
+double Tempo_Tracker::find_period(const float* autocorrelation, size_t max_lag) const {
+    double frames_per_second =
+        (double)this->samples_per_second / (double)this->samples_per_frame;
+    auto min_period = (size_t)(frames_per_second * 60.0 / Tempo_Tracker::max_bpm);
+    auto max_period = (size_t)ceil(frames_per_second * 60.0 / Tempo_Tracker::min_bpm);
+    min_period = min_period > 2 ? min_period : 2;
+    max_period = max_period + 1 < max_lag ? max_period : max_lag - 1;
+    if (min_period > max_period) {
+        return 0.0;
+    }
+    double scores[Tempo_Tracker::history_size];
+    size_t best = 0;
+    for (size_t period = min_period - 1; period <= max_period + 1; period++) {
+        // Multiples of the period only fall on whole lags approximately, so they get
+        // the best of the nearest three.
+        double score = autocorrelation[period];
+        size_t num_harmonics = 1;
+        for (size_t k = 2; k <= TEMPO_NUM_HARMONICS && k * period + 1 <= max_lag; k++) {
+            const float* near = &autocorrelation[k * period - 1];
+            float max = near[0] > near[1] ? near[0] : near[1];
+            score += max > near[2] ? max : near[2];
+            num_harmonics++;
+        }
+        double bpm = 60.0 * frames_per_second / (double)period;
+        double octaves = log2(bpm / TEMPO_PREFERRED_BPM) / TEMPO_PREFERENCE_OCTAVES;
+        scores[period] = score / (double)num_harmonics * exp(-0.5 * octaves * octaves);
+        if (period >= min_period && period <= max_period
+            && (best == 0 || scores[period] > scores[best])) {
+            best = period;
+        }
+    }
+    if (!(scores[best] > 0.0)) {
+        return 0.0;
+    }
+    // Interpolate between whole periods with a parabola through the neighbors.
+    double before = scores[best - 1];
+    double after = scores[best + 1];
+    double curvature = before - 2.0 * scores[best] + after;
+    double fraction = curvature < 0.0 ? 0.5 * (before - after) / curvature : 0.0;
+    return (double)best + fraction;
+}
+
+/**
+ * Return how many frames before the newest one the latest beat was, by lining up a
+ * pulse train of `period` frames with the onsets.
+ */
+double Tempo_Tracker::find_beat_offset(const float* onsets,
+                                       size_t length,
+                                       double period) {
+    auto num_offsets = (size_t)ceil(period);
+    auto num_beats = (size_t)(((double)length - (double)num_offsets) / period);
+    num_beats = num_beats < TEMPO_PHASE_BEATS ? num_beats : TEMPO_PHASE_BEATS;
+    double scores[Tempo_Tracker::history_size];
+    size_t best = 0;
+    for (size_t offset = 0; offset < num_offsets; offset++) {
+        double score = 0.0;
+        double weight = 1.0;
+        for (size_t k = 0; k <= num_beats; k++) {
+            auto back = (size_t)((double)offset + (double)k * period + 0.5);
+            if (back >= length) {
+                break;
+            }
+            score += onsets[length - 1 - back] * weight;
+            weight *= TEMPO_PHASE_DECAY;
+        }
+        scores[offset] = score;
+        if (score > scores[best]) {
+            best = offset;
+        }
+    }
+    // The offsets wrap around at the period.
+    double before = scores[(best + num_offsets - 1) % num_offsets];
+    double after = scores[(best + 1) % num_offsets];
+    double curvature = before - 2.0 * scores[best] + after;
+    double fraction = curvature < 0.0 ? 0.5 * (before - after) / curvature : 0.0;
+    return (double)best + fraction;
+}
+
+void Tempo_Tracker::publish(const Tempo_Estimate& estimate) {
+    uint32_t sequence = this->sequence.load(std::memory_order_relaxed);
+    this->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    this->published_bpm.store(estimate.bpm, std::memory_order_relaxed);
+    this->published_confidence.store(estimate.confidence, std::memory_order_relaxed);
+    this->published_period.store(estimate.beat_period, std::memory_order_relaxed);
+    this->published_beat_time.store(estimate.beat_time, std::memory_order_relaxed);
+    this->published_samples_per_second.store(estimate.samples_per_second,
+                                             std::memory_order_relaxed);
+    this->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool Tempo_Tracker::estimate(Tempo_Estimate* estimate_out) const {
+    uint32_t sequence;
+    do {
+        sequence = this->sequence.load(std::memory_order_acquire);
+        estimate_out->bpm = this->published_bpm.load(std::memory_order_relaxed);
+        estimate_out->confidence =
+            this->published_confidence.load(std::memory_order_relaxed);
+        estimate_out->beat_period =
+            this->published_period.load(std::memory_order_relaxed);
+        estimate_out->beat_time =
+            this->published_beat_time.load(std::memory_order_relaxed);
+        estimate_out->samples_per_second =
+            this->published_samples_per_second.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((sequence & 1) != 0
+             || sequence != this->sequence.load(std::memory_order_relaxed));
+    return estimate_out->beat_period > 0.0 && estimate_out->samples_per_second > 0;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A snapshot of the tempo of a stream. All times are stream positions in samples, as
+ * counted by the `Beat_Detector` feeding the tracker.
+ */
+struct Tempo_Estimate {
+    // 0 if no tempo was found yet.
+    double bpm;
+    // How clearly the audio has this tempo, from 0 to 1.
+    double confidence;
+    double beat_period;
+    // The most recent beat at or before the time of the estimate, later beats follow
+    // every `beat_period` samples.
+    double beat_time;
+    size_t samples_per_second;
+};
+
+/**
+ * Tempo estimation from an onset strength signal, e.g. the spectral flux from
+ * `Beat_Detector`.
+ *
+ * Onset strengths are collected into frames of roughly 10ms. Every `update_interval`
+ * frames, the autocorrelation of the last `history_size` frames is weighted with a
+ * comb of the first few multiples of each candidate beat period, and with a preference
+ * for tempos around 120 BPM that steers clear of double and half tempo. The best
+ * period only replaces the current one if it persists for a few updates. The beat
+ * phase then is the offset at which a pulse train of that period best lines up with
+ * the recent onsets.
+ *
+ * `add()` is meant to be called from a single (audio) thread, `estimate()` may be
+ * called from any thread.
+ */
+class Tempo_Tracker {
+   public:
+    static constexpr size_t history_size = 512;
+    static constexpr size_t update_interval = 8;
+    static constexpr double min_bpm = 60.0;
+    static constexpr double max_bpm = 180.0;
+
+    Tempo_Tracker();
+    Tempo_Tracker(const Tempo_Tracker&) = delete;
+    Tempo_Tracker& operator=(const Tempo_Tracker&) = delete;
+
+    void reset();
+    /**
+     * Add the onset strength of the `samples_per_hop` samples up to stream position
+     * `time`.
+     */
+    void add(float onset_strength,
+             int64_t time,
+             size_t samples_per_hop,
+             size_t samples_per_second);
+    // Copy the latest estimate into `estimate_out`. Returns `false` if there's none.
+    bool estimate(Tempo_Estimate* estimate_out) const;
+
+   private:
+    void update(int64_t time);
+    double find_period(const float* autocorrelation, size_t max_lag) const;
+    static double find_beat_offset(const float* onsets, size_t length, double period);
+    void publish(const Tempo_Estimate& estimate);
+
+    size_t samples_per_second = 0;
+    size_t hops_per_frame = 1;
+    size_t samples_per_frame = 0;
+    // Onset strength per frame, as a ring buffer.
+    float history[history_size];
+    size_t history_head = 0;
+    size_t history_length = 0;
+    float frame_strength = 0.0f;
+    size_t frame_hops = 0;
+    size_t frames_until_update = update_interval;
+
+    // The current period in frames, and a differing one that may replace it.
+    double period = 0.0;
+    double confidence = 0.0;
+    double candidate_period = 0.0;
+    size_t candidate_count = 0;
+
+    /**
+     * The published estimate. A sequence lock: The writer makes `sequence` odd while
+     * it updates the fields, readers retry if it was odd or changed while reading.
+     */
+    std::atomic<uint32_t> sequence{0};
+    std::atomic<double> published_bpm{0.0};
+    std::atomic<double> published_confidence{0.0};
+    std::atomic<double> published_period{0.0};
+    std::atomic<double> published_beat_time{0.0};
+    std::atomic<size_t> published_samples_per_second{0};
+};
@@ -0,0 +1,56 @@
+#include "tile_bins.h"
+
+void Tile_Bins::reset(int h, int tile_height) {
+    this->h = h > 0 ? h : 0;
+    this->tile_height = tile_height;
+    this->tile_count = (this->h + tile_height - 1) / tile_height;
+    this->ranges.clear();
+}
+
+void Tile_Bins::add(uint32_t item, int64_t top, int64_t bottom) {
+    if (bottom < 0 || top >= this->h || bottom < top) {
+        return;
+    }
+    int first_tile = top < 0 ? 0 : (int)(top / this->tile_height);
+    int last_tile =
+        (int)((bottom >= this->h ? this->h - 1 : bottom) / this->tile_height);
+    this->ranges.push_back({item, first_tile, last_tile});
+}
+
+void Tile_Bins::finish() {
+    // Counting sort by tile, which keeps the order of items within each tile.
+    this->tile_start.assign(this->tile_count + 1, 0);
+    for (auto& range : this->ranges) {
+        for (int t = range.first_tile; t <= range.last_tile; t++) {
+            this->tile_start[t + 1]++;
+        }
+    }
+    for (int t = 0; t < this->tile_count; t++) {
+        this->tile_start[t + 1] += this->tile_start[t];
+    }
+    this->items.resize(this->tile_start[this->tile_count]);
+    // Use tile_start[t + 1] as the insertion cursor for tile t, which leaves it at the
+    // start of tile t + 1 when done.
+    for (auto& range : this->ranges) {
+        for (int t = range.first_tile; t <= range.last_tile; t++) {
+            this->items[this->tile_start[t]++] = range.item;
+        }
+    }
+    for (int t = this->tile_count; t > 0; t--) {
+        this->tile_start[t] = this->tile_start[t - 1];
+    }
+    this->tile_start[0] = 0;
+}
+
+int Tile_Bins::tile_bottom(int tile) const {
+    int bottom = (tile + 1) * this->tile_height;
+    return bottom < this->h ? bottom : this->h;
+}
+
+const uint32_t* Tile_Bins::items_begin(int tile) const {
+    return this->items.data() + this->tile_start[tile];
+}
+
+const uint32_t* Tile_Bins::items_end(int tile) const {
+    return this->items.data() + this->tile_start[tile + 1];
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * Sorts overlapping draw items into horizontal strips ("tiles") of the screen, so that
+ * the tiles can be drawn in parallel. Items are added in drawing order, each with the
+ * range of rows it may touch, and each tile lists the items touching it in that same
+ * order. Drawing every tile's items clipped to the tile thus blends each pixel in the
+ * same sequence as drawing all items one after another.
+ */
+class Tile_Bins {
+   public:
+    // Start a new frame for a screen of height `h`, dropping all previous items.
+    void reset(int h, int tile_height);
+    // Add item number `item`, which may draw into rows `top` through `bottom`. Rows
+    // outside of the screen are ignored.
+    void add(uint32_t item, int64_t top, int64_t bottom);
+    // Build the per-tile lists. Call after adding all items and before reading.
+    void finish();
+
+    int num_tiles() const { return this->tile_count; }
+    bool empty() const { return this->ranges.empty(); }
+    int tile_top(int tile) const { return tile * this->tile_height; }
+    int tile_bottom(int tile) const;  // exclusive
+    const uint32_t* items_begin(int tile) const;
+    const uint32_t* items_end(int tile) const;
+
+   private:
+    struct Range {
+        uint32_t item;
+        int first_tile;
+        int last_tile;
+    };
+    int h = 0;
+    int tile_height = 1;
+    int tile_count = 0;
+    std::vector<Range> ranges;
+    // Items of tile t are `items[tile_start[t]]` up to (excluding)
+    // `items[tile_start[t + 1]]`.
+    std::vector<uint32_t> tile_start;
+    std::vector<uint32_t> items;
+};
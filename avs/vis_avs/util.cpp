@@ -302,6 +302,21 @@ static void _dosetsel(HWND hwndDlg) {
             "    'channel' can be: 0=center, 1=left, 2=right. return value is "
             "(0..1)\r\n"
             "\r\n"
+            "getband(band,smoothed)\r\n"
+            "  = returns the RMS level of frequency band 'band' (0=bass, 1=mids, "
+            "2=treble by default)\r\n"
+            "    if 'smoothed' is nonzero, the level rises fast and falls slowly "
+            "instead\r\n"
+            "\r\n"
+            "getlevel(which)\r\n"
+            "  = returns the overall audio level, 'which' can be: 0=RMS, 1=peak, "
+            "2=smoothed RMS\r\n"
+            "\r\n"
+            "gettempo(which)\r\n"
+            "  = returns the tempo, 'which' can be: 0=BPM (0 if unknown), "
+            "1=confidence (0..1),\r\n"
+            "    2=beat phase (0 at a beat, rising to 1 until the next)\r\n"
+            "\r\n"
             "gettime(start_time)\r\n"
             "  = returns time in seconds since start_time (start_time can be 0 for "
             "time since boot)\r\n"
@@ -249,6 +249,8 @@ class AVS_Video {
 
     struct LibAV;
     LibAV* av;
+    // Audio_File decodes with the same dynamically loaded libav functions.
+    friend class Audio_File;
 
     Output_Format output_format;
     Resample_Info resampler;
@@ -16,6 +16,7 @@ bool AVS_Video::LibAV::load_libav_dlibs() {
     LOAD_FUNC(AVS_Video::LibAV, libavformat, avformat, alloc_context);
     LOAD_FUNC(AVS_Video::LibAV, libavformat, avformat, open_input);
     LOAD_FUNC(AVS_Video::LibAV, libavformat, avformat, close_input);
+    LOAD_FUNC(AVS_Video::LibAV, libavformat, avformat, find_stream_info);
     LOAD_FUNC(AVS_Video::LibAV, libavformat, av, find_best_stream);
     LOAD_FUNC(AVS_Video::LibAV, libavcodec, av, packet_alloc);
     LOAD_FUNC(AVS_Video::LibAV, libavutil, av, frame_alloc);
@@ -46,6 +47,7 @@ dlib_t* AVS_Video::LibAV::libswscale = NULL;
 DEFINE_FUNC(AVS_Video::LibAV, avformat, alloc_context);
 DEFINE_FUNC(AVS_Video::LibAV, avformat, open_input);
 DEFINE_FUNC(AVS_Video::LibAV, avformat, close_input);
+DEFINE_FUNC(AVS_Video::LibAV, avformat, find_stream_info);
 DEFINE_FUNC(AVS_Video::LibAV, av, find_best_stream);
 DEFINE_FUNC(AVS_Video::LibAV, av, packet_alloc);
 DEFINE_FUNC(AVS_Video::LibAV, av, frame_alloc);
@@ -44,6 +44,7 @@ struct AVS_Video::LibAV {
     static decltype(&avformat_alloc_context) alloc_context;
     static decltype(&avformat_open_input) open_input;
     static decltype(&avformat_close_input) close_input;
+    static decltype(&avformat_find_stream_info) find_stream_info;
     static decltype(&av_find_best_stream) find_best_stream;
     static decltype(&av_packet_alloc) packet_alloc;
     static decltype(&av_frame_alloc) frame_alloc;
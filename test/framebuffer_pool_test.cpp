@@ -0,0 +1,115 @@
+/**
+ * Render an Effect List that's only enabled on beat, and check that its framebuffer,
+ * which is returned and borrowed again every few frames, comes out of the instance's
+ * framebuffer pool instead of the heap once the pool is warmed up.
+ */
+
+#include "../avs/vis_avs/avs.h"
+#include "../avs/vis_avs/avs_editor.h"
+#include "../avs/vis_avs/avs_internal.h"
+#include "../avs/vis_avs/instance.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static constexpr size_t width = 320;
+static constexpr size_t height = 240;
+static constexpr int num_warmup_frames = 10;
+// More than `Framebuffer_Pool::max_idle_frames`, to see buffers survive aging too.
+static constexpr int num_frames = 1000;
+static constexpr int beat_interval = 4;
+
+static AVS_Effect_Handle find_effect(AVS_Handle avs, const char* name) {
+    uint32_t length;
+    auto effects = avs_effect_library(avs, &length);
+    for (uint32_t i = 0; i < length; i++) {
+        AVS_Effect_Info info;
+        if (avs_effect_info(avs, effects[i], &info) && strcmp(info.name, name) == 0) {
+            return effects[i];
+        }
+    }
+    return 0;
+}
+
+static AVS_Parameter_Handle find_parameter(AVS_Handle avs,
+                                           AVS_Effect_Handle effect,
+                                           const char* name) {
+    AVS_Effect_Info effect_info;
+    if (!avs_effect_info(avs, effect, &effect_info)) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < effect_info.parameters_length; i++) {
+        AVS_Parameter_Info info;
+        if (avs_parameter_info(avs, effect, effect_info.parameters[i], &info)
+            && strcmp(info.name, name) == 0) {
+            return effect_info.parameters[i];
+        }
+    }
+    return 0;
+}
+
+int main() {
+    AVS_Handle avs = avs_init("", AVS_AUDIO_EXTERNAL, AVS_BEAT_EXTERNAL);
+    if (!avs) {
+        printf("Init error: %s\n", avs_error_str(0));
+        return 1;
+    }
+    AVS_Effect_Handle effect_list = find_effect(avs, "Effect List");
+    AVS_Effect_Handle invert = find_effect(avs, "Invert");
+    AVS_Component_Handle list_component =
+        avs_component_create(avs, effect_list, 0, AVS_COMPONENT_POSITION_DONTCARE);
+    if (!list_component
+        || !avs_component_create(
+            avs, invert, list_component, AVS_COMPONENT_POSITION_CHILD)) {
+        printf("Create error: %s\n", avs_error_str(avs));
+        avs_free(avs);
+        return 1;
+    }
+    AVS_Component_Properties properties;
+    avs_component_properties_get(avs, list_component, &properties);
+    properties.enabled = false;
+    avs_component_properties_set(avs, list_component, properties);
+    avs_parameter_set_bool(avs,
+                           list_component,
+                           find_parameter(avs, effect_list, "On Beat"),
+                           true,
+                           0,
+                           nullptr);
+    avs_parameter_set_int(avs,
+                          list_component,
+                          find_parameter(avs, effect_list, "On Beat Frames"),
+                          1,
+                          0,
+                          nullptr);
+
+    AVS_Instance* instance = get_instance_from_handle(avs);
+    auto framebuffer = (uint32_t*)calloc(width * height, sizeof(uint32_t));
+    uint64_t num_allocations_after_warmup = 0;
+    for (int i = 0; i < num_frames; i++) {
+        bool is_beat = i % beat_interval == 0;
+        if (!avs_render_frame(
+                avs, framebuffer, width, height, i * 16, is_beat, AVS_PIXEL_RGB0_8)) {
+            printf("Render error in frame %d: %s\n", i, avs_error_str(avs));
+            free(framebuffer);
+            avs_free(avs);
+            return 1;
+        }
+        if (i == num_warmup_frames) {
+            num_allocations_after_warmup =
+                instance->framebuffer_pool.stats().num_allocations;
+        }
+    }
+    free(framebuffer);
+
+    uint64_t num_allocations = instance->framebuffer_pool.stats().num_allocations;
+    avs_free(avs);
+    if (num_allocations != num_allocations_after_warmup) {
+        printf("FAIL: %llu heap allocations after warm-up, expected %llu\n",
+               (unsigned long long)num_allocations,
+               (unsigned long long)num_allocations_after_warmup);
+        return 1;
+    }
+    printf("OK: %llu heap allocations\n", (unsigned long long)num_allocations);
+    return 0;
+}